@@ -0,0 +1,211 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/ports/lazydataoutport.h>
+#include <inviwo/molecularchargetransitions/util/chargequantization.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+#include <inviwo/core/util/exception.h>
+#include <inviwo/core/util/formats.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <modules/python3/pyportutils.h>
+
+#include <warn/push>
+#include <warn/ignore/shadow>
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+#include <warn/pop>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace inviwo {
+
+namespace {
+
+py::array readOnly(py::array array) {
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+std::shared_ptr<const Column> findColumn(const DataFrame& dataFrame, const std::string& name) {
+    if (auto column = dataFrame.getColumn(name)) return column;
+    throw Exception("DataFrame has no column '" + name + "'",
+                    IVW_CONTEXT_CUSTOM("ivwmolecularchargetransitions"));
+}
+
+/**
+ * A NumPy array referring directly to the column buffer, which is kept alive by the array.
+ * Quantized columns are decoded to float32, which is the only case where the values are copied.
+ */
+py::array columnArray(const std::shared_ptr<const Column>& column) {
+    auto buffer = column->getBuffer();
+    if (const auto encoding = ChargeQuantization::encodingOf(*buffer)) {
+        py::array_t<float> values(buffer->getSize());
+        ChargeQuantization::decode(*buffer, *encoding, values.mutable_data());
+        return std::move(values);
+    }
+
+    py::capsule owner(new std::shared_ptr<const BufferBase>(buffer), [](void* p) {
+        delete static_cast<std::shared_ptr<const BufferBase>*>(p);
+    });
+    return buffer->getRepresentation<BufferRAM>()
+        ->dispatch<py::array, dispatching::filter::Scalars>([&](auto buf) {
+            using ValueType = util::PrecisionValueType<decltype(buf)>;
+            const auto dtype = []() {
+                if constexpr (std::is_same_v<ValueType, f16>) {
+                    return py::dtype("float16");
+                } else {
+                    return py::dtype::of<ValueType>();
+                }
+            }();
+            const auto& data = buf->getDataContainer();
+            return readOnly(
+                py::array(dtype, {data.size()}, {sizeof(ValueType)}, data.data(), owner));
+        });
+}
+
+py::dict columns(const DataFrame& dataFrame, const std::vector<std::string>& names) {
+    py::dict result;
+    if (names.empty()) {
+        for (size_t i = 0; i < dataFrame.getNumberOfColumns(); ++i) {
+            auto column = dataFrame.getColumn(i);
+            result[py::str(column->getHeader())] = columnArray(column);
+        }
+    } else {
+        for (const auto& name : names) {
+            result[py::str(name)] = columnArray(findColumn(dataFrame, name));
+        }
+    }
+    return result;
+}
+
+/**
+ * The columns side by side as a rows x columns float32 array, all columns except the index
+ * column if no names are given. The array is column major so that each column is one contiguous
+ * copy, the columns are separate buffers and can not be viewed as one array.
+ */
+py::array_t<float, py::array::f_style> matrix(const DataFrame& dataFrame,
+                                              const std::vector<std::string>& names) {
+    std::vector<std::shared_ptr<const Column>> selected;
+    if (names.empty()) {
+        const auto indexColumn = dataFrame.getIndexColumn();
+        for (size_t i = 0; i < dataFrame.getNumberOfColumns(); ++i) {
+            auto column = dataFrame.getColumn(i);
+            if (column != indexColumn) selected.push_back(column);
+        }
+    } else {
+        for (const auto& name : names) selected.push_back(findColumn(dataFrame, name));
+    }
+
+    const size_t nrRows = dataFrame.getNumberOfRows();
+    py::array_t<float, py::array::f_style> result({nrRows, selected.size()});
+    float* dst = result.mutable_data();
+    for (size_t j = 0; j < selected.size(); ++j) {
+        const ColumnView<float> values(selected[j]);
+        if (values.size() != nrRows) {
+            throw Exception("Column '" + selected[j]->getHeader() + "' has " +
+                                std::to_string(values.size()) + " rows, expected " +
+                                std::to_string(nrRows),
+                            IVW_CONTEXT_CUSTOM("ivwmolecularchargetransitions"));
+        }
+        std::copy(values.begin(), values.end(), dst + j * nrRows);
+    }
+    return result;
+}
+
+py::array_t<float, py::array::f_style> chargeTransferMatrix(const DataFrame& dataFrame) {
+    auto result = matrix(dataFrame, {});
+    if (result.shape(0) != result.shape(1)) {
+        throw Exception("Charge transfer matrix is not square (" +
+                            std::to_string(result.shape(0)) + " rows, " +
+                            std::to_string(result.shape(1)) + " columns)",
+                        IVW_CONTEXT_CUSTOM("ivwmolecularchargetransitions"));
+    }
+    return result;
+}
+
+}  // namespace
+
+}  // namespace inviwo
+
+PYBIND11_MODULE(ivwmolecularchargetransitions, m) {
+    using namespace inviwo;
+
+    // The DataFrame type and its outport are bound in ivwdataframe
+    py::module::import("ivwdataframe");
+
+    // The outports of ComputeChargeTransfer. Without this, pybind11 gives them as the static type
+    // Outport, which has no getData()
+    py::class_<LazyDataOutport<DataFrame>, DataOutport<DataFrame>,
+               PortPtr<LazyDataOutport<DataFrame>>>(m, "LazyDataFrameOutport")
+        .def("isPending", &LazyDataOutport<DataFrame>::isPending);
+
+    m.doc() = R"doc(
+        Bulk access to the DataFrames of the MolecularChargeTransitions module, e.g. the outputs
+        of ComputeChargeTransfer, SumChargeInSegmentedRegions and ClusterStatistics, as NumPy
+        arrays. One call gives a whole table instead of one call per value.
+        )doc";
+
+    m.def("column",
+          [](const DataFrame& dataFrame, const std::string& name) {
+              return columnArray(findColumn(dataFrame, name));
+          },
+          py::arg("dataFrame"), py::arg("name"),
+          R"doc(
+        A read only array referring to the column buffer, nothing is copied. Quantized columns
+        are decoded to a float32 copy.
+        )doc");
+
+    m.def("columns", &columns, py::arg("dataFrame"),
+          py::arg("names") = std::vector<std::string>{},
+          R"doc(
+        A dict of column name to column array (see column) of the given columns, or of all
+        columns including the index column if no names are given.
+        )doc");
+
+    m.def("matrix", &matrix, py::arg("dataFrame"), py::arg("names") = std::vector<std::string>{},
+          R"doc(
+        The given columns, or all columns except the index column, as a 2-D float32 array of
+        rows x columns. Made with one copy per column since the columns are separate buffers.
+        )doc");
+
+    m.def("chargeTransferMatrix", &chargeTransferMatrix, py::arg("dataFrame"),
+          R"doc(
+        The charge transfer matrix of ComputeChargeTransfer as a square 2-D float32 array, where
+        [i, j] is row i of the matrix column j + 1.
+        )doc");
+}
@@ -29,6 +29,11 @@
 #pragma once
 
 #include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/deterministicreduction.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <algorithm>
 #include <vector>
 
 #include <inviwo/core/common/inviwoapplication.h>
@@ -46,12 +51,247 @@ namespace inviwo {
  *     * particleCharges is a vector with the charges for the particle state.
  *
  * The input vectors must have the same length!
+ *
+ * The second mode computes the matrix from the hole and particle densities instead of the subgroup
+ * totals, using the overlap of the densities per segmented region (accumulateRegionOverlap).
  */
 class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ChargeTransferMatrix {
 public:
     static std::pair<std::vector<std::vector<float>>, std::vector<float>>
     computeTransposedChargeTransferAndChargeDifference(std::vector<float> holeCharges,
                                                        std::vector<float> particleCharges);
+
+    /**
+     * How the hole charge of a region that does not overlap at voxel level is distributed over
+     * the particle charge that does not overlap (free particle charge), including that of the
+     * region itself.
+     *
+     *     * Proportional, to all regions in proportion to their free particle charge.
+     *     * Adjacent, only to the region itself and the regions sharing voxel faces with it, in
+     *       proportion to their free particle charge. Falls back to Proportional if none of them
+     *       has free particle charge.
+     */
+    enum class Coupling { Proportional, Adjacent };
+
+    /**
+     * Overlap terms of the hole and particle densities per region, accumulated in one pass over
+     * the volumes (see accumulateRegionOverlap).
+     *
+     *     * hole and particle are the integrated charges per region.
+     *     * overlap is the integral of min(hole, particle) per region, the charge that stays in
+     *       place at voxel level.
+     *     * faces is the number of shared voxel faces between region i and j, at i * nrRegions + j
+     *       (symmetric, empty if not requested).
+     */
+    struct RegionOverlap {
+        size_t nrRegions = 0;
+        std::vector<float> hole;
+        std::vector<float> particle;
+        std::vector<float> overlap;
+        std::vector<float> faces;
+    };
+
+    /**
+     * Streams the hole and particle densities together over the segmentation, in parallel over
+     * z-slabs. Labels must be in [firstLabel, firstLabel + nrRegions). As in SegmentedRegionSum
+     * the charge of a region is the sum of its voxel values, and the result does not depend on
+     * nrThreads. The hole and particle values are multiplied by scale.x and scale.y before the
+     * overlap is taken, e.g. to normalize both densities to a total charge of one.
+     */
+    template <typename HoleType, typename ParticleType, typename LabelType>
+    static RegionOverlap accumulateRegionOverlap(const HoleType* hole, const ParticleType* particle,
+                                                 const LabelType* labels, size3_t dims,
+                                                 size_t firstLabel, size_t nrRegions, bool faces,
+                                                 const dvec2& scale = dvec2{1.0},
+                                                 size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Sums up the overlap terms of the regions in each group, groups[i] are the region indices of
+     * group i. Use to go from segmented regions to subgroups.
+     */
+    static RegionOverlap groupRegions(const RegionOverlap& regions,
+                                      const std::vector<std::vector<size_t>>& groups);
+
+    /**
+     * Charge transfer matrix ("vector of columns", as above) and charge difference from the
+     * overlap terms. The overlap of a region stays on the diagonal, and the rest of its hole
+     * charge is distributed according to coupling, so each column sums up to the hole charge of
+     * the region. Where the densities coincide within each region this is the same as the
+     * heuristic on the subgroup charges, hole and particle charge that are apart within a region
+     * are also transferred to other regions.
+     */
+    static std::pair<std::vector<std::vector<float>>, std::vector<float>>
+    computeTransposedChargeTransferAndChargeDifference(const RegionOverlap& regions,
+                                                       Coupling coupling);
+
+    /**
+     * Settings of the optimal transport mode. The transport is solved with entropic
+     * regularization (Sinkhorn iterations), epsilon is the regularization relative to the largest
+     * cost, smaller values are closer to the exact (earth mover's) transport but need more
+     * iterations. The iterations stop when the acceptor charges are met within tolerance, relative
+     * to the transferred charge. warmStartBlockSize is the number of consecutive members of an
+     * ensemble that are warm started from each other (see computeEnsembleOptimalTransport).
+     */
+    struct TransportSettings {
+        double epsilon = 0.01;
+        double tolerance = 1e-6;
+        size_t maxIterations = 5000;
+        size_t warmStartBlockSize = 256;
+    };
+
+    /**
+     * Scaling vectors of a Sinkhorn solution, one element per subgroup. Passing the state of a
+     * similar problem (e.g. the previous member of a scan) warm starts the solver.
+     */
+    struct TransportState {
+        std::vector<double> donorScaling;
+        std::vector<double> acceptorScaling;
+        size_t iterations = 0;  // Of the last solve
+    };
+
+    /**
+     * Charge transfer matrix ("vector of columns", as above) and charge difference where the
+     * charge of the donors (hole - particle > 0) is moved to the acceptors at the least total
+     * cost, instead of in proportion to the acceptor charge. cost has n * n elements, the cost of
+     * moving a unit of charge from subgroup d to subgroup a is at d * n + a, e.g. the distance
+     * between the subgroups. The diagonal is min(hole, particle) as for the heuristic, and if the
+     * total hole and particle charges differ the acceptor charges are scaled to the donated
+     * charge, so each column sums up to the hole charge.
+     */
+    static std::pair<std::vector<std::vector<float>>, std::vector<float>>
+    computeTransposedOptimalTransport(const std::vector<float>& holeCharges,
+                                      const std::vector<float>& particleCharges,
+                                      const std::vector<double>& cost,
+                                      const TransportSettings& settings,
+                                      TransportState* state = nullptr);
+
+    /**
+     * The heuristic charge transfer (as above) of all members of an ensemble, in parallel.
+     * holeCharges[i] and particleCharges[i] are the charge columns of subgroup i (one value per
+     * member). Returns the n * n charge transfer columns, the transfer from d to a of each member
+     * is in column d * n + a. Members without donors or acceptors only get the diagonal, like in
+     * computeEnsembleOptimalTransport, instead of throwing.
+     */
+    static std::vector<std::vector<float>> computeEnsembleChargeTransfer(
+        const std::vector<const float*>& holeCharges,
+        const std::vector<const float*>& particleCharges, size_t nrMembers,
+        size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Optimal transport of all members of an ensemble, with the same arguments and result as
+     * computeEnsembleChargeTransfer. The members are split into fixed blocks of
+     * settings.warmStartBlockSize members that are solved in parallel, each member warm started
+     * from the solution of the previous member in its block. The blocks do not depend on
+     * nrThreads, so neither does the result.
+     */
+    static std::vector<std::vector<float>> computeEnsembleOptimalTransport(
+        const std::vector<const float*>& holeCharges,
+        const std::vector<const float*>& particleCharges, size_t nrMembers,
+        const std::vector<double>& cost, const TransportSettings& settings,
+        size_t nrThreads = util::defaultThreadCount());
 };
 
+template <typename HoleType, typename ParticleType, typename LabelType>
+ChargeTransferMatrix::RegionOverlap ChargeTransferMatrix::accumulateRegionOverlap(
+    const HoleType* hole, const ParticleType* particle, const LabelType* labels, size3_t dims,
+    size_t firstLabel, size_t nrRegions, bool faces, const dvec2& scale, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("ChargeTransferMatrix::accumulateRegionOverlap");
+    if (nrRegions == 0) {
+        throw Exception("Seem to be no segmented regions in the segmented volume...",
+                        IVW_CONTEXT_CUSTOM("ChargeTransferMatrix"));
+    }
+
+    struct Accumulator {
+        std::vector<double> hole, particle, overlap;
+    };
+
+    // The sums are reduced over fixed blocks of z slices, so they do not depend on the number of
+    // threads. The faces are integer counts and are summed per thread instead.
+    const size_t sliceSize = dims.x * dims.y;
+    const auto blockSlices =
+        std::max<size_t>(1, (size_t{1} << 16) / std::max<size_t>(1, sliceSize));
+    nrThreads = std::max<size_t>(1, std::min(nrThreads, dims.z));
+    std::vector<std::vector<double>> faceCounts(nrThreads);
+
+    const auto region = [&](size_t i) {
+        const auto r = static_cast<size_t>(labels[i]) - firstLabel;
+        if (r >= nrRegions) {
+            throw Exception("Segmentation label outside of the segmented regions range",
+                            IVW_CONTEXT_CUSTOM("ChargeTransferMatrix"));
+        }
+        return r;
+    };
+
+    const auto accumulateBlock = [&](size_t thread, size_t zBegin, size_t zEnd) {
+        Accumulator acc;
+        acc.hole.assign(nrRegions, 0.0);
+        acc.particle.assign(nrRegions, 0.0);
+        acc.overlap.assign(nrRegions, 0.0);
+        auto& faceCount = faceCounts[thread];
+        if (faces && faceCount.empty()) faceCount.assign(nrRegions * nrRegions, 0.0);
+
+        const auto addFace = [&](size_t r, size_t neighbour) {
+            const auto s = region(neighbour);
+            if (r != s) {
+                faceCount[r * nrRegions + s] += 1.0;
+                faceCount[s * nrRegions + r] += 1.0;
+            }
+        };
+
+        for (size_t z = zBegin; z < zEnd; z++) {
+            for (size_t y = 0; y < dims.y; y++) {
+                for (size_t x = 0; x < dims.x; x++) {
+                    const size_t i = z * sliceSize + y * dims.x + x;
+                    const auto r = region(i);
+                    const auto h = scale.x * static_cast<double>(hole[i]);
+                    const auto p = scale.y * static_cast<double>(particle[i]);
+                    acc.hole[r] += h;
+                    acc.particle[r] += p;
+                    acc.overlap[r] += std::min(h, p);
+
+                    if (faces) {
+                        if (x + 1 < dims.x) addFace(r, i + 1);
+                        if (y + 1 < dims.y) addFace(r, i + dims.x);
+                        if (z + 1 < dims.z) addFace(r, i + sliceSize);
+                    }
+                }
+            }
+        }
+        return acc;
+    };
+    const auto mergeBlocks = [nrRegions](Accumulator& a, const Accumulator& b) {
+        for (size_t r = 0; r < nrRegions; r++) {
+            a.hole[r] += b.hole[r];
+            a.particle[r] += b.particle[r];
+            a.overlap[r] += b.overlap[r];
+        }
+    };
+    const auto total = util::deterministicReduce(dims.z, blockSlices, Accumulator{},
+                                                 accumulateBlock, mergeBlocks, nrThreads);
+
+    std::vector<double> totalFaces(faces ? nrRegions * nrRegions : 0, 0.0);
+    for (const auto& faceCount : faceCounts) {
+        for (size_t i = 0; i < faceCount.size(); i++) {
+            totalFaces[i] += faceCount[i];
+        }
+    }
+
+    const auto toFloat = [](const std::vector<double>& src) {
+        return std::vector<float>(src.begin(), src.end());
+    };
+
+    RegionOverlap result;
+    result.nrRegions = nrRegions;
+    result.hole = toFloat(total.hole);
+    result.particle = toFloat(total.particle);
+    result.overlap = toFloat(total.overlap);
+    result.faces = toFloat(totalFaces);
+
+    const auto nrVoxels = sliceSize * dims.z;
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("bytes", static_cast<double>(nrVoxels * (sizeof(HoleType) + sizeof(ParticleType) +
+                                                         sizeof(LabelType))));
+    return result;
+}
+
 }  // namespace inviwo
@@ -0,0 +1,74 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Groups the members of an ensemble by their cluster id.
+ *
+ *     * clusters is the cluster id for each member.
+ *     * indices is the (row) index of each member, must be same length as clusters.
+ *
+ * Returns a map from cluster id to the indices of all members in that cluster, in the order they
+ * appear in the input. The pointer overload groups n members without requiring the input to be
+ * copied into vectors first.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ClusterGrouping {
+public:
+    static std::map<int, std::vector<uint32_t>> groupByCluster(
+        const std::vector<int>& clusters, const std::vector<uint32_t>& indices);
+    static std::map<int, std::vector<uint32_t>> groupByCluster(const int* clusters,
+                                                               const uint32_t* indices, size_t n);
+
+    /**
+     * The same grouping in compressed form, with all members in one array: the members of
+     * cluster clusters[i] are members[offsets[i]] to members[offsets[i + 1]], in input order, and
+     * the clusters are sorted by id.
+     */
+    struct Ranges {
+        std::vector<int> clusters;
+        std::vector<size_t> offsets{0};
+        std::vector<uint32_t> members;
+
+        size_t size() const { return clusters.size(); }
+        size_t clusterSize(size_t i) const { return offsets[i + 1] - offsets[i]; }
+        const uint32_t* begin(size_t i) const { return members.data() + offsets[i]; }
+        const uint32_t* end(size_t i) const { return members.data() + offsets[i + 1]; }
+    };
+    static Ranges groupRanges(const int* clusters, const uint32_t* indices, size_t n);
+};
+
+}  // namespace inviwo
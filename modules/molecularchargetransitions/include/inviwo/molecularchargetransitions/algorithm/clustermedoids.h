@@ -0,0 +1,81 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/algorithm/clustergrouping.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Most representative member (medoid) of each cluster of an ensemble, the member with the
+ * smallest sum of Euclidean distances to the other members of its cluster.
+ *
+ *     * features are the feature columns, e.g. the hole and particle charges of each subgroup.
+ *       Member m has the feature vector features[f][m].
+ *     * ranges are the members of each cluster, see ClusterGrouping::groupRanges.
+ *
+ * Small clusters are searched by brute force over all pairs. Larger clusters use the trimmed
+ * search of Newling and Fleuret (2017): the candidates are visited in a random order, and a
+ * candidate is skipped if a lower bound on its distance sum, from the triangle inequality and the
+ * candidates computed so far, is larger than the best sum so far. Both give the exact medoid, the
+ * trimmed search computes far fewer than all distances for low dimensional features. The clusters
+ * are processed in parallel, largest first.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ClusterMedoids {
+public:
+    struct Settings {
+        size_t bruteForceSize = 256;  // Clusters up to this size are searched by brute force
+        uint32_t seed = 0;            // Seed of the candidate order of the trimmed search
+    };
+
+    struct Medoid {
+        uint32_t member = 0;        // The medoid, from the members in ranges
+        double meanDistance = 0.0;  // Mean distance from the medoid to the members of the cluster
+        size_t candidates = 0;      // Number of members whose distance sum was computed
+    };
+
+    static std::vector<Medoid> compute(const std::vector<const float*>& features,
+                                       const ClusterGrouping::Ranges& ranges,
+                                       const Settings& settings,
+                                       size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Medoid of a single cluster of k members, with the feature vectors of the members row by
+     * row in points (k * nrFeatures). Returns the local index of the medoid in member.
+     */
+    static Medoid medoid(const std::vector<float>& points, size_t nrFeatures, size_t k,
+                         const Settings& settings);
+};
+
+}  // namespace inviwo
@@ -0,0 +1,123 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Index over the merge tree of a hierarchical clustering of an ensemble, to get the clusters at
+ * any level of detail without clustering again.
+ *
+ * The tree is given as a linkage (as from scipy or the children of sklearn's
+ * AgglomerativeClustering): merge i joins the nodes first[i] and second[i] at height heights[i]
+ * into node n + i, where nodes 0 to n-1 are the n members. The members are laid out in leaf order,
+ * so every node covers a contiguous range of leaf positions.
+ *
+ * A cut at level m applies the first m merges, which gives n - m clusters. Each cluster is the
+ * node of the tree, so cluster ids do not change between levels for clusters that are not split
+ * or merged. Heights that decrease (inversions, e.g. centroid linkage) are replaced with the
+ * running maximum, so that the levels are ordered by height as well.
+ *
+ *     * members of a cluster are a contiguous range of leafOrder, O(1).
+ *     * cluster of a member at a level climbs skew-binary jump pointers, O(log depth), with a
+ *       linear size index.
+ *     * clusters at a level are found top down from the root, O(number of clusters).
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API DendrogramIndex {
+public:
+    DendrogramIndex(const std::vector<size_t>& first, const std::vector<size_t>& second,
+                    const std::vector<double>& heights);
+
+    size_t nrMembers() const { return nrMembers_; }
+    size_t nrMerges() const { return nrMembers_ - 1; }
+    size_t root() const { return parent_.size() - 1; }
+
+    /**
+     * Number of merges at or below the given height, the level of a cut at that height.
+     */
+    size_t level(double height) const;
+    /**
+     * Level with the given number of clusters (clamped to [1, nrMembers]).
+     */
+    size_t levelOfClusters(size_t nrClusters) const;
+
+    /**
+     * Cluster (node) of member at the given level.
+     */
+    size_t cluster(size_t member, size_t level) const;
+
+    /**
+     * Clusters (nodes) at the given level, in leaf order.
+     */
+    std::vector<size_t> clusters(size_t level) const;
+
+    /**
+     * Cluster number (1 to number of clusters, in leaf order) of each member at the given level.
+     */
+    std::vector<int> labels(size_t level) const;
+
+    /**
+     * Range [begin, end) of leaf positions covered by node, the members are
+     * leafOrder()[begin] to leafOrder()[end - 1].
+     */
+    std::pair<size_t, size_t> leafRange(size_t node) const { return {begin_[node], end_[node]}; }
+    const std::vector<size_t>& leafOrder() const { return leafOrder_; }
+    size_t leafPosition(size_t member) const { return begin_[member]; }
+
+    /**
+     * Height of the merge that created node, zero for members.
+     */
+    double height(size_t node) const {
+        return node < nrMembers_ ? 0.0 : heights_[node - nrMembers_];
+    }
+
+private:
+    // Node is created by one of the first level merges
+    bool exists(size_t node, size_t level) const {
+        return node < nrMembers_ || node - nrMembers_ < level;
+    }
+
+    size_t nrMembers_;
+    std::vector<double> heights_;
+    std::vector<uint32_t> first_;
+    std::vector<uint32_t> second_;
+    std::vector<uint32_t> parent_;
+    std::vector<uint32_t> jump_;
+    std::vector<uint32_t> begin_;
+    std::vector<uint32_t> end_;
+    std::vector<size_t> leafOrder_;
+};
+
+}  // namespace inviwo
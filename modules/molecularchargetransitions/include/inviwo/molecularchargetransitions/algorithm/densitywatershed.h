@@ -0,0 +1,170 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Grid based watershed (Bader) segmentation of a density volume. Every voxel points to the
+ * neighbor (26-neighborhood) with the steepest ascent, (value - value of voxel) / distance, and
+ * belongs to the basin of the maximum its ascent path ends in. The boundaries between the basins
+ * approximate the zero-flux surfaces of the density.
+ *
+ * Only neighbors that are larger in the order (value, voxel index) are considered, which makes
+ * the ascent paths end in a single voxel on plateaus. Ties in ascent go to the larger index, so
+ * the result does not depend on the number of threads.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API DensityWatershed {
+public:
+    struct Basins {
+        std::vector<uint32_t> labels;  // Basin of each voxel, x fastest
+        std::vector<size_t> maxima;    // Voxel index of the maximum of each basin, ascending
+    };
+
+    /**
+     * Watershed segmentation of density (dims voxels, x fastest). indexToWorld is the basis of
+     * the volume, used for the distances to the neighbors.
+     */
+    template <typename T>
+    static Basins segment(const T* density, size3_t dims, const dmat3& indexToWorld,
+                          size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * The index of the voxel each voxel ascends to. The parallel ascent computation of segment.
+     */
+    template <typename T>
+    static std::vector<uint32_t> ascentPointers(const T* density, size3_t dims,
+                                                const dmat3& indexToWorld,
+                                                size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Follows the ascent pointers to the maxima. Each thread compresses the paths within its
+     * z-slab, the paths leaving a slab are then merged with union-find on the voxels where they
+     * cross slab boundaries, after which every voxel is at most two steps from its maximum.
+     */
+    static Basins resolve(std::vector<uint32_t> parent, size3_t dims,
+                          size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Atom nearest to the maximum of each basin. indexToWorld and offset map a voxel index to
+     * world space (world = indexToWorld * index + offset), where the atom positions are given.
+     * Ties go to the atom with the smallest index.
+     */
+    static std::vector<uint16_t> nearestAtoms(const Basins& basins, size3_t dims,
+                                              const dmat3& indexToWorld, const dvec3& offset,
+                                              const std::vector<dvec3>& positions);
+
+    /**
+     * Label volume from the basins, where basin i gets the label basinLabels[i]. Without
+     * basinLabels, the basin index is used as label.
+     */
+    static std::vector<uint16_t> labels(const Basins& basins,
+                                        const std::vector<uint16_t>& basinLabels = {},
+                                        size_t nrThreads = util::defaultThreadCount());
+
+private:
+    struct Neighbor {
+        ivec3 step;
+        std::ptrdiff_t offset;
+        double invDistance;
+    };
+    static std::array<Neighbor, 26> neighborhood(size3_t dims, const dmat3& indexToWorld);
+};
+
+template <typename T>
+DensityWatershed::Basins DensityWatershed::segment(const T* density, size3_t dims,
+                                                   const dmat3& indexToWorld, size_t nrThreads) {
+    return resolve(ascentPointers(density, dims, indexToWorld, nrThreads), dims, nrThreads);
+}
+
+template <typename T>
+std::vector<uint32_t> DensityWatershed::ascentPointers(const T* density, size3_t dims,
+                                                       const dmat3& indexToWorld,
+                                                       size_t nrThreads) {
+    const auto neighbors = neighborhood(dims, indexToWorld);
+    const size_t sx = dims.x;
+    const size_t sxy = dims.x * dims.y;
+    std::vector<uint32_t> parent(glm::compMul(dims));
+
+    // Starting from a slope of zero at the voxel itself, the neighbors that are smaller in the
+    // order (value, index) can not win
+    const auto ascend = [&](size_t v, auto&& isInside) {
+        const auto value = static_cast<double>(density[v]);
+        size_t best = v;
+        double bestSlope = 0.0;
+        for (const auto& n : neighbors) {
+            if (!isInside(n)) continue;
+            const size_t w = v + n.offset;
+            const double slope = (static_cast<double>(density[w]) - value) * n.invDistance;
+            if (slope > bestSlope || (slope == bestSlope && w > best)) {
+                best = w;
+                bestSlope = slope;
+            }
+        }
+        return static_cast<uint32_t>(best);
+    };
+    const auto always = [](const Neighbor&) { return true; };
+    const auto inside = [](size_t i, int step, size_t size) {
+        return (step >= 0 || i > 0) && (step <= 0 || i + 1 < size);
+    };
+
+    util::parallelForRanges(dims.z, nrThreads, [&](size_t, size_t zBegin, size_t zEnd) {
+        for (size_t z = zBegin; z < zEnd; z++) {
+            for (size_t y = 0; y < dims.y; y++) {
+                const size_t row = y * sx + z * sxy;
+                const auto boundary = [&](size_t x) {
+                    parent[row + x] = ascend(row + x, [&](const Neighbor& n) {
+                        return inside(x, n.step.x, dims.x) && inside(y, n.step.y, dims.y) &&
+                               inside(z, n.step.z, dims.z);
+                    });
+                };
+                if (z == 0 || z + 1 == dims.z || y == 0 || y + 1 == dims.y || dims.x < 3) {
+                    for (size_t x = 0; x < dims.x; x++) boundary(x);
+                    continue;
+                }
+                boundary(0);
+                for (size_t x = 1; x + 1 < dims.x; x++) {
+                    parent[row + x] = ascend(row + x, always);
+                }
+                boundary(dims.x - 1);
+            }
+        }
+    });
+    return parent;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,76 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/algorithm/clustergrouping.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <cstddef>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Mean and quantiles of columns per group of members, e.g. of every entry of the charge transfer
+ * matrices of an ensemble per cluster.
+ *
+ *     * columns are the columns, member m has the value columns[c][m].
+ *     * ranges are the members of each group, see ClusterGrouping::groupRanges.
+ *     * quantiles are the quantiles to compute, in [0, 1] (0.5 is the median).
+ *
+ * The values of a column in a group are gathered once and the quantiles are selected with
+ * nth_element in increasing order, each on the part that is left after the previous one, so no
+ * group is sorted. The column and group pairs are processed in parallel. The quantiles
+ * interpolate linearly between the order statistics, as the default of numpy.quantile.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API GroupedColumnStatistics {
+public:
+    /**
+     * The statistics of column c in group g are at g * nrColumns + c.
+     */
+    struct Result {
+        size_t nrColumns = 0;
+        size_t nrGroups = 0;
+        std::vector<float> mean;
+        std::vector<std::vector<float>> quantiles;  // One for each of the given quantiles
+    };
+
+    static Result compute(const std::vector<const float*>& columns,
+                          const ClusterGrouping::Ranges& ranges,
+                          const std::vector<double>& quantiles,
+                          size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Quantiles of values, which are reordered. Returns NaN for empty values.
+     */
+    static std::vector<float> quantiles(std::vector<float>& values,
+                                        const std::vector<double>& quantiles);
+};
+
+}  // namespace inviwo
@@ -0,0 +1,183 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
+#include <inviwo/core/common/inviwoapplication.h>
+
+namespace inviwo {
+
+/**
+ * Locality descriptors of the electronic transitions of an ensemble, computed directly from the
+ * hole and particle charges of the subgroups without the charge transfer matrices. They are
+ * closed forms for the matrix of the subgroup charge heuristic in ChargeTransferMatrix, where the
+ * charge donated by a subgroup d (hole - particle > 0) goes to the acceptors a in proportion to
+ * their particle - hole charge:
+ *
+ *     * measureOfLocality is the trace of the matrix, sum of min(hole, particle).
+ *     * transferredCharge is the sum of the off-diagonal elements, the charge donated in total.
+ *     * donors and acceptors are the number of subgroups with hole > particle and hole <= particle.
+ *     * ctDistance is the distance between the donated charge weighted centroid of the donor
+ *       positions and the accepted charge weighted centroid of the acceptor positions, and
+ *       ctRmsDistance the root mean square distance of the transferred charge, i.e. of the
+ *       off-diagonal elements weighted by |position d - position a|^2. Both are only computed if
+ *       subgroup positions are given, and are zero for members without any transferred charge.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API LocalityDescriptors {
+public:
+    struct Descriptors {
+        std::vector<float> measureOfLocality;
+        std::vector<float> transferredCharge;
+        std::vector<int> donors;
+        std::vector<int> acceptors;
+        std::vector<float> ctDistance;
+        std::vector<float> ctRmsDistance;
+    };
+
+    /**
+     * Descriptors of nrMembers members, holeCharges[i] and particleCharges[i] are the charge
+     * columns of subgroup i (one value per member). positions is either empty or has one position
+     * per subgroup. The members are processed in blocks in parallel, with one pass over the
+     * columns per block.
+     */
+    template <typename T>
+    static Descriptors compute(const std::vector<const T*>& holeCharges,
+                               const std::vector<const T*>& particleCharges, size_t nrMembers,
+                               const std::vector<dvec3>& positions = {},
+                               size_t nrThreads = util::defaultThreadCount());
+
+private:
+    static constexpr size_t blockSize = 256;
+
+    // Sums per member of a block, over all subgroups
+    struct Block {
+        std::array<float, blockSize> locality, donated, accepted;
+        std::array<int, blockSize> donors;
+        // Charge weighted sums of the donor and acceptor positions and squared positions
+        std::array<std::array<float, blockSize>, 4> donorPosition, acceptorPosition;
+    };
+
+    static void finish(const Block& block, size_t begin, size_t size, size_t nrSubgroups,
+                       bool withPositions, Descriptors& descriptors);
+};
+
+template <typename T>
+LocalityDescriptors::Descriptors LocalityDescriptors::compute(
+    const std::vector<const T*>& holeCharges, const std::vector<const T*>& particleCharges,
+    size_t nrMembers, const std::vector<dvec3>& positions, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("LocalityDescriptors::compute");
+    const auto nrSubgroups = holeCharges.size();
+    if (nrSubgroups == 0 || particleCharges.size() != nrSubgroups) {
+        throw Exception("Need the same (non-zero) number of hole and particle charge columns",
+                        IVW_CONTEXT_CUSTOM("LocalityDescriptors"));
+    }
+    const bool withPositions = !positions.empty();
+    if (withPositions && positions.size() != nrSubgroups) {
+        throw Exception("Need one position per subgroup",
+                        IVW_CONTEXT_CUSTOM("LocalityDescriptors"));
+    }
+
+    // Positions relative to their mean, which keeps the single precision sums of squared
+    // positions accurate (the distances do not depend on the origin)
+    std::vector<std::array<float, 4>> centered(positions.size());
+    if (withPositions) {
+        dvec3 mean{0.0};
+        for (const auto& p : positions) mean += p;
+        mean = mean / static_cast<double>(positions.size());
+        for (size_t i = 0; i < positions.size(); i++) {
+            const auto p = positions[i] - mean;
+            centered[i] = {static_cast<float>(p.x), static_cast<float>(p.y),
+                           static_cast<float>(p.z), static_cast<float>(glm::dot(p, p))};
+        }
+    }
+
+    Descriptors descriptors;
+    descriptors.measureOfLocality.resize(nrMembers);
+    descriptors.transferredCharge.resize(nrMembers);
+    descriptors.donors.resize(nrMembers);
+    descriptors.acceptors.resize(nrMembers);
+    if (withPositions) {
+        descriptors.ctDistance.resize(nrMembers);
+        descriptors.ctRmsDistance.resize(nrMembers);
+    }
+
+    const auto nrBlocks = (nrMembers + blockSize - 1) / blockSize;
+    util::parallelForRanges(nrBlocks, nrThreads, [&](size_t, size_t blockBegin, size_t blockEnd) {
+        auto block = std::make_unique<Block>();
+        for (size_t b = blockBegin; b < blockEnd; b++) {
+            const auto begin = b * blockSize;
+            const auto size = std::min(blockSize, nrMembers - begin);
+            *block = Block{};
+            auto& locality = block->locality;
+            auto& donated = block->donated;
+            auto& accepted = block->accepted;
+            auto& donors = block->donors;
+
+            for (size_t i = 0; i < nrSubgroups; i++) {
+                const T* hole = holeCharges[i] + begin;
+                const T* particle = particleCharges[i] + begin;
+                for (size_t k = 0; k < size; k++) {
+                    const auto h = static_cast<float>(hole[k]);
+                    const auto p = static_cast<float>(particle[k]);
+                    locality[k] += std::min(h, p);
+                    donated[k] += std::max(h - p, 0.0f);
+                    accepted[k] += std::max(p - h, 0.0f);
+                    donors[k] += h > p ? 1 : 0;
+                }
+                if (!withPositions) continue;
+                for (size_t c = 0; c < 4; c++) {
+                    const auto x = centered[i][c];
+                    auto& donorPosition = block->donorPosition[c];
+                    auto& acceptorPosition = block->acceptorPosition[c];
+                    for (size_t k = 0; k < size; k++) {
+                        const auto h = static_cast<float>(hole[k]);
+                        const auto p = static_cast<float>(particle[k]);
+                        donorPosition[k] += std::max(h - p, 0.0f) * x;
+                        acceptorPosition[k] += std::max(p - h, 0.0f) * x;
+                    }
+                }
+            }
+            finish(*block, begin, size, nrSubgroups, withPositions, descriptors);
+        }
+    });
+
+    timer.count("rows", static_cast<double>(nrMembers));
+    timer.count("bytes", static_cast<double>(2 * nrSubgroups * nrMembers * sizeof(T)));
+    return descriptors;
+}
+
+}  // namespace inviwo
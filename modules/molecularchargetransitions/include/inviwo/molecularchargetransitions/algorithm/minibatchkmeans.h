@@ -0,0 +1,91 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Mini-batch k-means (Sculley 2010) of the members of an ensemble, as a first clustering stage
+ * for ensembles too large for hierarchical clustering. The micro-clusters it gives are few enough
+ * to be clustered hierarchically (CreateDendrogram), and a cut of that dendrogram is mapped back
+ * to the members through the micro-cluster of each member (DendrogramCut).
+ *
+ *     * features are the feature columns, e.g. the hole and particle charges of each subgroup.
+ *       Member m has the feature vector features[f][m], for nrMembers members.
+ *
+ * The centers start from k-means++ on a random sample of the members, and each step assigns a
+ * random batch of members to the nearest center (in parallel) and moves the centers toward them
+ * with a per center learning rate. Only the centers and one batch are kept in memory besides the
+ * labels. The members are then assigned to the final centers chunk by chunk, and the centers are
+ * set to the means of their members. The result only depends on the seed, not on the number of
+ * threads.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API MiniBatchKMeans {
+public:
+    struct Settings {
+        size_t nrClusters = 256;
+        size_t batchSize = 4096;
+        size_t nrBatches = 200;
+        uint32_t seed = 0;
+    };
+
+    /**
+     * Micro-clusters without members are removed, so there can be fewer than
+     * Settings::nrClusters. centers are the means of the members, row by row (nrClusters *
+     * nrFeatures), and inertia is the sum of the squared distances from the members to the
+     * centers they were assigned to.
+     */
+    struct Result {
+        size_t nrFeatures = 0;
+        std::vector<float> centers;
+        std::vector<size_t> sizes;
+        std::vector<uint32_t> labels;
+        double inertia = 0.0;
+
+        size_t nrClusters() const { return sizes.size(); }
+    };
+
+    static Result compute(const std::vector<const float*>& features, size_t nrMembers,
+                          const Settings& settings,
+                          size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Index of the center nearest to point, with centers row by row.
+     */
+    static size_t nearest(const float* point, const std::vector<float>& centers,
+                          size_t nrFeatures);
+};
+
+}  // namespace inviwo
@@ -0,0 +1,67 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Voronoi segmentation of a volume by its atoms, every voxel gets the index of the nearest atom.
+ *
+ *     * dims are the volume dimensions.
+ *     * indexToWorld and offset map a voxel index to world space (world = indexToWorld * index +
+ *       offset), where the atom positions are given.
+ *     * radii are optional atomic radii (same length as positions). If given, the power distance
+ *       |x - p|^2 - r^2 is used, which moves the boundaries towards the smaller atoms.
+ *
+ * The atoms are put in a uniform grid. The volume is processed in blocks of voxels, in parallel
+ * over z-slabs of blocks, and only the atoms that can be nearest to a voxel in the block (found
+ * from the nearest atom to the block center) are tested for each voxel. Ties go to the atom with
+ * the smallest index.
+ * Returns labels 0 to nrAtoms - 1, x fastest.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API NearestAtomSegmentation {
+public:
+    static std::vector<uint16_t> segment(size3_t dims, const dmat3& indexToWorld,
+                                         const dvec3& offset, const std::vector<dvec3>& positions,
+                                         const std::vector<double>& radii = {},
+                                         size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Covalent radius in Ångström (Cordero et al. 2008) for atomic numbers 1 (H) to 86 (Rn).
+     */
+    static double covalentRadius(int atomicNumber);
+};
+
+}  // namespace inviwo
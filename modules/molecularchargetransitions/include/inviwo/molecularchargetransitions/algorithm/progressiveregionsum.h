@@ -0,0 +1,229 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <inviwo/core/common/inviwoapplication.h>
+
+namespace inviwo {
+
+/**
+ * Approximate sums of a volume per segmented region, computed from a coarse level of a
+ * resolution pyramid, to give a preview before the exact SegmentedRegionSum is done.
+ *
+ * The label pyramid only depends on the segmentation, and can be reused for all charge densities
+ * on the same grid. Level l has blocks of 2^l voxels along each axis, and each block gets the
+ * majority label of its eight children at level l - 1. Blocks containing more than one label are
+ * marked as mixed. The levels are built in parallel over z slabs, the result does not depend on
+ * the number of threads.
+ *
+ * The estimate at level l samples the density at the center voxel of each block and multiplies by
+ * the number of voxels in the block, i.e. it reads 1 / 8^l of the volume. The change estimate per
+ * region is the absolute charge of the mixed blocks assigned to the region, plus the change from
+ * the previous (coarser) estimate when given. It is a heuristic for how much the charge may still
+ * change when refined, not a bound on the error: the sampled center voxels can be off by more,
+ * e.g. for densities that vary strongly within pure blocks.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ProgressiveRegionSum {
+public:
+    struct Level {
+        size3_t dims{0};
+        std::vector<uint16_t> regions;  // Region index, i.e. label - firstLabel
+        std::vector<uint8_t> mixed;
+    };
+
+    struct LabelPyramid {
+        size3_t dims{0};
+        size_t nrRegions = 0;
+        std::vector<Level> levels;  // levels[l - 1] is level l
+    };
+
+    struct Estimate {
+        size_t level = 0;
+        std::vector<float> charges;
+        std::vector<float> changeEstimate;  // Heuristic, not a bound, see ProgressiveRegionSum
+        std::vector<SegmentedRegionSum::Moments> moments;  // Only for the exact result (level 0)
+    };
+
+    template <typename LabelType>
+    static LabelPyramid buildLabelPyramid(const LabelType* labels, size3_t dims,
+                                          size_t firstLabel, size_t nrRegions, size_t nrLevels,
+                                          size_t nrThreads = util::defaultThreadCount());
+
+    template <typename ValueType>
+    static Estimate estimate(const ValueType* values, const LabelPyramid& pyramid, size_t level,
+                             const Estimate* coarser = nullptr);
+};
+
+template <typename LabelType>
+ProgressiveRegionSum::LabelPyramid ProgressiveRegionSum::buildLabelPyramid(
+    const LabelType* labels, size3_t dims, size_t firstLabel, size_t nrRegions, size_t nrLevels,
+    size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("ProgressiveRegionSum::buildLabelPyramid");
+    if (nrRegions == 0) {
+        throw Exception("Seem to be no segmented regions in the segmented volume...",
+                        IVW_CONTEXT_CUSTOM("ProgressiveRegionSum"));
+    }
+
+    LabelPyramid pyramid;
+    pyramid.dims = dims;
+    pyramid.nrRegions = nrRegions;
+
+    // Level 0 is the segmentation itself, pure by definition
+    Level fine;
+    fine.dims = dims;
+    fine.regions.resize(glm::compMul(dims));
+    util::parallelForRanges(fine.regions.size(), nrThreads, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            const auto region = static_cast<size_t>(labels[i]) - firstLabel;
+            if (region >= nrRegions) {
+                throw Exception("Segmentation label outside of the segmented regions range",
+                                IVW_CONTEXT_CUSTOM("ProgressiveRegionSum"));
+            }
+            fine.regions[i] = static_cast<uint16_t>(region);
+        }
+    });
+    fine.mixed.assign(fine.regions.size(), 0);
+
+    const Level* previous = &fine;
+    for (size_t l = 1; l <= nrLevels; l++) {
+        const auto pdims = previous->dims;
+        Level level;
+        level.dims = (pdims + size3_t(1)) / size_t{2};
+        level.regions.resize(glm::compMul(level.dims));
+        level.mixed.resize(level.regions.size());
+
+        // The blocks of a z slab only read the corresponding slabs of the finer level
+        util::parallelForRanges(level.dims.z, nrThreads, [&](size_t, size_t zBegin, size_t zEnd) {
+            for (size_t z = zBegin; z < zEnd; z++) {
+                for (size_t y = 0; y < level.dims.y; y++) {
+                    for (size_t x = 0; x < level.dims.x; x++) {
+                        std::array<uint16_t, 8> children{};
+                        size_t nrChildren = 0;
+                        bool mixed = false;
+                        for (size_t k = 2 * z; k < std::min(2 * z + 2, pdims.z); k++) {
+                            for (size_t j = 2 * y; j < std::min(2 * y + 2, pdims.y); j++) {
+                                for (size_t i = 2 * x; i < std::min(2 * x + 2, pdims.x); i++) {
+                                    const auto child = (k * pdims.y + j) * pdims.x + i;
+                                    children[nrChildren++] = previous->regions[child];
+                                    mixed = mixed || previous->mixed[child];
+                                }
+                            }
+                        }
+                        // Majority label, ties to the smallest region index
+                        uint16_t majority = children[0];
+                        size_t best = 0;
+                        for (size_t c = 0; c < nrChildren; c++) {
+                            const auto count = static_cast<size_t>(std::count(
+                                children.begin(), children.begin() + nrChildren, children[c]));
+                            if (count > best || (count == best && children[c] < majority)) {
+                                best = count;
+                                majority = children[c];
+                            }
+                        }
+                        const auto index = (z * level.dims.y + y) * level.dims.x + x;
+                        level.regions[index] = majority;
+                        level.mixed[index] = mixed || best != nrChildren;
+                    }
+                }
+            }
+        });
+        pyramid.levels.push_back(std::move(level));
+        previous = &pyramid.levels.back();
+    }
+
+    timer.count("voxels", static_cast<double>(glm::compMul(dims)));
+    return pyramid;
+}
+
+template <typename ValueType>
+ProgressiveRegionSum::Estimate ProgressiveRegionSum::estimate(const ValueType* values,
+                                                              const LabelPyramid& pyramid,
+                                                              size_t level,
+                                                              const Estimate* coarser) {
+    HotPathProfiler::ScopedTimer timer("ProgressiveRegionSum::estimate");
+    if (level == 0 || level > pyramid.levels.size()) {
+        throw Exception("Level outside of the label pyramid",
+                        IVW_CONTEXT_CUSTOM("ProgressiveRegionSum"));
+    }
+
+    const auto& coarse = pyramid.levels[level - 1];
+    const auto dims = pyramid.dims;
+    const size_t blockSize = size_t{1} << level;
+
+    Estimate result;
+    result.level = level;
+    result.charges.assign(pyramid.nrRegions, 0.0f);
+    result.changeEstimate.assign(pyramid.nrRegions, 0.0f);
+
+    for (size_t z = 0; z < coarse.dims.z; z++) {
+        const auto zEnd = std::min((z + 1) * blockSize, dims.z);
+        const auto zSample = std::min(z * blockSize + blockSize / 2, zEnd - 1);
+        for (size_t y = 0; y < coarse.dims.y; y++) {
+            const auto yEnd = std::min((y + 1) * blockSize, dims.y);
+            const auto ySample = std::min(y * blockSize + blockSize / 2, yEnd - 1);
+            for (size_t x = 0; x < coarse.dims.x; x++) {
+                const auto xEnd = std::min((x + 1) * blockSize, dims.x);
+                const auto xSample = std::min(x * blockSize + blockSize / 2, xEnd - 1);
+
+                const auto blockVoxels = (xEnd - x * blockSize) * (yEnd - y * blockSize) *
+                                         (zEnd - z * blockSize);
+                const auto value =
+                    static_cast<float>(values[(zSample * dims.y + ySample) * dims.x + xSample]);
+                const auto charge = value * static_cast<float>(blockVoxels);
+
+                const auto index = (z * coarse.dims.y + y) * coarse.dims.x + x;
+                const auto region = coarse.regions[index];
+                result.charges[region] += charge;
+                if (coarse.mixed[index]) result.changeEstimate[region] += std::abs(charge);
+            }
+        }
+    }
+
+    if (coarser) {
+        for (size_t r = 0; r < pyramid.nrRegions; r++) {
+            result.changeEstimate[r] += std::abs(result.charges[r] - coarser->charges[r]);
+        }
+    }
+
+    timer.count("voxels", static_cast<double>(coarse.regions.size()));
+    return result;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,182 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <inviwo/core/common/inviwoapplication.h>
+
+namespace inviwo {
+
+/**
+ * Region adjacency graph of a segmentation, i.e. which segmented regions touch and by how many
+ * voxel faces, and the (voxel) centroid of each region.
+ *
+ *     * labels is the segmentation, dims voxels (x fastest, as in VolumeRAM).
+ *     * firstLabel and nrRegions give the range of labels, as in SegmentedRegionSum.
+ *     * indexToWorld and offset map a voxel index to world space (world = indexToWorld * index +
+ *       offset), the centroids are in world space.
+ *
+ * The volume is split into slabs of z slices that are scanned in parallel. Each thread collects
+ * the edges of its slab in a local edge set, and the sets are merged in thread order at the end.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API RegionAdjacency {
+public:
+    /**
+     * Edge between region first and second (first < second, both relative to firstLabel) sharing
+     * faces voxel faces.
+     */
+    struct Edge {
+        size_t first;
+        size_t second;
+        size_t faces;
+    };
+
+    struct Graph {
+        size_t nrRegions = 0;
+        std::vector<Edge> edges;  // Sorted by first, then second
+        std::vector<size_t> voxels;
+        std::vector<dvec3> centroids;
+    };
+
+    template <typename LabelType>
+    static Graph compute(const LabelType* labels, size3_t dims, size_t firstLabel,
+                         size_t nrRegions, const dmat3& indexToWorld, const dvec3& offset,
+                         size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Distances between the region centroids, nrRegions * nrRegions with region i and j at
+     * i * nrRegions + j. Regions without voxels have no centroid and a distance of zero.
+     */
+    static std::vector<double> centroidDistances(const Graph& graph);
+
+    /**
+     * Number of shared faces between all regions, nrRegions * nrRegions with region i and j at
+     * i * nrRegions + j (symmetric), same form as ChargeTransferMatrix::RegionOverlap::faces.
+     */
+    static std::vector<float> faceMatrix(const Graph& graph);
+
+private:
+    struct Accumulator {
+        std::unordered_map<uint64_t, size_t> edges;  // first << 32 | second
+        std::vector<size_t> voxels;
+        std::vector<dvec3> positions;  // Sum of the voxel indices
+    };
+
+    static Graph merge(std::vector<Accumulator>& accumulators, size_t nrRegions,
+                       const dmat3& indexToWorld, const dvec3& offset);
+};
+
+template <typename LabelType>
+RegionAdjacency::Graph RegionAdjacency::compute(const LabelType* labels, size3_t dims,
+                                                size_t firstLabel, size_t nrRegions,
+                                                const dmat3& indexToWorld, const dvec3& offset,
+                                                size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("RegionAdjacency::compute");
+    if (nrRegions == 0) {
+        throw Exception("Seem to be no segmented regions in the segmented volume...",
+                        IVW_CONTEXT_CUSTOM("RegionAdjacency"));
+    }
+
+    const size_t sliceSize = dims.x * dims.y;
+    nrThreads = std::max<size_t>(1, std::min(nrThreads, dims.z));
+    std::vector<Accumulator> accumulators(nrThreads);
+
+    util::parallelForRanges(dims.z, nrThreads, [&](size_t thread, size_t zBegin, size_t zEnd) {
+        auto& acc = accumulators[thread];
+        acc.voxels.assign(nrRegions, 0);
+        acc.positions.assign(nrRegions, dvec3{0.0});
+
+        const auto region = [&](LabelType label) {
+            const auto r = static_cast<size_t>(label) - firstLabel;
+            if (r >= nrRegions) {
+                throw Exception("Segmentation label outside of the segmented regions range",
+                                IVW_CONTEXT_CUSTOM("RegionAdjacency"));
+            }
+            return r;
+        };
+        // Neighbouring faces are mostly between the same two regions, so the last edge is kept
+        // (references to unordered_map elements stay valid when it grows)
+        uint64_t lastKey = ~uint64_t{0};
+        size_t* lastFaces = nullptr;
+        const auto addFace = [&](size_t r, LabelType neighbour) {
+            const auto s = region(neighbour);
+            const auto key = (static_cast<uint64_t>(std::min(r, s)) << 32) | std::max(r, s);
+            if (key != lastKey) {
+                lastKey = key;
+                lastFaces = &acc.edges[key];
+            }
+            ++*lastFaces;
+        };
+
+        for (size_t z = zBegin; z < zEnd; z++) {
+            for (size_t y = 0; y < dims.y; y++) {
+                const size_t row = z * sliceSize + y * dims.x;
+                // Labels come in runs along x, the voxel count and position sum is added per run
+                for (size_t x = 0; x < dims.x;) {
+                    const auto label = labels[row + x];
+                    const auto r = region(label);
+                    const auto begin = x;
+                    for (; x < dims.x && labels[row + x] == label; x++) {
+                        const size_t i = row + x;
+                        if (y + 1 < dims.y && labels[i + dims.x] != label) {
+                            addFace(r, labels[i + dims.x]);
+                        }
+                        if (z + 1 < dims.z && labels[i + sliceSize] != label) {
+                            addFace(r, labels[i + sliceSize]);
+                        }
+                    }
+                    if (x < dims.x) addFace(r, labels[row + x]);
+
+                    const auto length = x - begin;
+                    acc.voxels[r] += length;
+                    acc.positions[r] += dvec3{0.5 * static_cast<double>((begin + x - 1) * length),
+                                              static_cast<double>(y * length),
+                                              static_cast<double>(z * length)};
+                }
+            }
+        }
+    });
+
+    auto graph = merge(accumulators, nrRegions, indexToWorld, offset);
+
+    const auto nrVoxels = sliceSize * dims.z;
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("bytes", static_cast<double>(nrVoxels * sizeof(LabelType)));
+    return graph;
+}
+
+}  // namespace inviwo
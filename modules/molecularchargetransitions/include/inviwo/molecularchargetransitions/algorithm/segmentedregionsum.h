@@ -0,0 +1,309 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/deterministicreduction.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/glm.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <inviwo/core/common/inviwoapplication.h>
+
+namespace inviwo {
+
+/**
+ * Sums up the values of a volume per segmented region.
+ *
+ *     * values is the volume data (charge density), nrVoxels values.
+ *     * labels is the segmentation of the volume, nrVoxels labels.
+ *     * firstLabel is the smallest label in the segmentation.
+ *     * nrRegions is the number of regions, i.e. labels are in [firstLabel, firstLabel+nrRegions).
+ *
+ * Returns the summed up value for each region, where element i belongs to label firstLabel + i.
+ * The voxels are summed in double precision over fixed blocks which are merged pairwise, so the
+ * result is the same for any number of threads.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API SegmentedRegionSum {
+public:
+    /**
+     * Number of voxels per block of the reductions. The blocks do not depend on the number of
+     * threads, see util::deterministicReduce.
+     */
+    static constexpr size_t reductionBlockSize = size_t{1} << 16;
+
+    template <typename ValueType, typename LabelType>
+    static std::vector<float> sumPerRegion(const ValueType* values, const LabelType* labels,
+                                           size_t nrVoxels, size_t firstLabel, size_t nrRegions,
+                                           size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Called with the number of voxels done so far as the blocks of a reduction are done, to
+     * report progress or to stop the sum by returning false. It is called from the threads of the
+     * reduction, but one call at a time. The result of a stopped sum is incomplete and should be
+     * discarded.
+     */
+    using ProgressCallback = std::function<bool(size_t voxelsDone)>;
+
+    /**
+     * Same as sumPerRegion of all dims voxels, with progress called as the blocks are done.
+     */
+    template <typename ValueType, typename LabelType>
+    static std::vector<float> sumPerRegion(const ValueType* values, const LabelType* labels,
+                                           size3_t dims, size_t firstLabel, size_t nrRegions,
+                                           const ProgressCallback& progress,
+                                           size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Value (charge) weighted spatial moments of a region, in world space.
+     */
+    struct Moments {
+        double charge = 0.0;
+        dvec3 first{0.0};               // Sum of value * position
+        std::array<double, 6> second{};  // Sum of value * position products xx, yy, zz, xy, xz, yz
+
+        Moments& operator+=(const Moments& other);
+    };
+
+    /**
+     * Descriptors of the moments of a region. The spread is the standard deviation of the
+     * positions along each axis and the radius the root mean square distance to the centroid. The
+     * dipole is the first moment, i.e. relative to the origin of the world space.
+     */
+    struct Features {
+        dvec3 centroid{0.0};
+        dvec3 spread{0.0};
+        double radius = 0.0;
+        dvec3 dipole{0.0};
+    };
+
+    /**
+     * Sums up the values per region, and in the same pass the first and second moments of the
+     * voxel positions weighted by the values. The volume has dims voxels, and indexToWorld and
+     * offset map a voxel index to world space (world = indexToWorld * index + offset). The moments
+     * are accumulated in double precision in index space, over the same blocks as sumPerRegion,
+     * and transformed to world space afterwards. The charges are bit-identical to sumPerRegion and
+     * neither depends on nrThreads. The optional progress is called as the blocks are done.
+     */
+    template <typename ValueType, typename LabelType>
+    static std::vector<Moments> momentsPerRegion(const ValueType* values, const LabelType* labels,
+                                                 size3_t dims, size_t firstLabel,
+                                                 size_t nrRegions, const dmat3& indexToWorld,
+                                                 const dvec3& offset,
+                                                 const ProgressCallback& progress = {},
+                                                 size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Moments in index space transformed to world space.
+     */
+    static Moments toWorld(const Moments& moments, const dmat3& indexToWorld, const dvec3& offset);
+
+    /**
+     * Sum of the moments of the given regions, e.g. a subgroup.
+     */
+    static Moments sum(const std::vector<Moments>& moments, const std::vector<size_t>& indices);
+
+    static Features features(const Moments& moments);
+
+private:
+    template <typename ValueType, typename LabelType>
+    static std::vector<float> sums(const ValueType* values, const LabelType* labels,
+                                   size_t nrVoxels, size_t firstLabel, size_t nrRegions,
+                                   const ProgressCallback& progress, size_t nrThreads);
+
+    /**
+     * Reports the progress of a reduction over nrVoxels voxels to a ProgressCallback, from any
+     * thread. The callback is called one call at a time, each time at least progressInterval more
+     * voxels are done and when all are done. stopped() is true once the callback has returned
+     * false.
+     */
+    class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API BlockProgress {
+    public:
+        static constexpr size_t progressInterval = size_t{1} << 18;
+
+        BlockProgress(const ProgressCallback& callback, size_t nrVoxels);
+        void done(size_t voxels);
+        bool stopped() const { return stopped_; }
+
+    private:
+        const ProgressCallback& callback_;
+        size_t nrVoxels_;
+        std::mutex mutex_;
+        size_t done_ = 0;
+        size_t reported_ = 0;
+        std::atomic<bool> stopped_{false};
+    };
+};
+
+template <typename ValueType, typename LabelType>
+std::vector<float> SegmentedRegionSum::sumPerRegion(const ValueType* values,
+                                                    const LabelType* labels, size_t nrVoxels,
+                                                    size_t firstLabel, size_t nrRegions,
+                                                    size_t nrThreads) {
+    return sums(values, labels, nrVoxels, firstLabel, nrRegions, {}, nrThreads);
+}
+
+template <typename ValueType, typename LabelType>
+std::vector<float> SegmentedRegionSum::sumPerRegion(const ValueType* values,
+                                                    const LabelType* labels, size3_t dims,
+                                                    size_t firstLabel, size_t nrRegions,
+                                                    const ProgressCallback& progress,
+                                                    size_t nrThreads) {
+    return sums(values, labels, glm::compMul(dims), firstLabel, nrRegions, progress, nrThreads);
+}
+
+template <typename ValueType, typename LabelType>
+std::vector<float> SegmentedRegionSum::sums(const ValueType* values, const LabelType* labels,
+                                            size_t nrVoxels, size_t firstLabel, size_t nrRegions,
+                                            const ProgressCallback& progress, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("SegmentedRegionSum::sumPerRegion");
+    if (nrRegions == 0) {
+        throw Exception("Seem to be no segmented regions in the segmented volume...",
+                        IVW_CONTEXT_CUSTOM("SegmentedRegionSum"));
+    }
+
+    BlockProgress blocksDone(progress, nrVoxels);
+    const auto sumBlock = [&](size_t, size_t begin, size_t end) {
+        std::vector<double> sums(nrRegions, 0.0);
+        if (blocksDone.stopped()) return sums;
+        for (size_t i = begin; i < end; i++) {
+            const auto region = static_cast<size_t>(labels[i]) - firstLabel;
+            if (region >= nrRegions) {
+                throw Exception("Segmentation label outside of the segmented regions range",
+                                IVW_CONTEXT_CUSTOM("SegmentedRegionSum"));
+            }
+            sums[region] += static_cast<double>(values[i]);
+        }
+        blocksDone.done(end - begin);
+        return sums;
+    };
+    const auto merge = [](std::vector<double>& a, const std::vector<double>& b) {
+        for (size_t i = 0; i < a.size(); i++) {
+            a[i] += b[i];
+        }
+    };
+    auto sums = util::deterministicReduce(nrVoxels, reductionBlockSize,
+                                          std::vector<double>(nrRegions, 0.0), sumBlock, merge,
+                                          nrThreads);
+    std::vector<float> accumulatedValues(sums.begin(), sums.end());
+
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("bytes", static_cast<double>(nrVoxels * (sizeof(ValueType) + sizeof(LabelType))));
+    return accumulatedValues;
+}
+
+template <typename ValueType, typename LabelType>
+std::vector<SegmentedRegionSum::Moments> SegmentedRegionSum::momentsPerRegion(
+    const ValueType* values, const LabelType* labels, size3_t dims, size_t firstLabel,
+    size_t nrRegions, const dmat3& indexToWorld, const dvec3& offset,
+    const ProgressCallback& progress, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("SegmentedRegionSum::momentsPerRegion");
+    if (nrRegions == 0) {
+        throw Exception("Seem to be no segmented regions in the segmented volume...",
+                        IVW_CONTEXT_CUSTOM("SegmentedRegionSum"));
+    }
+
+    const auto sliceSize = dims.x * dims.y;
+    const auto nrVoxels = sliceSize * dims.z;
+    BlockProgress blocksDone(progress, nrVoxels);
+    // Same blocks as sumPerRegion, and the charge of each voxel is added in the same order, so the
+    // charges are bit-identical to sumPerRegion
+    const auto momentsBlock = [&](size_t, size_t begin, size_t end) {
+        std::vector<Moments> moments(nrRegions);
+        if (blocksDone.stopped()) return moments;
+
+        size_t x = begin % dims.x;
+        size_t y = (begin / dims.x) % dims.y;
+        size_t z = begin / sliceSize;
+        // Labels come in runs along x, within a run only the sums of q, q x and q x^2 are needed
+        // and the y and z terms are added once per run
+        for (size_t i = begin; i < end;) {
+            const auto label = labels[i];
+            const auto region = static_cast<size_t>(label) - firstLabel;
+            if (region >= nrRegions) {
+                throw Exception("Segmentation label outside of the segmented regions range",
+                                IVW_CONTEXT_CUSTOM("SegmentedRegionSum"));
+            }
+            auto& m = moments[region];
+            const auto py = static_cast<double>(y);
+            const auto pz = static_cast<double>(z);
+            double q = 0.0;
+            double qx = 0.0;
+            double qxx = 0.0;
+            for (; i < end && x < dims.x && labels[i] == label; x++, i++) {
+                const auto px = static_cast<double>(x);
+                const auto value = static_cast<double>(values[i]);
+                m.charge += value;
+                q += value;
+                qx += value * px;
+                qxx += value * px * px;
+            }
+            m.first.x += qx;
+            m.first.y += q * py;
+            m.first.z += q * pz;
+            m.second[0] += qxx;
+            m.second[1] += q * py * py;
+            m.second[2] += q * pz * pz;
+            m.second[3] += qx * py;
+            m.second[4] += qx * pz;
+            m.second[5] += q * py * pz;
+            if (x == dims.x) {
+                x = 0;
+                if (++y == dims.y) {
+                    y = 0;
+                    ++z;
+                }
+            }
+        }
+        blocksDone.done(end - begin);
+        return moments;
+    };
+    const auto merge = [](std::vector<Moments>& a, const std::vector<Moments>& b) {
+        for (size_t i = 0; i < a.size(); i++) {
+            a[i] += b[i];
+        }
+    };
+    auto moments = util::deterministicReduce(nrVoxels, reductionBlockSize,
+                                             std::vector<Moments>(nrRegions), momentsBlock, merge,
+                                             nrThreads);
+    for (auto& m : moments) {
+        m = toWorld(m, indexToWorld, offset);
+    }
+
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("bytes", static_cast<double>(nrVoxels * (sizeof(ValueType) + sizeof(LabelType))));
+    return moments;
+}
+
+}  // namespace inviwo
@@ -36,6 +36,7 @@ namespace inviwo {
 /**
  * meanValue - calculates mean value of input values in vector
  * variance - calculates variance of input values in vector (assumes the values are the whole population)
+ * The sums are compensated double precision sums (see util::CompensatedSum).
  */
 class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API VectorStatistics {
 public:
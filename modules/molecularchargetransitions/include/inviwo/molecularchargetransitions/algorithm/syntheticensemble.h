@@ -0,0 +1,135 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/util/glm.h>
+#include <nlohmann/json.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Deterministic generator of synthetic ensembles of electronic transitions, for testing and
+ * benchmarking at production sizes.
+ *
+ * The volume is split into nrRegions box shaped regions (with randomly placed boundaries), and the
+ * regions are split into nrSubgroups subgroups of consecutive regions. The regions are the cells
+ * of a grid, if nrRegions has no even split into three factors (e.g. a prime) the grid has a few
+ * more cells and some regions are two cells long. The ensemble members are
+ * drawn around nrClusters cluster prototypes, where clusterSpread is the standard deviation of
+ * the member charges around the prototype charges.
+ *
+ * Everything is derived from the seed only, and each member has its own random stream. The output
+ * is therefore identical between runs, and any member can be generated on its own.
+ *
+ *     * labels is the segmentation, region labels 0 to nrRegions-1 (x fastest, as in VolumeRAM).
+ *     * density is the hole or particle charge density of a member, a sum of one gaussian per
+ *       region which integrates to the region charge (the total charge is one).
+ *     * subgroups is the subgroup json as read by SumChargeInSegmentedRegions.
+ *     * table is the hole and particle charges per subgroup for all members, and their cluster.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API SyntheticEnsemble {
+public:
+    struct Settings {
+        uint64_t seed = 0;
+        size3_t dimensions{64, 64, 64};
+        size_t nrRegions = 8;
+        size_t nrSubgroups = 3;
+        size_t nrMembers = 1000;
+        size_t nrClusters = 5;
+        float clusterSpread = 0.05f;
+    };
+
+    enum class Charge { Hole, Particle };
+
+    struct Table {
+        std::vector<int> cluster;
+        // [subgroup][member]
+        std::vector<std::vector<float>> holeCharges;
+        std::vector<std::vector<float>> particleCharges;
+    };
+
+    explicit SyntheticEnsemble(const Settings& settings);
+
+    const Settings& getSettings() const { return settings_; }
+
+    std::vector<uint16_t> labels() const;
+    std::vector<float> density(size_t member, Charge charge) const;
+    nlohmann::json subgroups() const;
+    Table table() const;
+
+    int cluster(size_t member) const;
+    /**
+     * Hole and particle charges per subgroup of one member, each sums up to one.
+     */
+    std::pair<std::vector<float>, std::vector<float>> charges(size_t member) const;
+
+    /**
+     * Random number generator used for all generated data (SplitMix64). The mapping to floating
+     * point numbers is done here as well, since the std distributions are implementation defined.
+     */
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : state_{seed} {}
+        uint64_t next();
+        /// Uniform in [0, 1)
+        double uniform();
+        /// Standard normal distribution (Box-Muller)
+        double normal();
+
+    private:
+        uint64_t state_;
+    };
+
+private:
+    struct Region {
+        std::array<size_t, 3> begin;
+        std::array<size_t, 3> end;
+        std::array<double, 3> center;
+        double sigma;
+        double weight;  // Share of the subgroup charge
+        size_t subgroup;
+    };
+
+    Random memberRandom(size_t member) const;
+    std::vector<float> regionCharges(const std::vector<float>& subgroupCharges) const;
+
+    Settings settings_;
+    std::array<std::vector<size_t>, 3> boundaries_;  // nr + 1 cell boundaries along each axis
+    std::array<size_t, 3> nrCells_;
+    std::vector<uint16_t> cellRegions_;  // Region of each grid cell, x fastest
+    std::vector<Region> regions_;
+    std::vector<std::vector<float>> holePrototypes_;
+    std::vector<std::vector<float>> particlePrototypes_;
+};
+
+}  // namespace inviwo
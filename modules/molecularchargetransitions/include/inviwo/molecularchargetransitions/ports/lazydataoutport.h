@@ -0,0 +1,157 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/ports/dataoutport.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace inviwo {
+
+/**
+ * Data outport that computes its data when it is read instead of when the processor is processed.
+ * The processor sets a generator (a function making the data) with setGenerator, which is called
+ * on the first getData() and the data is then kept until the next setGenerator, setData or
+ * clear. Outports that are never read, e.g. unconnected outports in a batch network, only cost
+ * the generator. The generator should capture the input data it needs by value (shared
+ * pointers), since it can be called after the inputs have changed.
+ */
+template <typename T>
+class LazyDataOutport : public DataOutport<T> {
+public:
+    using Generator = std::function<std::shared_ptr<const T>()>;
+    using DataOutport<T>::DataOutport;
+    using DataOutport<T>::setData;
+    virtual ~LazyDataOutport() = default;
+
+    void setGenerator(Generator generator);
+
+    /**
+     * Generator that calls generator once and returns the same data for all later calls, so
+     * that it can be set again later (e.g. from a ResultCache) without recomputing the data.
+     */
+    static Generator memoize(Generator generator);
+
+    /**
+     * True if there is a generator which has not been called yet.
+     */
+    bool isPending() const;
+
+    virtual std::shared_ptr<const T> getData() const override;
+    virtual std::shared_ptr<const T> detachData() override;
+    virtual void setData(std::shared_ptr<const T> data) override;
+    virtual bool hasData() const override;
+    virtual void clear() override;
+    virtual bool isReady() const override;
+
+private:
+    mutable std::mutex mutex_;
+    mutable Generator generator_;
+    mutable std::shared_ptr<const T> generated_;
+};
+
+template <typename T>
+void LazyDataOutport<T>::setGenerator(Generator generator) {
+    std::scoped_lock lock(mutex_);
+    DataOutport<T>::clear();
+    generated_.reset();
+    generator_ = std::move(generator);
+}
+
+template <typename T>
+auto LazyDataOutport<T>::memoize(Generator generator) -> Generator {
+    struct State {
+        std::once_flag once;
+        Generator generator;
+        std::shared_ptr<const T> data;
+    };
+    auto state = std::make_shared<State>();
+    state->generator = std::move(generator);
+    return [state]() {
+        std::call_once(state->once, [&]() {
+            state->data = state->generator();
+            state->generator = nullptr;
+        });
+        return state->data;
+    };
+}
+
+template <typename T>
+bool LazyDataOutport<T>::isPending() const {
+    std::scoped_lock lock(mutex_);
+    return static_cast<bool>(generator_);
+}
+
+template <typename T>
+std::shared_ptr<const T> LazyDataOutport<T>::getData() const {
+    std::scoped_lock lock(mutex_);
+    if (generator_) {
+        generated_ = generator_();
+        generator_ = nullptr;
+    }
+    return generated_ ? generated_ : DataOutport<T>::getData();
+}
+
+template <typename T>
+std::shared_ptr<const T> LazyDataOutport<T>::detachData() {
+    auto data = getData();
+    clear();
+    return data;
+}
+
+template <typename T>
+void LazyDataOutport<T>::setData(std::shared_ptr<const T> data) {
+    std::scoped_lock lock(mutex_);
+    generator_ = nullptr;
+    generated_.reset();
+    DataOutport<T>::setData(data);
+}
+
+template <typename T>
+bool LazyDataOutport<T>::hasData() const {
+    std::scoped_lock lock(mutex_);
+    return generator_ || generated_ || DataOutport<T>::hasData();
+}
+
+template <typename T>
+void LazyDataOutport<T>::clear() {
+    std::scoped_lock lock(mutex_);
+    generator_ = nullptr;
+    generated_.reset();
+    DataOutport<T>::clear();
+}
+
+template <typename T>
+bool LazyDataOutport<T>::isReady() const {
+    return Outport::isReady() && hasData();
+}
+
+}  // namespace inviwo
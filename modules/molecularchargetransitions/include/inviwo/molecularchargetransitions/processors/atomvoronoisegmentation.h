@@ -0,0 +1,86 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/nearestatomsegmentation.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.AtomVoronoiSegmentation, Atom Voronoi Segmentation}
+ * ![](org.inviwo.AtomVoronoiSegmentation.png?classIdentifier=org.inviwo.AtomVoronoiSegmentation)
+ *
+ * Segments a volume by its atoms, every voxel is labeled by the nearest atom (see
+ * NearestAtomSegmentation). The segmentation is computed directly in process, in parallel, so
+ * there is no background job to wait for. The output can be used as segmentation in
+ * SumChargeInSegmentedRegions.
+ *
+ * ### Inports
+ *   * __volume__ Volume defining the grid (dimensions, basis and offset) to segment.
+ *   * __atoms__ Atom positions in world space (columns x, y and z), and optionally the column
+ * "Radius" or "Atomic number" used for weighting.
+ *
+ * ### Outports
+ *   * __segmentation__ Segmentation (uint16), label i is the atom in row i.
+ *
+ * ### Properties
+ *   * __weighted__ Weight by atomic radius (power distance). Uses the "Radius" column if there is
+ * one, otherwise the covalent radius of the "Atomic number" column (in Ångström).
+ *   * __radiusScale__ Scale of the radii, e.g. 1.8897 if the positions are in Bohr.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API AtomVoronoiSegmentation : public Processor {
+public:
+    AtomVoronoiSegmentation();
+    virtual ~AtomVoronoiSegmentation() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    VolumeInport volume_;
+    DataFrameInport atoms_;
+    VolumeOutport segmentation_;
+
+    BoolProperty weighted_;
+    FloatProperty radiusScale_;
+
+    ColumnViewCache columnViews_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,105 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/properties/columnoptionproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/groupedcolumnstatistics.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.ClusterChargeTransferStatistics, Cluster Charge Transfer Statistics}
+ * ![](org.inviwo.ClusterChargeTransferStatistics.png?classIdentifier=org.inviwo.ClusterChargeTransferStatistics)
+ *
+ * Processor to aggregate the charge transfer matrices of an ensemble per cluster, for the cluster
+ * transition diagrams. Computes the mean, median, lower and upper quantile of every entry of the
+ * matrices in each cluster (see GroupedColumnStatistics). The outputs of the last few inputs are
+ * cached, as in ClusterStatistics.
+ *
+ * ### Inports
+ *   * __inport__   Dataframe containing cluster id and the charge transfer matrix of each
+ * ensemble member, columns "Charge transfer ij" as from ComputeEnsembleChargeTransfer.
+ *
+ * ### Outports
+ *   * __meanOutport__ Mean charge transfer matrix of each cluster.
+ *   * __medianOutport__ Median charge transfer matrix of each cluster.
+ *   * __lowerOutport__ Lower quantile of the charge transfer matrices of each cluster.
+ *   * __upperOutport__ Upper quantile of the charge transfer matrices of each cluster.
+ * The matrices are stacked, with one row for each row of the matrix of each cluster: columns
+ * "Cluster", "Cluster size", "Row" and "1" to "N", where row i and column j is the transfer from
+ * subgroup j to subgroup i.
+ *
+ * ### Properties
+ *   * __nrSubgroups__ How many subgroups each member in the ensemble has.
+ *   * __clusterCol__ Selecting which column contains the cluster id.
+ *   * __lowerQuantile__ Quantile of the lower output, 0.05 by default.
+ *   * __upperQuantile__ Quantile of the upper output, 0.95 by default.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ClusterChargeTransferStatistics
+    : public Processor {
+public:
+    ClusterChargeTransferStatistics();
+    virtual ~ClusterChargeTransferStatistics() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    struct Outputs {
+        std::shared_ptr<const DataFrame> mean;
+        std::shared_ptr<const DataFrame> median;
+        std::shared_ptr<const DataFrame> lower;
+        std::shared_ptr<const DataFrame> upper;
+    };
+    void setOutputs(const Outputs& outputs);
+
+    DataFrameInport inport_;
+    DataFrameOutport meanOutport_;
+    DataFrameOutport medianOutport_;
+    DataFrameOutport lowerOutport_;
+    DataFrameOutport upperOutport_;
+    IntProperty nrSubgroups_;
+    ColumnOptionProperty clusterCol_;
+    FloatProperty lowerQuantile_;
+    FloatProperty upperQuantile_;
+
+    ColumnViewCache columnViews_;
+    ResultCache<Outputs> results_;
+};
+
+}  // namespace inviwo
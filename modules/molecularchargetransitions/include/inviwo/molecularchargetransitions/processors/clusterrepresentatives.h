@@ -0,0 +1,85 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/properties/columnoptionproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/clustermedoids.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.ClusterRepresentatives, Cluster Representatives}
+ * ![](org.inviwo.ClusterRepresentatives.png?classIdentifier=org.inviwo.ClusterRepresentatives)
+ *
+ * Processor to find the most representative member (medoid) of each cluster of an ensemble of
+ * electronic transitions, the member with the smallest sum of distances between its hole and
+ * particle charges and those of the other members in the cluster (see ClusterMedoids). The
+ * representative selects the member transition diagram shown for a cluster. The outputs of the
+ * last few inputs are cached, as in ClusterStatistics.
+ *
+ * ### Inports
+ *   * __inport__   Dataframe containing cluster id, hole charges and particle charges for each
+ * ensemble member.
+ *
+ * ### Outports
+ *   * __outport__ Cluster, cluster size, index of the representative member and its mean
+ * distance to the members of the cluster, for each cluster.
+ *
+ * ### Properties
+ *   * __nrSubgroups__ How many subgroups each member in the ensemble has.
+ *   * __clusterCol__ Selecting which column contains the cluster id.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ClusterRepresentatives : public Processor {
+public:
+    ClusterRepresentatives();
+    virtual ~ClusterRepresentatives() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataFrameInport inport_;
+    DataFrameOutport outport_;
+    IntProperty nrSubgroups_;
+    ColumnOptionProperty clusterCol_;
+
+    ColumnViewCache columnViews_;
+    ResultCache<std::shared_ptr<const DataFrame>> results_;
+};
+
+}  // namespace inviwo
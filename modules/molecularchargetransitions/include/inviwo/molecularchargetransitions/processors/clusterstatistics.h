@@ -31,32 +31,59 @@
 
 #include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
 #include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
 #include <inviwo/core/properties/ordinalproperty.h>
 #include <inviwo/dataframe/properties/columnoptionproperty.h>
 #include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/clustergrouping.h>
 #include <inviwo/molecularchargetransitions/algorithm/statistics.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/kllsketch.h>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
 
 namespace inviwo {
 
 /** \docpage{org.inviwo.ClusterStatistics, Cluster Statistics}
  * ![](org.inviwo.ClusterStatistics.png?classIdentifier=org.inviwo.ClusterStatistics)
  *
- * Processor to calculate some statistics for an ensemble of electronic transitions.
+ * Processor to calculate some statistics for an ensemble of electronic transitions. The outputs
+ * of the last few inputs are cached by the values of the used columns and the settings (see
+ * ResultCache), so switching back to an earlier input outputs the earlier result right away.
+ *
+ * Optionally, the median and a lower and upper quantile of every hole, particle and measure of
+ * locality column are estimated with one quantile sketch per cluster and column (see KllSketch),
+ * in one pass and bounded memory. If a linkage of the clusters is given, the sketches are merged
+ * up the dendrogram one column at a time, which gives the quantiles of every node, i.e. of any
+ * cluster at any level (see the "Node" column of DendrogramCut).
+ *
+ * With a linkage, the cluster column must hold the 0-based leaf ids of the linkage, e.g. the
+ * "Micro cluster" column of MiniBatchClustering. Other labels, e.g. the 1-based cluster labels of
+ * CreateDendrogram, give wrong node quantiles or an error.
  *
  * ### Inports
  *   * __inport__   Dataframe containing cluster id, hole charges, particle charges and measure of
  * locality value for each ensemble member.
+ *   * __linkage__  Optional, merges of the clusters, columns "Child 1", "Child 2" and "Distance".
  *
  * ### Outports
  *   * __outport__ Min and max particle and hole charges for each cluster??.
  *   * __diffOutport__ Difference between min and max within each cluster??.
  *   * __meanOutport__ Mean and variance for each cluster.
  *   * __meanMeasureOfLocalityOutport__ Mean of measure of locality for each cluster.
+ *   * __quantileOutport__ Median, lower and upper quantile for each cluster, with quantile
+ * sketches enabled.
+ *   * __nodeQuantileOutport__ Median, lower and upper quantile for each node of the linkage,
+ * with quantile sketches enabled and a linkage.
  *
  * ### Properties
  *   * __nrSubgroups__ How many subgroups each member in the ensemble has.
  *   * __clusterCol__ Selecting which column contains the cluster id.
  *   * __measureOfLocalityCol__ Selecting which column contains measure of locality value.
+ *   * __quantileSketches__ Estimate quantiles with quantile sketches.
+ *   * __sketchSize__ Size parameter k of the sketches, the rank error is about 1.7 / k.
+ *   * __lowerQuantile__ Lower quantile, 0.05 by default.
+ *   * __upperQuantile__ Upper quantile, 0.95 by default.
  */
 class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ClusterStatistics : public Processor {
 public:
@@ -78,14 +105,41 @@ private:
         std::vector<float> variance;
     };
 
+    struct Outputs {
+        std::shared_ptr<const DataFrame> minMax;
+        std::shared_ptr<const DataFrame> diff;
+        std::shared_ptr<const DataFrame> mean;
+        std::shared_ptr<const DataFrame> meanMeasureOfLocality;
+        std::shared_ptr<const DataFrame> quantile;
+        std::shared_ptr<const DataFrame> nodeQuantile;
+    };
+    void setOutputs(const Outputs& outputs);
+
+    /**
+     * Median, lower and upper quantile of the sketches of one column, one row per sketch, named
+     * "Median <name>", "Lower quantile <name>" and "Upper quantile <name>".
+     */
+    void addQuantileColumns(DataFrame& dataFrame, const std::vector<KllSketch>& sketches,
+                            const std::string& name) const;
+
     DataFrameInport inport_;
+    DataFrameInport linkage_;
     DataFrameOutport outport_;
     DataFrameOutport diffOutport_;
     DataFrameOutport meanOutport_;
     DataFrameOutport meanMeasureOfLocalityOutport_;
+    DataFrameOutport quantileOutport_;
+    DataFrameOutport nodeQuantileOutport_;
     IntProperty nrSubgroups_;
     ColumnOptionProperty clusterCol_;
     ColumnOptionProperty measureOfLocalityCol_;
+    BoolProperty quantileSketches_;
+    IntProperty sketchSize_;
+    FloatProperty lowerQuantile_;
+    FloatProperty upperQuantile_;
+
+    ColumnViewCache columnViews_;
+    ResultCache<Outputs> results_;
 };
 
 }  // namespace inviwo
@@ -34,6 +34,10 @@
 #include <inviwo/core/properties/ordinalproperty.h>
 #include <inviwo/dataframe/datastructures/dataframe.h>
 #include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/ports/lazydataoutport.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
 #include <vector>
 
 namespace inviwo {
@@ -48,12 +52,23 @@ namespace inviwo {
  *   * __holeCharges__      The hole charges for each subgroup (column name charge_sg).
  *   * __particleCharges__  The particle charges for each subgroup (column name charge_sg).
  *                          Must be same length as holeCharges_.
+ *   * __chargeTransferMatrix__ Optional charge transfer matrix for the subgroups, same form as the
+ * chargeTransfer outport (e.g. from VoxelOverlapChargeTransfer). If connected it is used instead of
+ * the heuristic based on the subgroup charges. Its columns have to sum up to the hole charges
+ * (charge_sg), otherwise the processor throws. Without it, the processor throws if none or all of
+ * the subgroups lose charge, since the heuristic needs both donors and acceptors.
  *
  * ### Outports
  *   * __chargeDifference__ Difference in charge from hole to particle ("particle - hole") for each
- * subgroup.
+ * subgroup. If both charge inputs have the centroid columns (centroid_x_sg etc.), it also has the
+ * distance between the hole and particle centroids of each subgroup.
  *   * __chargeTransfer__   Charge transfer matrix.
+ *   * __holeAndParticleCharges__ The hole charges followed by the particle charges.
  *
+ * The outputs are computed when they are read (see LazyDataOutport), so outports that are not
+ * used cost nothing. A charge transfer matrix input of float columns is passed on without
+ * copying the columns. The outputs of the last few inputs are cached by the values of the input
+ * columns (see ResultCache), so inputs that are equal to an earlier one output the earlier result.
  */
 class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ComputeChargeTransfer : public Processor {
 public:
@@ -69,9 +84,20 @@ public:
 private:
     DataFrameInport holeCharges_;
     DataFrameInport particleCharges_;
-    DataFrameOutport chargeDifference_;
-    DataFrameOutport chargeTransfer_;
-    DataFrameOutport holeAndParticleCharges_;
+    DataFrameInport chargeTransferMatrix_;
+    LazyDataOutport<DataFrame> chargeDifference_;
+    LazyDataOutport<DataFrame> chargeTransfer_;
+    LazyDataOutport<DataFrame> holeAndParticleCharges_;
+
+    struct Generators {
+        LazyDataOutport<DataFrame>::Generator chargeDifference;
+        LazyDataOutport<DataFrame>::Generator chargeTransfer;
+        LazyDataOutport<DataFrame>::Generator holeAndParticleCharges;
+    };
+    void setGenerators(const Generators& generators);
+
+    ColumnViewCache columnViews_;
+    ResultCache<Generators> results_;
 };
 
 }  // namespace inviwo
@@ -0,0 +1,91 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.ComputeEnsembleChargeTransfer, Compute Ensemble Charge Transfer}
+ * ![](org.inviwo.ComputeEnsembleChargeTransfer.png?classIdentifier=org.inviwo.ComputeEnsembleChargeTransfer)
+ *
+ * Computes the charge transfer matrix of every member of an ensemble from its hole and particle
+ * charges. In the proportional mode the charge of each donor is distributed over the acceptors in
+ * proportion to their charge difference, as in ComputeChargeTransfer. In the optimal transport
+ * mode the donated charge is moved to the acceptors at the least total cost, where the cost of
+ * moving charge between two subgroups is the distance between them (earth mover's distance). The
+ * members are solved in parallel, each warm started from the previous member.
+ *
+ * ### Inports
+ *   * __inport__ DataFrame with the hole and particle charges of each member (columns
+ * "Hole sg1", "Particle sg1", ...). All subgroups with both columns are used.
+ *   * __subgroupPositions__ Positions of the subgroups (columns x, y and z, one row per
+ * subgroup). Required for the optimal transport mode.
+ *
+ * ### Outports
+ *   * __outport__ Charge transfer matrix of each member (columns "Charge transfer 11",
+ * "Charge transfer 12", ..., named as by the data generation script).
+ *
+ * ### Properties
+ *   * __mode__ Proportional or optimal transport.
+ *   * __epsilon__ Entropic regularization of the optimal transport, relative to the largest
+ * distance. Smaller values are closer to the exact transport but need more iterations.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ComputeEnsembleChargeTransfer : public Processor {
+public:
+    enum class Mode { Proportional, OptimalTransport };
+
+    ComputeEnsembleChargeTransfer();
+    virtual ~ComputeEnsembleChargeTransfer() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataFrameInport inport_;
+    DataFrameInport subgroupPositions_;
+    DataFrameOutport outport_;
+
+    TemplateOptionProperty<Mode> mode_;
+    FloatProperty epsilon_;
+
+    ColumnViewCache columnViews_;
+};
+
+}  // namespace inviwo
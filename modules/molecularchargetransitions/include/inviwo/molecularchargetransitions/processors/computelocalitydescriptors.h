@@ -0,0 +1,78 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/localitydescriptors.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.ComputeLocalityDescriptors, Compute Locality Descriptors}
+ * ![](org.inviwo.ComputeLocalityDescriptors.png?classIdentifier=org.inviwo.ComputeLocalityDescriptors)
+ *
+ * Computes the measure of locality and related descriptors of each ensemble member directly from
+ * its hole and particle charges (see LocalityDescriptors), in one pass over the table and without
+ * the charge transfer matrices. The measure of locality is the same as from MeasureOfLocality
+ * with the charge transfer matrices of ComputeChargeTransfer.
+ *
+ * ### Inports
+ *   * __inport__ DataFrame with the hole and particle charges of each member (columns
+ * "Hole sg1", "Particle sg1", ...). All subgroups with both columns are used.
+ *   * __subgroupPositions__ Optional positions of the subgroups (columns x, y and z, one row per
+ * subgroup), needed for the charge transfer distances.
+ *
+ * ### Outports
+ *   * __outport__ Measure of locality, transferred charge, number of donor and acceptor
+ * subgroups, and with positions the charge transfer distance and root mean square distance of
+ * each member.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ComputeLocalityDescriptors : public Processor {
+public:
+    ComputeLocalityDescriptors();
+    virtual ~ComputeLocalityDescriptors() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataFrameInport inport_;
+    DataFrameInport subgroupPositions_;
+    DataFrameOutport outport_;
+
+    ColumnViewCache columnViews_;
+};
+
+}  // namespace inviwo
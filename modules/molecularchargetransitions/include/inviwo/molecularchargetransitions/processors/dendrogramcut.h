@@ -0,0 +1,91 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/dendrogramindex.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <memory>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.DendrogramCut, Dendrogram Cut}
+ * ![](org.inviwo.DendrogramCut.png?classIdentifier=org.inviwo.DendrogramCut)
+ *
+ * Cluster column of an ensemble at any level of detail of a hierarchical clustering, from the
+ * linkage output of CreateDendrogram. The merge tree is indexed once per linkage (see
+ * DendrogramIndex), so changing the threshold or the number of clusters does not cluster again.
+ *
+ * If the dendrogram is of micro-clusters (see MiniBatchClustering), the micro-cluster of each
+ * member can be given in members, and the output is then per member instead of per leaf.
+ *
+ * ### Inports
+ *   * __linkage__ Merges of the clustering, columns "Child 1", "Child 2" and "Distance".
+ *   * __members__ Optional, column "Micro cluster" with the leaf of each member.
+ *
+ * ### Outports
+ *   * __outport__ Cluster (1 to the number of clusters, in leaf order of the dendrogram), leaf
+ * position and node of the cluster in the dendrogram of each member. The cluster is to be used as
+ * cluster column in ClusterStatistics, and the node to look up its quantiles there.
+ *
+ * ### Properties
+ *   * __useThreshold__ Cut the dendrogram at a height, otherwise at a number of clusters.
+ *   * __threshold__ Height of the cut.
+ *   * __nrClusters__ Number of clusters.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API DendrogramCut : public Processor {
+public:
+    DendrogramCut();
+    virtual ~DendrogramCut() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataFrameInport linkage_;
+    DataFrameInport members_;
+    DataFrameOutport outport_;
+
+    BoolProperty useThreshold_;
+    FloatProperty threshold_;
+    IntSizeTProperty nrClusters_;
+
+    ColumnViewCache columnViews_;
+    std::unique_ptr<DendrogramIndex> index_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,85 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/densitywatershed.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.DensityWatershedSegmentation, Density Watershed Segmentation}
+ * ![](org.inviwo.DensityWatershedSegmentation.png?classIdentifier=org.inviwo.DensityWatershedSegmentation)
+ *
+ * Bader style segmentation of a density, every voxel follows the steepest ascent to a maximum and
+ * the voxels ending in the same maximum form a basin (see DensityWatershed). The basins can be
+ * assigned to the atom nearest to their maximum, which merges the small basins in low density
+ * regions into the atoms. The output can be used as segmentation in SumChargeInSegmentedRegions.
+ *
+ * ### Inports
+ *   * __density__ Density to segment, e.g. the total electron density.
+ *   * __atoms__ Optional atom positions in world space (columns x, y and z).
+ *
+ * ### Outports
+ *   * __segmentation__ Segmentation (uint16), the atom index if assigned to atoms, otherwise the
+ * basin index.
+ *   * __basins__ Position, density and number of voxels of the maximum of each basin, and the
+ * atom it was assigned to.
+ *
+ * ### Properties
+ *   * __assignToAtoms__ Label the basins by the nearest atom. Requires the atoms.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API DensityWatershedSegmentation : public Processor {
+public:
+    DensityWatershedSegmentation();
+    virtual ~DensityWatershedSegmentation() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    VolumeInport density_;
+    DataFrameInport atoms_;
+    VolumeOutport segmentation_;
+    DataFrameOutport basins_;
+
+    BoolProperty assignToAtoms_;
+
+    ColumnViewCache columnViews_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,77 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/util/cubefile.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.FastCubeSource, Fast Cube Source}
+ * ![](org.inviwo.FastCubeSource.png?classIdentifier=org.inviwo.FastCubeSource)
+ *
+ * Loads a Gaussian cube file, parsing the values in parallel (see CubeFile). After the first load
+ * a binary cache is written next to the file (file name + ".ivwcube"), which is used as long as
+ * the size, modification time and content hash of the cube file are the same. Loading an
+ * ensemble member a second time then only reads the values.
+ *
+ * ### Outports
+ *   * __volume__ The values of the cube (float), positioned in the units of the file.
+ *   * __atoms__ Atomic number, charge and position (x, y, z) of the atoms.
+ *
+ * ### Properties
+ *   * __cube__ Cube file to load.
+ *   * __useCache__ Read and write the binary cache.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API FastCubeSource : public Processor {
+public:
+    FastCubeSource();
+    virtual ~FastCubeSource() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    VolumeOutport volume_;
+    DataFrameOutport atoms_;
+
+    FileProperty cube_;
+    BoolProperty useCache_;
+};
+
+}  // namespace inviwo
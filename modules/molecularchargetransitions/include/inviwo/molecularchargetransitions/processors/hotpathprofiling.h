@@ -0,0 +1,82 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/buttonproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.HotPathProfiling, Hot Path Profiling}
+ * ![](org.inviwo.HotPathProfiling.png?classIdentifier=org.inviwo.HotPathProfiling)
+ *
+ * Switches the collection of timings and counters in the processors and algorithms of this module
+ * on and off (see HotPathProfiler), and exports the collected data. Collection is switched off
+ * again when the processor is removed.
+ *
+ * ### Outports
+ *   * __outport__ Summary per scope: number of calls, total and mean time, the summed up counters
+ * and the counters per second (for example voxels/s or bytes/s).
+ *
+ * ### Properties
+ *   * __enabled__ Collect timings and counters, until maxEvents events are collected.
+ *   * __refresh__ Update the summary with the events collected so far.
+ *   * __clear__ Remove all collected events.
+ *   * __maxEvents__ Number of events to keep, later events are dropped until the next clear.
+ *   * __traceFile__ File to export the events to, in the Chrome trace event format (json).
+ *   * __exportTrace__ Export the collected events to the trace file.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API HotPathProfiling : public Processor {
+public:
+    HotPathProfiling();
+    virtual ~HotPathProfiling();
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataFrameOutport outport_;
+    BoolProperty enabled_;
+    ButtonProperty refresh_;
+    ButtonProperty clear_;
+    SizeTProperty maxEvents_;
+    FileProperty traceFile_;
+    ButtonProperty exportTrace_;
+};
+
+}  // namespace inviwo
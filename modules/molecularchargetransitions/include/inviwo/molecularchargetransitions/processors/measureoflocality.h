@@ -33,6 +33,8 @@
 #include <inviwo/core/processors/processor.h>
 #include <inviwo/core/properties/ordinalproperty.h>
 #include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
 
 namespace inviwo {
 
@@ -65,6 +67,8 @@ private:
     DataFrameInport inport_;
     DataFrameOutport outport_;
     IntProperty nrSubgroups_;
+
+    ColumnViewCache columnViews_;
 };
 
 }  // namespace inviwo
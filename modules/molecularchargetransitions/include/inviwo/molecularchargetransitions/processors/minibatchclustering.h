@@ -0,0 +1,99 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/minibatchkmeans.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.MiniBatchClustering, Mini Batch Clustering}
+ * ![](org.inviwo.MiniBatchClustering.png?classIdentifier=org.inviwo.MiniBatchClustering)
+ *
+ * Processor to cluster a large ensemble of electronic transitions into micro-clusters by their
+ * hole and particle charges, with mini-batch k-means (see MiniBatchKMeans). The micro-clusters
+ * replace the members as input of the hierarchical clustering in CreateDendrogram (use "sg" as
+ * feature vector name), and DendrogramCut maps the clusters of the micro-clusters back to the
+ * members. Memory stays linear in the number of members, unlike the hierarchical clustering of
+ * all members. The outputs of the last few inputs are cached, as in ClusterStatistics.
+ *
+ * ### Inports
+ *   * __inport__   Dataframe containing hole charges and particle charges for each ensemble
+ * member.
+ *
+ * ### Outports
+ *   * __outport__ Micro-cluster of each member.
+ *   * __microClusters__ Micro-cluster, size and mean hole and particle charges of each
+ * micro-cluster, with the same column names as the input.
+ *
+ * ### Properties
+ *   * __nrSubgroups__ How many subgroups each member in the ensemble has.
+ *   * __nrMicroClusters__ Number of micro-clusters, empty ones are removed.
+ *   * __batchSize__ Number of members in each mini-batch.
+ *   * __nrBatches__ Number of mini-batch steps.
+ *   * __seed__ Seed of the random batches.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API MiniBatchClustering : public Processor {
+public:
+    MiniBatchClustering();
+    virtual ~MiniBatchClustering() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    struct Outputs {
+        std::shared_ptr<const DataFrame> members;
+        std::shared_ptr<const DataFrame> microClusters;
+    };
+    void setOutputs(const Outputs& outputs);
+
+    DataFrameInport inport_;
+    DataFrameOutport outport_;
+    DataFrameOutport microClustersOutport_;
+    IntProperty nrSubgroups_;
+    IntSizeTProperty nrMicroClusters_;
+    IntSizeTProperty batchSize_;
+    IntSizeTProperty nrBatches_;
+    IntProperty seed_;
+
+    ColumnViewCache columnViews_;
+    ResultCache<Outputs> results_;
+};
+
+}  // namespace inviwo
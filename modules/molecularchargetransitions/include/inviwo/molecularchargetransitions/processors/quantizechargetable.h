@@ -0,0 +1,83 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/boolproperty.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/util/chargequantization.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.QuantizeChargeTable, Quantize Charge Table}
+ * ![](org.inviwo.QuantizeChargeTable.png?classIdentifier=org.inviwo.QuantizeChargeTable)
+ *
+ * Stores the float columns of a charge table (e.g. the hole and particle charges or the charge
+ * transfer matrices) as half floats or fixed point numbers, which needs 2-4 times less memory for
+ * large ensembles. The processors of this module, including its Python processors, decode the
+ * columns when reading them (see ChargeQuantization), other processors see the raw uint16 or uint8
+ * codes. Fixed point numbers cannot store NaN, so columns with NaN are only stored as half floats.
+ *
+ * ### Inports
+ *   * __inport__ DataFrame with charges.
+ *
+ * ### Outports
+ *   * __outport__ DataFrame with quantized float columns, the other columns are copied.
+ *
+ * ### Properties
+ *   * __automatic__ Use the smallest format that is within the error bound for every column.
+ *   * __format__ Format of all columns if not automatic.
+ *   * __errorBound__ Largest absolute error of a quantized value, columns that would exceed it are
+ * kept as 32 bit floats.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API QuantizeChargeTable : public Processor {
+public:
+    QuantizeChargeTable();
+    virtual ~QuantizeChargeTable() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    DataFrameInport inport_;
+    DataFrameOutport outport_;
+
+    BoolProperty automatic_;
+    TemplateOptionProperty<ChargeQuantization::Format> format_;
+    FloatProperty errorBound_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,88 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/regionadjacency.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
+#include <memory>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.RegionAdjacencyGraph, Region Adjacency Graph}
+ * ![](org.inviwo.RegionAdjacencyGraph.png?classIdentifier=org.inviwo.RegionAdjacencyGraph)
+ *
+ * Computes which segmented regions touch, with the number of shared voxel faces, and the distances
+ * between the region centroids from a segmentation, e.g. the one used by
+ * SumChargeInSegmentedRegions (see RegionAdjacency). The volume is scanned in parallel slabs.
+ *
+ * The outputs of the last few segmentations are cached by the labels and the geometry (basis and
+ * offset) of the volume, so the graph is computed once per segmentation.
+ *
+ * ### Inports
+ *   * __segmentation__ Segmentation of the volume.
+ *
+ * ### Outports
+ *   * __edges__ One row per pair of touching regions, with the labels of both regions, the number
+ * of shared voxel faces and the distance between their centroids.
+ *   * __regions__ Number of voxels and centroid (in world space) of each region.
+ *   * __distances__ Distances between all region centroids, one column per region.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API RegionAdjacencyGraph : public Processor {
+public:
+    RegionAdjacencyGraph();
+    virtual ~RegionAdjacencyGraph() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    struct Outputs {
+        std::shared_ptr<const DataFrame> edges;
+        std::shared_ptr<const DataFrame> regions;
+        std::shared_ptr<const DataFrame> distances;
+    };
+    void setOutputs(const Outputs& outputs);
+
+    VolumeInport segmentation_;
+    DataFrameOutport edges_;
+    DataFrameOutport regions_;
+    DataFrameOutport distances_;
+
+    ResultCache<Outputs> results_;
+};
+
+}  // namespace inviwo
@@ -31,6 +31,8 @@
 
 #include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
 #include <inviwo/core/processors/processor.h>
+#include <inviwo/core/processors/progressbarowner.h>
+#include <inviwo/core/properties/boolproperty.h>
 #include <inviwo/core/properties/ordinalproperty.h>
 #include <inviwo/core/ports/volumeport.h>
 #include <inviwo/dataframe/datastructures/dataframe.h>
@@ -40,9 +42,17 @@
 #include <inviwo/core/util/indexmapper.h>
 #include <inviwo/core/properties/fileproperty.h>
 #include <inviwo/core/util/filesystem.h>
+#include <inviwo/molecularchargetransitions/algorithm/progressiveregionsum.h>
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/subgroupfile.h>
 #include <nlohmann/json.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
 #include <vector>
-#include <unordered_map>
 
 namespace inviwo {
 
@@ -52,6 +62,18 @@ namespace inviwo {
  * Sums up the values (charge) in a volume based on a segmentation of that volume. Also adds these
  * regions together based on a subgroup file provided.
  *
+ * The sum over the whole volume runs as a background job on the thread pool, in blocks with
+ * progress shown in the progress bar. New input stops a running job after the current blocks, and
+ * results of stopped jobs are never output. An error in the background is thrown by the next
+ * process(), which puts the processor in an error state. Without progressive mode the outports are
+ * empty until the result of the current input is done.
+ *
+ * In progressive mode an approximate result, with a change estimate, is computed from a coarse
+ * level of a resolution pyramid first (see ProgressiveRegionSum). It is then refined level by level
+ * in the background until the exact result replaces it. The majority label pyramid is kept as long
+ * as the segmentation is unchanged, so swapping charge densities only reads a fraction of the new
+ * volume for the first result.
+ *
  * ### Inports
  *   * __segmentation__ Segmentation of the volume.
  *   * __volumeValues__ The volume containing values (charges) that should be accumulated.
@@ -60,13 +82,26 @@ namespace inviwo {
  *   * __chargePerRegion__ Summed up value (charge) per segmented region.
  *   * __chargePerSubgroup__ Summed up value (charge) per subgroup, which is multiple regions.
  *
+ * In progressive mode both outports also have charge change estimate columns, zero for the exact
+ * result. They are a heuristic for how much a charge may still change, not a bound on its error.
+ * Like "Charge [%]" and charge_sg, the relative change estimates are fractions of the total charge.
+ * With spatial moments, both outports also have the charge weighted centroid, spread (standard
+ * deviation along each axis and root mean square radius) and dipole of each region or subgroup
+ * in world space (see SegmentedRegionSum::momentsPerRegion). They are computed in the same pass
+ * as the charges, and only for the exact result, the coarse estimates have the columns with NaN.
+ *
  * ### Properties
  *   * __fileLocation__ Path to a file stating which regions belong to each subgroup.
+ *   * __progressive__ Show a coarse estimate first and refine it in the background.
+ *   * __nrLevels__ Number of coarse levels, the first estimate reads 1 / 8^nrLevels of the volume.
+ *   * __moments__ Add the spatial moment columns.
  */
-class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API SumChargeInSegmentedRegions : public Processor {
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API SumChargeInSegmentedRegions
+    : public Processor,
+      public ProgressBarOwner {
 public:
     SumChargeInSegmentedRegions();
-    virtual ~SumChargeInSegmentedRegions() = default;
+    virtual ~SumChargeInSegmentedRegions();
 
     virtual void process() override;
 
@@ -79,6 +114,23 @@ private:
     DataFrameOutport chargePerRegion_;
     DataFrameOutport chargePerSubgroup_;
     FileProperty fileLocation_;
+    BoolProperty progressive_;
+    IntSizeTProperty nrLevels_;
+    BoolProperty moments_;
+
+    void setOutputs(const ProgressiveRegionSum::Estimate& estimate);
+
+    size_t firstRegion_ = 0;
+    std::vector<SubgroupFile::Subgroup> subgroups_;
+    std::shared_ptr<const ProgressiveRegionSum::LabelPyramid> labelPyramid_;
+    std::weak_ptr<const Volume> labelPyramidSource_;
+
+    // Incremented for each new input, background refinements of older input are dropped
+    std::shared_ptr<std::atomic<size_t>> generation_;
+    std::shared_ptr<bool> alive_;
+    std::optional<ProgressiveRegionSum::Estimate> refined_;
+    // Error of a background refinement, thrown by the next process()
+    std::optional<std::string> error_;
 };
 
 }  // namespace inviwo
@@ -0,0 +1,100 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/ordinalproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <optional>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.SyntheticEnsembleSource, Synthetic Ensemble Source}
+ * ![](org.inviwo.SyntheticEnsembleSource.png?classIdentifier=org.inviwo.SyntheticEnsembleSource)
+ *
+ * Generates a synthetic ensemble of electronic transitions with a given seed, to be used for
+ * testing and performance evaluation of the pipeline at production sizes. The same seed and
+ * settings always give the same data.
+ *
+ * ### Outports
+ *   * __segmentation__ Segmentation with the given number of regions (uint16, labels from 0).
+ *   * __holeDensity__ Hole charge density of the selected member.
+ *   * __particleDensity__ Particle charge density of the selected member.
+ *   * __ensemble__ Cluster, hole and particle charges for each subgroup of all members (same column
+ * names as the ensemble tables, "Hole sg1", "Particle sg1" etc.).
+ *
+ * ### Properties
+ *   * __seed__ Seed of the generated data.
+ *   * __dimensions__ Dimensions of the volumes.
+ *   * __nrRegions__ Number of segmented regions.
+ *   * __nrSubgroups__ Number of subgroups, each subgroup is made up of consecutive regions.
+ *   * __nrMembers__ Number of ensemble members.
+ *   * __nrClusters__ Number of clusters the members are drawn around.
+ *   * __clusterSpread__ Standard deviation of the member charges around the cluster prototypes.
+ *   * __member__ The member to generate the densities for. Changing it only regenerates the two
+ * densities.
+ *   * __subgroupFile__ If set, the subgroups are written to this file (json), to be used in
+ * SumChargeInSegmentedRegions.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API SyntheticEnsembleSource : public Processor {
+public:
+    SyntheticEnsembleSource();
+    virtual ~SyntheticEnsembleSource() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    VolumeOutport segmentation_;
+    VolumeOutport holeDensity_;
+    VolumeOutport particleDensity_;
+    DataFrameOutport ensemble_;
+
+    IntSizeTProperty seed_;
+    IntSize3Property dimensions_;
+    IntSizeTProperty nrRegions_;
+    IntSizeTProperty nrSubgroups_;
+    IntSizeTProperty nrMembers_;
+    IntSizeTProperty nrClusters_;
+    FloatProperty clusterSpread_;
+    IntSizeTProperty member_;
+    FileProperty subgroupFile_;
+
+    std::optional<SyntheticEnsemble> generator_;
+};
+
+}  // namespace inviwo
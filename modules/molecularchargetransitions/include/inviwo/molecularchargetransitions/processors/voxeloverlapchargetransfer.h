@@ -0,0 +1,92 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/processors/processor.h>
+#include <inviwo/core/properties/optionproperty.h>
+#include <inviwo/core/properties/fileproperty.h>
+#include <inviwo/core/ports/volumeport.h>
+#include <inviwo/dataframe/datastructures/dataframe.h>
+#include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/molecularchargetransitions/util/subgroupfile.h>
+
+namespace inviwo {
+
+/** \docpage{org.inviwo.VoxelOverlapChargeTransfer, Voxel Overlap Charge Transfer}
+ * ![](org.inviwo.VoxelOverlapChargeTransfer.png?classIdentifier=org.inviwo.VoxelOverlapChargeTransfer)
+ *
+ * Computes the charge transfer matrix from the hole and particle densities of a transition. Both
+ * densities are normalized to a total charge of one, as the charges of SumChargeInSegmentedRegions,
+ * and streamed together over the volumes. The charge that overlaps at voxel level (min of hole and
+ * particle) stays in its region, and the remaining hole charge of each region is transferred to the
+ * particle charge that does not overlap, in the same or other regions. The columns of the matrix
+ * sum up to the hole charges and the rows to the particle charges, so it can be used as input to
+ * ComputeChargeTransfer instead of the heuristic based on the subgroup charges.
+ *
+ * ### Inports
+ *   * __segmentation__ Segmentation of the volume.
+ *   * __holeDensity__ Hole charge density.
+ *   * __particleDensity__ Particle charge density.
+ *
+ * ### Outports
+ *   * __chargeTransfer__ Charge transfer matrix, same form as in ComputeChargeTransfer.
+ *   * __chargeDifference__ Charge difference (particle - hole) per subgroup.
+ *   * __overlap__ Hole and particle charge and overlap of the densities per subgroup, normalized.
+ *
+ * ### Properties
+ *   * __fileLocation__ Path to a file stating which regions belong to each subgroup. If empty, the
+ * matrix is computed for the segmented regions.
+ *   * __coupling__ Transfer to all regions, or only within the region and to adjacent regions.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API VoxelOverlapChargeTransfer : public Processor {
+public:
+    VoxelOverlapChargeTransfer();
+    virtual ~VoxelOverlapChargeTransfer() = default;
+
+    virtual void process() override;
+
+    virtual const ProcessorInfo& getProcessorInfo() const override;
+    static const ProcessorInfo processorInfo_;
+
+private:
+    VolumeInport segmentation_;
+    VolumeInport holeDensity_;
+    VolumeInport particleDensity_;
+    DataFrameOutport chargeTransfer_;
+    DataFrameOutport chargeDifference_;
+    DataFrameOutport overlap_;
+
+    FileProperty fileLocation_;
+    TemplateOptionProperty<ChargeTransferMatrix::Coupling> coupling_;
+};
+
+}  // namespace inviwo
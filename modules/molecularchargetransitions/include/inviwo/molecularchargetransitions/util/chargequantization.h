@@ -0,0 +1,101 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+#include <cstdint>
+#include <optional>
+
+namespace inviwo {
+
+/**
+ * Reduced precision storage of charge columns (hole, particle, charge difference and charge
+ * transfer), which are in [0, 1] or [-1, 1] and need far less than 32 bit floats.
+ *
+ *     * Float16 stores IEEE half floats in uint16 (relative error 2^-11, rounded to nearest even).
+ *     * Fixed16 and Fixed8 store value = offset + scale * code in uint16 or uint8, where offset
+ *       and scale map [min, max] of the column to all codes (absolute error scale / 2, plus the
+ *       rounding of the decoded value to float). The codes are computed in double precision,
+ *       values outside [min, max] are clamped and NaN becomes code 0.
+ *
+ * The encoding of a quantized column is stored in the meta data of its buffer, so that
+ * ColumnView decodes it to floats (once per buffer when used through a ColumnViewCache). The
+ * conversion loops are branch free and are vectorized by the compiler.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ChargeQuantization {
+public:
+    enum class Format { Float32, Float16, Fixed16, Fixed8 };
+
+    struct Encoding {
+        Format format = Format::Float32;
+        double offset = 0.0;
+        double scale = 1.0;
+    };
+
+    /**
+     * Encoding of values in [min, max] with the given format.
+     */
+    static Encoding encoding(Format format, double min, double max);
+
+    /**
+     * The largest absolute error of values in [min, max] stored with the given encoding.
+     */
+    static double maxError(const Encoding& encoding, double min, double max);
+
+    /**
+     * The encoding with the fewest bytes per value whose error for values in [min, max] is at most
+     * errorBound. Of two formats with the same size the one with the smaller error is used, and
+     * Float32 if no format is accurate enough.
+     */
+    static Encoding choose(double min, double max, double errorBound);
+
+    static size_t bytesPerValue(Format format);
+
+    static void toHalf(const float* src, uint16_t* dst, size_t n);
+    static void fromHalf(const uint16_t* src, float* dst, size_t n);
+    static void toFixed(const float* src, uint16_t* dst, size_t n, const Encoding& encoding);
+    static void toFixed(const float* src, uint8_t* dst, size_t n, const Encoding& encoding);
+    static void fromFixed(const uint16_t* src, float* dst, size_t n, const Encoding& encoding);
+    static void fromFixed(const uint8_t* src, float* dst, size_t n, const Encoding& encoding);
+
+    static void setEncoding(BufferBase& buffer, const Encoding& encoding);
+
+    /**
+     * The encoding of a quantized buffer, or nothing for a buffer with plain values.
+     */
+    static std::optional<Encoding> encodingOf(const BufferBase& buffer);
+
+    /**
+     * Decodes a quantized buffer (see encodingOf) into dst, which has room for all values.
+     */
+    static void decode(const BufferBase& buffer, const Encoding& encoding, float* dst);
+};
+
+}  // namespace inviwo
@@ -0,0 +1,187 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/chargequantization.h>
+#include <inviwo/core/datastructures/buffer/bufferram.h>
+#include <inviwo/core/util/formatdispatching.h>
+#include <inviwo/dataframe/datastructures/column.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Read only access to the data of a DataFrame column as type T.
+ *
+ * If the column buffer already holds values of type T, the view refers directly to the buffer data
+ * (and keeps the buffer alive), nothing is copied. Otherwise the values are converted to T on the
+ * first access of the data, and the converted values are shared between all copies of the view
+ * and the ColumnViewCache the view came from.
+ *
+ * Quantized columns (see ChargeQuantization) are decoded to their values when T is a floating
+ * point type, and give the raw codes otherwise.
+ *
+ * The lazy conversion is not thread safe, call data() once before sharing a view between threads.
+ */
+template <typename T>
+class ColumnView {
+public:
+    ColumnView() = default;
+    explicit ColumnView(std::shared_ptr<const Column> column);
+
+    const T* data() const;
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size_; }
+    const T& operator[](size_t i) const { return data()[i]; }
+
+    /**
+     * True if the column data is not of type T, i.e. if accessing the data makes a converted copy.
+     */
+    bool isConverted() const { return converted_ != nullptr; }
+
+    /**
+     * The encoding of a quantized column that is decoded by the view.
+     */
+    const std::optional<ChargeQuantization::Encoding>& encoding() const { return encoding_; }
+
+private:
+    friend class ColumnViewCache;
+    struct Converted {
+        std::vector<T> data;
+        bool done = false;
+    };
+
+    std::shared_ptr<const BufferBase> buffer_;
+    mutable const T* data_ = nullptr;
+    size_t size_ = 0;
+    std::optional<ChargeQuantization::Encoding> encoding_;
+    std::shared_ptr<Converted> converted_;
+};
+
+/**
+ * Keeps the converted data of ColumnViews alive between evaluations, so that a processor only
+ * converts a column once as long as its input buffer is the same. Buffers are identified by their
+ * address, which assumes that inport data is not modified in place.
+ */
+class ColumnViewCache {
+public:
+    template <typename T>
+    ColumnView<T> get(std::shared_ptr<const Column> column);
+
+    void clear() { entries_.clear(); }
+
+private:
+    struct Entry {
+        std::weak_ptr<const BufferBase> buffer;
+        std::type_index type;
+        std::shared_ptr<void> converted;
+    };
+    std::vector<Entry> entries_;
+};
+
+template <typename T>
+ColumnView<T>::ColumnView(std::shared_ptr<const Column> column) : buffer_{column->getBuffer()} {
+    size_ = buffer_->getSize();
+    if constexpr (std::is_floating_point_v<T>) {
+        encoding_ = ChargeQuantization::encodingOf(*buffer_);
+        if (encoding_) {
+            converted_ = std::make_shared<Converted>();
+            return;
+        }
+    }
+    buffer_->getRepresentation<BufferRAM>()->dispatch<void, dispatching::filter::Scalars>(
+        [&](auto buf) {
+            using ValueType = util::PrecisionValueType<decltype(buf)>;
+            if constexpr (std::is_same_v<ValueType, T>) {
+                data_ = buf->getDataContainer().data();
+            } else {
+                converted_ = std::make_shared<Converted>();
+            }
+        });
+}
+
+template <typename T>
+const T* ColumnView<T>::data() const {
+    if (data_ || !converted_) return data_;
+
+    if (!converted_->done && encoding_) {
+        if constexpr (std::is_same_v<T, float>) {
+            converted_->data.resize(size_);
+            ChargeQuantization::decode(*buffer_, *encoding_, converted_->data.data());
+        } else {
+            std::vector<float> decoded(size_);
+            ChargeQuantization::decode(*buffer_, *encoding_, decoded.data());
+            converted_->data.assign(decoded.begin(), decoded.end());
+        }
+        converted_->done = true;
+    } else if (!converted_->done) {
+        buffer_->getRepresentation<BufferRAM>()->dispatch<void, dispatching::filter::Scalars>(
+            [&](auto buf) {
+                const auto& src = buf->getDataContainer();
+                converted_->data.resize(src.size());
+                std::transform(src.begin(), src.end(), converted_->data.begin(),
+                               [](auto v) { return static_cast<T>(v); });
+            });
+        converted_->done = true;
+    }
+    data_ = converted_->data.data();
+    return data_;
+}
+
+template <typename T>
+ColumnView<T> ColumnViewCache::get(std::shared_ptr<const Column> column) {
+    entries_.erase(std::remove_if(entries_.begin(), entries_.end(),
+                                  [](const Entry& e) { return e.buffer.expired(); }),
+                   entries_.end());
+
+    ColumnView<T> view(column);
+    if (!view.isConverted()) return view;
+
+    auto it = std::find_if(entries_.begin(), entries_.end(), [&](const Entry& e) {
+        return e.buffer.lock() == view.buffer_ && e.type == std::type_index(typeid(T));
+    });
+    if (it != entries_.end()) {
+        using Converted = typename ColumnView<T>::Converted;
+        view.converted_ = std::static_pointer_cast<Converted>(it->converted);
+    } else {
+        entries_.push_back(Entry{view.buffer_, std::type_index(typeid(T)), view.converted_});
+    }
+    return view;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,128 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <inviwo/core/util/glm.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Reads Gaussian cube files, on the form
+ *
+ *     two comment lines
+ *     nrAtoms originX originY originZ
+ *     n1 step1X step1Y step1Z
+ *     n2 step2X step2Y step2Z
+ *     n3 step3X step3Y step3Z
+ *     atomicNumber charge x y z  (nrAtoms lines)
+ *     values, n1 * n2 * n3 in total with the third axis fastest
+ *
+ * A negative number of atoms is followed by a line with the number of data sets and their ids,
+ * only one data set is supported. Negative voxel counts mean that the units are Ångström instead
+ * of Bohr, the values are returned in the units of the file.
+ *
+ * The data section is split into chunks that are parsed in parallel using std::from_chars, and
+ * the values are reordered to have the first axis fastest, as in an Inviwo volume.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API CubeFile {
+public:
+    struct Atom {
+        int atomicNumber;
+        double charge;
+        dvec3 position;
+    };
+
+    struct Cube {
+        std::string comment;  // The two comment lines
+        size3_t dims{0};
+        dvec3 origin{0.0};
+        dmat3 basis{};  // Step between voxels along each axis (columns)
+        bool angstrom = false;
+        std::vector<Atom> atoms;
+        std::unique_ptr<float[]> values;  // dims voxels, x fastest
+    };
+
+    /**
+     * Identifies the content of a cube file without reading all of it, from its size, modification
+     * time and a hash of the first and last 64 KiB.
+     */
+    struct Key {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        uint64_t hash = 0;
+        bool operator==(const Key& other) const {
+            return size == other.size && modified == other.modified && hash == other.hash;
+        }
+        bool operator!=(const Key& other) const { return !(*this == other); }
+    };
+
+    /**
+     * Parses the text of a cube file.
+     */
+    static Cube parse(std::string_view text, size_t nrThreads = util::defaultThreadCount());
+
+    static Cube read(const std::string& path, size_t nrThreads = util::defaultThreadCount());
+
+    /**
+     * Reads the cube from the binary cache next to the file (see cachePath) if it matches the
+     * key of the file, otherwise parses the file and writes the cache. Failing to write the cache,
+     * e.g. in a read only directory, is not an error.
+     */
+    static Cube load(const std::string& path, bool useCache = true,
+                     size_t nrThreads = util::defaultThreadCount());
+
+    static Key key(const std::string& path);
+
+    /**
+     * The binary cache of a cube file, the cube file path with the extension ".ivwcube" added.
+     */
+    static std::string cachePath(const std::string& path);
+
+    /**
+     * The cache has a fixed size header (including the key), the comment and the atoms followed by
+     * the values as floats (x fastest), starting at a multiple of 64 bytes so that the file can be
+     * memory mapped. Returns false if the cache could not be written.
+     */
+    static bool writeCache(const Cube& cube, const Key& key, const std::string& cachePath);
+
+    /**
+     * Returns the cached cube if the cache exists and was written for a file with the given key.
+     */
+    static std::optional<Cube> readCache(const std::string& cachePath, const Key& key);
+};
+
+}  // namespace inviwo
@@ -0,0 +1,141 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/molecularchargetransitions/util/parallel.h>
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace inviwo {
+
+namespace util {
+
+/**
+ * Compensated (Neumaier) sum in double precision. The rounding error of each addition is
+ * accumulated separately, so the sum is exact to about the last bit of a double regardless of the
+ * number or magnitude of the terms.
+ */
+class CompensatedSum {
+public:
+    void add(double value) {
+        const auto t = sum_ + value;
+        if (std::abs(sum_) >= std::abs(value)) {
+            compensation_ += (sum_ - t) + value;
+        } else {
+            compensation_ += (value - t) + sum_;
+        }
+        sum_ = t;
+    }
+    CompensatedSum& operator+=(const CompensatedSum& other) {
+        add(other.sum_);
+        add(other.compensation_);
+        return *this;
+    }
+    double value() const { return sum_ + compensation_; }
+
+private:
+    double sum_ = 0.0;
+    double compensation_ = 0.0;
+};
+
+/**
+ * Reduction of [0, n) with a result that only depends on n and blockSize, not on the number of
+ * threads. [0, n) is split into fixed blocks of blockSize elements, block(thread, begin, end)
+ * reduces one block and the blocks are processed in parallel (see parallelForRanges). The block
+ * results are then merged with merge(a, b), a = a + b, in a fixed pairwise tree: neighbouring
+ * blocks first, then neighbouring pairs and so on. Floating point sums are thereby bit-identical
+ * for any thread count. Returns identity if n is zero.
+ *
+ * Each thread gets whole aligned subtrees of a power of two blocks and merges them as the blocks
+ * are done, so only a few results per thread are alive at a time instead of one per block, which
+ * matters for large results such as one accumulator per region.
+ *
+ * thread is only meant for thread local scratch data whose result does not depend on the order,
+ * e.g. integer counts.
+ *
+ * Used for the sums of this module that are split over threads: SegmentedRegionSum::sumPerRegion
+ * and momentsPerRegion (same blocks, so the charges are identical with and without moments),
+ * ChargeTransferMatrix::accumulateRegionOverlap and the final means of MiniBatchKMeans. The
+ * ensemble optimal transport instead chains its warm starts within fixed blocks of members (see
+ * ChargeTransferMatrix::TransportSettings), and the other parallel loops write disjoint outputs.
+ * Changing a blockSize changes the results in the last bits, and they are not bit-identical to a
+ * plain sequential sum.
+ */
+template <typename T, typename BlockFunc, typename MergeFunc>
+T deterministicReduce(size_t n, size_t blockSize, T identity, BlockFunc&& block,
+                      MergeFunc&& merge, size_t nrThreads = defaultThreadCount()) {
+    blockSize = std::max<size_t>(1, blockSize);
+    const auto nrBlocks = (n + blockSize - 1) / blockSize;
+    if (nrBlocks == 0) return identity;
+
+    // Subtrees of a power of two blocks, about four per thread for the load balance
+    nrThreads = std::max<size_t>(1, nrThreads);
+    size_t subtreeBlocks = 1;
+    while (subtreeBlocks * 4 * nrThreads < nrBlocks) subtreeBlocks *= 2;
+    const auto nrSubtrees = (nrBlocks + subtreeBlocks - 1) / subtreeBlocks;
+
+    std::vector<T> results(nrSubtrees, identity);
+    parallelForRanges(nrSubtrees, nrThreads, [&](size_t thread, size_t first, size_t last) {
+        // Results of complete subtrees of 2^level blocks, the last one is the most recent
+        std::vector<std::pair<T, size_t>> stack;
+        for (size_t t = first; t < last; t++) {
+            const auto end = std::min(nrBlocks, (t + 1) * subtreeBlocks);
+            for (size_t b = t * subtreeBlocks; b < end; b++) {
+                stack.emplace_back(block(thread, b * blockSize, std::min(n, (b + 1) * blockSize)),
+                                   0);
+                while (stack.size() > 1 && stack.back().second == stack[stack.size() - 2].second) {
+                    merge(stack[stack.size() - 2].first, stack.back().first);
+                    stack[stack.size() - 2].second++;
+                    stack.pop_back();
+                }
+            }
+            // The subtree of the last blocks may be incomplete, its right part is merged first
+            while (stack.size() > 1) {
+                merge(stack[stack.size() - 2].first, stack.back().first);
+                stack.pop_back();
+            }
+            results[t] = std::move(stack.back().first);
+            stack.clear();
+        }
+    });
+
+    for (size_t stride = 1; stride < nrSubtrees; stride *= 2) {
+        for (size_t b = 0; b + stride < nrSubtrees; b += 2 * stride) {
+            merge(results[b], results[b + stride]);
+        }
+    }
+    return std::move(results.front());
+}
+
+}  // namespace util
+
+}  // namespace inviwo
@@ -0,0 +1,141 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <nlohmann/json.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Collects scoped timings and counters (voxels, bytes, rows etc.) of the hot paths in
+ * the processors and algorithms of this module, to be able to profile a whole ensemble batch
+ * without an external profiler.
+ *
+ * Collection is disabled by default and can be switched on and off at runtime. When disabled, a
+ * ScopedTimer costs a single relaxed atomic load and its counters are no-ops. At most maxEvents
+ * events are kept, later events are dropped and counted until the next clear().
+ *
+ * Usage:
+ *
+ *     HotPathProfiler::ScopedTimer timer("SegmentedRegionSum::sumPerRegion");
+ *     ...
+ *     timer.count("voxels", nrVoxels);
+ *
+ * The collected events can be exported as Chrome trace event json (chrome://tracing, Perfetto) or
+ * summarized per scope, see the HotPathProfiling processor.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API HotPathProfiler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::string name;
+        size_t thread;            // Small thread index, in order of first appearance
+        Clock::duration start;    // Relative to the time of the last clear()
+        Clock::duration duration;
+        std::vector<std::pair<std::string, double>> counters;
+    };
+
+    static constexpr size_t defaultMaxEvents = size_t{1} << 20;
+
+    struct Summary {
+        std::string name;
+        size_t calls = 0;
+        Clock::duration total{0};
+        std::vector<std::pair<std::string, double>> counters;  // Summed over all calls
+    };
+
+    class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API ScopedTimer {
+    public:
+        explicit ScopedTimer(const char* name);
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+        ~ScopedTimer();
+
+        void count(const char* counter, double value) {
+            if (profiler_) counters_.emplace_back(counter, value);
+        }
+
+    private:
+        HotPathProfiler* profiler_;
+        const char* name_;
+        Clock::time_point start_;
+        std::vector<std::pair<std::string, double>> counters_;
+    };
+
+    static HotPathProfiler& getInstance();
+
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+    void setEnabled(bool enabled);
+    void clear();
+
+    size_t getMaxEvents() const;
+    void setMaxEvents(size_t maxEvents);
+    /**
+     * Number of events dropped since the last clear() because maxEvents were already kept.
+     */
+    size_t getDroppedEvents() const;
+
+    std::vector<Event> getEvents() const;
+
+    /**
+     * Events summarized per scope name, in order of first appearance.
+     */
+    std::vector<Summary> summarize() const;
+
+    /**
+     * Events in the Chrome trace event format (complete events, "ph": "X", timestamps in
+     * microseconds), with the counters as event args.
+     */
+    nlohmann::json toChromeTrace() const;
+
+private:
+    HotPathProfiler();
+    void record(const char* name, Clock::time_point start, Clock::time_point end,
+                std::vector<std::pair<std::string, double>> counters);
+
+    std::atomic<bool> enabled_;
+    Clock::time_point epoch_;
+    mutable std::mutex mutex_;
+    std::vector<Event> events_;
+    size_t maxEvents_;
+    size_t droppedEvents_;
+    std::unordered_map<std::thread::id, size_t> threads_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,95 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Mergeable quantile sketch of a stream of values (Karnin, Lang and Liberty 2016), to get
+ * approximate quantiles in one pass and bounded memory. The values are kept in compactors of
+ * increasing weight: when the sketch is full the lowest full compactor is sorted and every other
+ * value, starting at a random first or second, moves to the next compactor with twice the weight.
+ *
+ * Keeps about 3k values, and the rank error of a quantile is about 1.7 / k of the number of
+ * values (k = 200 gives ~1%). Merging two sketches gives the same accuracy as a sketch of both
+ * streams, so sketches of clusters can be merged into sketches of the clusters above them. The
+ * random choices come from the seed, so a sketch of the same stream is always the same.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API KllSketch {
+public:
+    explicit KllSketch(size_t k = 200, uint64_t seed = 0);
+
+    void add(float value);
+    void merge(const KllSketch& other);
+
+    /**
+     * Number of values added, and number of values kept.
+     */
+    size_t count() const { return count_; }
+    size_t size() const { return size_; }
+    float min() const { return min_; }
+    float max() const { return max_; }
+
+    /**
+     * Approximate quantile q in [0, 1], NaN for an empty sketch. Quantile 0 and 1 are the exact
+     * minimum and maximum.
+     */
+    float quantile(double q) const;
+    std::vector<float> quantiles(const std::vector<double>& qs) const;
+
+    /**
+     * Sketches of all nodes of a merge tree from the sketches of its leaves, in the layout of
+     * DendrogramIndex: merge i joins the nodes first[i] and second[i] into node leaves.size() + i.
+     */
+    static std::vector<KllSketch> mergeUp(std::vector<KllSketch> leaves,
+                                          const std::vector<size_t>& first,
+                                          const std::vector<size_t>& second);
+
+private:
+    size_t capacity(size_t level) const;
+    void updateMaxSize();
+    void compress();
+    bool coin();
+
+    size_t k_;
+    uint64_t state_;
+    size_t count_ = 0;
+    size_t size_ = 0;
+    size_t maxSize_ = 0;  // Sum of the capacities of the levels
+    float min_;
+    float max_;
+    std::vector<std::vector<float>> levels_;
+};
+
+}  // namespace inviwo
@@ -0,0 +1,100 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace inviwo {
+
+namespace util {
+
+/**
+ * Number of threads used by the module algorithms, one per hardware thread. The environment
+ * variable IVW_THREAD_COUNT overrides it, e.g. for several Inviwo processes sharing a machine
+ * (see scripts/generate_data_sharded.py).
+ */
+inline size_t defaultThreadCount() {
+    static const size_t count = []() -> size_t {
+        if (const char* env = std::getenv("IVW_THREAD_COUNT")) {
+            if (const auto n = std::strtoul(env, nullptr, 10); n > 0) return n;
+        }
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }();
+    return count;
+}
+
+/**
+ * Splits [0, n) into at most nrThreads contiguous ranges of (almost) equal size and calls
+ * func(thread, begin, end) for each range on its own thread, where thread is the index of the
+ * range. The first range is processed on the calling thread. Exceptions thrown by func are
+ * rethrown on the calling thread after all threads have finished.
+ *
+ * The algorithms in the module do not depend on the InviwoApplication thread pool, so that they
+ * can be used in unit tests and benchmarks as well.
+ */
+template <typename Func>
+void parallelForRanges(size_t n, size_t nrThreads, Func&& func) {
+    nrThreads = std::max<size_t>(1, std::min(nrThreads, n));
+    if (nrThreads == 1) {
+        func(size_t{0}, size_t{0}, n);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(nrThreads);
+    const auto run = [&](size_t thread) {
+        try {
+            func(thread, thread * n / nrThreads, (thread + 1) * n / nrThreads);
+        } catch (...) {
+            errors[thread] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(nrThreads - 1);
+    for (size_t thread = 1; thread < nrThreads; thread++) {
+        threads.emplace_back(run, thread);
+    }
+    run(0);
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (auto& error : errors) {
+        if (error) std::rethrow_exception(error);
+    }
+}
+
+}  // namespace util
+
+}  // namespace inviwo
@@ -0,0 +1,111 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <inviwo/dataframe/datastructures/column.h>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace inviwo {
+
+/**
+ * 64 bit hash of the inputs of a processor, i.e. the values of the columns it reads and its
+ * settings, used as key of a ResultCache. Columns are hashed by header, data format, quantization
+ * encoding and values, so equal data in new buffers (e.g. after an upstream change that did not
+ * affect the charges) gives the same key. Not a cryptographic hash.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API InputHash {
+public:
+    /**
+     * Adds a column, a missing column (nullptr) is hashed as well.
+     */
+    InputHash& add(const Column* column);
+    InputHash& add(std::string_view string);
+    InputHash& add(const void* data, size_t size);
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    InputHash& add(T value) {
+        return add(&value, sizeof(value));
+    }
+
+    uint64_t value() const { return hash_; }
+
+private:
+    uint64_t hash_ = 0x6a09e667f3bcc908ull;
+};
+
+/**
+ * Least recently used cache of processor results by InputHash. find moves the result to the
+ * front, insert adds it there and drops the least recently used results beyond the capacity.
+ */
+template <typename T>
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity = 8) : capacity_{capacity} {}
+
+    const T* find(uint64_t key);
+    void insert(uint64_t key, T result);
+    void clear() { entries_.clear(); }
+    size_t size() const { return entries_.size(); }
+    size_t capacity() const { return capacity_; }
+
+private:
+    size_t capacity_;
+    std::list<std::pair<uint64_t, T>> entries_;  // Most recently used first
+};
+
+template <typename T>
+const T* ResultCache<T>::find(uint64_t key) {
+    for (auto it = entries_.begin(); it != entries_.end(); ++it) {
+        if (it->first == key) {
+            entries_.splice(entries_.begin(), entries_, it);
+            return &entries_.front().second;
+        }
+    }
+    return nullptr;
+}
+
+template <typename T>
+void ResultCache<T>::insert(uint64_t key, T result) {
+    if (find(key)) {
+        entries_.front().second = std::move(result);
+        return;
+    }
+    entries_.emplace_front(key, std::move(result));
+    while (entries_.size() > capacity_) {
+        entries_.pop_back();
+    }
+}
+
+}  // namespace inviwo
@@ -0,0 +1,61 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#pragma once
+
+#include <inviwo/molecularchargetransitions/molecularchargetransitionsmoduledefine.h>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+namespace inviwo {
+
+/**
+ * Reads the subgroup file stating which segmented regions belong to each subgroup, on the form
+ *
+ *     [{"name": "sg1", "indices": [0, 1]}, {"name": "sg2", "indices": [2]}, ...]
+ *
+ * where the indices are region indices, i.e. label minus the smallest label in the segmentation.
+ */
+class IVW_MODULE_MOLECULARCHARGETRANSITIONS_API SubgroupFile {
+public:
+    struct Subgroup {
+        std::string name;
+        std::vector<size_t> indices;
+    };
+
+    static std::vector<Subgroup> read(const std::string& path);
+    static std::vector<Subgroup> fromJson(const nlohmann::json& json);
+
+    /**
+     * Total number of region indices in all subgroups.
+     */
+    static size_t nrRegions(const std::vector<Subgroup>& subgroups);
+};
+
+}  // namespace inviwo
@@ -28,13 +28,23 @@
  *********************************************************************************/
 
 #include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+#include <atomic>
+#include <cmath>
 
 namespace inviwo {
 
-std::pair<std::vector<std::vector<float>>, std::vector<float>>
-ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
-    std::vector<float> holeCharges, std::vector<float> particleCharges) {
+namespace {
 
+using Transfer = std::pair<std::vector<std::vector<float>>, std::vector<float>>;
+
+// The solvers without profiling, so that the ensemble versions record one event per ensemble
+
+// Without donors or acceptors, the ensemble (degenerate) keeps only the diagonal, as the optimal
+// transport does, instead of throwing
+Transfer subgroupHeuristic(const std::vector<float>& holeCharges,
+                           const std::vector<float>& particleCharges, bool degenerate = false) {
     if (holeCharges.size() == 0 || particleCharges.size() == 0) {
         throw Exception("Empty particle and/or hole charges.",
                         IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
@@ -70,6 +80,7 @@ ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
     }
 
     if (donors.size() == 0 || acceptors.size() == 0) {
+        if (degenerate) return {chargeTransfer, chargeDifference};
         throw Exception("No acceptors and/or donors (not valid).",
                         IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
     }
@@ -88,8 +99,340 @@ ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
         }
     }
 
-    return std::pair<std::vector<std::vector<float>>, std::vector<float>>{chargeTransfer,
-                                                                          chargeDifference};
+    return {chargeTransfer, chargeDifference};
+}
+
+Transfer optimalTransport(const std::vector<float>& holeCharges,
+                          const std::vector<float>& particleCharges,
+                          const std::vector<double>& cost,
+                          const ChargeTransferMatrix::TransportSettings& settings,
+                          ChargeTransferMatrix::TransportState* state) {
+    const auto n = holeCharges.size();
+    if (n == 0 || particleCharges.size() == 0) {
+        throw Exception("Empty particle and/or hole charges.",
+                        IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
+    }
+    if (particleCharges.size() != n) {
+        throw Exception("Particle and hole charges not same size.",
+                        IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
+    }
+    if (cost.size() != n * n) {
+        throw Exception("Transport cost must have one element per pair of subgroups.",
+                        IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
+    }
+
+    std::vector<std::vector<float>> chargeTransfer(n, std::vector<float>(n, 0.0f));
+    std::vector<float> chargeDifference(n);
+    std::vector<size_t> donors;
+    std::vector<size_t> acceptors;
+    double totalDonated = 0.0;
+    double totalAccepted = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        chargeDifference[i] = particleCharges[i] - holeCharges[i];
+        chargeTransfer[i][i] = std::min(holeCharges[i], particleCharges[i]);
+        if (chargeDifference[i] < 0.0f) {
+            donors.push_back(i);
+            totalDonated -= chargeDifference[i];
+        } else if (chargeDifference[i] > 0.0f) {
+            acceptors.push_back(i);
+            totalAccepted += chargeDifference[i];
+        }
+    }
+    if (state) state->iterations = 0;
+    // Nothing is transferred, only the diagonal
+    if (donors.empty() || acceptors.empty()) return {chargeTransfer, chargeDifference};
+
+    const auto nd = donors.size();
+    const auto na = acceptors.size();
+    std::vector<double> donated(nd);
+    std::vector<double> accepted(na);
+    for (size_t d = 0; d < nd; d++) donated[d] = -chargeDifference[donors[d]];
+    // Scale the acceptor charges to the donated charge so that the marginals balance
+    for (size_t a = 0; a < na; a++) {
+        accepted[a] = chargeDifference[acceptors[a]] * (totalDonated / totalAccepted);
+    }
+
+    double maxCost = 0.0;
+    for (auto d : donors) {
+        for (auto a : acceptors) maxCost = std::max(maxCost, cost[d * n + a]);
+    }
+    // exp(-cost / epsilon) must not underflow for the largest cost
+    const auto epsilon =
+        maxCost > 0.0 ? std::max(settings.epsilon * maxCost, maxCost / 700.0) : 1.0;
+    std::vector<double> kernel(nd * na);
+    for (size_t d = 0; d < nd; d++) {
+        for (size_t a = 0; a < na; a++) {
+            kernel[d * na + a] = std::exp(-cost[donors[d] * n + acceptors[a]] / epsilon);
+        }
+    }
+
+    // Warm start from the scaling of an earlier solution, if it has the same subgroups
+    const auto warmStart = state && state->donorScaling.size() == n &&
+                           state->acceptorScaling.size() == n;
+    const auto initial = [](const std::vector<double>& scaling, size_t i) {
+        return std::isfinite(scaling[i]) && scaling[i] > 0.0 ? scaling[i] : 1.0;
+    };
+    std::vector<double> u(nd, 1.0);
+    std::vector<double> v(na, 1.0);
+    if (warmStart) {
+        for (size_t d = 0; d < nd; d++) u[d] = initial(state->donorScaling, donors[d]);
+        for (size_t a = 0; a < na; a++) v[a] = initial(state->acceptorScaling, acceptors[a]);
+    }
+
+    std::vector<double> column(na);
+    const auto columnSums = [&]() {
+        std::fill(column.begin(), column.end(), 0.0);
+        for (size_t d = 0; d < nd; d++) {
+            for (size_t a = 0; a < na; a++) column[a] += kernel[d * na + a] * u[d];
+        }
+    };
+    // The donor (row) marginals are met exactly after each update of u, iterate until the
+    // acceptor (column) marginals are met as well
+    size_t iterations = 0;
+    columnSums();
+    while (iterations < settings.maxIterations) {
+        double error = 0.0;
+        for (size_t a = 0; a < na; a++) error += std::abs(v[a] * column[a] - accepted[a]);
+        if (iterations > 0 && error <= settings.tolerance * totalDonated) break;
+
+        for (size_t a = 0; a < na; a++) v[a] = column[a] > 0.0 ? accepted[a] / column[a] : 0.0;
+        for (size_t d = 0; d < nd; d++) {
+            double row = 0.0;
+            for (size_t a = 0; a < na; a++) row += kernel[d * na + a] * v[a];
+            u[d] = row > 0.0 ? donated[d] / row : 0.0;
+        }
+        columnSums();
+        iterations++;
+    }
+
+    for (size_t d = 0; d < nd; d++) {
+        for (size_t a = 0; a < na; a++) {
+            // transpose of charge transfer matrix
+            chargeTransfer[donors[d]][acceptors[a]] =
+                static_cast<float>(u[d] * kernel[d * na + a] * v[a]);
+        }
+    }
+
+    if (state) {
+        state->donorScaling.assign(n, 1.0);
+        state->acceptorScaling.assign(n, 1.0);
+        for (size_t d = 0; d < nd; d++) state->donorScaling[donors[d]] = u[d];
+        for (size_t a = 0; a < na; a++) state->acceptorScaling[acceptors[a]] = v[a];
+        state->iterations = iterations;
+    }
+
+    return {chargeTransfer, chargeDifference};
+}
+
+}  // namespace
+
+std::pair<std::vector<std::vector<float>>, std::vector<float>>
+ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+    std::vector<float> holeCharges, std::vector<float> particleCharges) {
+    HotPathProfiler::ScopedTimer timer("ChargeTransferMatrix::compute");
+    auto result = subgroupHeuristic(holeCharges, particleCharges);
+
+    const auto n = holeCharges.size();
+    timer.count("subgroups", static_cast<double>(n));
+    timer.count("bytes", static_cast<double>((2 * n + n * n + n) * sizeof(float)));
+    return result;
+}
+
+ChargeTransferMatrix::RegionOverlap ChargeTransferMatrix::groupRegions(
+    const RegionOverlap& regions, const std::vector<std::vector<size_t>>& groups) {
+    const auto n = groups.size();
+    std::vector<size_t> regionToGroup(regions.nrRegions, n);
+    for (size_t g = 0; g < n; g++) {
+        for (auto r : groups[g]) {
+            if (r >= regions.nrRegions) {
+                throw Exception("Subgroup refers to a region that does not exist.",
+                                IVW_CONTEXT_CUSTOM("ChargeTransferMatrix"));
+            }
+            regionToGroup[r] = g;
+        }
+    }
+
+    RegionOverlap grouped;
+    grouped.nrRegions = n;
+    grouped.hole.assign(n, 0.0f);
+    grouped.particle.assign(n, 0.0f);
+    grouped.overlap.assign(n, 0.0f);
+    if (!regions.faces.empty()) grouped.faces.assign(n * n, 0.0f);
+
+    for (size_t r = 0; r < regions.nrRegions; r++) {
+        const auto g = regionToGroup[r];
+        if (g == n) continue;
+        grouped.hole[g] += regions.hole[r];
+        grouped.particle[g] += regions.particle[r];
+        grouped.overlap[g] += regions.overlap[r];
+        if (regions.faces.empty()) continue;
+        for (size_t s = 0; s < regions.nrRegions; s++) {
+            const auto h = regionToGroup[s];
+            // Faces between regions of the same group are inside the group
+            if (h == n || h == g) continue;
+            grouped.faces[g * n + h] += regions.faces[r * regions.nrRegions + s];
+        }
+    }
+    return grouped;
+}
+
+std::pair<std::vector<std::vector<float>>, std::vector<float>>
+ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+    const RegionOverlap& regions, Coupling coupling) {
+    HotPathProfiler::ScopedTimer timer("ChargeTransferMatrix::computeFromOverlap");
+
+    const auto n = regions.nrRegions;
+    if (n == 0) {
+        throw Exception("Empty particle and/or hole charges.",
+                        IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
+    }
+    if (coupling == Coupling::Adjacent && regions.faces.size() != n * n) {
+        throw Exception("Adjacent coupling requires the shared faces between the regions.",
+                        IVW_CONTEXT_CUSTOM("ComputeChargeTransfer"));
+    }
+
+    std::vector<std::vector<float>> chargeTransfer(n, std::vector<float>(n, 0.0f));
+    std::vector<float> chargeDifference(n);
+    std::vector<float> donated(n);
+    std::vector<float> accepted(n);
+    float totalAccepted = 0.0f;
+
+    for (size_t i = 0; i < n; i++) {
+        chargeDifference[i] = regions.particle[i] - regions.hole[i];
+        // The charge that overlaps at voxel level stays in place, the rest of the hole charge is
+        // free to move to the rest of the particle charge, also within the same region
+        chargeTransfer[i][i] = regions.overlap[i];
+        donated[i] = std::max(regions.hole[i] - regions.overlap[i], 0.0f);
+        accepted[i] = std::max(regions.particle[i] - regions.overlap[i], 0.0f);
+        totalAccepted += accepted[i];
+    }
+
+    for (size_t d = 0; d < n; d++) {
+        // Nowhere to put it, the free hole charge stays in the region
+        if (totalAccepted <= 0.0f) {
+            chargeTransfer[d][d] += donated[d];
+            continue;
+        }
+        if (donated[d] <= 0.0f) continue;
+
+        const auto adjacent = [&](size_t a) { return a == d || regions.faces[d * n + a] > 0.0f; };
+        float adjacentAccepted = 0.0f;
+        if (coupling == Coupling::Adjacent) {
+            for (size_t a = 0; a < n; a++) {
+                if (adjacent(a)) adjacentAccepted += accepted[a];
+            }
+        }
+        // Falls back to all regions if no adjacent region has free particle charge
+        const auto onlyAdjacent = adjacentAccepted > 0.0f;
+        for (size_t a = 0; a < n; a++) {
+            if (onlyAdjacent && !adjacent(a)) continue;
+            // transpose of charge transfer matrix
+            chargeTransfer[d][a] +=
+                donated[d] * accepted[a] / (onlyAdjacent ? adjacentAccepted : totalAccepted);
+        }
+    }
+
+    timer.count("subgroups", static_cast<double>(n));
+    timer.count("bytes", static_cast<double>((4 * n + n * n) * sizeof(float)));
+    return {chargeTransfer, chargeDifference};
+}
+
+std::pair<std::vector<std::vector<float>>, std::vector<float>>
+ChargeTransferMatrix::computeTransposedOptimalTransport(const std::vector<float>& holeCharges,
+                                                        const std::vector<float>& particleCharges,
+                                                        const std::vector<double>& cost,
+                                                        const TransportSettings& settings,
+                                                        TransportState* state) {
+    HotPathProfiler::ScopedTimer timer("ChargeTransferMatrix::computeOptimalTransport");
+    TransportState coldState;
+    if (!state) state = &coldState;
+    auto result = optimalTransport(holeCharges, particleCharges, cost, settings, state);
+
+    const auto n = holeCharges.size();
+    timer.count("subgroups", static_cast<double>(n));
+    timer.count("iterations", static_cast<double>(state->iterations));
+    timer.count("bytes", static_cast<double>((2 * n + n * n) * sizeof(float)));
+    return result;
+}
+
+std::vector<std::vector<float>> ChargeTransferMatrix::computeEnsembleChargeTransfer(
+    const std::vector<const float*>& holeCharges, const std::vector<const float*>& particleCharges,
+    size_t nrMembers, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("ChargeTransferMatrix::computeEnsembleChargeTransfer");
+
+    const auto n = holeCharges.size();
+    if (n == 0 || particleCharges.size() != n) {
+        throw Exception("Empty particle and/or hole charges, or not same size.",
+                        IVW_CONTEXT_CUSTOM("ChargeTransferMatrix"));
+    }
+
+    std::vector<std::vector<float>> transfer(n * n, std::vector<float>(nrMembers, 0.0f));
+    util::parallelForRanges(nrMembers, nrThreads, [&](size_t, size_t begin, size_t end) {
+        std::vector<float> hole(n);
+        std::vector<float> particle(n);
+        for (size_t m = begin; m < end; m++) {
+            for (size_t i = 0; i < n; i++) {
+                hole[i] = holeCharges[i][m];
+                particle[i] = particleCharges[i][m];
+            }
+            const auto member = subgroupHeuristic(hole, particle, /*degenerate*/ true).first;
+            for (size_t d = 0; d < n; d++) {
+                for (size_t a = 0; a < n; a++) transfer[d * n + a][m] = member[d][a];
+            }
+        }
+    });
+
+    timer.count("rows", static_cast<double>(nrMembers));
+    timer.count("bytes", static_cast<double>(n * n * nrMembers * sizeof(float)));
+    return transfer;
+}
+
+std::vector<std::vector<float>> ChargeTransferMatrix::computeEnsembleOptimalTransport(
+    const std::vector<const float*>& holeCharges, const std::vector<const float*>& particleCharges,
+    size_t nrMembers, const std::vector<double>& cost, const TransportSettings& settings,
+    size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("ChargeTransferMatrix::computeEnsembleOptimalTransport");
+
+    const auto n = holeCharges.size();
+    if (n == 0 || particleCharges.size() != n) {
+        throw Exception("Empty particle and/or hole charges, or not same size.",
+                        IVW_CONTEXT_CUSTOM("ChargeTransferMatrix"));
+    }
+
+    std::vector<std::vector<float>> transfer(n * n, std::vector<float>(nrMembers, 0.0f));
+    std::atomic<size_t> iterations{0};
+    // Consecutive members are usually similar, so each solve starts from the previous one. The
+    // warm starts are chained within fixed blocks of members, since the solution depends on the
+    // starting point (within the tolerance), so that the result does not depend on nrThreads
+    const auto blockSize = std::max<size_t>(1, settings.warmStartBlockSize);
+    const auto nrBlocks = (nrMembers + blockSize - 1) / blockSize;
+    util::parallelForRanges(nrBlocks, nrThreads, [&](size_t, size_t firstBlock, size_t lastBlock) {
+        std::vector<float> hole(n);
+        std::vector<float> particle(n);
+        size_t rangeIterations = 0;
+        for (size_t block = firstBlock; block < lastBlock; block++) {
+            TransportState state;
+            const auto end = std::min(nrMembers, (block + 1) * blockSize);
+            for (size_t m = block * blockSize; m < end; m++) {
+                for (size_t i = 0; i < n; i++) {
+                    hole[i] = holeCharges[i][m];
+                    particle[i] = particleCharges[i][m];
+                }
+                const auto member =
+                    optimalTransport(hole, particle, cost, settings, &state).first;
+                for (size_t d = 0; d < n; d++) {
+                    for (size_t a = 0; a < n; a++) transfer[d * n + a][m] = member[d][a];
+                }
+                rangeIterations += state.iterations;
+            }
+        }
+        iterations += rangeIterations;
+    });
+
+    timer.count("rows", static_cast<double>(nrMembers));
+    timer.count("iterations", static_cast<double>(iterations.load()));
+    timer.count("bytes", static_cast<double>(n * n * nrMembers * sizeof(float)));
+    return transfer;
 }
 
 }  // namespace inviwo
@@ -0,0 +1,90 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/algorithm/clustergrouping.h>
+#include <inviwo/core/util/exception.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <algorithm>
+
+namespace inviwo {
+
+std::map<int, std::vector<uint32_t>> ClusterGrouping::groupByCluster(
+    const std::vector<int>& clusters, const std::vector<uint32_t>& indices) {
+    if (clusters.size() != indices.size()) {
+        throw Exception("Unexpected dimension missmatch", IVW_CONTEXT_CUSTOM("ClusterGrouping"));
+    }
+    return groupByCluster(clusters.data(), indices.data(), clusters.size());
+}
+
+std::map<int, std::vector<uint32_t>> ClusterGrouping::groupByCluster(const int* clusters,
+                                                                     const uint32_t* indices,
+                                                                     size_t n) {
+    HotPathProfiler::ScopedTimer timer("ClusterGrouping::groupByCluster");
+
+    std::map<int, std::vector<uint32_t>> clusterNrToIndex = {};
+    for (size_t i = 0; i < n; i++) {
+        clusterNrToIndex[clusters[i]].push_back(indices[i]);
+    }
+    timer.count("rows", static_cast<double>(n));
+    return clusterNrToIndex;
+}
+
+ClusterGrouping::Ranges ClusterGrouping::groupRanges(const int* clusters, const uint32_t* indices,
+                                                     size_t n) {
+    HotPathProfiler::ScopedTimer timer("ClusterGrouping::groupRanges");
+
+    Ranges ranges;
+    ranges.clusters.assign(clusters, clusters + n);
+    std::sort(ranges.clusters.begin(), ranges.clusters.end());
+    ranges.clusters.erase(std::unique(ranges.clusters.begin(), ranges.clusters.end()),
+                          ranges.clusters.end());
+
+    // Counting sort of the members by cluster, stable so members keep the input order
+    std::vector<size_t> slot(n);
+    ranges.offsets.assign(ranges.clusters.size() + 1, 0);
+    for (size_t i = 0; i < n; i++) {
+        slot[i] = static_cast<size_t>(
+            std::lower_bound(ranges.clusters.begin(), ranges.clusters.end(), clusters[i]) -
+            ranges.clusters.begin());
+        ranges.offsets[slot[i] + 1]++;
+    }
+    for (size_t c = 0; c < ranges.clusters.size(); c++) {
+        ranges.offsets[c + 1] += ranges.offsets[c];
+    }
+    std::vector<size_t> next(ranges.offsets.begin(), ranges.offsets.end() - 1);
+    ranges.members.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        ranges.members[next[slot[i]]++] = indices[i];
+    }
+
+    timer.count("rows", static_cast<double>(n));
+    return ranges;
+}
+
+}  // namespace inviwo
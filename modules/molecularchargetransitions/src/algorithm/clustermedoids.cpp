@@ -0,0 +1,156 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/clustermedoids.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace inviwo {
+
+namespace {
+
+double distance(const float* a, const float* b, size_t nrFeatures) {
+    double sum = 0.0;
+    for (size_t f = 0; f < nrFeatures; f++) {
+        const auto d = static_cast<double>(a[f]) - static_cast<double>(b[f]);
+        sum += d * d;
+    }
+    return std::sqrt(sum);
+}
+
+}  // namespace
+
+ClusterMedoids::Medoid ClusterMedoids::medoid(const std::vector<float>& points, size_t nrFeatures,
+                                              size_t k, const Settings& settings) {
+    Medoid result;
+    if (k == 0) return result;
+    const auto point = [&](size_t i) { return points.data() + i * nrFeatures; };
+
+    if (k <= settings.bruteForceSize) {
+        // Every pair once, the distance sums are symmetric
+        std::vector<double> sums(k, 0.0);
+        for (size_t i = 0; i < k; i++) {
+            for (size_t j = i + 1; j < k; j++) {
+                const auto d = distance(point(i), point(j), nrFeatures);
+                sums[i] += d;
+                sums[j] += d;
+            }
+        }
+        const auto best = std::min_element(sums.begin(), sums.end());
+        result.member = static_cast<uint32_t>(best - sums.begin());
+        result.meanDistance = *best / static_cast<double>(k);
+        result.candidates = k;
+        return result;
+    }
+
+    // Trimmed search: for a computed candidate i with distance sum E(i), the triangle inequality
+    // gives E(j) >= |E(i) - k d(i, j)| for every other member j
+    std::vector<size_t> order(k);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::shuffle(order.begin(), order.end(), std::mt19937(settings.seed));
+
+    std::vector<double> lowerBound(k, 0.0);
+    std::vector<double> distances(k);
+    auto bestSum = std::numeric_limits<double>::infinity();
+    size_t best = 0;
+    for (const auto i : order) {
+        if (lowerBound[i] > bestSum) continue;
+
+        double sum = 0.0;
+        for (size_t j = 0; j < k; j++) {
+            distances[j] = distance(point(i), point(j), nrFeatures);
+            sum += distances[j];
+        }
+        result.candidates++;
+        if (sum < bestSum || (sum == bestSum && i < best)) {
+            bestSum = sum;
+            best = i;
+        }
+        const auto kd = static_cast<double>(k);
+        for (size_t j = 0; j < k; j++) {
+            lowerBound[j] = std::max(lowerBound[j], std::abs(sum - kd * distances[j]));
+        }
+        lowerBound[i] = sum;
+    }
+    result.member = static_cast<uint32_t>(best);
+    result.meanDistance = bestSum / static_cast<double>(k);
+    return result;
+}
+
+std::vector<ClusterMedoids::Medoid> ClusterMedoids::compute(
+    const std::vector<const float*>& features, const ClusterGrouping::Ranges& ranges,
+    const Settings& settings, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("ClusterMedoids::compute");
+
+    const auto nrClusters = ranges.size();
+    const auto nrFeatures = features.size();
+
+    // Largest clusters first, so that the threads finish at about the same time
+    std::vector<size_t> bySize(nrClusters);
+    std::iota(bySize.begin(), bySize.end(), size_t{0});
+    std::stable_sort(bySize.begin(), bySize.end(), [&](size_t a, size_t b) {
+        return ranges.clusterSize(a) > ranges.clusterSize(b);
+    });
+
+    std::vector<Medoid> medoids(nrClusters);
+    std::atomic<size_t> next{0};
+    nrThreads = std::max<size_t>(1, std::min(nrThreads, nrClusters));
+    util::parallelForRanges(nrThreads, nrThreads, [&](size_t, size_t, size_t) {
+        std::vector<float> points;
+        for (auto n = next++; n < nrClusters; n = next++) {
+            const auto c = bySize[n];
+            const auto k = ranges.clusterSize(c);
+            const auto members = ranges.begin(c);
+
+            // The feature vectors of the cluster row by row, for contiguous distance computations
+            points.resize(k * nrFeatures);
+            for (size_t i = 0; i < k; i++) {
+                for (size_t f = 0; f < nrFeatures; f++) {
+                    points[i * nrFeatures + f] = features[f][members[i]];
+                }
+            }
+
+            auto result = medoid(points, nrFeatures, k, settings);
+            result.member = members[result.member];
+            medoids[c] = result;
+        }
+    });
+
+    size_t candidates = 0;
+    for (const auto& m : medoids) candidates += m.candidates;
+    timer.count("rows", static_cast<double>(ranges.members.size()));
+    timer.count("iterations", static_cast<double>(candidates));
+    return medoids;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,159 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/dendrogramindex.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace inviwo {
+
+DendrogramIndex::DendrogramIndex(const std::vector<size_t>& first,
+                                 const std::vector<size_t>& second,
+                                 const std::vector<double>& heights)
+    : nrMembers_{first.size() + 1} {
+    HotPathProfiler::ScopedTimer timer("DendrogramIndex::build");
+
+    const auto nrMerges = first.size();
+    if (second.size() != nrMerges || heights.size() != nrMerges) {
+        throw Exception("Linkage columns not same size.", IVW_CONTEXT_CUSTOM("DendrogramIndex"));
+    }
+    const auto nrNodes = nrMembers_ + nrMerges;
+    if (nrNodes >= std::numeric_limits<uint32_t>::max()) {
+        throw Exception("Too many members in the linkage.", IVW_CONTEXT_CUSTOM("DendrogramIndex"));
+    }
+
+    constexpr auto none = std::numeric_limits<uint32_t>::max();
+    parent_.assign(nrNodes, none);
+    first_.resize(nrMerges);
+    second_.resize(nrMerges);
+    heights_.resize(nrMerges);
+    std::vector<uint32_t> size(nrNodes, 1);
+    for (size_t i = 0; i < nrMerges; i++) {
+        const auto node = static_cast<uint32_t>(nrMembers_ + i);
+        for (const auto child : {first[i], second[i]}) {
+            // Children are created before their parent, and merged only once
+            if (child >= node || parent_[child] != none) {
+                throw Exception("Invalid linkage, merge " + std::to_string(i) +
+                                    " refers to node " + std::to_string(child),
+                                IVW_CONTEXT_CUSTOM("DendrogramIndex"));
+            }
+            parent_[child] = node;
+        }
+        first_[i] = static_cast<uint32_t>(first[i]);
+        second_[i] = static_cast<uint32_t>(second[i]);
+        size[node] = size[first[i]] + size[second[i]];
+        heights_[i] = i > 0 ? std::max(heights[i], heights_[i - 1]) : heights[i];
+    }
+
+    // Top down from the root: leaf ranges, and jump pointers from the depths, where the jump of a
+    // node skips as many levels as the jump of its parent and the next jump together if those are
+    // equal, and otherwise goes to the parent
+    const auto rootNode = static_cast<uint32_t>(nrNodes - 1);
+    parent_[rootNode] = rootNode;
+    begin_.assign(nrNodes, 0);
+    end_.assign(nrNodes, 0);
+    jump_.assign(nrNodes, rootNode);
+    std::vector<uint32_t> depth(nrNodes, 0);
+    end_[rootNode] = static_cast<uint32_t>(nrMembers_);
+    for (size_t i = nrMerges; i-- > 0;) {
+        const auto node = static_cast<uint32_t>(nrMembers_ + i);
+        auto begin = begin_[node];
+        for (const auto child : {first_[i], second_[i]}) {
+            begin_[child] = begin;
+            end_[child] = begin + size[child];
+            begin += size[child];
+
+            depth[child] = depth[node] + 1;
+            const auto jump = jump_[node];
+            jump_[child] = depth[node] - depth[jump] == depth[jump] - depth[jump_[jump]]
+                               ? jump_[jump]
+                               : node;
+        }
+    }
+
+    leafOrder_.resize(nrMembers_);
+    for (size_t member = 0; member < nrMembers_; member++) {
+        leafOrder_[begin_[member]] = member;
+    }
+
+    timer.count("rows", static_cast<double>(nrMembers_));
+}
+
+size_t DendrogramIndex::level(double height) const {
+    return static_cast<size_t>(std::upper_bound(heights_.begin(), heights_.end(), height) -
+                               heights_.begin());
+}
+
+size_t DendrogramIndex::levelOfClusters(size_t nrClusters) const {
+    return nrMembers_ - std::clamp<size_t>(nrClusters, 1, nrMembers_);
+}
+
+size_t DendrogramIndex::cluster(size_t member, size_t level) const {
+    // The merges of the ancestors of a node are in increasing order, climb as long as the parent
+    // exists at this level, taking the jump whenever it exists as well
+    size_t node = member;
+    while (node != root() && exists(parent_[node], level)) {
+        node = exists(jump_[node], level) ? jump_[node] : parent_[node];
+    }
+    return node;
+}
+
+std::vector<size_t> DendrogramIndex::clusters(size_t level) const {
+    std::vector<size_t> result;
+    std::vector<size_t> stack{root()};
+    while (!stack.empty()) {
+        const auto node = stack.back();
+        stack.pop_back();
+        if (exists(node, level)) {
+            result.push_back(node);
+        } else {
+            // Second child last in leaf order, so it goes on the stack first
+            stack.push_back(second_[node - nrMembers_]);
+            stack.push_back(first_[node - nrMembers_]);
+        }
+    }
+    return result;
+}
+
+std::vector<int> DendrogramIndex::labels(size_t level) const {
+    HotPathProfiler::ScopedTimer timer("DendrogramIndex::labels");
+    std::vector<int> labels(nrMembers_);
+    const auto nodes = clusters(level);
+    for (size_t c = 0; c < nodes.size(); c++) {
+        for (auto i = begin_[nodes[c]]; i < end_[nodes[c]]; i++) {
+            labels[leafOrder_[i]] = static_cast<int>(c + 1);
+        }
+    }
+    timer.count("rows", static_cast<double>(nrMembers_));
+    return labels;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,202 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/densitywatershed.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace inviwo {
+
+std::array<DensityWatershed::Neighbor, 26> DensityWatershed::neighborhood(
+    size3_t dims, const dmat3& indexToWorld) {
+    if (glm::compMul(dims) > std::numeric_limits<uint32_t>::max()) {
+        throw Exception("Volume has too many voxels for the watershed segmentation",
+                        IVW_CONTEXT_CUSTOM("DensityWatershed"));
+    }
+    const auto sx = static_cast<std::ptrdiff_t>(dims.x);
+    const auto sxy = static_cast<std::ptrdiff_t>(dims.x * dims.y);
+
+    std::array<Neighbor, 26> neighbors;
+    size_t i = 0;
+    for (int z = -1; z <= 1; z++) {
+        for (int y = -1; y <= 1; y++) {
+            for (int x = -1; x <= 1; x++) {
+                if (x == 0 && y == 0 && z == 0) continue;
+                const auto d = indexToWorld * dvec3(x, y, z);
+                neighbors[i++] = {ivec3(x, y, z), x + y * sx + z * sxy,
+                                  1.0 / std::sqrt(glm::dot(d, d))};
+            }
+        }
+    }
+    return neighbors;
+}
+
+DensityWatershed::Basins DensityWatershed::resolve(std::vector<uint32_t> parent, size3_t dims,
+                                                   size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("DensityWatershed::resolve");
+
+    const size_t sxy = dims.x * dims.y;
+    nrThreads = std::max<size_t>(1, std::min(nrThreads, dims.z));
+
+    // Path compression within each slab, every voxel then points to its maximum or to the first
+    // voxel outside of the slab on its path. The latter are collected per slab.
+    std::vector<std::vector<uint32_t>> crossings(nrThreads);
+    util::parallelForRanges(dims.z, nrThreads, [&](size_t thread, size_t zBegin, size_t zEnd) {
+        const auto begin = static_cast<uint32_t>(zBegin * sxy);
+        const auto end = static_cast<uint32_t>(zEnd * sxy);
+        const auto inSlab = [&](uint32_t v) { return v >= begin && v < end; };
+
+        auto& local = crossings[thread];
+        for (uint32_t v = begin; v < end; v++) {
+            if (!inSlab(parent[v])) local.push_back(parent[v]);
+
+            uint32_t terminal = v;
+            while (inSlab(terminal) && parent[terminal] != terminal) {
+                terminal = parent[terminal];
+            }
+            for (uint32_t u = v; u != terminal;) {
+                const auto next = parent[u];
+                parent[u] = terminal;
+                u = next;
+            }
+        }
+        std::sort(local.begin(), local.end());
+        local.erase(std::unique(local.begin(), local.end()), local.end());
+    });
+
+    // Union-find over the slab crossings. The parent of a crossing voxel is its maximum or another
+    // crossing voxel, so afterwards the maximum of any voxel v is parent[parent[v]].
+    for (const auto& local : crossings) {
+        for (auto v : local) {
+            uint32_t root = v;
+            while (parent[root] != root) root = parent[root];
+            for (uint32_t u = v; u != root;) {
+                const auto next = parent[u];
+                parent[u] = root;
+                u = next;
+            }
+        }
+    }
+
+    // Number the maxima in index order
+    std::vector<size_t> counts(nrThreads + 1, 0);
+    util::parallelForRanges(dims.z, nrThreads, [&](size_t thread, size_t zBegin, size_t zEnd) {
+        for (size_t v = zBegin * sxy; v < zEnd * sxy; v++) {
+            if (parent[v] == v) counts[thread + 1]++;
+        }
+    });
+    std::partial_sum(counts.begin(), counts.end(), counts.begin());
+
+    Basins basins;
+    basins.labels.resize(parent.size());
+    basins.maxima.resize(counts.back());
+    util::parallelForRanges(dims.z, nrThreads, [&](size_t thread, size_t zBegin, size_t zEnd) {
+        auto basin = counts[thread];
+        for (size_t v = zBegin * sxy; v < zEnd * sxy; v++) {
+            if (parent[v] == v) {
+                basins.maxima[basin] = v;
+                basins.labels[v] = static_cast<uint32_t>(basin++);
+            }
+        }
+    });
+    util::parallelForRanges(dims.z, nrThreads, [&](size_t, size_t zBegin, size_t zEnd) {
+        for (size_t v = zBegin * sxy; v < zEnd * sxy; v++) {
+            if (parent[v] != v) basins.labels[v] = basins.labels[parent[parent[v]]];
+        }
+    });
+
+    timer.count("voxels", static_cast<double>(parent.size()));
+    timer.count("rows", static_cast<double>(basins.maxima.size()));
+    return basins;
+}
+
+std::vector<uint16_t> DensityWatershed::nearestAtoms(const Basins& basins, size3_t dims,
+                                                     const dmat3& indexToWorld,
+                                                     const dvec3& offset,
+                                                     const std::vector<dvec3>& positions) {
+    if (positions.empty()) {
+        throw Exception("No atoms to assign the basins to", IVW_CONTEXT_CUSTOM("DensityWatershed"));
+    }
+    if (positions.size() > size_t{std::numeric_limits<uint16_t>::max()} + 1) {
+        throw Exception("Too many atoms for a uint16 segmentation",
+                        IVW_CONTEXT_CUSTOM("DensityWatershed"));
+    }
+
+    const size_t sx = dims.x;
+    const size_t sxy = dims.x * dims.y;
+    std::vector<uint16_t> atoms(basins.maxima.size());
+    for (size_t basin = 0; basin < basins.maxima.size(); basin++) {
+        const auto v = basins.maxima[basin];
+        const auto p = indexToWorld * dvec3(v % sx, (v % sxy) / sx, v / sxy) + offset;
+        double best = std::numeric_limits<double>::max();
+        for (size_t atom = 0; atom < positions.size(); atom++) {
+            const auto d = positions[atom] - p;
+            const auto dist = glm::dot(d, d);
+            if (dist < best) {
+                best = dist;
+                atoms[basin] = static_cast<uint16_t>(atom);
+            }
+        }
+    }
+    return atoms;
+}
+
+std::vector<uint16_t> DensityWatershed::labels(const Basins& basins,
+                                               const std::vector<uint16_t>& basinLabels,
+                                               size_t nrThreads) {
+    if (!basinLabels.empty() && basinLabels.size() != basins.maxima.size()) {
+        throw Exception("Number of basin labels does not match the number of basins",
+                        IVW_CONTEXT_CUSTOM("DensityWatershed"));
+    }
+    if (basinLabels.empty() &&
+        basins.maxima.size() > size_t{std::numeric_limits<uint16_t>::max()} + 1) {
+        throw Exception("Too many basins for a uint16 segmentation, assign them to atoms",
+                        IVW_CONTEXT_CUSTOM("DensityWatershed"));
+    }
+
+    std::vector<uint16_t> labels(basins.labels.size());
+    util::parallelForRanges(labels.size(), nrThreads, [&](size_t, size_t begin, size_t end) {
+        if (basinLabels.empty()) {
+            std::transform(basins.labels.begin() + begin, basins.labels.begin() + end,
+                           labels.begin() + begin,
+                           [](uint32_t basin) { return static_cast<uint16_t>(basin); });
+        } else {
+            std::transform(basins.labels.begin() + begin, basins.labels.begin() + end,
+                           labels.begin() + begin,
+                           [&](uint32_t basin) { return basinLabels[basin]; });
+        }
+    });
+    return labels;
+}
+
+}  // namespace inviwo
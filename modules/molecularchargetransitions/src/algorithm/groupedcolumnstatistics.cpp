@@ -0,0 +1,109 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/groupedcolumnstatistics.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace inviwo {
+
+std::vector<float> GroupedColumnStatistics::quantiles(std::vector<float>& values,
+                                                      const std::vector<double>& quantiles) {
+    std::vector<float> result(quantiles.size(), std::numeric_limits<float>::quiet_NaN());
+    const auto k = values.size();
+    if (k == 0) return result;
+
+    std::vector<size_t> order(quantiles.size());
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) { return quantiles[a] < quantiles[b]; });
+
+    // Values before first are at most the values after, and the one before is in sorted position
+    size_t first = 0;
+    for (const auto q : order) {
+        const auto h = std::clamp(quantiles[q], 0.0, 1.0) * static_cast<double>(k - 1);
+        const auto lo = std::min(static_cast<size_t>(h), k - 1);
+        if (lo >= first) {
+            std::nth_element(values.begin() + first, values.begin() + lo, values.end());
+            first = lo + 1;
+        }
+        const auto fraction = h - static_cast<double>(lo);
+        auto value = static_cast<double>(values[lo]);
+        if (fraction > 0.0 && lo + 1 < k) {
+            const auto next = *std::min_element(values.begin() + lo + 1, values.end());
+            value += fraction * (static_cast<double>(next) - value);
+        }
+        result[q] = static_cast<float>(value);
+    }
+    return result;
+}
+
+GroupedColumnStatistics::Result GroupedColumnStatistics::compute(
+    const std::vector<const float*>& columns, const ClusterGrouping::Ranges& ranges,
+    const std::vector<double>& quantiles, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("GroupedColumnStatistics::compute");
+
+    Result result;
+    result.nrColumns = columns.size();
+    result.nrGroups = ranges.size();
+    const auto nrValues = result.nrColumns * result.nrGroups;
+    result.mean.resize(nrValues);
+    result.quantiles.assign(quantiles.size(), std::vector<float>(nrValues));
+
+    // Column major tasks, every column costs the same and the groups of a column are contiguous
+    util::parallelForRanges(nrValues, nrThreads, [&](size_t, size_t begin, size_t end) {
+        std::vector<float> values;
+        for (size_t t = begin; t < end; t++) {
+            const auto c = t / result.nrGroups;
+            const auto g = t % result.nrGroups;
+            const auto column = columns[c];
+            values.clear();
+            double sum = 0.0;
+            for (auto m = ranges.begin(g); m != ranges.end(g); ++m) {
+                values.push_back(column[*m]);
+                sum += column[*m];
+            }
+            const auto i = g * result.nrColumns + c;
+            result.mean[i] = static_cast<float>(sum / static_cast<double>(values.size()));
+            const auto groupQuantiles = GroupedColumnStatistics::quantiles(values, quantiles);
+            for (size_t q = 0; q < quantiles.size(); q++) {
+                result.quantiles[q][i] = groupQuantiles[q];
+            }
+        }
+    });
+
+    timer.count("rows", static_cast<double>(ranges.members.size()));
+    timer.count("bytes",
+                static_cast<double>(ranges.members.size() * columns.size() * sizeof(float)));
+    return result;
+}
+
+}  // namespace inviwo
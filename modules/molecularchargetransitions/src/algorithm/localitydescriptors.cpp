@@ -0,0 +1,64 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/localitydescriptors.h>
+
+#include <cmath>
+
+namespace inviwo {
+
+void LocalityDescriptors::finish(const Block& block, size_t begin, size_t size,
+                                 size_t nrSubgroups, bool withPositions,
+                                 Descriptors& descriptors) {
+    for (size_t k = 0; k < size; k++) {
+        const auto m = begin + k;
+        descriptors.measureOfLocality[m] = block.locality[k];
+        descriptors.transferredCharge[m] = block.donated[k];
+        descriptors.donors[m] = block.donors[k];
+        descriptors.acceptors[m] = static_cast<int>(nrSubgroups) - block.donors[k];
+        if (!withPositions || block.donated[k] <= 0.0f || block.accepted[k] <= 0.0f) continue;
+
+        // Centroids and variances of the donor and acceptor positions, the mean squared distance
+        // of the transferred charge is the squared centroid distance plus both variances
+        double distance2 = 0.0;
+        double variance = 0.0;
+        for (size_t c = 0; c < 3; c++) {
+            const double donor = block.donorPosition[c][k] / block.donated[k];
+            const double acceptor = block.acceptorPosition[c][k] / block.accepted[k];
+            distance2 += (acceptor - donor) * (acceptor - donor);
+            variance -= donor * donor + acceptor * acceptor;
+        }
+        variance += block.donorPosition[3][k] / block.donated[k] +
+                    block.acceptorPosition[3][k] / block.accepted[k];
+        descriptors.ctDistance[m] = static_cast<float>(std::sqrt(distance2));
+        descriptors.ctRmsDistance[m] =
+            static_cast<float>(std::sqrt(std::max(distance2 + variance, 0.0)));
+    }
+}
+
+}  // namespace inviwo
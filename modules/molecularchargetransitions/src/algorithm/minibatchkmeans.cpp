@@ -0,0 +1,197 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/minibatchkmeans.h>
+#include <inviwo/molecularchargetransitions/util/deterministicreduction.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/exception.h>
+#include <algorithm>
+#include <limits>
+#include <random>
+
+namespace inviwo {
+
+namespace {
+
+double squaredDistance(const float* a, const float* b, size_t nrFeatures) {
+    double sum = 0.0;
+    for (size_t f = 0; f < nrFeatures; f++) {
+        const auto d = static_cast<double>(a[f]) - static_cast<double>(b[f]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+}  // namespace
+
+size_t MiniBatchKMeans::nearest(const float* point, const std::vector<float>& centers,
+                                size_t nrFeatures) {
+    size_t best = 0;
+    auto bestDistance = std::numeric_limits<double>::infinity();
+    const auto nrCenters = centers.size() / nrFeatures;
+    for (size_t c = 0; c < nrCenters; c++) {
+        const auto d = squaredDistance(point, centers.data() + c * nrFeatures, nrFeatures);
+        if (d < bestDistance) {
+            bestDistance = d;
+            best = c;
+        }
+    }
+    return best;
+}
+
+MiniBatchKMeans::Result MiniBatchKMeans::compute(const std::vector<const float*>& features,
+                                                 size_t nrMembers, const Settings& settings,
+                                                 size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("MiniBatchKMeans::compute");
+    const auto nrFeatures = features.size();
+    if (nrFeatures == 0 || nrMembers == 0) {
+        throw Exception("Need at least one feature and one member",
+                        IVW_CONTEXT_CUSTOM("MiniBatchKMeans"));
+    }
+    const auto k = std::max<size_t>(1, std::min(settings.nrClusters, nrMembers));
+    const auto batchSize = std::max<size_t>(1, std::min(settings.batchSize, nrMembers));
+
+    std::mt19937 rand(settings.seed);
+    std::uniform_int_distribution<size_t> randomMember(0, nrMembers - 1);
+    std::vector<float> batch(batchSize * nrFeatures);
+    const auto sampleBatch = [&]() {
+        for (size_t i = 0; i < batchSize; i++) {
+            const auto m = randomMember(rand);
+            for (size_t f = 0; f < nrFeatures; f++) {
+                batch[i * nrFeatures + f] = features[f][m];
+            }
+        }
+    };
+
+    // k-means++ seeding on the first batch
+    sampleBatch();
+    std::vector<float> centers(k * nrFeatures);
+    std::vector<double> distances(batchSize, std::numeric_limits<double>::infinity());
+    size_t next = randomMember(rand) % batchSize;
+    for (size_t c = 0; c < k; c++) {
+        std::copy_n(batch.data() + next * nrFeatures, nrFeatures, centers.data() + c * nrFeatures);
+        double total = 0.0;
+        for (size_t i = 0; i < batchSize; i++) {
+            distances[i] = std::min(distances[i], squaredDistance(batch.data() + i * nrFeatures,
+                                                                  centers.data() + c * nrFeatures,
+                                                                  nrFeatures));
+            total += distances[i];
+        }
+        // Without any distance left (e.g. duplicates) the next center is picked uniformly
+        next = randomMember(rand) % batchSize;
+        if (total > 0.0) {
+            auto target = std::uniform_real_distribution<double>(0.0, total)(rand);
+            for (size_t i = 0; i < batchSize; i++) {
+                target -= distances[i];
+                if (target <= 0.0 && distances[i] > 0.0) {
+                    next = i;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Mini-batch steps, the assignment is in parallel and the update in batch order
+    std::vector<size_t> counts(k, 0);
+    std::vector<size_t> assigned(batchSize);
+    for (size_t step = 0; step < settings.nrBatches; step++) {
+        if (step > 0) sampleBatch();
+        util::parallelForRanges(batchSize, nrThreads, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                assigned[i] = nearest(batch.data() + i * nrFeatures, centers, nrFeatures);
+            }
+        });
+        for (size_t i = 0; i < batchSize; i++) {
+            const auto c = assigned[i];
+            const auto eta = 1.0f / static_cast<float>(++counts[c]);
+            auto center = centers.data() + c * nrFeatures;
+            const auto point = batch.data() + i * nrFeatures;
+            for (size_t f = 0; f < nrFeatures; f++) {
+                center[f] += eta * (point[f] - center[f]);
+            }
+        }
+    }
+
+    // Final assignment of all members, chunk by chunk, with deterministic sums for the means
+    struct Sums {
+        std::vector<double> features;
+        std::vector<size_t> sizes;
+        double inertia = 0.0;
+    };
+    Result result;
+    result.nrFeatures = nrFeatures;
+    result.labels.resize(nrMembers);
+    const auto chunkSize = std::max<size_t>(size_t{1} << 16, (nrMembers + 63) / 64);
+    const auto sums = util::deterministicReduce(
+        nrMembers, chunkSize, Sums{},
+        [&](size_t, size_t begin, size_t end) {
+            Sums chunk{std::vector<double>(k * nrFeatures, 0.0), std::vector<size_t>(k, 0), 0.0};
+            std::vector<float> point(nrFeatures);
+            for (size_t m = begin; m < end; m++) {
+                for (size_t f = 0; f < nrFeatures; f++) point[f] = features[f][m];
+                const auto c = nearest(point.data(), centers, nrFeatures);
+                result.labels[m] = static_cast<uint32_t>(c);
+                chunk.sizes[c]++;
+                chunk.inertia +=
+                    squaredDistance(point.data(), centers.data() + c * nrFeatures, nrFeatures);
+                for (size_t f = 0; f < nrFeatures; f++) {
+                    chunk.features[c * nrFeatures + f] += point[f];
+                }
+            }
+            return chunk;
+        },
+        [](Sums& a, const Sums& b) {
+            for (size_t i = 0; i < a.features.size(); i++) a.features[i] += b.features[i];
+            for (size_t i = 0; i < a.sizes.size(); i++) a.sizes[i] += b.sizes[i];
+            a.inertia += b.inertia;
+        },
+        nrThreads);
+
+    // Remove empty micro-clusters and use the means of the members as centers
+    std::vector<uint32_t> newLabel(k, 0);
+    for (size_t c = 0; c < k; c++) {
+        if (sums.sizes[c] == 0) continue;
+        newLabel[c] = static_cast<uint32_t>(result.sizes.size());
+        result.sizes.push_back(sums.sizes[c]);
+        for (size_t f = 0; f < nrFeatures; f++) {
+            result.centers.push_back(static_cast<float>(sums.features[c * nrFeatures + f] /
+                                                        static_cast<double>(sums.sizes[c])));
+        }
+    }
+    if (result.nrClusters() != k) {
+        for (auto& label : result.labels) label = newLabel[label];
+    }
+    result.inertia = sums.inertia;
+
+    timer.count("rows", static_cast<double>(nrMembers + settings.nrBatches * batchSize));
+    timer.count("iterations", static_cast<double>(settings.nrBatches));
+    timer.count("bytes", static_cast<double>(nrMembers * nrFeatures * sizeof(float)));
+    return result;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,299 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/nearestatomsegmentation.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace inviwo {
+
+namespace {
+
+// clang-format off
+constexpr std::array<double, 86> covalentRadii = {
+    0.31, 0.28,                                                              // H - He
+    1.28, 0.96, 0.84, 0.76, 0.71, 0.66, 0.57, 0.58,                          // Li - Ne
+    1.66, 1.41, 1.21, 1.11, 1.07, 1.05, 1.02, 1.06,                          // Na - Ar
+    2.03, 1.76, 1.70, 1.60, 1.53, 1.39, 1.39, 1.32, 1.26, 1.24, 1.32, 1.22,  // K - Zn
+    1.22, 1.20, 1.19, 1.20, 1.20, 1.16,                                      // Ga - Kr
+    2.20, 1.95, 1.90, 1.75, 1.64, 1.54, 1.47, 1.46, 1.42, 1.39, 1.45, 1.44,  // Rb - Cd
+    1.42, 1.39, 1.39, 1.38, 1.39, 1.40,                                      // In - Xe
+    2.44, 2.15,                                                              // Cs - Ba
+    2.07, 2.04, 2.03, 2.01, 1.99, 1.98, 1.98, 1.96, 1.94, 1.92, 1.92, 1.89,  // La - Er
+    1.90, 1.87, 1.87,                                                        // Tm - Lu
+    1.75, 1.70, 1.62, 1.51, 1.44, 1.41, 1.36, 1.36, 1.32,                    // Hf - Hg
+    1.45, 1.46, 1.48, 1.40, 1.50, 1.50};                                     // Tl - Rn
+// clang-format on
+
+/**
+ * Atoms sorted into a uniform grid of about one atom per cell (CSR layout).
+ */
+class AtomGrid {
+public:
+    AtomGrid(const std::vector<dvec3>& positions) {
+        dvec3 min = positions.front();
+        dvec3 max = positions.front();
+        for (auto& p : positions) {
+            for (size_t i = 0; i < 3; i++) {
+                min[i] = std::min(min[i], p[i]);
+                max[i] = std::max(max[i], p[i]);
+            }
+        }
+        double extent = 0.0;
+        double volume = 1.0;
+        for (size_t i = 0; i < 3; i++) {
+            extent = std::max(extent, max[i] - min[i]);
+        }
+        // Flat or linear molecules, do not let the short axes collapse the cell size
+        for (size_t i = 0; i < 3; i++) {
+            volume *= std::max(max[i] - min[i], extent / 64.0);
+        }
+        const auto n = static_cast<double>(positions.size());
+        cellSize_ = std::max({std::cbrt(volume / n), extent / 64.0, 1.0e-6});
+        origin_ = min;
+        for (size_t i = 0; i < 3; i++) {
+            dims_[i] = static_cast<long>((max[i] - min[i]) / cellSize_) + 1;
+        }
+
+        // Counting sort of the atoms into the cells
+        std::vector<size_t> cellOfAtom(positions.size());
+        cellStart_.assign(nrCells() + 1, 0);
+        for (size_t a = 0; a < positions.size(); a++) {
+            cellOfAtom[a] = linearIndex(cellOf(positions[a]));
+            cellStart_[cellOfAtom[a] + 1]++;
+        }
+        for (size_t c = 0; c < nrCells(); c++) {
+            cellStart_[c + 1] += cellStart_[c];
+        }
+        atoms_.resize(positions.size());
+        auto next = cellStart_;
+        for (size_t a = 0; a < positions.size(); a++) {
+            atoms_[next[cellOfAtom[a]]++] = static_cast<uint32_t>(a);
+        }
+    }
+
+    size_t nrCells() const { return static_cast<size_t>(dims_[0] * dims_[1] * dims_[2]); }
+    double cellSize() const { return cellSize_; }
+    const std::array<long, 3>& dims() const { return dims_; }
+
+    std::array<long, 3> cellOf(const dvec3& p) const {
+        std::array<long, 3> cell{};
+        for (size_t i = 0; i < 3; i++) {
+            const auto c = static_cast<long>(std::floor((p[i] - origin_[i]) / cellSize_));
+            cell[i] = std::clamp(c, 0l, dims_[i] - 1);
+        }
+        return cell;
+    }
+    size_t linearIndex(const std::array<long, 3>& c) const {
+        return static_cast<size_t>((c[2] * dims_[1] + c[1]) * dims_[0] + c[0]);
+    }
+
+    const uint32_t* begin(size_t cell) const { return atoms_.data() + cellStart_[cell]; }
+    const uint32_t* end(size_t cell) const { return atoms_.data() + cellStart_[cell + 1]; }
+
+private:
+    dvec3 origin_;
+    double cellSize_;
+    std::array<long, 3> dims_;
+    std::vector<size_t> cellStart_;
+    std::vector<uint32_t> atoms_;
+};
+
+}  // namespace
+
+std::vector<uint16_t> NearestAtomSegmentation::segment(size3_t dims, const dmat3& indexToWorld,
+                                                       const dvec3& offset,
+                                                       const std::vector<dvec3>& positions,
+                                                       const std::vector<double>& radii,
+                                                       size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("NearestAtomSegmentation::segment");
+    if (positions.empty()) {
+        throw Exception("No atoms to segment the volume by",
+                        IVW_CONTEXT_CUSTOM("NearestAtomSegmentation"));
+    }
+    if (positions.size() > std::numeric_limits<uint16_t>::max() + size_t{1}) {
+        throw Exception("Too many atoms for a uint16 segmentation",
+                        IVW_CONTEXT_CUSTOM("NearestAtomSegmentation"));
+    }
+    if (!radii.empty() && radii.size() != positions.size()) {
+        throw Exception("Number of radii does not match the number of atoms",
+                        IVW_CONTEXT_CUSTOM("NearestAtomSegmentation"));
+    }
+
+    const AtomGrid grid(positions);
+    std::vector<double> squaredRadii(positions.size(), 0.0);
+    std::transform(radii.begin(), radii.end(), squaredRadii.begin(),
+                   [](double r) { return r * r; });
+    const auto maxSquaredRadius = *std::max_element(squaredRadii.begin(), squaredRadii.end());
+    const auto maxRing = std::max({grid.dims()[0], grid.dims()[1], grid.dims()[2]});
+
+    // Nearest atom (power distance) to p, searching rings of grid cells
+    const auto nearest = [&](const dvec3& p) {
+        const auto center = grid.cellOf(p);
+        double best = std::numeric_limits<double>::infinity();
+        uint32_t bestAtom = 0;
+        for (long k = 0; k <= maxRing; k++) {
+            // Atoms in ring k are at least (k - 1) cells away
+            const auto lower = static_cast<double>(std::max(k - 1, 0l)) * grid.cellSize();
+            if (lower * lower - maxSquaredRadius > best) break;
+
+            for (long dz = -k; dz <= k; dz++) {
+                const auto cz = center[2] + dz;
+                if (cz < 0 || cz >= grid.dims()[2]) continue;
+                for (long dy = -k; dy <= k; dy++) {
+                    const auto cy = center[1] + dy;
+                    if (cy < 0 || cy >= grid.dims()[1]) continue;
+                    const bool onFace = std::abs(dz) == k || std::abs(dy) == k;
+                    for (long dx = -k; dx <= k; dx += (onFace || k == 0) ? 1 : 2 * k) {
+                        const auto cx = center[0] + dx;
+                        if (cx < 0 || cx >= grid.dims()[0]) continue;
+                        const auto cell = grid.linearIndex({cx, cy, cz});
+                        for (auto a = grid.begin(cell); a != grid.end(cell); a++) {
+                            const auto d = positions[*a] - p;
+                            const auto dist = glm::dot(d, d) - squaredRadii[*a];
+                            if (dist < best || (dist == best && *a < bestAtom)) {
+                                best = dist;
+                                bestAtom = *a;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return std::make_pair(bestAtom, best);
+    };
+
+    const auto toWorld = [&](double x, double y, double z) {
+        return indexToWorld * dvec3(x, y, z) + offset;
+    };
+
+    // The voxels are processed in blocks. Only atoms that can be nearest to some voxel in the
+    // block are tested per voxel, found from the nearest atom to the block center.
+    constexpr size_t blockSize = 8;
+    const size3_t nrBlocks{(dims.x + blockSize - 1) / blockSize,
+                           (dims.y + blockSize - 1) / blockSize,
+                           (dims.z + blockSize - 1) / blockSize};
+    std::vector<uint16_t> labels(dims.x * dims.y * dims.z);
+
+    util::parallelForRanges(nrBlocks.z, nrThreads, [&](size_t, size_t bzBegin, size_t bzEnd) {
+        std::vector<uint32_t> candidates;
+        for (size_t bz = bzBegin; bz < bzEnd; bz++) {
+            for (size_t by = 0; by < nrBlocks.y; by++) {
+                for (size_t bx = 0; bx < nrBlocks.x; bx++) {
+                    const size3_t begin{bx * blockSize, by * blockSize, bz * blockSize};
+                    const size3_t end{std::min(begin.x + blockSize, dims.x),
+                                      std::min(begin.y + blockSize, dims.y),
+                                      std::min(begin.z + blockSize, dims.z)};
+
+                    const auto mid = [](size_t b, size_t e) {
+                        return 0.5 * static_cast<double>(b + e - 1);
+                    };
+                    const auto center = toWorld(mid(begin.x, end.x), mid(begin.y, end.y),
+                                                mid(begin.z, end.z));
+                    // Largest distance from the center to a voxel in the block
+                    double h = 0.0;
+                    for (size_t c = 0; c < 8; c++) {
+                        const auto corner = toWorld(
+                            static_cast<double>((c & 1) ? end.x - 1 : begin.x),
+                            static_cast<double>((c & 2) ? end.y - 1 : begin.y),
+                            static_cast<double>((c & 4) ? end.z - 1 : begin.z));
+                        const auto d = corner - center;
+                        h = std::max(h, std::sqrt(glm::dot(d, d)));
+                    }
+
+                    // For a voxel v in the block, atom a can only beat the center's nearest atom
+                    // n if |a - v|^2 - ra^2 <= (|n - center| + h)^2 - rn^2
+                    const auto [n, best] = nearest(center);
+                    const auto dn = std::sqrt(std::max(best + squaredRadii[n], 0.0)) + h;
+                    const auto reach = std::sqrt(std::max(dn * dn - squaredRadii[n], 0.0) +
+                                                 maxSquaredRadius) +
+                                       h;
+
+                    candidates.clear();
+                    const auto lo = grid.cellOf(center - dvec3(reach, reach, reach));
+                    const auto hi = grid.cellOf(center + dvec3(reach, reach, reach));
+                    for (long cz = lo[2]; cz <= hi[2]; cz++) {
+                        for (long cy = lo[1]; cy <= hi[1]; cy++) {
+                            for (long cx = lo[0]; cx <= hi[0]; cx++) {
+                                const auto cell = grid.linearIndex({cx, cy, cz});
+                                for (auto a = grid.begin(cell); a != grid.end(cell); a++) {
+                                    const auto d = positions[*a] - center;
+                                    if (glm::dot(d, d) <= reach * reach) candidates.push_back(*a);
+                                }
+                            }
+                        }
+                    }
+                    // Smallest index first, for the tie breaking
+                    std::sort(candidates.begin(), candidates.end());
+
+                    for (size_t z = begin.z; z < end.z; z++) {
+                        for (size_t y = begin.y; y < end.y; y++) {
+                            for (size_t x = begin.x; x < end.x; x++) {
+                                const auto p = toWorld(static_cast<double>(x),
+                                                       static_cast<double>(y),
+                                                       static_cast<double>(z));
+                                double bestDist = std::numeric_limits<double>::infinity();
+                                uint32_t bestAtom = n;
+                                for (auto a : candidates) {
+                                    const auto d = positions[a] - p;
+                                    const auto dist = glm::dot(d, d) - squaredRadii[a];
+                                    if (dist < bestDist) {
+                                        bestDist = dist;
+                                        bestAtom = a;
+                                    }
+                                }
+                                labels[(z * dims.y + y) * dims.x + x] =
+                                    static_cast<uint16_t>(bestAtom);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    timer.count("voxels", static_cast<double>(labels.size()));
+    timer.count("atoms", static_cast<double>(positions.size()));
+    timer.count("bytes", static_cast<double>(labels.size() * sizeof(uint16_t)));
+    return labels;
+}
+
+double NearestAtomSegmentation::covalentRadius(int atomicNumber) {
+    if (atomicNumber < 1 || atomicNumber > static_cast<int>(covalentRadii.size())) {
+        throw Exception("No covalent radius for atomic number " + std::to_string(atomicNumber),
+                        IVW_CONTEXT_CUSTOM("NearestAtomSegmentation"));
+    }
+    return covalentRadii[atomicNumber - 1];
+}
+
+}  // namespace inviwo
@@ -0,0 +1,95 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/regionadjacency.h>
+
+#include <cmath>
+
+namespace inviwo {
+
+RegionAdjacency::Graph RegionAdjacency::merge(std::vector<Accumulator>& accumulators,
+                                              size_t nrRegions, const dmat3& indexToWorld,
+                                              const dvec3& offset) {
+    // Merge the per thread edge sets and sums in thread order
+    auto& total = accumulators.front();
+    for (size_t t = 1; t < accumulators.size(); t++) {
+        for (const auto& [key, faces] : accumulators[t].edges) {
+            total.edges[key] += faces;
+        }
+        for (size_t r = 0; r < nrRegions; r++) {
+            total.voxels[r] += accumulators[t].voxels[r];
+            total.positions[r] += accumulators[t].positions[r];
+        }
+    }
+
+    Graph graph;
+    graph.nrRegions = nrRegions;
+    graph.edges.reserve(total.edges.size());
+    for (const auto& [key, faces] : total.edges) {
+        graph.edges.push_back({static_cast<size_t>(key >> 32),
+                               static_cast<size_t>(key & 0xffffffffull), faces});
+    }
+    std::sort(graph.edges.begin(), graph.edges.end(), [](const Edge& a, const Edge& b) {
+        return a.first != b.first ? a.first < b.first : a.second < b.second;
+    });
+
+    graph.voxels = std::move(total.voxels);
+    graph.centroids.resize(nrRegions, dvec3{0.0});
+    for (size_t r = 0; r < nrRegions; r++) {
+        if (graph.voxels[r] == 0) continue;
+        graph.centroids[r] =
+            indexToWorld * (total.positions[r] / static_cast<double>(graph.voxels[r])) + offset;
+    }
+    return graph;
+}
+
+std::vector<double> RegionAdjacency::centroidDistances(const Graph& graph) {
+    const auto n = graph.nrRegions;
+    std::vector<double> distances(n * n, 0.0);
+    for (size_t i = 0; i < n; i++) {
+        if (graph.voxels[i] == 0) continue;
+        for (size_t j = i + 1; j < n; j++) {
+            if (graph.voxels[j] == 0) continue;
+            const auto d = graph.centroids[i] - graph.centroids[j];
+            distances[i * n + j] = distances[j * n + i] = std::sqrt(glm::dot(d, d));
+        }
+    }
+    return distances;
+}
+
+std::vector<float> RegionAdjacency::faceMatrix(const Graph& graph) {
+    const auto n = graph.nrRegions;
+    std::vector<float> faces(n * n, 0.0f);
+    for (const auto& edge : graph.edges) {
+        faces[edge.first * n + edge.second] = static_cast<float>(edge.faces);
+        faces[edge.second * n + edge.first] = static_cast<float>(edge.faces);
+    }
+    return faces;
+}
+
+}  // namespace inviwo
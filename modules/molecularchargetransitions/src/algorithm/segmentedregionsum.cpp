@@ -0,0 +1,119 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace inviwo {
+
+namespace {
+
+// Order of the symmetric matrix elements in Moments::second
+constexpr size_t symmetric[3][3] = {{0, 3, 4}, {3, 1, 5}, {4, 5, 2}};
+
+}  // namespace
+
+SegmentedRegionSum::Moments& SegmentedRegionSum::Moments::operator+=(const Moments& other) {
+    charge += other.charge;
+    first += other.first;
+    for (size_t i = 0; i < second.size(); i++) {
+        second[i] += other.second[i];
+    }
+    return *this;
+}
+
+SegmentedRegionSum::BlockProgress::BlockProgress(const ProgressCallback& callback, size_t nrVoxels)
+    : callback_{callback}, nrVoxels_{nrVoxels} {}
+
+void SegmentedRegionSum::BlockProgress::done(size_t voxels) {
+    if (!callback_) return;
+    std::scoped_lock lock(mutex_);
+    done_ += voxels;
+    if (stopped_ || (done_ - reported_ < progressInterval && done_ < nrVoxels_)) return;
+    reported_ = done_;
+    if (!callback_(done_)) stopped_ = true;
+}
+
+SegmentedRegionSum::Moments SegmentedRegionSum::toWorld(const Moments& moments,
+                                                        const dmat3& indexToWorld,
+                                                        const dvec3& offset) {
+    // p = B * i + o gives
+    //     sum q p   = B F + Q o
+    //     sum q p p^T = B S B^T + B F o^T + o (B F)^T + Q o o^T
+    // with Q, F and S the zeroth, first and second moments in index space
+    const auto& q = moments.charge;
+    const auto bf = indexToWorld * moments.first;
+
+    Moments world;
+    world.charge = q;
+    world.first = bf + offset * q;
+    for (size_t r = 0; r < 3; r++) {
+        for (size_t c = r; c < 3; c++) {
+            double bsb = 0.0;
+            for (size_t i = 0; i < 3; i++) {
+                for (size_t j = 0; j < 3; j++) {
+                    bsb += indexToWorld[i][r] * moments.second[symmetric[i][j]] *
+                           indexToWorld[j][c];
+                }
+            }
+            world.second[symmetric[r][c]] =
+                bsb + bf[r] * offset[c] + offset[r] * bf[c] + q * offset[r] * offset[c];
+        }
+    }
+    return world;
+}
+
+SegmentedRegionSum::Moments SegmentedRegionSum::sum(const std::vector<Moments>& moments,
+                                                    const std::vector<size_t>& indices) {
+    Moments total;
+    for (auto i : indices) {
+        total += moments[i];
+    }
+    return total;
+}
+
+SegmentedRegionSum::Features SegmentedRegionSum::features(const Moments& moments) {
+    Features features;
+    features.dipole = moments.first;
+    if (moments.charge == 0.0) return features;
+
+    features.centroid = moments.first / moments.charge;
+    double trace = 0.0;
+    for (size_t i = 0; i < 3; i++) {
+        const auto variance = moments.second[i] / moments.charge -
+                              features.centroid[i] * features.centroid[i];
+        features.spread[i] = std::sqrt(std::max(variance, 0.0));
+        trace += std::max(variance, 0.0);
+    }
+    features.radius = std::sqrt(trace);
+    return features;
+}
+
+}  // namespace inviwo
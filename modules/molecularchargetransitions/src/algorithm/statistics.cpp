@@ -28,18 +28,25 @@
  *********************************************************************************/
 
 #include <inviwo/molecularchargetransitions/algorithm/statistics.h>
-#include <numeric>
+#include <inviwo/molecularchargetransitions/util/deterministicreduction.h>
 
 namespace inviwo {
 
 float VectorStatistics::meanValue(const std::vector<float>& values) {
-    const auto sum = std::accumulate(values.begin(), values.end(), 0.0f);
-    return sum / values.size();
+    util::CompensatedSum sum;
+    for (const auto value : values) {
+        sum.add(value);
+    }
+    return static_cast<float>(sum.value() / values.size());
 }
 
 float VectorStatistics::variance(const std::vector<float>& values, const float& mean) {
-    const auto sqSum = std::inner_product(values.begin(), values.end(), values.begin(), 0.0f);
-    return sqSum / values.size() - mean * mean;
+    util::CompensatedSum sqSum;
+    for (const auto value : values) {
+        sqSum.add(static_cast<double>(value) * value);
+    }
+    return static_cast<float>(sqSum.value() / values.size() -
+                              static_cast<double>(mean) * mean);
 }
 
 }  // namespace inviwo
@@ -0,0 +1,351 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+#include <inviwo/core/util/exception.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace inviwo {
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+// Split n into three factors, as even as possible, the largest factor along the largest dimension.
+// If the factors of n are uneven (e.g. {1, 1, n} for a prime n), a grid with a few more cells is
+// used instead, where the cells beyond n are part of the last layer.
+std::array<size_t, 3> splitIntoCells(size_t n, const size3_t& dims) {
+    std::array<size_t, 3> best{n, 1, 1};
+    size_t bestSpread = n;
+    for (size_t a = 1; a <= n; a++) {
+        if (n % a != 0) continue;
+        for (size_t b = 1; b <= n / a; b++) {
+            if ((n / a) % b != 0) continue;
+            const size_t c = n / a / b;
+            const auto spread = std::max({a, b, c}) - std::min({a, b, c});
+            if (spread < bestSpread) {
+                bestSpread = spread;
+                best = {a, b, c};
+            }
+        }
+    }
+    std::sort(best.begin(), best.end());
+
+    // a <= b <= c with c = ceil(n / (a b)), so fewer than a b cells are left over
+    std::array<size_t, 3> grid = best;
+    size_t gridSpread = bestSpread;
+    for (size_t a = 1; (n + a * a - 1) / (a * a) >= a; a++) {
+        for (size_t b = a;; b++) {
+            const auto c = (n + a * b - 1) / (a * b);
+            if (c < b) break;
+            if (c - a < gridSpread) {
+                gridSpread = c - a;
+                grid = {a, b, c};
+            }
+        }
+    }
+
+    std::array<size_t, 3> axes{0, 1, 2};
+    std::sort(axes.begin(), axes.end(), [&](size_t l, size_t r) { return dims[l] < dims[r]; });
+    const auto toAxes = [&](const std::array<size_t, 3>& factors) {
+        std::array<size_t, 3> cells{};
+        for (size_t i = 0; i < 3; i++) {
+            cells[axes[i]] = factors[i];
+        }
+        return cells;
+    };
+    const auto fits = [&](const std::array<size_t, 3>& cells) {
+        return cells[0] <= dims[0] && cells[1] <= dims[1] && cells[2] <= dims[2];
+    };
+    const auto exact = toAxes(best);
+    return fits(exact) && best[2] <= 2 * grid[2] ? exact : toAxes(grid);
+}
+
+void normalize(std::vector<float>& v) {
+    const auto sum = std::accumulate(v.begin(), v.end(), 0.0f);
+    std::transform(v.begin(), v.end(), v.begin(), [&](float x) { return x / sum; });
+}
+
+}  // namespace
+
+uint64_t SyntheticEnsemble::Random::next() {
+    uint64_t z = (state_ += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+double SyntheticEnsemble::Random::uniform() {
+    return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+double SyntheticEnsemble::Random::normal() {
+    const auto u1 = 1.0 - uniform();
+    const auto u2 = uniform();
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(2.0 * pi * u2);
+}
+
+SyntheticEnsemble::SyntheticEnsemble(const Settings& settings) : settings_{settings} {
+    const auto& dims = settings_.dimensions;
+    if (settings_.nrRegions == 0 || settings_.nrSubgroups == 0 || settings_.nrClusters == 0) {
+        throw Exception("Need at least one region, subgroup and cluster",
+                        IVW_CONTEXT_CUSTOM("SyntheticEnsemble"));
+    }
+    if (settings_.nrSubgroups > settings_.nrRegions) {
+        throw Exception("More subgroups than regions", IVW_CONTEXT_CUSTOM("SyntheticEnsemble"));
+    }
+    if (settings_.nrRegions > std::numeric_limits<uint16_t>::max()) {
+        throw Exception("Too many regions for a uint16 segmentation",
+                        IVW_CONTEXT_CUSTOM("SyntheticEnsemble"));
+    }
+
+    nrCells_ = splitIntoCells(settings_.nrRegions, dims);
+    for (size_t axis = 0; axis < 3; axis++) {
+        if (nrCells_[axis] > dims[axis]) {
+            throw Exception("Too many regions for the volume dimensions",
+                            IVW_CONTEXT_CUSTOM("SyntheticEnsemble"));
+        }
+    }
+
+    Random rnd(settings_.seed ^ 0x5851f42d4c957f2dull);
+
+    // Cell boundaries, jittered by up to a quarter of a cell
+    for (size_t axis = 0; axis < 3; axis++) {
+        const auto n = nrCells_[axis];
+        const auto dim = static_cast<double>(dims[axis]);
+        auto& b = boundaries_[axis];
+        b.resize(n + 1);
+        b.front() = 0;
+        b.back() = dims[axis];
+        for (size_t k = 1; k < n; k++) {
+            const auto pos = (static_cast<double>(k) + 0.5 * rnd.uniform() - 0.25) * dim / n;
+            b[k] = std::clamp(static_cast<size_t>(pos), b[k - 1] + 1, dims[axis] - (n - k));
+        }
+    }
+
+    // Cells beyond nrRegions belong to the region next to them along the slowest axis with more
+    // than one cell, which makes that region two cells long. They are all in the last layer.
+    const auto nrGridCells = nrCells_[0] * nrCells_[1] * nrCells_[2];
+    const size_t mergeAxis = nrCells_[2] > 1 ? 2 : (nrCells_[1] > 1 ? 1 : 0);
+    const size_t mergeStride = mergeAxis == 2 ? nrCells_[0] * nrCells_[1]
+                                              : (mergeAxis == 1 ? nrCells_[0] : 1);
+    cellRegions_.resize(nrGridCells);
+    for (size_t k = 0; k < nrGridCells; k++) {
+        cellRegions_[k] = static_cast<uint16_t>(k < settings_.nrRegions ? k : k - mergeStride);
+    }
+
+    // Regions, x fastest
+    regions_.resize(settings_.nrRegions);
+    for (size_t r = 0; r < settings_.nrRegions; r++) {
+        const std::array<size_t, 3> cell{r % nrCells_[0], (r / nrCells_[0]) % nrCells_[1],
+                                         r / (nrCells_[0] * nrCells_[1])};
+        const auto merged = r + mergeStride >= settings_.nrRegions && r + mergeStride < nrGridCells;
+        auto& region = regions_[r];
+        double minExtent = std::numeric_limits<double>::max();
+        for (size_t axis = 0; axis < 3; axis++) {
+            region.begin[axis] = boundaries_[axis][cell[axis]];
+            region.end[axis] =
+                boundaries_[axis][cell[axis] + (merged && axis == mergeAxis ? 2 : 1)];
+            const auto extent = static_cast<double>(region.end[axis] - region.begin[axis]);
+            region.center[axis] = static_cast<double>(region.begin[axis]) +
+                                  extent * (0.5 + 0.3 * (rnd.uniform() - 0.5)) - 0.5;
+            minExtent = std::min(minExtent, extent);
+        }
+        region.sigma = std::max(0.5, 0.25 * minExtent);
+        region.weight = 0.5 + rnd.uniform();
+        region.subgroup = r * settings_.nrSubgroups / settings_.nrRegions;
+    }
+    // Normalize the weights within each subgroup
+    std::vector<double> subgroupWeights(settings_.nrSubgroups, 0.0);
+    for (const auto& region : regions_) subgroupWeights[region.subgroup] += region.weight;
+    for (auto& region : regions_) region.weight /= subgroupWeights[region.subgroup];
+
+    // Cluster prototypes
+    auto prototype = [&]() {
+        std::vector<float> charges(settings_.nrSubgroups);
+        std::generate(charges.begin(), charges.end(),
+                      [&]() { return static_cast<float>(0.1 + rnd.uniform()); });
+        normalize(charges);
+        return charges;
+    };
+    for (size_t c = 0; c < settings_.nrClusters; c++) {
+        holePrototypes_.push_back(prototype());
+        particlePrototypes_.push_back(prototype());
+    }
+}
+
+SyntheticEnsemble::Random SyntheticEnsemble::memberRandom(size_t member) const {
+    Random seeder(settings_.seed + 0x2545f4914f6cdd1dull * (static_cast<uint64_t>(member) + 1));
+    return Random(seeder.next());
+}
+
+int SyntheticEnsemble::cluster(size_t member) const {
+    auto rnd = memberRandom(member);
+    return static_cast<int>(rnd.next() % settings_.nrClusters);
+}
+
+std::pair<std::vector<float>, std::vector<float>> SyntheticEnsemble::charges(size_t member) const {
+    auto rnd = memberRandom(member);
+    const auto c = static_cast<size_t>(rnd.next() % settings_.nrClusters);
+
+    auto perturbed = [&](const std::vector<float>& prototype) {
+        std::vector<float> charges(prototype.size());
+        std::transform(prototype.begin(), prototype.end(), charges.begin(), [&](float q) {
+            return std::max(
+                1.0e-3f, q + settings_.clusterSpread * static_cast<float>(rnd.normal()));
+        });
+        normalize(charges);
+        return charges;
+    };
+    auto hole = perturbed(holePrototypes_[c]);
+    auto particle = perturbed(particlePrototypes_[c]);
+    return {std::move(hole), std::move(particle)};
+}
+
+std::vector<float> SyntheticEnsemble::regionCharges(
+    const std::vector<float>& subgroupCharges) const {
+    std::vector<float> charges(regions_.size());
+    std::transform(regions_.begin(), regions_.end(), charges.begin(), [&](const Region& region) {
+        return static_cast<float>(subgroupCharges[region.subgroup] * region.weight);
+    });
+    return charges;
+}
+
+std::vector<uint16_t> SyntheticEnsemble::labels() const {
+    HotPathProfiler::ScopedTimer timer("SyntheticEnsemble::labels");
+    const auto& dims = settings_.dimensions;
+
+    std::array<std::vector<uint16_t>, 3> cellOf;
+    for (size_t axis = 0; axis < 3; axis++) {
+        cellOf[axis].resize(dims[axis]);
+        for (size_t k = 0; k < nrCells_[axis]; k++) {
+            std::fill(cellOf[axis].begin() + boundaries_[axis][k],
+                      cellOf[axis].begin() + boundaries_[axis][k + 1], static_cast<uint16_t>(k));
+        }
+    }
+
+    std::vector<uint16_t> labels(dims.x * dims.y * dims.z);
+    auto dst = labels.begin();
+    for (size_t z = 0; z < dims.z; z++) {
+        const auto zOffset = cellOf[2][z] * nrCells_[0] * nrCells_[1];
+        for (size_t y = 0; y < dims.y; y++) {
+            const auto yzOffset = zOffset + cellOf[1][y] * nrCells_[0];
+            dst = std::transform(cellOf[0].begin(), cellOf[0].end(), dst,
+                                 [&](uint16_t x) { return cellRegions_[yzOffset + x]; });
+        }
+    }
+    timer.count("voxels", static_cast<double>(labels.size()));
+    return labels;
+}
+
+std::vector<float> SyntheticEnsemble::density(size_t member, Charge charge) const {
+    HotPathProfiler::ScopedTimer timer("SyntheticEnsemble::density");
+    const auto& dims = settings_.dimensions;
+    const auto [hole, particle] = charges(member);
+    const auto charges = regionCharges(charge == Charge::Hole ? hole : particle);
+
+    std::vector<float> density(dims.x * dims.y * dims.z, 0.0f);
+    std::array<std::vector<double>, 3> gaussian;
+    for (size_t r = 0; r < regions_.size(); r++) {
+        const auto& region = regions_[r];
+
+        // Separable gaussian, cut off at three sigma
+        std::array<size_t, 3> begin{};
+        std::array<size_t, 3> end{};
+        double norm = 1.0;
+        for (size_t axis = 0; axis < 3; axis++) {
+            const auto c = region.center[axis];
+            const auto reach = 3.0 * region.sigma;
+            begin[axis] = static_cast<size_t>(std::max(0.0, std::ceil(c - reach)));
+            end[axis] = std::min(dims[axis], static_cast<size_t>(std::floor(c + reach)) + 1);
+            auto& g = gaussian[axis];
+            g.resize(end[axis] - begin[axis]);
+            for (size_t i = 0; i < g.size(); i++) {
+                const auto d = static_cast<double>(begin[axis] + i) - c;
+                g[i] = std::exp(-d * d / (2.0 * region.sigma * region.sigma));
+            }
+            norm *= std::accumulate(g.begin(), g.end(), 0.0);
+        }
+        // Normalize so that the gaussian integrates to the region charge
+        const auto amplitude = static_cast<double>(charges[r]) / norm;
+
+        for (size_t z = begin[2]; z < end[2]; z++) {
+            const auto gz = amplitude * gaussian[2][z - begin[2]];
+            for (size_t y = begin[1]; y < end[1]; y++) {
+                const auto gyz = gz * gaussian[1][y - begin[1]];
+                auto* dst = density.data() + (z * dims.y + y) * dims.x;
+                for (size_t x = begin[0]; x < end[0]; x++) {
+                    dst[x] += static_cast<float>(gyz * gaussian[0][x - begin[0]]);
+                }
+            }
+        }
+    }
+    timer.count("voxels", static_cast<double>(density.size()));
+    return density;
+}
+
+nlohmann::json SyntheticEnsemble::subgroups() const {
+    auto json = nlohmann::json::array();
+    for (size_t sg = 0; sg < settings_.nrSubgroups; sg++) {
+        auto indices = nlohmann::json::array();
+        for (size_t r = 0; r < regions_.size(); r++) {
+            if (regions_[r].subgroup == sg) indices.push_back(r);
+        }
+        json.push_back({{"name", "sg" + std::to_string(sg + 1)}, {"indices", indices}});
+    }
+    return json;
+}
+
+SyntheticEnsemble::Table SyntheticEnsemble::table() const {
+    HotPathProfiler::ScopedTimer timer("SyntheticEnsemble::table");
+    const auto members = settings_.nrMembers;
+    const auto nrSubgroups = settings_.nrSubgroups;
+
+    Table table;
+    table.cluster.resize(members);
+    table.holeCharges.assign(nrSubgroups, std::vector<float>(members));
+    table.particleCharges.assign(nrSubgroups, std::vector<float>(members));
+    for (size_t m = 0; m < members; m++) {
+        table.cluster[m] = cluster(m);
+        const auto [hole, particle] = charges(m);
+        for (size_t sg = 0; sg < nrSubgroups; sg++) {
+            table.holeCharges[sg][m] = hole[sg];
+            table.particleCharges[sg][m] = particle[sg];
+        }
+    }
+    timer.count("rows", static_cast<double>(members));
+    return table;
+}
+
+}  // namespace inviwo
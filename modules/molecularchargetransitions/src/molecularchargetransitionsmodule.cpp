@@ -28,10 +28,29 @@
  *********************************************************************************/
 
 #include <inviwo/molecularchargetransitions/molecularchargetransitionsmodule.h>
+#include <inviwo/molecularchargetransitions/processors/atomvoronoisegmentation.h>
+#include <inviwo/molecularchargetransitions/processors/clusterchargetransferstatistics.h>
+#include <inviwo/molecularchargetransitions/processors/clusterrepresentatives.h>
 #include <inviwo/molecularchargetransitions/processors/clusterstatistics.h>
 #include <inviwo/molecularchargetransitions/processors/computechargetransfer.h>
+#include <inviwo/molecularchargetransitions/processors/computeensemblechargetransfer.h>
+#include <inviwo/molecularchargetransitions/processors/computelocalitydescriptors.h>
+#include <inviwo/molecularchargetransitions/processors/dendrogramcut.h>
+#include <inviwo/molecularchargetransitions/processors/densitywatershedsegmentation.h>
+#include <inviwo/molecularchargetransitions/processors/fastcubesource.h>
+#include <inviwo/molecularchargetransitions/processors/hotpathprofiling.h>
 #include <inviwo/molecularchargetransitions/processors/measureoflocality.h>
+#include <inviwo/molecularchargetransitions/processors/minibatchclustering.h>
+#include <inviwo/molecularchargetransitions/processors/quantizechargetable.h>
+#include <inviwo/molecularchargetransitions/processors/regionadjacencygraph.h>
 #include <inviwo/molecularchargetransitions/processors/sumchargeinsegmentedregions.h>
+#include <inviwo/molecularchargetransitions/processors/syntheticensemblesource.h>
+#include <inviwo/molecularchargetransitions/processors/voxeloverlapchargetransfer.h>
+
+#include <warn/push>
+#include <warn/ignore/shadow>
+#include <pybind11/pybind11.h>
+#include <warn/pop>
 
 namespace inviwo {
 
@@ -44,11 +63,33 @@ MolecularChargeTransitionsModule::MolecularChargeTransitionsModule(InviwoApplica
     // Register objects that can be shared with the rest of inviwo here:
 
     // Processors
+    registerProcessor<AtomVoronoiSegmentation>();
+    registerProcessor<ClusterChargeTransferStatistics>();
+    registerProcessor<ClusterRepresentatives>();
     registerProcessor<ClusterStatistics>();
     registerProcessor<ComputeChargeTransfer>();
+    registerProcessor<ComputeEnsembleChargeTransfer>();
+    registerProcessor<ComputeLocalityDescriptors>();
+    registerProcessor<DendrogramCut>();
+    registerProcessor<DensityWatershedSegmentation>();
+    registerProcessor<FastCubeSource>();
+    registerProcessor<HotPathProfiling>();
     registerProcessor<MeasureOfLocality>();
+    registerProcessor<MiniBatchClustering>();
     // registerProcessor<MolecularChargeTransitionsProcessor>();
+    registerProcessor<QuantizeChargeTable>();
+    registerProcessor<RegionAdjacencyGraph>();
     registerProcessor<SumChargeInSegmentedRegions>();
+    registerProcessor<SyntheticEnsembleSource>();
+    registerProcessor<VoxelOverlapChargeTransfer>();
+
+    // Registers the LazyDataOutports with Python, so that getData() works on them in all scripts
+    try {
+        pybind11::gil_scoped_acquire gil;
+        pybind11::module::import("ivwmolecularchargetransitions");
+    } catch (const std::exception& e) {
+        LogWarn("Could not import ivwmolecularchargetransitions: " << e.what());
+    }
 
     // Properties
     // registerProperty<MolecularChargeTransitionsProperty>();
@@ -10,6 +10,7 @@
 
 import inviwopy as ivw
 import ivwdataframe as df
+import ivwmolecularchargetransitions as mct
 import subprocess
 import os
 
@@ -77,6 +78,10 @@ class CreateClusterTransitionDiagrams(ivw.Processor):
     def process(self):
         print("process")
         inputDataFrame = self.dataFrame.getData()
+        # Decoded column values, get(i) would give the integer codes of quantized charge
+        # columns (see QuantizeChargeTable)
+        values = [mct.column(inputDataFrame, inputDataFrame.column(j).header).tolist()
+                  for j in range(0, inputDataFrame.cols)]
         
         if (self.resetFileLocation.value == True):
             self.resultingFolder.value = '/'
@@ -113,7 +118,7 @@ class CreateClusterTransitionDiagrams(ivw.Processor):
                             for j in range(0, inputDataFrame.cols):
                                 header = inputDataFrame.column(j).header.lower()
                                 if featureVector_name in header:
-                                    value = inputDataFrame.column(j).get(i)
+                                    value = values[j][i]
                                     fv_row.append(value)
                                     text_file.write(f"{value} ")
                             text_file.write("\n")
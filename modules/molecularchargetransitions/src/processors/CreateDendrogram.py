@@ -3,6 +3,7 @@
 
 import inviwopy as ivw
 import ivwdataframe as df
+import ivwmolecularchargetransitions as mct
 from inviwopy.glm import vec2,vec3,vec4
 
 import numpy as np
@@ -18,6 +19,9 @@ class CreateDendrogram(ivw.Processor):
         self.addInport(self.dataFrame, owner=False)
         self.outport = df.DataFrameOutport("outport")
         self.addOutport(self.outport)
+        # Merges of the clustering, for cuts at other levels of detail with DendrogramCut
+        self.linkageOutport = df.DataFrameOutport("linkage")
+        self.addOutport(self.linkageOutport)
 
         self.featureVectorName = ivw.properties.StringProperty("fetureVectorName", "Feature vector name", "TranFV")
         self.addProperty(self.featureVectorName)
@@ -115,6 +119,10 @@ class CreateDendrogram(ivw.Processor):
     def process(self):
         print("process")
         inputDataFrame = self.dataFrame.getData()
+        # Decoded column values, get(i) would give the integer codes of quantized charge
+        # columns (see QuantizeChargeTable)
+        values = [mct.column(inputDataFrame, inputDataFrame.column(j).header).tolist()
+                  for j in range(0, inputDataFrame.cols)]
         
         # This seem to help if get error: 'NoneType' object has no attribute 'rows' ??
         print(inputDataFrame.rows)
@@ -134,7 +142,7 @@ class CreateDendrogram(ivw.Processor):
                 #    label = label + inputDataFrame.column(j).get(i)
 
                 if featureVector_name in header:
-                    fv_row.append(inputDataFrame.column(j).get(i))
+                    fv_row.append(values[j][i])
 
             X.append(fv_row)
             labels.append(label)
@@ -222,4 +230,11 @@ class CreateDendrogram(ivw.Processor):
         dataframe.updateIndex()
 
         self.outport.setData(dataframe)
+
+        linkageDataFrame = df.DataFrame()
+        linkageDataFrame.addIntColumn("Child 1", model.children_[:, 0].tolist())
+        linkageDataFrame.addIntColumn("Child 2", model.children_[:, 1].tolist())
+        linkageDataFrame.addFloatColumn("Distance", model.distances_.tolist())
+        linkageDataFrame.updateIndex()
+        self.linkageOutport.setData(linkageDataFrame)
         
@@ -2,6 +2,7 @@
 
 import inviwopy as ivw
 import ivwdataframe as df
+import ivwmolecularchargetransitions as mct
 import numpy as np
 from sklearn.manifold import TSNE
 from sklearn.manifold import MDS
@@ -65,6 +66,10 @@ class DimensionalityReduction(ivw.Processor):
 
     def process(self):
         inputDataFrame = self.inport.getData()
+        # Decoded column values, get(i) would give the integer codes of quantized charge
+        # columns (see QuantizeChargeTable)
+        values = [mct.column(inputDataFrame, inputDataFrame.column(j).header).tolist()
+                  for j in range(0, inputDataFrame.cols)]
 
         # Get feature vector from data frame
         featureVector_name = self.featureVectorName.value.lower()
@@ -74,7 +79,7 @@ class DimensionalityReduction(ivw.Processor):
             for j in range(0, inputDataFrame.cols):
                 header = inputDataFrame.column(j).header.lower()
                 if featureVector_name in header:
-                    fv_row.append(inputDataFrame.column(j).get(i))
+                    fv_row.append(values[j][i])
 
             X.append(fv_row)
 
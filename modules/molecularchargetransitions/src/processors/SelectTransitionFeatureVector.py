@@ -2,6 +2,7 @@
 
 import inviwopy as ivw
 import ivwdataframe as df
+import ivwmolecularchargetransitions as mct
 
 import numpy as np
 
@@ -62,6 +63,10 @@ class SelectTransitionFeatureVector(ivw.Processor):
 
     def process(self):
         inputDataFrame = self.dataFrame.getData()
+        # Decoded column values, get(i) would give the integer codes of quantized charge
+        # columns (see QuantizeChargeTable)
+        values = [mct.column(inputDataFrame, inputDataFrame.column(j).header).tolist()
+                  for j in range(0, inputDataFrame.cols)]
 
         # Get feature vector from data frame
         X = []
@@ -73,47 +78,47 @@ class SelectTransitionFeatureVector(ivw.Processor):
                 # Use hole and particle subgroup charges
                 if self.featureVectorSelection.value == "holeAndParticle":
                     if ("hole" in header) or ("particle" in header):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Use charge transfer matrix
                 elif self.featureVectorSelection.value == "chargeTransferMatrix":
                     if ("transfer" in header):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Use trace of matrix
                 elif self.featureVectorSelection.value == "trace":
                     if ("transfer" in header and header[-1] == header[-2]):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # bottleneck
                 elif self.featureVectorSelection.value == "bottleneck":
                     if ("h0" in header or "h2" in header):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Use column range
                 elif self.featureVectorSelection.value == "columnRange":
                     if (j >= self.colRangeStart.value and j <= self.colRangeEnd.value):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Add oscillatory strength to feature vector
                 if self.useOscStrength.value == True : 
                     if ("osc" in header):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Add rotatory strength to feature vector
                 if self.useRotStrength.value == True :
                     if ("rot" in header):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Add energy to feature vector
                 if self.useEnergy.value == True :
                     if ("energy" in header):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
 
                 # Add trace to feature vector
                 if self.useTrace.value == True :
                     if ("transfer" in header and header[-1] == header[-2]):
-                        row.append(inputDataFrame.column(j).get(i))
+                        row.append(values[j][i])
             
             X.append(row)
 
@@ -0,0 +1,118 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/processors/atomvoronoisegmentation.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo AtomVoronoiSegmentation::processorInfo_{
+    "org.inviwo.AtomVoronoiSegmentation",  // Class identifier
+    "Atom Voronoi Segmentation",           // Display name
+    "Undefined",                           // Category
+    CodeState::Experimental,               // Code state
+    Tags::None,                            // Tags
+};
+const ProcessorInfo& AtomVoronoiSegmentation::getProcessorInfo() const { return processorInfo_; }
+
+AtomVoronoiSegmentation::AtomVoronoiSegmentation()
+    : Processor()
+    , volume_("volume")
+    , atoms_("atoms")
+    , segmentation_("segmentation")
+    , weighted_("weighted", "Weight by atomic radius", false)
+    , radiusScale_("radiusScale", "Radius scale", 1.0f, 0.01f, 10.0f, 0.01f) {
+
+    addPort(volume_);
+    addPort(atoms_);
+    addPort(segmentation_);
+    addProperty(weighted_);
+    addProperty(radiusScale_);
+
+    radiusScale_.visibilityDependsOn(weighted_, [](const auto& p) { return p.get(); });
+}
+
+void AtomVoronoiSegmentation::process() {
+    HotPathProfiler::ScopedTimer timer("AtomVoronoiSegmentation::process");
+
+    const auto volume = volume_.getData();
+    const auto atoms = atoms_.getData();
+
+    const auto xCol = atoms->getColumn("x");
+    const auto yCol = atoms->getColumn("y");
+    const auto zCol = atoms->getColumn("z");
+    if (xCol == nullptr || yCol == nullptr || zCol == nullptr) {
+        throw Exception("Could not get atom position columns (x, y, z)", IVW_CONTEXT);
+    }
+    const auto x = columnViews_.get<double>(xCol);
+    const auto y = columnViews_.get<double>(yCol);
+    const auto z = columnViews_.get<double>(zCol);
+
+    std::vector<dvec3> positions(x.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        positions[i] = dvec3(x[i], y[i], z[i]);
+    }
+
+    std::vector<double> radii;
+    if (weighted_) {
+        const auto scale = static_cast<double>(radiusScale_.get());
+        if (const auto radiusCol = atoms->getColumn("Radius")) {
+            const auto radius = columnViews_.get<double>(radiusCol);
+            for (auto r : radius) radii.push_back(scale * r);
+        } else if (const auto numberCol = atoms->getColumn("Atomic number")) {
+            const auto atomicNumber = columnViews_.get<int>(numberCol);
+            for (auto n : atomicNumber) {
+                radii.push_back(scale * NearestAtomSegmentation::covalentRadius(n));
+            }
+        } else {
+            throw Exception("Weighting requires a Radius or Atomic number column", IVW_CONTEXT);
+        }
+    }
+
+    const auto dims = volume->getDimensions();
+    const dmat4 indexToWorld{volume->getCoordinateTransformer().getIndexToWorldMatrix()};
+    const auto labels = NearestAtomSegmentation::segment(dims, dmat3(indexToWorld),
+                                                         dvec3(indexToWorld[3]), positions, radii);
+
+    auto volumeRAM = std::make_shared<VolumeRAMPrecision<uint16_t>>(dims);
+    std::copy(labels.begin(), labels.end(), volumeRAM->getDataTyped());
+    auto segmentation = std::make_shared<Volume>(volumeRAM);
+    segmentation->setModelMatrix(volume->getModelMatrix());
+    segmentation->setWorldMatrix(volume->getWorldMatrix());
+    const auto lastLabel = static_cast<double>(positions.size() - 1);
+    segmentation->dataMap.dataRange = dvec2(0.0, lastLabel);
+    segmentation->dataMap.valueRange = dvec2(0.0, lastLabel);
+
+    timer.count("voxels", static_cast<double>(labels.size()));
+    timer.count("bytes copied", static_cast<double>(labels.size() * sizeof(uint16_t)));
+    segmentation_.setData(segmentation);
+}
+
+}  // namespace inviwo
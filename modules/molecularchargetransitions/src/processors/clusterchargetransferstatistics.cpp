@@ -0,0 +1,163 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/clusterchargetransferstatistics.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo ClusterChargeTransferStatistics::processorInfo_{
+    "org.inviwo.ClusterChargeTransferStatistics",  // Class identifier
+    "Cluster Charge Transfer Statistics",          // Display name
+    "Undefined",                                   // Category
+    CodeState::Experimental,                       // Code state
+    Tags::None,                                    // Tags
+};
+const ProcessorInfo& ClusterChargeTransferStatistics::getProcessorInfo() const {
+    return processorInfo_;
+}
+
+ClusterChargeTransferStatistics::ClusterChargeTransferStatistics()
+    : Processor()
+    , inport_("inport")
+    , meanOutport_("meanOutport")
+    , medianOutport_("medianOutport")
+    , lowerOutport_("lowerOutport")
+    , upperOutport_("upperOutport")
+    , nrSubgroups_("nrSubgroups", "Nr of subgroups", 2, 1, 10, 1)
+    , clusterCol_{"clusterCol", "Column", inport_, ColumnOptionProperty::AddNoneOption::No, 0}
+    , lowerQuantile_("lowerQuantile", "Lower quantile", 0.05f, 0.0f, 0.5f, 0.01f)
+    , upperQuantile_("upperQuantile", "Upper quantile", 0.95f, 0.5f, 1.0f, 0.01f) {
+
+    addPort(inport_);
+    addPort(meanOutport_);
+    addPort(medianOutport_);
+    addPort(lowerOutport_);
+    addPort(upperOutport_);
+    addProperty(nrSubgroups_);
+    addProperty(clusterCol_);
+    addProperty(lowerQuantile_);
+    addProperty(upperQuantile_);
+}
+
+void ClusterChargeTransferStatistics::process() {
+    HotPathProfiler::ScopedTimer timer("ClusterChargeTransferStatistics::process");
+    const auto input = inport_.getData();
+    auto iCol = input->getIndexColumn();
+    auto& indexCol = iCol->getTypedBuffer()->getRAMRepresentation()->getDataContainer();
+
+    // "Charge transfer ij" is row i of the charge transfer matrix, the transfer from j to i
+    const auto n = static_cast<size_t>(nrSubgroups_.get());
+    std::vector<std::string> names;
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            names.push_back("Charge transfer " + std::to_string(i + 1) + std::to_string(j + 1));
+        }
+    }
+
+    const std::vector<double> quantiles{0.5, lowerQuantile_.get(), upperQuantile_.get()};
+    InputHash key;
+    key.add(clusterCol_.get()).add(n).add(quantiles[1]).add(quantiles[2]);
+    key.add(iCol.get()).add(input->getColumn(clusterCol_.get()).get());
+    for (const auto& name : names) {
+        key.add(input->getColumn(name).get());
+    }
+    if (const auto cached = results_.find(key.value())) {
+        timer.count("cache hits", 1.0);
+        setOutputs(*cached);
+        return;
+    }
+
+    const auto clusters = columnViews_.get<int>(input->getColumn(clusterCol_.get()));
+    if (indexCol.size() != clusters.size()) {
+        throw Exception("Unexpected dimension missmatch", IVW_CONTEXT);
+    }
+
+    std::vector<ColumnView<float>> transfer = {};
+    for (const auto& name : names) {
+        const auto col = input->getColumn(name);
+        if (col == nullptr) {
+            throw Exception("Could not get charge transfer column " + name, IVW_CONTEXT);
+        }
+        transfer.push_back(columnViews_.get<float>(col));
+    }
+    std::vector<const float*> columns;
+    for (const auto& column : transfer) {
+        columns.push_back(column.data());
+    }
+
+    const auto ranges =
+        ClusterGrouping::groupRanges(clusters.data(), indexCol.data(), clusters.size());
+    const auto stats = GroupedColumnStatistics::compute(columns, ranges, quantiles);
+
+    // The matrices of the clusters stacked, one row for each matrix row
+    const auto nrClusters = ranges.size();
+    const auto nrRows = nrClusters * n;
+    std::vector<int> clusterCol(nrRows);
+    std::vector<size_t> clusterSize(nrRows);
+    std::vector<int> rowCol(nrRows);
+    for (size_t c = 0; c < nrClusters; c++) {
+        for (size_t i = 0; i < n; i++) {
+            clusterCol[c * n + i] = ranges.clusters[c];
+            clusterSize[c * n + i] = ranges.clusterSize(c);
+            rowCol[c * n + i] = static_cast<int>(i + 1);
+        }
+    }
+    const auto matrices = [&](const std::vector<float>& values) {
+        auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrRows));
+        dataFrame->addColumn("Cluster", clusterCol);
+        dataFrame->addColumn("Cluster size", clusterSize);
+        dataFrame->addColumn("Row", rowCol);
+        for (size_t j = 0; j < n; j++) {
+            std::vector<float> column(nrRows);
+            for (size_t r = 0; r < nrRows; r++) {
+                // Entry ij of cluster c is at (c * n + i) * n + j, and r = c * n + i
+                column[r] = values[r * n + j];
+            }
+            dataFrame->addColumn(std::to_string(j + 1), std::move(column));
+        }
+        return std::shared_ptr<const DataFrame>(dataFrame);
+    };
+
+    timer.count("rows", static_cast<double>(clusters.size()));
+
+    const Outputs outputs{matrices(stats.mean), matrices(stats.quantiles[0]),
+                          matrices(stats.quantiles[1]), matrices(stats.quantiles[2])};
+    results_.insert(key.value(), outputs);
+    setOutputs(outputs);
+}
+
+void ClusterChargeTransferStatistics::setOutputs(const Outputs& outputs) {
+    meanOutport_.setData(outputs.mean);
+    medianOutport_.setData(outputs.median);
+    lowerOutport_.setData(outputs.lower);
+    upperOutport_.setData(outputs.upper);
+}
+
+}  // namespace inviwo
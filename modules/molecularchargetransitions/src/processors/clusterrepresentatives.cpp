@@ -0,0 +1,126 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/clusterrepresentatives.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo ClusterRepresentatives::processorInfo_{
+    "org.inviwo.ClusterRepresentatives",  // Class identifier
+    "Cluster Representatives",            // Display name
+    "Undefined",                          // Category
+    CodeState::Experimental,              // Code state
+    Tags::None,                           // Tags
+};
+const ProcessorInfo& ClusterRepresentatives::getProcessorInfo() const { return processorInfo_; }
+
+ClusterRepresentatives::ClusterRepresentatives()
+    : Processor()
+    , inport_("inport")
+    , outport_("outport")
+    , nrSubgroups_("nrSubgroups", "Nr of subgroups", 2, 1, 10, 1)
+    , clusterCol_{"clusterCol", "Column", inport_, ColumnOptionProperty::AddNoneOption::No, 0} {
+
+    addPort(inport_);
+    addPort(outport_);
+    addProperty(nrSubgroups_);
+    addProperty(clusterCol_);
+}
+
+void ClusterRepresentatives::process() {
+    HotPathProfiler::ScopedTimer timer("ClusterRepresentatives::process");
+    const auto input = inport_.getData();
+    auto iCol = input->getIndexColumn();
+    auto& indexCol = iCol->getTypedBuffer()->getRAMRepresentation()->getDataContainer();
+
+    const auto nrSubgroups = nrSubgroups_.get();
+    InputHash key;
+    key.add(clusterCol_.get()).add(nrSubgroups);
+    key.add(iCol.get()).add(input->getColumn(clusterCol_.get()).get());
+    for (size_t i = 0; i < nrSubgroups; i++) {
+        key.add(input->getColumn("Hole sg" + std::to_string(i + 1)).get())
+            .add(input->getColumn("Particle sg" + std::to_string(i + 1)).get());
+    }
+    if (const auto cached = results_.find(key.value())) {
+        timer.count("cache hits", 1.0);
+        outport_.setData(*cached);
+        return;
+    }
+
+    const auto clusters = columnViews_.get<int>(input->getColumn(clusterCol_.get()));
+    if (indexCol.size() != clusters.size()) {
+        throw Exception("Unexpected dimension missmatch", IVW_CONTEXT);
+    }
+
+    // The hole and particle charges of the subgroups are the features of a member
+    std::vector<ColumnView<float>> charges = {};
+    for (size_t i = 0; i < nrSubgroups; i++) {
+        const auto holeCol = input->getColumn("Hole sg" + std::to_string(i + 1));
+        const auto particleCol = input->getColumn("Particle sg" + std::to_string(i + 1));
+        if (holeCol == nullptr || particleCol == nullptr) {
+            throw Exception(
+                "Could not get hole or particle column, subgroup " + std::to_string(i + 1),
+                IVW_CONTEXT);
+        }
+        charges.push_back(columnViews_.get<float>(holeCol));
+        charges.push_back(columnViews_.get<float>(particleCol));
+    }
+    std::vector<const float*> features;
+    for (const auto& column : charges) {
+        features.push_back(column.data());
+    }
+
+    const auto ranges =
+        ClusterGrouping::groupRanges(clusters.data(), indexCol.data(), clusters.size());
+    const auto medoids = ClusterMedoids::compute(features, ranges, ClusterMedoids::Settings{});
+
+    const auto nrClusters = ranges.size();
+    std::vector<size_t> clusterSize(nrClusters);
+    std::vector<int> representative(nrClusters);
+    std::vector<float> meanDistance(nrClusters);
+    for (size_t c = 0; c < nrClusters; c++) {
+        clusterSize[c] = ranges.clusterSize(c);
+        representative[c] = static_cast<int>(medoids[c].member);
+        meanDistance[c] = static_cast<float>(medoids[c].meanDistance);
+    }
+
+    timer.count("rows", static_cast<double>(clusters.size()));
+
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrClusters));
+    dataFrame->addColumn("Cluster", ranges.clusters);
+    dataFrame->addColumn("Cluster size", std::move(clusterSize));
+    dataFrame->addColumn("Representative", std::move(representative));
+    dataFrame->addColumn("Mean distance", std::move(meanDistance));
+
+    results_.insert(key.value(), dataFrame);
+    outport_.setData(dataFrame);
+}
+
+}  // namespace inviwo
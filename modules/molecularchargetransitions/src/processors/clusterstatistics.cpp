@@ -44,76 +44,98 @@ const ProcessorInfo& ClusterStatistics::getProcessorInfo() const { return proces
 ClusterStatistics::ClusterStatistics()
     : Processor()
     , inport_("inport")
+    , linkage_("linkage")
     , outport_("outport")
     , diffOutport_("diffOutport")
     , meanOutport_("meanOutport")
     , meanMeasureOfLocalityOutport_("meanMeasureOfLocalityOutport")
+    , quantileOutport_("quantileOutport")
+    , nodeQuantileOutport_("nodeQuantileOutport")
     , nrSubgroups_("nrSubgroups", "Nr of subgroups", 2, 1, 10, 1)
     , clusterCol_{"clusterCol", "Column", inport_, ColumnOptionProperty::AddNoneOption::No, 0}
     , measureOfLocalityCol_{"measureOfLocalityCol", "Measure of Locality column", inport_,
-                            ColumnOptionProperty::AddNoneOption::No, 0} {
+                            ColumnOptionProperty::AddNoneOption::No, 0}
+    , quantileSketches_("quantileSketches", "Quantile sketches", false)
+    , sketchSize_("sketchSize", "Sketch size", 200, 8, 2000, 8)
+    , lowerQuantile_("lowerQuantile", "Lower quantile", 0.05f, 0.0f, 0.5f, 0.01f)
+    , upperQuantile_("upperQuantile", "Upper quantile", 0.95f, 0.5f, 1.0f, 0.01f) {
 
     addPort(inport_);
+    linkage_.setOptional(true);
+    addPort(linkage_);
     addPort(outport_);
     addPort(diffOutport_);
     addPort(meanOutport_);
     addPort(meanMeasureOfLocalityOutport_);
+    addPort(quantileOutport_);
+    addPort(nodeQuantileOutport_);
     addProperty(nrSubgroups_);
     addProperty(clusterCol_);
     addProperty(measureOfLocalityCol_);
+    addProperty(quantileSketches_);
+    addProperty(sketchSize_);
+    addProperty(lowerQuantile_);
+    addProperty(upperQuantile_);
+
+    const auto sketchesEnabled = [](const auto& p) { return p.get(); };
+    sketchSize_.visibilityDependsOn(quantileSketches_, sketchesEnabled);
+    lowerQuantile_.visibilityDependsOn(quantileSketches_, sketchesEnabled);
+    upperQuantile_.visibilityDependsOn(quantileSketches_, sketchesEnabled);
 }
 
 void ClusterStatistics::process() {
-    auto iCol = inport_.getData()->getIndexColumn();
+    HotPathProfiler::ScopedTimer timer("ClusterStatistics::process");
+    const auto input = inport_.getData();
+    auto iCol = input->getIndexColumn();
     auto& indexCol = iCol->getTypedBuffer()->getRAMRepresentation()->getDataContainer();
 
-    const auto clusters =
-        inport_.getData()
-            ->getColumn(clusterCol_.get())
-            ->getBuffer()
-            ->getRepresentation<BufferRAM>()
-            ->dispatch<std::vector<int>, dispatching::filter::Scalars>([](auto buf) {
-                auto& data = buf->getDataContainer();
-                std::vector<int> dst(data.size(), 0.0f);
-                std::transform(data.begin(), data.end(), dst.begin(),
-                               [&](auto v) { return static_cast<int>(v); });
-                return dst;
-            });
+    // Key of the used columns and settings, the columns are looked up (and checked) again below
+    const auto nrSubgroups = nrSubgroups_.get();
+    InputHash key;
+    key.add(clusterCol_.get()).add(measureOfLocalityCol_.get()).add(nrSubgroups);
+    key.add(iCol.get())
+        .add(input->getColumn(clusterCol_.get()).get())
+        .add(input->getColumn(measureOfLocalityCol_.get()).get());
+    for (size_t i = 0; i < nrSubgroups; i++) {
+        key.add(input->getColumn("Hole sg" + std::to_string(i + 1)).get())
+            .add(input->getColumn("Particle sg" + std::to_string(i + 1)).get());
+    }
+    const auto linkage = linkage_.hasData() ? linkage_.getData() : nullptr;
+    key.add(quantileSketches_.get());
+    if (quantileSketches_.get()) {
+        key.add(sketchSize_.get()).add(lowerQuantile_.get()).add(upperQuantile_.get());
+        key.add(linkage != nullptr);
+        if (linkage) {
+            key.add(linkage->getColumn("Child 1").get())
+                .add(linkage->getColumn("Child 2").get())
+                .add(linkage->getColumn("Distance").get());
+        }
+    }
+    if (const auto cached = results_.find(key.value())) {
+        timer.count("cache hits", 1.0);
+        setOutputs(*cached);
+        return;
+    }
+
+    const auto clusters = columnViews_.get<int>(input->getColumn(clusterCol_.get()));
 
     if (indexCol.size() != clusters.size()) {
         throw Exception("Unexpected dimension missmatch", IVW_CONTEXT);
     }
-    const auto n = indexCol.size();
 
     // Create a map from cluster nr to the indices of all points in the cluster
-    std::map<int, std::vector<uint32_t>> clusterNrToIndex = {};
-    for (size_t i = 0; i < n; i++) {
-        auto clusterNr = clusters[i];
-        auto index = indexCol[i];
-
-        if (clusterNrToIndex.empty()) {
-            clusterNrToIndex.emplace(clusterNr, std::vector<uint32_t>{index});
-        } else {
-            auto it = clusterNrToIndex.find(clusterNr);
-
-            if (it != clusterNrToIndex.end()) {
-                it->second.push_back(index);
-            } else {
-                clusterNrToIndex.emplace(clusterNr, std::vector<uint32_t>{index});
-            }
-        }
-    }
+    const auto clusterNrToIndex =
+        ClusterGrouping::groupByCluster(clusters.data(), indexCol.data(), clusters.size());
 
     // Get hole and particle charges for each subgroup
-    std::vector<std::vector<float>> holeCharges = {};
-    std::vector<std::vector<float>> particleCharges = {};
-    const auto nrSubgroups = nrSubgroups_.get();
+    std::vector<ColumnView<float>> holeCharges = {};
+    std::vector<ColumnView<float>> particleCharges = {};
     for (size_t i = 0; i < nrSubgroups; i++) {
         auto holeColumnName = "Hole sg" + std::to_string(i + 1);
         auto particleColumnName = "Particle sg" + std::to_string(i + 1);
 
-        auto holeCol = inport_.getData()->getColumn(holeColumnName);
-        auto particleCol = inport_.getData()->getColumn(particleColumnName);
+        auto holeCol = input->getColumn(holeColumnName);
+        auto particleCol = input->getColumn(particleColumnName);
 
         if (holeCol == nullptr || particleCol == nullptr) {
             throw Exception(
@@ -121,45 +143,25 @@ void ClusterStatistics::process() {
                 IVW_CONTEXT);
         }
 
-        holeCharges.push_back(
-            holeCol->getBuffer()
-                ->getRepresentation<BufferRAM>()
-                ->dispatch<std::vector<float>, dispatching::filter::Scalars>([](auto buf) {
-                    auto& data = buf->getDataContainer();
-                    std::vector<float> dst(data.size(), 0.0f);
-                    std::transform(data.begin(), data.end(), dst.begin(),
-                                   [&](auto v) { return static_cast<float>(v); });
-                    return dst;
-                }));
-
-        particleCharges.push_back(
-            particleCol->getBuffer()
-                ->getRepresentation<BufferRAM>()
-                ->dispatch<std::vector<float>, dispatching::filter::Scalars>([](auto buf) {
-                    auto& data = buf->getDataContainer();
-                    std::vector<float> dst(data.size(), 0.0f);
-                    std::transform(data.begin(), data.end(), dst.begin(),
-                                   [&](auto v) { return static_cast<float>(v); });
-                    return dst;
-                }));
+        holeCharges.push_back(columnViews_.get<float>(holeCol));
+        particleCharges.push_back(columnViews_.get<float>(particleCol));
     }
 
-    const auto measureOfLocalityCol = inport_.getData()->getColumn(measureOfLocalityCol_.get());
+    const auto measureOfLocalityCol = input->getColumn(measureOfLocalityCol_.get());
 
     if (measureOfLocalityCol == nullptr) {
         throw Exception("Could not get diff column", IVW_CONTEXT);
     }
 
-    const auto measureOfLocalityData =
-        measureOfLocalityCol->getBuffer()
-            ->getRepresentation<BufferRAM>()
-            ->dispatch<std::vector<float>, dispatching::filter::Scalars>([](auto buf) {
-                auto& data = buf->getDataContainer();
-                std::vector<float> dst(data.size(), 0.0f);
-                std::transform(data.begin(), data.end(), dst.begin(),
-                               [&](auto v) { return static_cast<float>(v); });
-                return dst;
-            });
+    const auto measureOfLocalityData = columnViews_.get<float>(measureOfLocalityCol);
+
+    size_t convertedColumns = clusters.isConverted() + measureOfLocalityData.isConverted();
+    for (size_t i = 0; i < nrSubgroups; i++) {
+        convertedColumns += holeCharges[i].isConverted() + particleCharges[i].isConverted();
+    }
+    timer.count("bytes copied",
+                static_cast<double>(clusters.size() * convertedColumns * sizeof(float)));
+    timer.count("converted columns", static_cast<double>(convertedColumns));
 
     std::vector<int> clusterNr = {};
     std::vector<size_t> clusterSize = {};
@@ -302,10 +304,131 @@ void ClusterStatistics::process() {
                                  subgroupToClusterStatistics_particle[i].variance);
     }
 
-    outport_.setData(dataFrame);
-    diffOutport_.setData(diffDataFrame);
-    meanOutport_.setData(meanDataFrame);
-    meanMeasureOfLocalityOutport_.setData(measureOfLocalityDataFrame);
+    timer.count("rows", static_cast<double>(4 * clusterNrToIndex.size()));
+
+    // One sketch per cluster and column, filled in one pass over the members of each cluster
+    std::shared_ptr<DataFrame> quantileDataFrame;
+    std::shared_ptr<DataFrame> nodeQuantileDataFrame;
+    if (quantileSketches_.get()) {
+        std::vector<std::string> names;
+        std::vector<ColumnView<float>> columns;
+        for (size_t i = 0; i < nrSubgroups; i++) {
+            names.push_back("hole charge sg " + std::to_string(i + 1));
+            columns.push_back(holeCharges[i]);
+            names.push_back("particle charge sg " + std::to_string(i + 1));
+            columns.push_back(particleCharges[i]);
+        }
+        names.push_back("MeasureOfLocality");
+        columns.push_back(measureOfLocalityData);
+
+        const auto k = static_cast<size_t>(sketchSize_.get());
+        // sketches[column][cluster]
+        std::vector<std::vector<KllSketch>> sketches(
+            columns.size(), std::vector<KllSketch>(clusterNrToIndex.size(), KllSketch(k)));
+        size_t c = 0;
+        for (auto&& cluster : clusterNrToIndex) {
+            for (size_t col = 0; col < columns.size(); col++) {
+                for (auto&& ind : cluster.second) {
+                    sketches[col][c].add(columns[col][ind]);
+                }
+            }
+            c++;
+        }
+
+        quantileDataFrame =
+            std::make_shared<DataFrame>(static_cast<glm::u32>(clusterNrToIndex.size()));
+        quantileDataFrame->addColumn("Cluster", clusterNr);
+        quantileDataFrame->addColumn("Cluster size", clusterSize);
+        for (size_t col = 0; col < columns.size(); col++) {
+            addQuantileColumns(*quantileDataFrame, sketches[col], names[col]);
+        }
+
+        if (linkage) {
+            const auto firstCol = linkage->getColumn("Child 1");
+            const auto secondCol = linkage->getColumn("Child 2");
+            const auto distanceCol = linkage->getColumn("Distance");
+            if (firstCol == nullptr || secondCol == nullptr || distanceCol == nullptr) {
+                throw Exception("Could not get linkage columns (Child 1, Child 2, Distance)",
+                                IVW_CONTEXT);
+            }
+            const auto firstView = columnViews_.get<double>(firstCol);
+            const auto secondView = columnViews_.get<double>(secondCol);
+            const auto distanceView = columnViews_.get<double>(distanceCol);
+            const auto nrMerges = firstView.size();
+            std::vector<size_t> first(nrMerges);
+            std::vector<size_t> second(nrMerges);
+            for (size_t i = 0; i < nrMerges; i++) {
+                first[i] = static_cast<size_t>(firstView[i]);
+                second[i] = static_cast<size_t>(secondView[i]);
+            }
+
+            // The cluster ids are the leaves of the linkage, leaves without members stay empty
+            const auto nrLeaves = nrMerges + 1;
+            const auto nrNodes = nrLeaves + nrMerges;
+            for (auto&& cluster : clusterNrToIndex) {
+                if (cluster.first < 0 || static_cast<size_t>(cluster.first) >= nrLeaves) {
+                    throw Exception("Cluster " + std::to_string(cluster.first) +
+                                        " is not a leaf of the linkage",
+                                    IVW_CONTEXT);
+                }
+            }
+
+            nodeQuantileDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrNodes));
+            // One column at a time, so that only the node sketches of one column are kept
+            for (size_t col = 0; col < columns.size(); col++) {
+                std::vector<KllSketch> leaves(nrLeaves, KllSketch(k));
+                size_t leaf = 0;
+                for (auto&& cluster : clusterNrToIndex) {
+                    leaves[cluster.first] = std::move(sketches[col][leaf++]);
+                }
+                const auto nodes = KllSketch::mergeUp(std::move(leaves), first, second);
+
+                if (col == 0) {
+                    std::vector<int> node(nrNodes);
+                    std::vector<size_t> nodeSize(nrNodes);
+                    std::vector<double> height(nrNodes, 0.0);
+                    for (size_t n = 0; n < nrNodes; n++) {
+                        node[n] = static_cast<int>(n);
+                        nodeSize[n] = nodes[n].count();
+                        if (n >= nrLeaves) height[n] = distanceView[n - nrLeaves];
+                    }
+                    nodeQuantileDataFrame->addColumn("Node", std::move(node));
+                    nodeQuantileDataFrame->addColumn("Size", std::move(nodeSize));
+                    nodeQuantileDataFrame->addColumn("Height", std::move(height));
+                }
+                addQuantileColumns(*nodeQuantileDataFrame, nodes, names[col]);
+            }
+        }
+    }
+
+    const Outputs outputs{dataFrame, diffDataFrame, meanDataFrame, measureOfLocalityDataFrame,
+                          quantileDataFrame, nodeQuantileDataFrame};
+    results_.insert(key.value(), outputs);
+    setOutputs(outputs);
+}
+
+void ClusterStatistics::setOutputs(const Outputs& outputs) {
+    outport_.setData(outputs.minMax);
+    diffOutport_.setData(outputs.diff);
+    meanOutport_.setData(outputs.mean);
+    meanMeasureOfLocalityOutport_.setData(outputs.meanMeasureOfLocality);
+    quantileOutport_.setData(outputs.quantile);
+    nodeQuantileOutport_.setData(outputs.nodeQuantile);
+}
+
+void ClusterStatistics::addQuantileColumns(DataFrame& dataFrame,
+                                           const std::vector<KllSketch>& sketches,
+                                           const std::string& name) const {
+    const std::vector<double> quantiles{0.5, lowerQuantile_.get(), upperQuantile_.get()};
+    const std::vector<std::string> prefixes{"Median ", "Lower quantile ", "Upper quantile "};
+    std::vector<std::vector<float>> values(quantiles.size(), std::vector<float>(sketches.size()));
+    for (size_t row = 0; row < sketches.size(); row++) {
+        const auto q = sketches[row].quantiles(quantiles);
+        for (size_t i = 0; i < quantiles.size(); i++) values[i][row] = q[i];
+    }
+    for (size_t i = 0; i < quantiles.size(); i++) {
+        dataFrame.addColumn(prefixes[i] + name, std::move(values[i]));
+    }
 }
 
 }  // namespace inviwo
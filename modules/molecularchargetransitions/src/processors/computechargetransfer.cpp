@@ -28,6 +28,10 @@
  *********************************************************************************/
 
 #include <inviwo/molecularchargetransitions/processors/computechargetransfer.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
 
 namespace inviwo {
 
@@ -45,44 +49,28 @@ ComputeChargeTransfer::ComputeChargeTransfer()
     : Processor()
     , holeCharges_("holeCharges")
     , particleCharges_("particleCharges")
+    , chargeTransferMatrix_("chargeTransferMatrix")
     , chargeDifference_("chargeDifference")
     , chargeTransfer_("chargeTransfer")
     , holeAndParticleCharges_("holeAndParticleCharges") {
 
     addPort(holeCharges_);
     addPort(particleCharges_);
+    addPort(chargeTransferMatrix_);
     addPort(chargeDifference_);
     addPort(chargeTransfer_);
     addPort(holeAndParticleCharges_);
+
+    chargeTransferMatrix_.setOptional(true);
 }
 
 void ComputeChargeTransfer::process() {
+    HotPathProfiler::ScopedTimer timer("ComputeChargeTransfer::process");
 
-    const auto holeCharges =
-        holeCharges_.getData()
-            ->getColumn("charge_sg")
-            ->getBuffer()
-            ->getRepresentation<BufferRAM>()
-            ->dispatch<std::vector<float>, dispatching::filter::Scalars>([](auto buf) {
-                auto& data = buf->getDataContainer();
-                std::vector<float> dst(data.size(), 0.0f);
-                std::transform(data.begin(), data.end(), dst.begin(),
-                               [&](auto v) { return static_cast<float>(v); });
-                return dst;
-            });
-
-    const auto particleCharges =
-        particleCharges_.getData()
-            ->getColumn("charge_sg")
-            ->getBuffer()
-            ->getRepresentation<BufferRAM>()
-            ->dispatch<std::vector<float>, dispatching::filter::Scalars>([](auto buf) {
-                auto& data = buf->getDataContainer();
-                std::vector<float> dst(data.size(), 0.0f);
-                std::transform(data.begin(), data.end(), dst.begin(),
-                               [&](auto v) { return static_cast<float>(v); });
-                return dst;
-            });
+    const auto holeData = holeCharges_.getData();
+    const auto particleData = particleCharges_.getData();
+    const auto holeCharges = columnViews_.get<float>(holeData->getColumn("charge_sg"));
+    const auto particleCharges = columnViews_.get<float>(particleData->getColumn("charge_sg"));
 
     if (holeCharges.size() != particleCharges.size()) {
         throw Exception("Unexpected dimension missmatch", IVW_CONTEXT);
@@ -90,42 +78,175 @@ void ComputeChargeTransfer::process() {
     if (holeCharges.size() == 0) {
         throw Exception("No input charges", IVW_CONTEXT);
     }
-
-    const auto [chargeTransfer, chargeDifference] =
-        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(holeCharges,
-                                                                                 particleCharges);
+    // Converts the columns here, the views are then shared with the generators
+    holeCharges.data();
+    particleCharges.data();
 
     const auto n = holeCharges.size();
+    InputHash key;
+    key.add(holeData->getColumn("charge_sg").get()).add(particleData->getColumn("charge_sg").get());
+    for (const auto& name : {"centroid_x_sg", "centroid_y_sg", "centroid_z_sg"}) {
+        key.add(holeData->getColumn(name).get()).add(particleData->getColumn(name).get());
+    }
+    std::vector<std::shared_ptr<const Column>> matrixColumns;
+    if (chargeTransferMatrix_.hasData()) {
+        const auto matrix = chargeTransferMatrix_.getData();
+        for (size_t i = 0; i < n; i++) {
+            const auto column = matrix->getColumn(std::to_string(i + 1));
+            if (column == nullptr || column->getSize() != n) {
+                throw Exception("Charge transfer matrix does not match the number of subgroups",
+                                IVW_CONTEXT);
+            }
+            matrixColumns.push_back(column);
+            key.add(column.get());
+        }
+    }
 
-    auto chargeDiffDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
-    auto& col1 = chargeDiffDataFrame->addColumn<float>("Charge difference", n)
-                     ->getTypedBuffer()
-                     ->getEditableRAMRepresentation()
-                     ->getDataContainer();
-
-    auto chargeTransferDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
-    for (auto i = 0; i < n; i++) {
-        col1[i] = chargeDifference[i];
-        auto& col = chargeTransferDataFrame->addColumn<float>(toString(i + 1), n)
-                        ->getTypedBuffer()
-                        ->getEditableRAMRepresentation()
-                        ->getDataContainer();
-        // This charge transfer matrix is the on the form "vector of columns"
-        col = chargeTransfer[i];
+    if (const auto cached = results_.find(key.value())) {
+        timer.count("cache hits", 1.0);
+        setGenerators(*cached);
+        return;
     }
 
+    // An input matrix has to be in the same units as charge_sg, each column sums up to the hole
+    // charge of its subgroup (e.g. normalized as in VoxelOverlapChargeTransfer)
+    for (size_t i = 0; i < matrixColumns.size(); i++) {
+        const ColumnView<float> column(matrixColumns[i]);
+        const auto sum = std::accumulate(column.begin(), column.end(), 0.0);
+        if (std::abs(sum - holeCharges[i]) > 1e-3) {
+            throw Exception("Column " + std::to_string(i + 1) + " of the charge transfer matrix " +
+                                "sums up to " + std::to_string(sum) + ", not to the hole charge " +
+                                std::to_string(holeCharges[i]) + " of the subgroup",
+                            IVW_CONTEXT);
+        }
+    }
+
+    // The heuristic needs a donor and an acceptor subgroup. Checked here so that the processor
+    // throws, instead of every read of the lazy chargeTransfer outport.
+    if (matrixColumns.empty()) {
+        bool hasDonor = false;
+        bool hasAcceptor = false;
+        for (size_t i = 0; i < n; i++) {
+            const auto donor = particleCharges[i] - holeCharges[i] < 0.0f;
+            hasDonor = hasDonor || donor;
+            hasAcceptor = hasAcceptor || !donor;
+        }
+        if (!hasDonor || !hasAcceptor) {
+            throw Exception("No acceptors and/or donors (not valid).", IVW_CONTEXT);
+        }
+    }
+
+    const size_t convertedColumns = holeCharges.isConverted() + particleCharges.isConverted();
+    timer.count("bytes copied", static_cast<double>(convertedColumns * n * sizeof(float)));
+    timer.count("converted columns", static_cast<double>(convertedColumns));
+
+    Generators generators;
+    generators.chargeDifference = [holeCharges, particleCharges, holeData, particleData, n]() {
+        HotPathProfiler::ScopedTimer timer("ComputeChargeTransfer::chargeDifference");
+        std::vector<float> chargeDifference(n);
+        for (size_t i = 0; i < n; i++) {
+            chargeDifference[i] = particleCharges[i] - holeCharges[i];
+        }
+        auto chargeDiffDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
+        chargeDiffDataFrame->addColumn("Charge difference", std::move(chargeDifference));
+
+        // Distance between the hole and particle centroids of each subgroup, if the spatial
+        // moments are available (see SumChargeInSegmentedRegions)
+        std::vector<float> centroidDistance(n, 0.0f);
+        bool hasCentroids = true;
+        for (const auto& name : {"centroid_x_sg", "centroid_y_sg", "centroid_z_sg"}) {
+            const auto holeColumn = holeData->getColumn(name);
+            const auto particleColumn = particleData->getColumn(name);
+            if (holeColumn == nullptr || particleColumn == nullptr) {
+                hasCentroids = false;
+                break;
+            }
+            const ColumnView<float> hole(holeColumn);
+            const ColumnView<float> particle(particleColumn);
+            for (size_t i = 0; i < n; i++) {
+                const auto d = particle[i] - hole[i];
+                centroidDistance[i] += d * d;
+            }
+        }
+        if (hasCentroids) {
+            std::transform(centroidDistance.begin(), centroidDistance.end(),
+                           centroidDistance.begin(), [](float d2) { return std::sqrt(d2); });
+            chargeDiffDataFrame->addColumn("Centroid distance", std::move(centroidDistance));
+        }
+
+        timer.count("rows", static_cast<double>(n));
+        return std::shared_ptr<const DataFrame>(chargeDiffDataFrame);
+    };
+
+    generators.chargeTransfer = [holeCharges, particleCharges, matrixColumns, n]() {
+        HotPathProfiler::ScopedTimer timer("ComputeChargeTransfer::chargeTransfer");
+        auto chargeTransferDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
+        size_t copiedColumns = 0;
+        if (!matrixColumns.empty()) {
+            // Float columns are shared with the input, others are converted. The const cast is
+            // only for DataFrame::addColumn: port data is not modified once it is set, the output
+            // is a const DataFrame as well, and the generator keeps the columns alive.
+            for (size_t i = 0; i < n; i++) {
+                const ColumnView<float> values(matrixColumns[i]);
+                if (!values.isConverted()) {
+                    chargeTransferDataFrame->addColumn(
+                        std::const_pointer_cast<Column>(matrixColumns[i]));
+                } else {
+                    chargeTransferDataFrame->addColumn(
+                        std::to_string(i + 1), std::vector<float>(values.begin(), values.end()));
+                    ++copiedColumns;
+                }
+            }
+        } else {
+            // This charge transfer matrix is the on the form "vector of columns"
+            auto chargeTransfer =
+                ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+                    {holeCharges.begin(), holeCharges.end()},
+                    {particleCharges.begin(), particleCharges.end()})
+                    .first;
+            for (size_t i = 0; i < n; i++) {
+                chargeTransferDataFrame->addColumn(std::to_string(i + 1),
+                                                   std::move(chargeTransfer[i]));
+            }
+            copiedColumns = 2;
+        }
+
+        timer.count("rows", static_cast<double>(n));
+        timer.count("bytes copied", static_cast<double>(copiedColumns * n * sizeof(float)));
+        return std::shared_ptr<const DataFrame>(chargeTransferDataFrame);
+    };
+
     // Concatenate hole and particle charges
     // [ hole charge subgroup 1, ..., hole charge subgroup N,
     //   particle charge subgroup 1, ..., particle charge subgroup N ]
-    std::vector<float> holeAndParticleCharges = holeCharges;
-    holeAndParticleCharges.insert(holeAndParticleCharges.end(), particleCharges.begin(),
-                                  particleCharges.end());
-    auto holeAndParticleChargesDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
-    holeAndParticleChargesDataFrame->addColumn("charges", holeAndParticleCharges);
-
-    chargeDifference_.setData(chargeDiffDataFrame);
-    chargeTransfer_.setData(chargeTransferDataFrame);
-    holeAndParticleCharges_.setData(holeAndParticleChargesDataFrame);
+    generators.holeAndParticleCharges = [holeCharges, particleCharges, n]() {
+        HotPathProfiler::ScopedTimer timer("ComputeChargeTransfer::holeAndParticleCharges");
+        std::vector<float> holeAndParticleCharges(2 * n);
+        std::copy(holeCharges.begin(), holeCharges.end(), holeAndParticleCharges.begin());
+        std::copy(particleCharges.begin(), particleCharges.end(),
+                  holeAndParticleCharges.begin() + n);
+        auto holeAndParticleChargesDataFrame =
+            std::make_shared<DataFrame>(static_cast<glm::u32>(2 * n));
+        holeAndParticleChargesDataFrame->addColumn("charges", std::move(holeAndParticleCharges));
+
+        timer.count("rows", static_cast<double>(2 * n));
+        timer.count("bytes copied", static_cast<double>(2 * n * sizeof(float)));
+        return std::shared_ptr<const DataFrame>(holeAndParticleChargesDataFrame);
+    };
+
+    // Memoized so that a cached result is only computed once, even if it is set again later
+    using Port = LazyDataOutport<DataFrame>;
+    generators = {Port::memoize(generators.chargeDifference),
+                  Port::memoize(generators.chargeTransfer),
+                  Port::memoize(generators.holeAndParticleCharges)};
+    results_.insert(key.value(), generators);
+    setGenerators(generators);
+}
+
+void ComputeChargeTransfer::setGenerators(const Generators& generators) {
+    chargeDifference_.setGenerator(generators.chargeDifference);
+    chargeTransfer_.setGenerator(generators.chargeTransfer);
+    holeAndParticleCharges_.setGenerator(generators.holeAndParticleCharges);
 }
 
 void ComputeChargeTransfer::doIfNotReady() {
@@ -0,0 +1,147 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/computeensemblechargetransfer.h>
+
+#include <cmath>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo ComputeEnsembleChargeTransfer::processorInfo_{
+    "org.inviwo.ComputeEnsembleChargeTransfer",  // Class identifier
+    "Compute Ensemble Charge Transfer",           // Display name
+    "Undefined",                                  // Category
+    CodeState::Experimental,                      // Code state
+    Tags::None,                                   // Tags
+};
+const ProcessorInfo& ComputeEnsembleChargeTransfer::getProcessorInfo() const {
+    return processorInfo_;
+}
+
+ComputeEnsembleChargeTransfer::ComputeEnsembleChargeTransfer()
+    : Processor()
+    , inport_("inport")
+    , subgroupPositions_("subgroupPositions")
+    , outport_("outport")
+    , mode_("mode", "Mode",
+            {{"proportional", "Proportional", Mode::Proportional},
+             {"optimalTransport", "Optimal transport", Mode::OptimalTransport}},
+            1)
+    , epsilon_("epsilon", "Regularization", 0.01f, 0.001f, 1.0f, 0.001f) {
+
+    subgroupPositions_.setOptional(true);
+    addPort(inport_);
+    addPort(subgroupPositions_);
+    addPort(outport_);
+    addProperty(mode_);
+    addProperty(epsilon_);
+
+    epsilon_.visibilityDependsOn(mode_,
+                                 [](const auto& p) { return p.get() == Mode::OptimalTransport; });
+}
+
+void ComputeEnsembleChargeTransfer::process() {
+    HotPathProfiler::ScopedTimer timer("ComputeEnsembleChargeTransfer::process");
+    const auto input = inport_.getData();
+    const auto nrMembers = input->getNumberOfRows();
+
+    std::vector<ColumnView<float>> holeCharges;
+    std::vector<ColumnView<float>> particleCharges;
+    for (size_t i = 1;; i++) {
+        const auto holeCol = input->getColumn("Hole sg" + std::to_string(i));
+        const auto particleCol = input->getColumn("Particle sg" + std::to_string(i));
+        if (holeCol == nullptr || particleCol == nullptr) break;
+        holeCharges.push_back(columnViews_.get<float>(holeCol));
+        particleCharges.push_back(columnViews_.get<float>(particleCol));
+    }
+    if (holeCharges.empty()) {
+        throw Exception("Could not get hole and particle columns (Hole sg1, Particle sg1, ...)",
+                        IVW_CONTEXT);
+    }
+    const auto n = holeCharges.size();
+    // Converts the columns here, before the views are shared between threads
+    std::vector<const float*> hole;
+    std::vector<const float*> particle;
+    for (size_t i = 0; i < n; i++) {
+        hole.push_back(holeCharges[i].data());
+        particle.push_back(particleCharges[i].data());
+    }
+
+    std::vector<std::vector<float>> transfer;
+    if (mode_.get() == Mode::OptimalTransport) {
+        if (!subgroupPositions_.hasData()) {
+            throw Exception("Optimal transport needs the subgroup positions", IVW_CONTEXT);
+        }
+        const auto positionData = subgroupPositions_.getData();
+        const auto x = positionData->getColumn("x");
+        const auto y = positionData->getColumn("y");
+        const auto z = positionData->getColumn("z");
+        if (x == nullptr || y == nullptr || z == nullptr) {
+            throw Exception("Subgroup positions need the columns x, y and z", IVW_CONTEXT);
+        }
+        if (x->getSize() != n) {
+            throw Exception("Subgroup positions do not match the number of subgroups (" +
+                                std::to_string(n) + ")",
+                            IVW_CONTEXT);
+        }
+        const auto xs = columnViews_.get<double>(x);
+        const auto ys = columnViews_.get<double>(y);
+        const auto zs = columnViews_.get<double>(z);
+        std::vector<double> cost(n * n);
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = 0; j < n; j++) {
+                const dvec3 d{xs[i] - xs[j], ys[i] - ys[j], zs[i] - zs[j]};
+                cost[i * n + j] = std::sqrt(glm::dot(d, d));
+            }
+        }
+
+        ChargeTransferMatrix::TransportSettings settings;
+        settings.epsilon = epsilon_.get();
+        transfer = ChargeTransferMatrix::computeEnsembleOptimalTransport(hole, particle,
+                                                                         nrMembers, cost, settings);
+    } else {
+        transfer = ChargeTransferMatrix::computeEnsembleChargeTransfer(hole, particle, nrMembers);
+    }
+
+    timer.count("rows", static_cast<double>(nrMembers));
+
+    // "Charge transfer ij" is row i of the charge transfer matrix, the transfer from j to i
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrMembers));
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            dataFrame->addColumn("Charge transfer " + std::to_string(i + 1) + std::to_string(j + 1),
+                                 std::move(transfer[j * n + i]));
+        }
+    }
+
+    outport_.setData(dataFrame);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,128 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/computelocalitydescriptors.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo ComputeLocalityDescriptors::processorInfo_{
+    "org.inviwo.ComputeLocalityDescriptors",  // Class identifier
+    "Compute Locality Descriptors",           // Display name
+    "Undefined",                              // Category
+    CodeState::Experimental,                  // Code state
+    Tags::None,                               // Tags
+};
+const ProcessorInfo& ComputeLocalityDescriptors::getProcessorInfo() const {
+    return processorInfo_;
+}
+
+ComputeLocalityDescriptors::ComputeLocalityDescriptors()
+    : Processor()
+    , inport_("inport")
+    , subgroupPositions_("subgroupPositions")
+    , outport_("outport") {
+
+    subgroupPositions_.setOptional(true);
+    addPort(inport_);
+    addPort(subgroupPositions_);
+    addPort(outport_);
+}
+
+void ComputeLocalityDescriptors::process() {
+    HotPathProfiler::ScopedTimer timer("ComputeLocalityDescriptors::process");
+    const auto input = inport_.getData();
+    const auto nrMembers = input->getNumberOfRows();
+
+    std::vector<ColumnView<float>> holeCharges;
+    std::vector<ColumnView<float>> particleCharges;
+    for (size_t i = 1;; i++) {
+        const auto holeCol = input->getColumn("Hole sg" + std::to_string(i));
+        const auto particleCol = input->getColumn("Particle sg" + std::to_string(i));
+        if (holeCol == nullptr || particleCol == nullptr) break;
+        holeCharges.push_back(columnViews_.get<float>(holeCol));
+        particleCharges.push_back(columnViews_.get<float>(particleCol));
+    }
+    if (holeCharges.empty()) {
+        throw Exception("Could not get hole and particle columns (Hole sg1, Particle sg1, ...)",
+                        IVW_CONTEXT);
+    }
+
+    std::vector<const float*> hole;
+    std::vector<const float*> particle;
+    size_t convertedColumns = 0;
+    for (size_t i = 0; i < holeCharges.size(); i++) {
+        hole.push_back(holeCharges[i].data());
+        particle.push_back(particleCharges[i].data());
+        convertedColumns += holeCharges[i].isConverted() + particleCharges[i].isConverted();
+    }
+
+    std::vector<dvec3> positions;
+    if (subgroupPositions_.hasData()) {
+        const auto positionData = subgroupPositions_.getData();
+        const auto x = positionData->getColumn("x");
+        const auto y = positionData->getColumn("y");
+        const auto z = positionData->getColumn("z");
+        if (x == nullptr || y == nullptr || z == nullptr) {
+            throw Exception("Subgroup positions need the columns x, y and z", IVW_CONTEXT);
+        }
+        if (x->getSize() != hole.size()) {
+            throw Exception("Subgroup positions do not match the number of subgroups (" +
+                                std::to_string(hole.size()) + ")",
+                            IVW_CONTEXT);
+        }
+        const auto xs = columnViews_.get<double>(x);
+        const auto ys = columnViews_.get<double>(y);
+        const auto zs = columnViews_.get<double>(z);
+        for (size_t i = 0; i < xs.size(); i++) {
+            positions.emplace_back(xs[i], ys[i], zs[i]);
+        }
+    }
+
+    auto descriptors = LocalityDescriptors::compute(hole, particle, nrMembers, positions);
+
+    timer.count("bytes copied",
+                static_cast<double>(convertedColumns * nrMembers * sizeof(float)));
+    timer.count("converted columns", static_cast<double>(convertedColumns));
+    timer.count("rows", static_cast<double>(nrMembers));
+
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrMembers));
+    dataFrame->addColumn("Measure of locality", std::move(descriptors.measureOfLocality));
+    dataFrame->addColumn("Transferred charge", std::move(descriptors.transferredCharge));
+    dataFrame->addColumn("Donors", std::move(descriptors.donors));
+    dataFrame->addColumn("Acceptors", std::move(descriptors.acceptors));
+    if (!positions.empty()) {
+        dataFrame->addColumn("CT distance", std::move(descriptors.ctDistance));
+        dataFrame->addColumn("CT rms distance", std::move(descriptors.ctRmsDistance));
+    }
+
+    outport_.setData(dataFrame);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,154 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/dendrogramcut.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo DendrogramCut::processorInfo_{
+    "org.inviwo.DendrogramCut",  // Class identifier
+    "Dendrogram Cut",            // Display name
+    "Undefined",                 // Category
+    CodeState::Experimental,     // Code state
+    Tags::None,                  // Tags
+};
+const ProcessorInfo& DendrogramCut::getProcessorInfo() const { return processorInfo_; }
+
+DendrogramCut::DendrogramCut()
+    : Processor()
+    , linkage_("linkage")
+    , members_("members")
+    , outport_("outport")
+    , useThreshold_("useThreshold", "Cut at threshold", true)
+    , threshold_("threshold", "Threshold", 1.0f, 0.0f, 10.0f, 0.05f)
+    , nrClusters_("nrClusters", "Nr of clusters", 5, 1, 100, 1) {
+
+    addPort(linkage_);
+    members_.setOptional(true);
+    addPort(members_);
+    addPort(outport_);
+    addProperty(useThreshold_);
+    addProperty(threshold_);
+    addProperty(nrClusters_);
+
+    threshold_.visibilityDependsOn(useThreshold_, [](const auto& p) { return p.get(); });
+    nrClusters_.visibilityDependsOn(useThreshold_, [](const auto& p) { return !p.get(); });
+}
+
+void DendrogramCut::process() {
+    HotPathProfiler::ScopedTimer timer("DendrogramCut::process");
+
+    // The index is only rebuilt for a new linkage, not when the cut changes
+    if (linkage_.isChanged() || !index_) {
+        const auto linkage = linkage_.getData();
+        const auto firstCol = linkage->getColumn("Child 1");
+        const auto secondCol = linkage->getColumn("Child 2");
+        const auto distanceCol = linkage->getColumn("Distance");
+        if (firstCol == nullptr || secondCol == nullptr || distanceCol == nullptr) {
+            index_.reset();
+            throw Exception("Could not get linkage columns (Child 1, Child 2, Distance)",
+                            IVW_CONTEXT);
+        }
+        const auto firstView = columnViews_.get<double>(firstCol);
+        const auto secondView = columnViews_.get<double>(secondCol);
+        const auto distanceView = columnViews_.get<double>(distanceCol);
+        const auto nrMerges = firstView.size();
+
+        std::vector<size_t> first(nrMerges);
+        std::vector<size_t> second(nrMerges);
+        std::vector<double> heights(nrMerges);
+        for (size_t i = 0; i < nrMerges; i++) {
+            first[i] = static_cast<size_t>(firstView[i]);
+            second[i] = static_cast<size_t>(secondView[i]);
+            heights[i] = distanceView[i];
+        }
+        // No index of an older linkage is kept if the new one is invalid
+        index_.reset();
+        index_ = std::make_unique<DendrogramIndex>(first, second, heights);
+
+        threshold_.setMaxValue(
+            static_cast<float>(index_->height(index_->root()) * 1.1 + 1e-6));
+        nrClusters_.setMaxValue(index_->nrMembers());
+    }
+
+    const auto level = useThreshold_.get() ? index_->level(threshold_.get())
+                                           : index_->levelOfClusters(nrClusters_.get());
+    auto labels = index_->labels(level);
+
+    const auto nrLeaves = index_->nrMembers();
+    std::vector<int> leafPosition(nrLeaves);
+    for (size_t m = 0; m < nrLeaves; m++) {
+        leafPosition[m] = static_cast<int>(index_->leafPosition(m));
+    }
+    std::vector<int> node(nrLeaves);
+    for (const auto cluster : index_->clusters(level)) {
+        const auto [begin, end] = index_->leafRange(cluster);
+        for (size_t p = begin; p < end; p++) {
+            node[index_->leafOrder()[p]] = static_cast<int>(cluster);
+        }
+    }
+
+    // Leaves are micro-clusters, map their clusters to the members
+    if (members_.hasData()) {
+        const auto microCol = members_.getData()->getColumn("Micro cluster");
+        if (microCol == nullptr) {
+            throw Exception("Could not get members column (Micro cluster)", IVW_CONTEXT);
+        }
+        const auto micro = columnViews_.get<int>(microCol);
+        std::vector<int> memberLabels(micro.size());
+        std::vector<int> memberLeafPosition(micro.size());
+        std::vector<int> memberNode(micro.size());
+        for (size_t m = 0; m < micro.size(); m++) {
+            const auto leaf = static_cast<size_t>(micro[m]);
+            if (leaf >= nrLeaves) {
+                throw Exception("Micro cluster of member " + std::to_string(m) +
+                                    " is not a leaf of the dendrogram",
+                                IVW_CONTEXT);
+            }
+            memberLabels[m] = labels[leaf];
+            memberLeafPosition[m] = leafPosition[leaf];
+            memberNode[m] = node[leaf];
+        }
+        labels = std::move(memberLabels);
+        leafPosition = std::move(memberLeafPosition);
+        node = std::move(memberNode);
+    }
+    const auto nrMembers = labels.size();
+
+    timer.count("rows", static_cast<double>(nrMembers));
+
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrMembers));
+    dataFrame->addColumn("Cluster", std::move(labels));
+    dataFrame->addColumn("Leaf position", std::move(leafPosition));
+    dataFrame->addColumn("Node", std::move(node));
+    outport_.setData(dataFrame);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,153 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/processors/densitywatershedsegmentation.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo DensityWatershedSegmentation::processorInfo_{
+    "org.inviwo.DensityWatershedSegmentation",  // Class identifier
+    "Density Watershed Segmentation",           // Display name
+    "Undefined",                                // Category
+    CodeState::Experimental,                    // Code state
+    Tags::None,                                 // Tags
+};
+const ProcessorInfo& DensityWatershedSegmentation::getProcessorInfo() const {
+    return processorInfo_;
+}
+
+DensityWatershedSegmentation::DensityWatershedSegmentation()
+    : Processor()
+    , density_("density")
+    , atoms_("atoms")
+    , segmentation_("segmentation")
+    , basins_("basins")
+    , assignToAtoms_("assignToAtoms", "Assign basins to atoms", true) {
+
+    atoms_.setOptional(true);
+    addPort(density_);
+    addPort(atoms_);
+    addPort(segmentation_);
+    addPort(basins_);
+    addProperty(assignToAtoms_);
+}
+
+void DensityWatershedSegmentation::process() {
+    HotPathProfiler::ScopedTimer timer("DensityWatershedSegmentation::process");
+
+    const auto volume = density_.getData();
+    const auto dims = volume->getDimensions();
+    const dmat4 indexToWorld{volume->getCoordinateTransformer().getIndexToWorldMatrix()};
+    const dmat3 basis{indexToWorld};
+    const dvec3 offset{indexToWorld[3]};
+
+    DensityWatershed::Basins basins;
+    std::vector<double> maximumValues;
+    volume->getRepresentation<VolumeRAM>()->dispatch<void, dispatching::filter::FloatScalars>(
+        [&](auto vr) {
+            using DensityValueType = util::PrecisionValueType<decltype(vr)>;
+            const DensityValueType* density = vr->getDataTyped();
+            basins = DensityWatershed::segment(density, dims, basis);
+            for (auto v : basins.maxima) {
+                maximumValues.push_back(static_cast<double>(density[v]));
+            }
+        });
+
+    std::vector<uint16_t> basinAtoms;
+    size_t nrLabels = basins.maxima.size();
+    if (assignToAtoms_) {
+        if (!atoms_.hasData()) {
+            throw Exception("Assigning basins to atoms requires the atoms", IVW_CONTEXT);
+        }
+        const auto atoms = atoms_.getData();
+        const auto xCol = atoms->getColumn("x");
+        const auto yCol = atoms->getColumn("y");
+        const auto zCol = atoms->getColumn("z");
+        if (xCol == nullptr || yCol == nullptr || zCol == nullptr) {
+            throw Exception("Could not get atom position columns (x, y, z)", IVW_CONTEXT);
+        }
+        const auto x = columnViews_.get<double>(xCol);
+        const auto y = columnViews_.get<double>(yCol);
+        const auto z = columnViews_.get<double>(zCol);
+        std::vector<dvec3> positions(x.size());
+        for (size_t i = 0; i < positions.size(); i++) {
+            positions[i] = dvec3(x[i], y[i], z[i]);
+        }
+        basinAtoms = DensityWatershed::nearestAtoms(basins, dims, basis, offset, positions);
+        nrLabels = positions.size();
+    }
+    const auto labels = DensityWatershed::labels(basins, basinAtoms);
+
+    auto volumeRAM = std::make_shared<VolumeRAMPrecision<uint16_t>>(dims);
+    std::copy(labels.begin(), labels.end(), volumeRAM->getDataTyped());
+    auto segmentation = std::make_shared<Volume>(volumeRAM);
+    segmentation->setModelMatrix(volume->getModelMatrix());
+    segmentation->setWorldMatrix(volume->getWorldMatrix());
+    const auto lastLabel = static_cast<double>(nrLabels > 0 ? nrLabels - 1 : 0);
+    segmentation->dataMap.dataRange = dvec2(0.0, lastLabel);
+    segmentation->dataMap.valueRange = dvec2(0.0, lastLabel);
+
+    // Basin table
+    const auto nrBasins = basins.maxima.size();
+    std::vector<float> px(nrBasins), py(nrBasins), pz(nrBasins), maximum(nrBasins);
+    std::vector<int> nrVoxels(nrBasins, 0);
+    for (auto basin : basins.labels) {
+        nrVoxels[basin]++;
+    }
+    const size_t sx = dims.x;
+    const size_t sxy = dims.x * dims.y;
+    for (size_t i = 0; i < nrBasins; i++) {
+        const auto v = basins.maxima[i];
+        const auto p = basis * dvec3(v % sx, (v % sxy) / sx, v / sxy) + offset;
+        px[i] = static_cast<float>(p.x);
+        py[i] = static_cast<float>(p.y);
+        pz[i] = static_cast<float>(p.z);
+        maximum[i] = static_cast<float>(maximumValues[i]);
+    }
+    auto basinTable = std::make_shared<DataFrame>(static_cast<glm::u32>(nrBasins));
+    basinTable->addColumn("x", px);
+    basinTable->addColumn("y", py);
+    basinTable->addColumn("z", pz);
+    basinTable->addColumn("Maximum", maximum);
+    basinTable->addColumn("Voxels", nrVoxels);
+    if (!basinAtoms.empty()) {
+        basinTable->addColumn("Atom", std::vector<int>(basinAtoms.begin(), basinAtoms.end()));
+    }
+
+    timer.count("voxels", static_cast<double>(labels.size()));
+    timer.count("bytes copied", static_cast<double>(labels.size() * sizeof(uint16_t)));
+    timer.count("rows", static_cast<double>(nrBasins));
+    segmentation_.setData(segmentation);
+    basins_.setData(basinTable);
+}
+
+}  // namespace inviwo
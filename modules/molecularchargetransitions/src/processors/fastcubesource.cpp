@@ -0,0 +1,110 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/processors/fastcubesource.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/filesystem.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo FastCubeSource::processorInfo_{
+    "org.inviwo.FastCubeSource",  // Class identifier
+    "Fast Cube Source",           // Display name
+    "Undefined",                  // Category
+    CodeState::Experimental,      // Code state
+    Tags::None,                   // Tags
+};
+const ProcessorInfo& FastCubeSource::getProcessorInfo() const { return processorInfo_; }
+
+FastCubeSource::FastCubeSource()
+    : Processor()
+    , volume_("volume")
+    , atoms_("atoms")
+    , cube_("cube", "Cube file")
+    , useCache_("useCache", "Use binary cache", true) {
+
+    addPort(volume_);
+    addPort(atoms_);
+    addProperty(cube_);
+    addProperty(useCache_);
+}
+
+void FastCubeSource::process() {
+    HotPathProfiler::ScopedTimer timer("FastCubeSource::process");
+
+    const auto path = cube_.get();
+    if (!filesystem::fileExists(path)) {
+        throw Exception("Could not find cube file " + path, IVW_CONTEXT);
+    }
+    auto cube = CubeFile::load(path, useCache_.get());
+    const auto nrVoxels = glm::compMul(cube.dims);
+
+    // The volume basis spans all voxels, with the cube origin at the center of the first voxel
+    mat3 basis;
+    vec3 offset{cube.origin};
+    for (size_t i = 0; i < 3; i++) {
+        basis[i] = vec3(cube.basis[i] * static_cast<double>(cube.dims[i]));
+        offset -= vec3(cube.basis[i] * 0.5);
+    }
+
+    const auto [min, max] = std::minmax_element(cube.values.get(), cube.values.get() + nrVoxels);
+    const dvec2 range(*min, *max);
+    auto volumeRAM = std::make_shared<VolumeRAMPrecision<float>>(cube.values.release(), cube.dims);
+    auto volume = std::make_shared<Volume>(volumeRAM);
+    volume->setBasis(basis);
+    volume->setOffset(offset);
+    volume->dataMap.dataRange = range;
+    volume->dataMap.valueRange = range;
+
+    const auto nrAtoms = cube.atoms.size();
+    std::vector<int> atomicNumber(nrAtoms);
+    std::vector<float> charge(nrAtoms), x(nrAtoms), y(nrAtoms), z(nrAtoms);
+    for (size_t i = 0; i < nrAtoms; i++) {
+        const auto& atom = cube.atoms[i];
+        atomicNumber[i] = atom.atomicNumber;
+        charge[i] = static_cast<float>(atom.charge);
+        x[i] = static_cast<float>(atom.position.x);
+        y[i] = static_cast<float>(atom.position.y);
+        z[i] = static_cast<float>(atom.position.z);
+    }
+    auto atoms = std::make_shared<DataFrame>(static_cast<glm::u32>(nrAtoms));
+    atoms->addColumn("Atomic number", atomicNumber);
+    atoms->addColumn("Charge", charge);
+    atoms->addColumn("x", x);
+    atoms->addColumn("y", y);
+    atoms->addColumn("z", z);
+
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("rows", static_cast<double>(nrAtoms));
+    volume_.setData(volume);
+    atoms_.setData(atoms);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,147 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/hotpathprofiling.h>
+#include <inviwo/core/util/filesystem.h>
+
+#include <chrono>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo HotPathProfiling::processorInfo_{
+    "org.inviwo.HotPathProfiling",  // Class identifier
+    "Hot Path Profiling",           // Display name
+    "Undefined",                    // Category
+    CodeState::Experimental,        // Code state
+    Tags::None,                     // Tags
+};
+const ProcessorInfo& HotPathProfiling::getProcessorInfo() const { return processorInfo_; }
+
+HotPathProfiling::HotPathProfiling()
+    : Processor()
+    , outport_("outport")
+    , enabled_("enabled", "Enabled", false)
+    , refresh_("refresh", "Refresh")
+    , clear_("clear", "Clear")
+    , maxEvents_("maxEvents", "Max events", HotPathProfiler::defaultMaxEvents, 1000,
+                 size_t{1} << 26, 1000)
+    , traceFile_("traceFile", "Trace file (json)")
+    , exportTrace_("exportTrace", "Export trace") {
+
+    addPort(outport_);
+    addProperty(enabled_);
+    addProperty(refresh_);
+    addProperty(clear_);
+    addProperty(maxEvents_);
+    addProperty(traceFile_);
+    addProperty(exportTrace_);
+
+    traceFile_.setAcceptMode(AcceptMode::SaveFile);
+
+    enabled_.onChange([this]() { HotPathProfiler::getInstance().setEnabled(enabled_.get()); });
+    clear_.onChange([]() { HotPathProfiler::getInstance().clear(); });
+    maxEvents_.onChange(
+        [this]() { HotPathProfiler::getInstance().setMaxEvents(maxEvents_.get()); });
+    exportTrace_.onChange([this]() {
+        if (traceFile_.get().empty()) {
+            LogWarn("No trace file provided");
+            return;
+        }
+        auto fileStream = filesystem::ofstream(traceFile_.get());
+        fileStream << HotPathProfiler::getInstance().toChromeTrace().dump();
+    });
+}
+
+HotPathProfiling::~HotPathProfiling() {
+    // The profiler is global, do not keep collecting without a processor to show or clear it
+    if (enabled_.get()) HotPathProfiler::getInstance().setEnabled(false);
+}
+
+void HotPathProfiling::process() {
+    using ms = std::chrono::duration<double, std::milli>;
+    using s = std::chrono::duration<double>;
+
+    auto& profiler = HotPathProfiler::getInstance();
+    profiler.setEnabled(enabled_.get());
+    profiler.setMaxEvents(maxEvents_.get());
+    if (const auto dropped = profiler.getDroppedEvents(); dropped > 0) {
+        LogWarn(dropped << " events dropped, more than " << maxEvents_.get() << " collected");
+    }
+    const auto summaries = profiler.summarize();
+
+    // All counters of all scopes, in order of first appearance
+    std::vector<std::string> counterNames;
+    for (const auto& summary : summaries) {
+        for (const auto& counter : summary.counters) {
+            if (std::find(counterNames.begin(), counterNames.end(), counter.first) ==
+                counterNames.end()) {
+                counterNames.push_back(counter.first);
+            }
+        }
+    }
+
+    const auto n = summaries.size();
+    std::vector<std::string> scopes;
+    std::vector<uint32_t> calls;
+    std::vector<float> totalTime;
+    std::vector<float> meanTime;
+    std::vector<std::vector<float>> counters(counterNames.size(), std::vector<float>(n, 0.0f));
+    std::vector<std::vector<float>> counterRates(counterNames.size(),
+                                                 std::vector<float>(n, 0.0f));
+    for (size_t i = 0; i < n; i++) {
+        const auto& summary = summaries[i];
+        scopes.push_back(summary.name);
+        calls.push_back(static_cast<uint32_t>(summary.calls));
+        totalTime.push_back(static_cast<float>(ms(summary.total).count()));
+        meanTime.push_back(static_cast<float>(ms(summary.total).count() / summary.calls));
+
+        const auto seconds = s(summary.total).count();
+        for (const auto& [name, value] : summary.counters) {
+            const auto c = static_cast<size_t>(
+                std::find(counterNames.begin(), counterNames.end(), name) - counterNames.begin());
+            counters[c][i] = static_cast<float>(value);
+            counterRates[c][i] = seconds > 0.0 ? static_cast<float>(value / seconds) : 0.0f;
+        }
+    }
+
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
+    dataFrame->addCategoricalColumn("Scope", scopes);
+    dataFrame->addColumn("Calls", calls);
+    dataFrame->addColumn("Total [ms]", totalTime);
+    dataFrame->addColumn("Mean [ms]", meanTime);
+    for (size_t c = 0; c < counterNames.size(); c++) {
+        dataFrame->addColumn(counterNames[c], counters[c]);
+        dataFrame->addColumn(counterNames[c] + "/s", counterRates[c]);
+    }
+
+    outport_.setData(dataFrame);
+}
+
+}  // namespace inviwo
@@ -53,12 +53,13 @@ MeasureOfLocality::MeasureOfLocality()
 }
 
 void MeasureOfLocality::process() {
+    HotPathProfiler::ScopedTimer timer("MeasureOfLocality::process");
     auto iCol = inport_.getData()->getIndexColumn();
     auto& indexCol = iCol->getTypedBuffer()->getRAMRepresentation()->getDataContainer();
 
     std::vector<float> traces(indexCol.size(), 0.0f);
 
-    std::vector<std::vector<float>> diagonalElements = {};
+    size_t convertedColumns = 0;
     const auto nrSubgroups = nrSubgroups_.get();
     for (size_t i = 0; i < nrSubgroups; i++) {
         auto diagonalElementsMatrixColumnName =
@@ -72,22 +73,19 @@ void MeasureOfLocality::process() {
                 IVW_CONTEXT);
         }
 
-        diagonalElements.push_back(
-            diagonalElementsCol->getBuffer()
-                ->getRepresentation<BufferRAM>()
-                ->dispatch<std::vector<float>, dispatching::filter::Scalars>([](auto buf) {
-                    auto& data = buf->getDataContainer();
-                    std::vector<float> dst(data.size(), 0.0f);
-                    std::transform(data.begin(), data.end(), dst.begin(),
-                                   [&](auto v) { return static_cast<float>(v); });
-                    return dst;
-                }));
-
-        for (size_t j = 0; j < diagonalElements[i].size(); j++) {
-            traces[j] += diagonalElements[i][j];
+        const auto diagonalElements = columnViews_.get<float>(diagonalElementsCol);
+        convertedColumns += diagonalElements.isConverted();
+
+        for (size_t j = 0; j < diagonalElements.size(); j++) {
+            traces[j] += diagonalElements[j];
         }
     }
 
+    timer.count("bytes copied",
+                static_cast<double>(convertedColumns * traces.size() * sizeof(float)));
+    timer.count("converted columns", static_cast<double>(convertedColumns));
+    timer.count("rows", static_cast<double>(traces.size()));
+
     auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(traces.size()));
     dataFrame->addColumn("Measure of locality", traces);
 
@@ -0,0 +1,148 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/minibatchclustering.h>
+#include <numeric>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo MiniBatchClustering::processorInfo_{
+    "org.inviwo.MiniBatchClustering",  // Class identifier
+    "Mini Batch Clustering",           // Display name
+    "Undefined",                       // Category
+    CodeState::Experimental,           // Code state
+    Tags::None,                        // Tags
+};
+const ProcessorInfo& MiniBatchClustering::getProcessorInfo() const { return processorInfo_; }
+
+MiniBatchClustering::MiniBatchClustering()
+    : Processor()
+    , inport_("inport")
+    , outport_("outport")
+    , microClustersOutport_("microClusters")
+    , nrSubgroups_("nrSubgroups", "Nr of subgroups", 2, 1, 10, 1)
+    , nrMicroClusters_("nrMicroClusters", "Nr of micro-clusters", 256, 2, 10000, 1)
+    , batchSize_("batchSize", "Batch size", 4096, 64, 1 << 20, 64)
+    , nrBatches_("nrBatches", "Nr of batches", 200, 1, 10000, 1)
+    , seed_("seed", "Seed", 0, 0, 1000, 1) {
+
+    addPort(inport_);
+    addPort(outport_);
+    addPort(microClustersOutport_);
+    addProperty(nrSubgroups_);
+    addProperty(nrMicroClusters_);
+    addProperty(batchSize_);
+    addProperty(nrBatches_);
+    addProperty(seed_);
+}
+
+void MiniBatchClustering::process() {
+    HotPathProfiler::ScopedTimer timer("MiniBatchClustering::process");
+    const auto input = inport_.getData();
+
+    const auto nrSubgroups = nrSubgroups_.get();
+    MiniBatchKMeans::Settings settings;
+    settings.nrClusters = nrMicroClusters_.get();
+    settings.batchSize = batchSize_.get();
+    settings.nrBatches = nrBatches_.get();
+    settings.seed = static_cast<uint32_t>(seed_.get());
+
+    std::vector<std::string> names;
+    for (size_t i = 0; i < nrSubgroups; i++) {
+        names.push_back("Hole sg" + std::to_string(i + 1));
+        names.push_back("Particle sg" + std::to_string(i + 1));
+    }
+
+    InputHash key;
+    key.add(nrSubgroups)
+        .add(settings.nrClusters)
+        .add(settings.batchSize)
+        .add(settings.nrBatches)
+        .add(settings.seed);
+    for (const auto& name : names) {
+        key.add(input->getColumn(name).get());
+    }
+    if (const auto cached = results_.find(key.value())) {
+        timer.count("cache hits", 1.0);
+        setOutputs(*cached);
+        return;
+    }
+
+    std::vector<ColumnView<float>> charges = {};
+    for (size_t i = 0; i < nrSubgroups; i++) {
+        const auto holeCol = input->getColumn(names[2 * i]);
+        const auto particleCol = input->getColumn(names[2 * i + 1]);
+        if (holeCol == nullptr || particleCol == nullptr) {
+            throw Exception(
+                "Could not get hole or particle column, subgroup " + std::to_string(i + 1),
+                IVW_CONTEXT);
+        }
+        charges.push_back(columnViews_.get<float>(holeCol));
+        charges.push_back(columnViews_.get<float>(particleCol));
+    }
+    std::vector<const float*> features;
+    for (const auto& column : charges) {
+        features.push_back(column.data());
+    }
+    const auto nrMembers = charges.front().size();
+
+    const auto result = MiniBatchKMeans::compute(features, nrMembers, settings);
+
+    std::vector<int> microCluster(result.labels.begin(), result.labels.end());
+    auto members = std::make_shared<DataFrame>(static_cast<glm::u32>(nrMembers));
+    members->addColumn("Micro cluster", std::move(microCluster));
+
+    const auto nrClusters = result.nrClusters();
+    std::vector<int> ids(nrClusters);
+    std::iota(ids.begin(), ids.end(), 0);
+    auto microClusters = std::make_shared<DataFrame>(static_cast<glm::u32>(nrClusters));
+    microClusters->addColumn("Micro cluster", std::move(ids));
+    microClusters->addColumn("Size", result.sizes);
+    for (size_t f = 0; f < names.size(); f++) {
+        std::vector<float> center(nrClusters);
+        for (size_t c = 0; c < nrClusters; c++) {
+            center[c] = result.centers[c * names.size() + f];
+        }
+        microClusters->addColumn(names[f], std::move(center));
+    }
+
+    timer.count("rows", static_cast<double>(nrMembers + nrClusters));
+
+    const Outputs outputs{members, microClusters};
+    results_.insert(key.value(), outputs);
+    setOutputs(outputs);
+}
+
+void MiniBatchClustering::setOutputs(const Outputs& outputs) {
+    outport_.setData(outputs.members);
+    microClustersOutport_.setData(outputs.microClusters);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,145 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/processors/quantizechargetable.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo QuantizeChargeTable::processorInfo_{
+    "org.inviwo.QuantizeChargeTable",  // Class identifier
+    "Quantize Charge Table",           // Display name
+    "Undefined",                       // Category
+    CodeState::Experimental,           // Code state
+    Tags::None,                        // Tags
+};
+const ProcessorInfo& QuantizeChargeTable::getProcessorInfo() const { return processorInfo_; }
+
+QuantizeChargeTable::QuantizeChargeTable()
+    : Processor()
+    , inport_("inport")
+    , outport_("outport")
+    , automatic_("automatic", "Choose format automatically", true)
+    , format_("format", "Format",
+              {{"float16", "Half float (16 bit)", ChargeQuantization::Format::Float16},
+               {"fixed16", "Fixed point (16 bit)", ChargeQuantization::Format::Fixed16},
+               {"fixed8", "Fixed point (8 bit)", ChargeQuantization::Format::Fixed8}},
+              1)
+    , errorBound_("errorBound", "Error bound", 1e-3f, 1e-7f, 0.1f, 1e-7f) {
+
+    addPort(inport_);
+    addPort(outport_);
+    addProperty(automatic_);
+    addProperty(format_);
+    addProperty(errorBound_);
+
+    format_.visibilityDependsOn(automatic_, [](const auto& p) { return !p.get(); });
+}
+
+void QuantizeChargeTable::process() {
+    HotPathProfiler::ScopedTimer timer("QuantizeChargeTable::process");
+    using Format = ChargeQuantization::Format;
+
+    const auto input = inport_.getData();
+    const auto nrRows = input->getNumberOfRows();
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrRows));
+
+    size_t inputBytes = 0;
+    size_t outputBytes = 0;
+    // The first column is the index column, which the new DataFrame already has
+    for (size_t c = 1; c < input->getNumberOfColumns(); c++) {
+        const auto column = input->getColumn(c);
+        const auto buffer = column->getBuffer();
+        if (column->getColumnType() != ColumnType::Ordinal ||
+            buffer->getDataFormat()->getId() != DataFormatId::Float32 ||
+            ChargeQuantization::encodingOf(*buffer)) {
+            dataFrame->addColumn(std::shared_ptr<Column>(column->clone()));
+            continue;
+        }
+
+        const auto& values = static_cast<const BufferRAMPrecision<float>*>(
+                                 buffer->getRepresentation<BufferRAM>())
+                                 ->getDataContainer();
+        // Range of the numbers, std::minmax_element is not defined for NaN
+        auto min = std::numeric_limits<double>::infinity();
+        auto max = -std::numeric_limits<double>::infinity();
+        bool hasNaN = false;
+        for (const auto value : values) {
+            if (std::isnan(value)) {
+                hasNaN = true;
+            } else {
+                min = std::min(min, static_cast<double>(value));
+                max = std::max(max, static_cast<double>(value));
+            }
+        }
+        if (min > max) min = max = 0.0;
+
+        auto encoding = ChargeQuantization::choose(min, max, errorBound_.get());
+        if (!automatic_.get()) encoding = ChargeQuantization::encoding(format_.get(), min, max);
+        // Fixed point has no code for NaN
+        if (hasNaN && encoding.format != Format::Float32) {
+            encoding = ChargeQuantization::encoding(Format::Float16, min, max);
+        }
+        if (ChargeQuantization::maxError(encoding, min, max) > errorBound_.get()) {
+            encoding = ChargeQuantization::encoding(Format::Float32, min, max);
+        }
+
+        inputBytes += values.size() * sizeof(float);
+        outputBytes += values.size() * ChargeQuantization::bytesPerValue(encoding.format);
+
+        const auto header = column->getHeader();
+        if (encoding.format == Format::Float16 || encoding.format == Format::Fixed16) {
+            std::vector<uint16_t> codes(values.size());
+            if (encoding.format == Format::Float16) {
+                ChargeQuantization::toHalf(values.data(), codes.data(), values.size());
+            } else {
+                ChargeQuantization::toFixed(values.data(), codes.data(), values.size(), encoding);
+            }
+            auto quantized = dataFrame->addColumn(header, std::move(codes));
+            ChargeQuantization::setEncoding(*quantized->getTypedBuffer(), encoding);
+        } else if (encoding.format == Format::Fixed8) {
+            std::vector<uint8_t> codes(values.size());
+            ChargeQuantization::toFixed(values.data(), codes.data(), values.size(), encoding);
+            auto quantized = dataFrame->addColumn(header, std::move(codes));
+            ChargeQuantization::setEncoding(*quantized->getTypedBuffer(), encoding);
+        } else {
+            dataFrame->addColumn(std::shared_ptr<Column>(column->clone()));
+        }
+    }
+
+    timer.count("rows", static_cast<double>(nrRows));
+    timer.count("bytes copied", static_cast<double>(inputBytes + outputBytes));
+
+    outport_.setData(dataFrame);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,157 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/regionadjacencygraph.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+
+namespace inviwo {
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo RegionAdjacencyGraph::processorInfo_{
+    "org.inviwo.RegionAdjacencyGraph",  // Class identifier
+    "Region Adjacency Graph",           // Display name
+    "Undefined",                        // Category
+    CodeState::Experimental,            // Code state
+    Tags::None,                         // Tags
+};
+const ProcessorInfo& RegionAdjacencyGraph::getProcessorInfo() const { return processorInfo_; }
+
+RegionAdjacencyGraph::RegionAdjacencyGraph()
+    : Processor()
+    , segmentation_("segmentation")
+    , edges_("edges")
+    , regions_("regions")
+    , distances_("distances") {
+
+    addPort(segmentation_);
+    addPort(edges_);
+    addPort(regions_);
+    addPort(distances_);
+}
+
+void RegionAdjacencyGraph::process() {
+    HotPathProfiler::ScopedTimer timer("RegionAdjacencyGraph::process");
+
+    const auto segmentation = segmentation_.getData();
+    const auto dims = segmentation->getDimensions();
+    const auto range = segmentation->dataMap.valueRange;
+    const auto firstRegion = static_cast<size_t>(static_cast<uint16_t>(range.x));
+    const auto lastRegion = static_cast<size_t>(static_cast<uint16_t>(range.y));
+    const auto nrRegions = lastRegion >= firstRegion ? lastRegion - firstRegion + 1 : 0;
+    const dmat4 indexToWorld{segmentation->getCoordinateTransformer().getIndexToWorldMatrix()};
+    const dmat3 basis{indexToWorld};
+    const dvec3 offset{indexToWorld[3]};
+
+    segmentation->getRepresentation<VolumeRAM>()
+        ->dispatch<void, dispatching::filter::UnsignedIntegerScalars>([&](auto labelRAM) {
+            using LabelType = util::PrecisionValueType<decltype(labelRAM)>;
+            const LabelType* labels = labelRAM->getDataTyped();
+
+            // Key of the labels and the geometry
+            InputHash key;
+            key.add(labels, glm::compMul(dims) * sizeof(LabelType));
+            key.add(static_cast<int>(segmentation->getDataFormat()->getId()));
+            key.add(dims.x).add(dims.y).add(dims.z).add(firstRegion).add(nrRegions);
+            for (size_t i = 0; i < 3; i++) {
+                key.add(basis[i].x).add(basis[i].y).add(basis[i].z).add(offset[i]);
+            }
+            if (const auto cached = results_.find(key.value())) {
+                timer.count("cache hits", 1.0);
+                setOutputs(*cached);
+                return;
+            }
+
+            const auto graph =
+                RegionAdjacency::compute(labels, dims, firstRegion, nrRegions, basis, offset);
+            const auto distances = RegionAdjacency::centroidDistances(graph);
+
+            const auto nrEdges = graph.edges.size();
+            std::vector<int> first(nrEdges);
+            std::vector<int> second(nrEdges);
+            std::vector<int> faces(nrEdges);
+            std::vector<float> edgeDistances(nrEdges);
+            for (size_t e = 0; e < nrEdges; e++) {
+                const auto& edge = graph.edges[e];
+                first[e] = static_cast<int>(firstRegion + edge.first);
+                second[e] = static_cast<int>(firstRegion + edge.second);
+                faces[e] = static_cast<int>(edge.faces);
+                edgeDistances[e] =
+                    static_cast<float>(distances[edge.first * nrRegions + edge.second]);
+            }
+            auto edgeDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrEdges));
+            edgeDataFrame->addColumn("Region A", std::move(first));
+            edgeDataFrame->addColumn("Region B", std::move(second));
+            edgeDataFrame->addColumn("Faces", std::move(faces));
+            edgeDataFrame->addColumn("Centroid distance", std::move(edgeDistances));
+
+            std::vector<int> labelColumn(nrRegions);
+            std::vector<int> voxels(nrRegions);
+            std::vector<float> x(nrRegions);
+            std::vector<float> y(nrRegions);
+            std::vector<float> z(nrRegions);
+            for (size_t r = 0; r < nrRegions; r++) {
+                labelColumn[r] = static_cast<int>(firstRegion + r);
+                voxels[r] = static_cast<int>(graph.voxels[r]);
+                x[r] = static_cast<float>(graph.centroids[r].x);
+                y[r] = static_cast<float>(graph.centroids[r].y);
+                z[r] = static_cast<float>(graph.centroids[r].z);
+            }
+            auto regionDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrRegions));
+            regionDataFrame->addColumn("Region", std::move(labelColumn));
+            regionDataFrame->addColumn("Voxels", std::move(voxels));
+            regionDataFrame->addColumn("Centroid x", std::move(x));
+            regionDataFrame->addColumn("Centroid y", std::move(y));
+            regionDataFrame->addColumn("Centroid z", std::move(z));
+
+            auto distanceDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(nrRegions));
+            for (size_t i = 0; i < nrRegions; i++) {
+                std::vector<float> column(nrRegions);
+                for (size_t j = 0; j < nrRegions; j++) {
+                    column[j] = static_cast<float>(distances[i * nrRegions + j]);
+                }
+                distanceDataFrame->addColumn(toString(firstRegion + i), std::move(column));
+            }
+
+            timer.count("voxels", static_cast<double>(glm::compMul(dims)));
+            timer.count("rows", static_cast<double>(nrEdges + 2 * nrRegions));
+
+            const Outputs outputs{edgeDataFrame, regionDataFrame, distanceDataFrame};
+            results_.insert(key.value(), outputs);
+            setOutputs(outputs);
+        });
+}
+
+void RegionAdjacencyGraph::setOutputs(const Outputs& outputs) {
+    edges_.setData(outputs.edges);
+    regions_.setData(outputs.regions);
+    distances_.setData(outputs.distances);
+}
+
+}  // namespace inviwo
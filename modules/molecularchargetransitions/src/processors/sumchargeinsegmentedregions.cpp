@@ -28,9 +28,35 @@
  *********************************************************************************/
 
 #include <inviwo/molecularchargetransitions/processors/sumchargeinsegmentedregions.h>
+#include <inviwo/core/common/inviwoapplication.h>
+#include <inviwo/core/util/raiiutils.h>
+#include <array>
+#include <limits>
 
 namespace inviwo {
 
+namespace {
+
+// Columns centroid, spread, radius and dipole of the moments, in the order of names
+void addMomentColumns(DataFrame& dataFrame,
+                      const std::vector<SegmentedRegionSum::Features>& features,
+                      const std::array<std::string, 10>& names) {
+    std::array<std::vector<float>, 10> columns;
+    for (const auto& f : features) {
+        const std::array<double, 10> values = {
+            f.centroid.x, f.centroid.y, f.centroid.z, f.spread.x, f.spread.y,
+            f.spread.z,   f.radius,     f.dipole.x,   f.dipole.y, f.dipole.z};
+        for (size_t i = 0; i < values.size(); i++) {
+            columns[i].push_back(static_cast<float>(values[i]));
+        }
+    }
+    for (size_t i = 0; i < columns.size(); i++) {
+        dataFrame.addColumn(names[i], columns[i]);
+    }
+}
+
+}  // namespace
+
 // The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
 const ProcessorInfo SumChargeInSegmentedRegions::processorInfo_{
     "org.inviwo.SumChargeInSegmentedRegions",  // Class identifier
@@ -47,137 +73,298 @@ SumChargeInSegmentedRegions::SumChargeInSegmentedRegions()
     , volumeValues_("chargeDensity")
     , chargePerRegion_("chargePerRegion")
     , chargePerSubgroup_("chargePerSubgroup")
-    , fileLocation_("fileLocation", "Subgroup file location (json)") {
+    , fileLocation_("fileLocation", "Subgroup file location (json)")
+    , progressive_("progressive", "Progressive", false)
+    , nrLevels_("nrLevels", "Nr of coarse levels", 3, 1, 6, 1)
+    , moments_("moments", "Spatial moments", true)
+    , generation_{std::make_shared<std::atomic<size_t>>(0)}
+    , alive_{std::make_shared<bool>(true)} {
 
     addPort(segmentation_);
     addPort(volumeValues_);
     addPort(chargePerRegion_);
     addPort(chargePerSubgroup_);
     addProperty(fileLocation_);
+    addProperty(progressive_);
+    addProperty(nrLevels_);
+    addProperty(moments_);
+
+    nrLevels_.visibilityDependsOn(progressive_, [](const auto& p) { return p.get(); });
 }
 
+SumChargeInSegmentedRegions::~SumChargeInSegmentedRegions() { ++*generation_; }
+
 void SumChargeInSegmentedRegions::process() {
+    HotPathProfiler::ScopedTimer timer("SumChargeInSegmentedRegions::process");
     // TODO: Should have the option to sum whole volume as well?
 
+    // A refinement failed in the background, the job has invalidated the processor to report it
+    if (error_) {
+        const auto error = std::move(*error_);
+        error_.reset();
+        refined_.reset();
+        throw Exception(error, IVW_CONTEXT);
+    }
+    // A refined estimate is done and nothing has changed since it was started
+    if (refined_ && !segmentation_.isChanged() && !volumeValues_.isChanged() &&
+        !fileLocation_.isModified() && !progressive_.isModified() && !nrLevels_.isModified() &&
+        !moments_.isModified()) {
+        setOutputs(*refined_);
+        refined_.reset();
+        return;
+    }
+    // Stop any refinement of earlier input
+    ++*generation_;
+    refined_.reset();
+
     const auto segmentationData = segmentation_.getData();
     const auto volumeData = volumeValues_.getData();
     const auto fileLoc = fileLocation_.get();
 
     if (volumeData->getDimensions() != segmentationData->getDimensions()) {
         throw Exception("Unexpected dimension missmatch", IVW_CONTEXT);
-        chargePerRegion_.setData(nullptr);
-        chargePerSubgroup_.setData(nullptr);
     } else if (fileLoc == "") {
         throw Exception("No subgroup file provided", IVW_CONTEXT);
-        chargePerRegion_.setData(nullptr);
-        chargePerSubgroup_.setData(nullptr);
     } else if (!filesystem::fileExists(fileLoc)) {
         throw Exception("Subgroup file does not exist", IVW_CONTEXT);
-        chargePerRegion_.setData(nullptr);
-        chargePerSubgroup_.setData(nullptr);
+    }
+
+    const auto range = segmentationData->dataMap.valueRange;
+    const auto firstRegion = static_cast<size_t>(static_cast<uint16_t>(range.x));
+    const auto lastRegion = static_cast<size_t>(static_cast<uint16_t>(range.y));
+    const auto nrRegions = lastRegion >= firstRegion ? lastRegion - firstRegion + 1 : 0;
+    const auto dims = volumeData->getDimensions();
+    const auto nrVoxels = glm::compMul(dims);
+
+    subgroups_ = SubgroupFile::read(fileLoc);
+    firstRegion_ = firstRegion;
+    if (SubgroupFile::nrRegions(subgroups_) != nrRegions) {
+        throw Exception("Subgroup info (indices) does not match the number of segmented regions",
+                        IVW_CONTEXT);
+    }
+
+    // Estimate of the given level, level 0 is the exact sum which reports its progress
+    std::function<ProgressiveRegionSum::Estimate(size_t, const ProgressiveRegionSum::Estimate*,
+                                                 const SegmentedRegionSum::ProgressCallback&)>
+        estimateLevel;
+    const auto nrLevels = progressive_.get() ? nrLevels_.get() : size_t{0};
+    const auto withMoments = moments_.get();
+    const dmat4 indexToWorld{volumeData->getCoordinateTransformer().getIndexToWorldMatrix()};
+    const dmat3 basis{indexToWorld};
+    const dvec3 offset{indexToWorld[3]};
+
+    volumeData->getRepresentation<VolumeRAM>()
+        ->dispatch<void, dispatching::filter::FloatScalars>([&](auto vr) {
+            using ChargeDensityValueType = util::PrecisionValueType<decltype(vr)>;
+            const ChargeDensityValueType* src = vr->getDataTyped();
+
+            segmentationData->getRepresentation<VolumeRAM>()
+                ->dispatch<void, dispatching::filter::UnsignedIntegerScalars>([&](auto seg) {
+                    using VolumeSegmentationValueType = util::PrecisionValueType<decltype(seg)>;
+                    const VolumeSegmentationValueType* indices = seg->getDataTyped();
+
+                    // The label pyramid is kept as long as the segmentation is the same
+                    if (nrLevels > 0 &&
+                        (!labelPyramid_ || labelPyramidSource_.lock() != segmentationData ||
+                         labelPyramid_->levels.size() != nrLevels)) {
+                        labelPyramid_ = std::make_shared<ProgressiveRegionSum::LabelPyramid>(
+                            ProgressiveRegionSum::buildLabelPyramid(indices, dims, firstRegion,
+                                                                    nrRegions, nrLevels));
+                        labelPyramidSource_ = segmentationData;
+                    }
+
+                    estimateLevel = [src, indices, dims, firstRegion, nrRegions, withMoments,
+                                     basis, offset, pyramid = labelPyramid_, volumeData,
+                                     segmentationData](
+                                        size_t level, const ProgressiveRegionSum::Estimate* coarser,
+                                        const SegmentedRegionSum::ProgressCallback& progress)
+                        -> ProgressiveRegionSum::Estimate {
+                        if (level > 0) {
+                            return ProgressiveRegionSum::estimate(src, *pyramid, level, coarser);
+                        }
+                        if (!withMoments) {
+                            return {0,
+                                    SegmentedRegionSum::sumPerRegion(src, indices, dims,
+                                                                     firstRegion, nrRegions,
+                                                                     progress),
+                                    std::vector<float>(nrRegions, 0.0f)};
+                        }
+                        // The charges and the moments in a single pass over the volume
+                        auto moments = SegmentedRegionSum::momentsPerRegion(
+                            src, indices, dims, firstRegion, nrRegions, basis, offset, progress);
+                        std::vector<float> charges(nrRegions);
+                        std::transform(moments.begin(), moments.end(), charges.begin(),
+                                       [](const auto& m) { return static_cast<float>(m.charge); });
+                        return {0, std::move(charges), std::vector<float>(nrRegions, 0.0f),
+                                std::move(moments)};
+                    };
+                });
+        });
+
+    // The coarsest estimate is cheap and is output right away, the exact sum only in the background
+    std::optional<ProgressiveRegionSum::Estimate> estimate;
+    if (nrLevels > 0) {
+        estimate = estimateLevel(nrLevels, nullptr, {});
+        setOutputs(*estimate);
     } else {
-        const auto range = segmentationData->dataMap.valueRange;
+        chargePerRegion_.clear();
+        chargePerSubgroup_.clear();
+    }
 
-        // TODO: do I really need to set an initial value here?
-        auto indicesToAccumulatedValue = std::unordered_map<uint16_t, float>();
-        for (auto i = static_cast<uint16_t>(range.x); i <= static_cast<uint16_t>(range.y); i++) {
-            indicesToAccumulatedValue.emplace(i, 0.0);
-        }
+    timer.count("voxels", static_cast<double>(nrLevels == 0 ? 0 : nrVoxels >> (3 * nrLevels)));
+    timer.count("rows", static_cast<double>(nrRegions + subgroups_.size()));
 
-        if (indicesToAccumulatedValue.size() == 0) {
-            throw Exception("Seem to be no segmented regions in the segmented volume...",
-                            IVW_CONTEXT);
-        }
+    getProgressBar().resetProgress();
+    notifyObserversStartBackgroundWork(this, 1);
 
-        const util::IndexMapper3D im(volumeData->getDimensions());
-        volumeData->getRepresentation<VolumeRAM>()
-            ->dispatch<void, dispatching::filter::FloatScalars>([&](auto vr) {
-                using ChargeDensityValueType = util::PrecisionValueType<decltype(vr)>;
-                const ChargeDensityValueType* src = vr->getDataTyped();
-
-                segmentationData->getRepresentation<VolumeRAM>()
-                    ->dispatch<void, dispatching::filter::UnsignedIntegerScalars>([&](auto seg) {
-                        using VolumeSegmentationValueType = util::PrecisionValueType<decltype(seg)>;
-                        const VolumeSegmentationValueType* indices = seg->getDataTyped();
-
-                        util::forEachVoxel(*vr, [&](const size3_t& pos) {
-                            float value = static_cast<float>(src[im(pos)]);
-                            uint16_t index = static_cast<uint16_t>(indices[im(pos)]);
-                            indicesToAccumulatedValue.at(index) =
-                                indicesToAccumulatedValue.at(index) + value;
-                        });
-                    });
+    // Refine level by level in the background, each result replaces the previous one. The blocks
+    // of the exact sum check that the input is still current, and stale results are dropped.
+    dispatchPool([this, estimateLevel, estimate, nrLevels, nrVoxels, generation = generation_,
+                  current = generation_->load(), alive = std::weak_ptr<bool>(alive_)]() {
+        // The job is always finished, also when a level throws
+        util::OnScopeExit finish([this, alive, generation, current]() {
+            dispatchFront([this, alive, generation, current]() {
+                if (alive.expired()) return;
+                if (*generation == current) getProgressBar().finishProgress();
+                notifyObserversFinishBackgroundWork(this, 1);
             });
+        });
 
-        float totalCharge =
-            std::accumulate(indicesToAccumulatedValue.begin(), indicesToAccumulatedValue.end(),
-                            0.0f, [](float value, auto current) { return value + current.second; });
-
-        auto dataFrame = std::make_shared<DataFrame>(
-            static_cast<glm::u32>(3 * indicesToAccumulatedValue.size()));
-        auto& col1 =
-            dataFrame->addColumn<uint16_t>("Segmented region", indicesToAccumulatedValue.size())
-                ->getTypedBuffer()
-                ->getEditableRAMRepresentation()
-                ->getDataContainer();
-        auto& col2 = dataFrame->addColumn<float>("Charge", indicesToAccumulatedValue.size())
-                         ->getTypedBuffer()
-                         ->getEditableRAMRepresentation()
-                         ->getDataContainer();
-        auto& col3 = dataFrame->addColumn<float>("Charge [%]", indicesToAccumulatedValue.size())
-                         ->getTypedBuffer()
-                         ->getEditableRAMRepresentation()
-                         ->getDataContainer();
-
-        size_t i = 0;
-        for (auto& indexToAccumulatedValue : indicesToAccumulatedValue) {
-            col1[i] = indexToAccumulatedValue.first;
-            col2[i] = indexToAccumulatedValue.second;
-            col3[i] = indexToAccumulatedValue.second / totalCharge;
-            i++;
-        }
+        const auto isCurrent = [&]() { return *generation == current; };
+        const auto progress = [&](size_t voxelsDone) {
+            if (!isCurrent()) return false;
+            const auto done = static_cast<float>(voxelsDone) / static_cast<float>(nrVoxels);
+            dispatchFront([this, done, alive, generation, current]() {
+                if (alive.expired() || *generation != current) return;
+                getProgressBar().updateProgress(done);
+            });
+            return true;
+        };
 
-        auto fileStream = filesystem::ifstream(fileLoc);
-        nlohmann::json subgroupsJson;
-        fileStream >> subgroupsJson;
-
-        const auto totalNrOfSubgroups = std::accumulate(
-            subgroupsJson.cbegin(), subgroupsJson.cend(), 0, [&](uint16_t value, auto current) {
-                if (!current.contains("indices")) {
-                    throw Exception("Wrong format on json object (does not contain 'indices')",
-                                    IVW_CONTEXT);
-                }
-                return value + current["indices"].size();
+        // Reported by the next process(), unless the input has changed in the meantime
+        const auto fail = [&](std::string message) {
+            dispatchFront([this, message = std::move(message), generation, current, alive]() {
+                if (alive.expired() || *generation != current) return;
+                error_ = message;
+                invalidate(InvalidationLevel::InvalidOutput);
             });
+        };
 
-        if (totalNrOfSubgroups != indicesToAccumulatedValue.size()) {
-            throw Exception(
-                "Subgroup info (indices) does not match the number of segmented regions",
-                IVW_CONTEXT);
+        auto previous = estimate;
+        for (size_t level = nrLevels; level-- > 0 && isCurrent();) {
+            try {
+                auto refined =
+                    estimateLevel(level, previous ? &*previous : nullptr,
+                                  level == 0 ? SegmentedRegionSum::ProgressCallback{progress}
+                                             : SegmentedRegionSum::ProgressCallback{});
+                if (!isCurrent()) break;
+                dispatchFront([this, refined, generation, current, alive]() {
+                    if (alive.expired() || *generation != current) return;
+                    refined_ = refined;
+                    invalidate(InvalidationLevel::InvalidOutput);
+                });
+                previous = std::move(refined);
+            } catch (const Exception& e) {
+                fail(e.getMessage());
+                break;
+            } catch (const std::exception& e) {
+                fail(e.what());
+                break;
+            } catch (...) {
+                fail("Unknown error in the region sum");
+                break;
+            }
         }
+    });
+}
 
-        auto subgroupDataFrame =
-            std::make_shared<DataFrame>(static_cast<glm::u32>(2 * subgroupsJson.size()));
+void SumChargeInSegmentedRegions::setOutputs(const ProgressiveRegionSum::Estimate& estimate) {
+    const auto& accumulatedValues = estimate.charges;
+    const auto nrRegions = accumulatedValues.size();
+    const float totalCharge =
+        std::accumulate(accumulatedValues.begin(), accumulatedValues.end(), 0.0f);
 
-        std::vector<std::string> subgroupNames = {};
-        std::vector<float> charges = {};
-        for (auto& subgroup : subgroupsJson) {
-            if (!subgroup.contains("name")) {
-                throw Exception("Wrong format on json object (does not contain 'name')",
-                                IVW_CONTEXT);
-            }
+    auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(3 * nrRegions));
+    auto& col1 = dataFrame->addColumn<uint16_t>("Segmented region", nrRegions)
+                     ->getTypedBuffer()
+                     ->getEditableRAMRepresentation()
+                     ->getDataContainer();
+    auto& col2 = dataFrame->addColumn<float>("Charge", nrRegions)
+                     ->getTypedBuffer()
+                     ->getEditableRAMRepresentation()
+                     ->getDataContainer();
+    auto& col3 = dataFrame->addColumn<float>("Charge [%]", nrRegions)
+                     ->getTypedBuffer()
+                     ->getEditableRAMRepresentation()
+                     ->getDataContainer();
+
+    for (size_t i = 0; i < nrRegions; i++) {
+        col1[i] = static_cast<uint16_t>(firstRegion_ + i);
+        col2[i] = accumulatedValues[i];
+        col3[i] = accumulatedValues[i] / totalCharge;
+    }
 
-            subgroupNames.push_back(subgroup["name"]);
-            charges.push_back(std::accumulate(
-                subgroup["indices"].begin(), subgroup["indices"].end(), 0.0f,
-                [col3](float value, auto current) { return value + col3[current]; }));
+    auto subgroupDataFrame =
+        std::make_shared<DataFrame>(static_cast<glm::u32>(2 * subgroups_.size()));
+
+    std::vector<std::string> subgroupNames = {};
+    std::vector<float> charges = {};
+    for (auto& subgroup : subgroups_) {
+        subgroupNames.push_back(subgroup.name);
+        charges.push_back(std::accumulate(
+            subgroup.indices.begin(), subgroup.indices.end(), 0.0f,
+            [&col3](float value, size_t current) { return value + col3[current]; }));
+    }
+    subgroupDataFrame->addCategoricalColumn("subgroup", subgroupNames);
+    subgroupDataFrame->addColumn("charge_sg", charges);
+
+    // The change estimate columns are always there in progressive mode, also for the exact result
+    if (progressive_) {
+        std::vector<float> change(nrRegions);
+        std::transform(estimate.changeEstimate.begin(), estimate.changeEstimate.end(),
+                       change.begin(), [totalCharge](float e) { return e / totalCharge; });
+        dataFrame->addColumn("Charge change estimate", estimate.changeEstimate);
+        dataFrame->addColumn("Charge change estimate [%]", change);
+
+        std::vector<float> subgroupChanges = {};
+        for (auto& subgroup : subgroups_) {
+            subgroupChanges.push_back(std::accumulate(
+                subgroup.indices.begin(), subgroup.indices.end(), 0.0f,
+                [&change](float value, size_t current) { return value + change[current]; }));
+        }
+        subgroupDataFrame->addColumn("change_estimate_sg", subgroupChanges);
+    }
+
+    // The coarse estimates have no moments, their moment columns are NaN so that the columns of
+    // the outports do not change while refining
+    if (moments_) {
+        const auto nan = std::numeric_limits<double>::quiet_NaN();
+        const bool exact = !estimate.moments.empty();
+        const SegmentedRegionSum::Features unknown{dvec3{nan}, dvec3{nan}, nan, dvec3{nan}};
+
+        std::vector<SegmentedRegionSum::Features> features(nrRegions, unknown);
+        for (size_t i = 0; exact && i < nrRegions; i++) {
+            features[i] = SegmentedRegionSum::features(estimate.moments[i]);
         }
-        subgroupDataFrame->addCategoricalColumn("subgroup", subgroupNames);
-        subgroupDataFrame->addColumn("charge_sg", charges);
+        addMomentColumns(*dataFrame, features,
+                         {"Centroid x", "Centroid y", "Centroid z", "Spread x", "Spread y",
+                          "Spread z", "Spread", "Dipole x", "Dipole y", "Dipole z"});
 
-        chargePerRegion_.setData(dataFrame);
-        chargePerSubgroup_.setData(subgroupDataFrame);
+        std::vector<SegmentedRegionSum::Features> subgroupFeatures;
+        for (auto& subgroup : subgroups_) {
+            subgroupFeatures.push_back(
+                exact ? SegmentedRegionSum::features(
+                            SegmentedRegionSum::sum(estimate.moments, subgroup.indices))
+                      : unknown);
+        }
+        addMomentColumns(*subgroupDataFrame, subgroupFeatures,
+                         {"centroid_x_sg", "centroid_y_sg", "centroid_z_sg", "spread_x_sg",
+                          "spread_y_sg", "spread_z_sg", "spread_sg", "dipole_x_sg", "dipole_y_sg",
+                          "dipole_z_sg"});
     }
+
+    chargePerRegion_.setData(dataFrame);
+    chargePerSubgroup_.setData(subgroupDataFrame);
 }
 
 }  // namespace inviwo
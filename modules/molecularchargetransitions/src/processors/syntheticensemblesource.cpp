@@ -0,0 +1,148 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/processors/syntheticensemblesource.h>
+#include <inviwo/core/datastructures/volume/volume.h>
+#include <inviwo/core/datastructures/volume/volumeramprecision.h>
+#include <inviwo/core/util/filesystem.h>
+
+namespace inviwo {
+
+namespace {
+
+template <typename T>
+std::shared_ptr<Volume> createVolume(const size3_t& dims, const std::vector<T>& data) {
+    auto volumeRAM = std::make_shared<VolumeRAMPrecision<T>>(dims);
+    std::copy(data.begin(), data.end(), volumeRAM->getDataTyped());
+
+    auto volume = std::make_shared<Volume>(volumeRAM);
+    const auto [min, max] = std::minmax_element(data.begin(), data.end());
+    volume->dataMap.dataRange = dvec2(*min, *max);
+    volume->dataMap.valueRange = dvec2(*min, *max);
+    return volume;
+}
+
+}  // namespace
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo SyntheticEnsembleSource::processorInfo_{
+    "org.inviwo.SyntheticEnsembleSource",  // Class identifier
+    "Synthetic Ensemble Source",           // Display name
+    "Undefined",                           // Category
+    CodeState::Experimental,               // Code state
+    Tags::None,                            // Tags
+};
+const ProcessorInfo& SyntheticEnsembleSource::getProcessorInfo() const { return processorInfo_; }
+
+SyntheticEnsembleSource::SyntheticEnsembleSource()
+    : Processor()
+    , segmentation_("segmentation")
+    , holeDensity_("holeDensity")
+    , particleDensity_("particleDensity")
+    , ensemble_("ensemble")
+    , seed_("seed", "Seed", 0, 0, 1000000, 1)
+    , dimensions_("dimensions", "Dimensions", size3_t(64), size3_t(8), size3_t(1024), size3_t(1))
+    , nrRegions_("nrRegions", "Nr of regions", 8, 1, 1000, 1)
+    , nrSubgroups_("nrSubgroups", "Nr of subgroups", 3, 1, 20, 1)
+    , nrMembers_("nrMembers", "Nr of members", 1000, 1, 10000000, 1)
+    , nrClusters_("nrClusters", "Nr of clusters", 5, 1, 1000, 1)
+    , clusterSpread_("clusterSpread", "Cluster spread", 0.05f, 0.0f, 0.5f, 0.005f)
+    , member_("member", "Member", 0, 0, 999, 1)
+    , subgroupFile_("subgroupFile", "Subgroup file location (json)") {
+
+    addPort(segmentation_);
+    addPort(holeDensity_);
+    addPort(particleDensity_);
+    addPort(ensemble_);
+    addProperty(seed_);
+    addProperty(dimensions_);
+    addProperty(nrRegions_);
+    addProperty(nrSubgroups_);
+    addProperty(nrMembers_);
+    addProperty(nrClusters_);
+    addProperty(clusterSpread_);
+    addProperty(member_);
+    addProperty(subgroupFile_);
+
+    subgroupFile_.setAcceptMode(AcceptMode::SaveFile);
+    nrMembers_.onChange([this]() { member_.setMaxValue(nrMembers_.get() - 1); });
+}
+
+void SyntheticEnsembleSource::process() {
+    HotPathProfiler::ScopedTimer timer("SyntheticEnsembleSource::process");
+    const auto dims = dimensions_.get();
+
+    // Only the densities depend on the member, the segmentation, the table and the subgroups are
+    // kept when only the member has changed
+    const bool regenerate = !generator_ || seed_.isModified() || dimensions_.isModified() ||
+                            nrRegions_.isModified() || nrSubgroups_.isModified() ||
+                            nrMembers_.isModified() || nrClusters_.isModified() ||
+                            clusterSpread_.isModified();
+    if (regenerate) {
+        SyntheticEnsemble::Settings settings;
+        settings.seed = seed_.get();
+        settings.dimensions = dims;
+        settings.nrRegions = nrRegions_.get();
+        settings.nrSubgroups = nrSubgroups_.get();
+        settings.nrMembers = nrMembers_.get();
+        settings.nrClusters = nrClusters_.get();
+        settings.clusterSpread = clusterSpread_.get();
+        generator_.emplace(settings);
+
+        segmentation_.setData(createVolume(dims, generator_->labels()));
+
+        auto table = generator_->table();
+        auto dataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(settings.nrMembers));
+        dataFrame->addColumn("Cluster", std::move(table.cluster));
+        for (size_t i = 0; i < settings.nrSubgroups; i++) {
+            dataFrame->addColumn("Hole sg" + std::to_string(i + 1),
+                                 std::move(table.holeCharges[i]));
+        }
+        for (size_t i = 0; i < settings.nrSubgroups; i++) {
+            dataFrame->addColumn("Particle sg" + std::to_string(i + 1),
+                                 std::move(table.particleCharges[i]));
+        }
+        timer.count("rows", static_cast<double>(settings.nrMembers));
+        ensemble_.setData(dataFrame);
+    }
+
+    const auto member = std::min(member_.get(), nrMembers_.get() - 1);
+    holeDensity_.setData(
+        createVolume(dims, generator_->density(member, SyntheticEnsemble::Charge::Hole)));
+    particleDensity_.setData(
+        createVolume(dims, generator_->density(member, SyntheticEnsemble::Charge::Particle)));
+    timer.count("voxels", static_cast<double>((regenerate ? 3 : 2) * dims.x * dims.y * dims.z));
+
+    if ((regenerate || subgroupFile_.isModified()) && !subgroupFile_.get().empty()) {
+        auto fileStream = filesystem::ofstream(subgroupFile_.get());
+        fileStream << generator_->subgroups().dump(4);
+    }
+}
+
+}  // namespace inviwo
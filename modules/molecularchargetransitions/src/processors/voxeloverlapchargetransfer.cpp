@@ -0,0 +1,182 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/processors/voxeloverlapchargetransfer.h>
+#include <inviwo/core/datastructures/volume/volumeram.h>
+#include <inviwo/core/util/filesystem.h>
+#include <inviwo/molecularchargetransitions/util/deterministicreduction.h>
+
+namespace inviwo {
+
+namespace {
+
+// Total charge of a density, one over it scales the density to a total charge of one
+template <typename T>
+double totalCharge(const T* values, size_t nrVoxels) {
+    return util::deterministicReduce(
+        nrVoxels, size_t{1} << 16, 0.0,
+        [values](size_t, size_t begin, size_t end) {
+            double sum = 0.0;
+            for (size_t i = begin; i < end; i++) sum += static_cast<double>(values[i]);
+            return sum;
+        },
+        [](double& a, double b) { a += b; });
+}
+
+}  // namespace
+
+// The Class Identifier has to be globally unique. Use a reverse DNS naming scheme
+const ProcessorInfo VoxelOverlapChargeTransfer::processorInfo_{
+    "org.inviwo.VoxelOverlapChargeTransfer",  // Class identifier
+    "Voxel Overlap Charge Transfer",          // Display name
+    "Undefined",                              // Category
+    CodeState::Experimental,                  // Code state
+    Tags::None,                               // Tags
+};
+const ProcessorInfo& VoxelOverlapChargeTransfer::getProcessorInfo() const { return processorInfo_; }
+
+VoxelOverlapChargeTransfer::VoxelOverlapChargeTransfer()
+    : Processor()
+    , segmentation_("segmentation")
+    , holeDensity_("holeDensity")
+    , particleDensity_("particleDensity")
+    , chargeTransfer_("chargeTransfer")
+    , chargeDifference_("chargeDifference")
+    , overlap_("overlap")
+    , fileLocation_("fileLocation", "Subgroup file location (json)")
+    , coupling_("coupling", "Coupling",
+                {{"proportional", "Proportional", ChargeTransferMatrix::Coupling::Proportional},
+                 {"adjacent", "Adjacent", ChargeTransferMatrix::Coupling::Adjacent}},
+                0) {
+
+    addPort(segmentation_);
+    addPort(holeDensity_);
+    addPort(particleDensity_);
+    addPort(chargeTransfer_);
+    addPort(chargeDifference_);
+    addPort(overlap_);
+    addProperty(fileLocation_);
+    addProperty(coupling_);
+}
+
+void VoxelOverlapChargeTransfer::process() {
+    HotPathProfiler::ScopedTimer timer("VoxelOverlapChargeTransfer::process");
+
+    const auto segmentation = segmentation_.getData();
+    const auto holeDensity = holeDensity_.getData();
+    const auto particleDensity = particleDensity_.getData();
+    const auto dims = segmentation->getDimensions();
+
+    if (holeDensity->getDimensions() != dims || particleDensity->getDimensions() != dims) {
+        throw Exception("Unexpected dimension missmatch", IVW_CONTEXT);
+    }
+
+    const auto fileLoc = fileLocation_.get();
+    if (!fileLoc.empty() && !filesystem::fileExists(fileLoc)) {
+        throw Exception("Subgroup file does not exist", IVW_CONTEXT);
+    }
+
+    const auto range = segmentation->dataMap.valueRange;
+    const auto firstRegion = static_cast<size_t>(static_cast<uint16_t>(range.x));
+    const auto lastRegion = static_cast<size_t>(static_cast<uint16_t>(range.y));
+    const auto nrRegions = lastRegion >= firstRegion ? lastRegion - firstRegion + 1 : 0;
+    const bool faces = coupling_.get() == ChargeTransferMatrix::Coupling::Adjacent;
+
+    ChargeTransferMatrix::RegionOverlap regions;
+    holeDensity->getRepresentation<VolumeRAM>()
+        ->dispatch<void, dispatching::filter::FloatScalars>([&](auto holeRAM) {
+            const auto* hole = holeRAM->getDataTyped();
+            particleDensity->getRepresentation<VolumeRAM>()
+                ->dispatch<void, dispatching::filter::FloatScalars>([&](auto particleRAM) {
+                    const auto* particle = particleRAM->getDataTyped();
+                    const auto nrVoxels = glm::compMul(dims);
+                    const auto holeTotal = totalCharge(hole, nrVoxels);
+                    const auto particleTotal = totalCharge(particle, nrVoxels);
+                    if (holeTotal <= 0.0 || particleTotal <= 0.0) {
+                        throw Exception("No hole and/or particle charge to normalize", IVW_CONTEXT);
+                    }
+                    const dvec2 scale{1.0 / holeTotal, 1.0 / particleTotal};
+                    segmentation->getRepresentation<VolumeRAM>()
+                        ->dispatch<void, dispatching::filter::UnsignedIntegerScalars>(
+                            [&](auto labelRAM) {
+                                regions = ChargeTransferMatrix::accumulateRegionOverlap(
+                                    hole, particle, labelRAM->getDataTyped(), dims, firstRegion,
+                                    nrRegions, faces, scale);
+                            });
+                });
+        });
+
+    std::vector<std::string> names;
+    if (fileLoc.empty()) {
+        for (size_t i = 0; i < nrRegions; i++) {
+            names.push_back(toString(firstRegion + i));
+        }
+    } else {
+        const auto subgroups = SubgroupFile::read(fileLoc);
+        if (SubgroupFile::nrRegions(subgroups) != nrRegions) {
+            throw Exception(
+                "Subgroup info (indices) does not match the number of segmented regions",
+                IVW_CONTEXT);
+        }
+        std::vector<std::vector<size_t>> groups;
+        for (auto& subgroup : subgroups) {
+            names.push_back(subgroup.name);
+            groups.push_back(subgroup.indices);
+        }
+        regions = ChargeTransferMatrix::groupRegions(regions, groups);
+    }
+
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(regions,
+                                                                                 coupling_.get());
+
+    const auto n = regions.nrRegions;
+    auto chargeTransferDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
+    for (size_t i = 0; i < n; i++) {
+        // This charge transfer matrix is the on the form "vector of columns"
+        chargeTransferDataFrame->addColumn(toString(i + 1), chargeTransfer[i]);
+    }
+
+    auto chargeDiffDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
+    chargeDiffDataFrame->addColumn("Charge difference", chargeDifference);
+
+    auto overlapDataFrame = std::make_shared<DataFrame>(static_cast<glm::u32>(n));
+    overlapDataFrame->addCategoricalColumn("subgroup", names);
+    overlapDataFrame->addColumn("Hole", regions.hole);
+    overlapDataFrame->addColumn("Particle", regions.particle);
+    overlapDataFrame->addColumn("Overlap", regions.overlap);
+
+    timer.count("voxels", static_cast<double>(glm::compMul(dims)));
+    timer.count("rows", static_cast<double>(3 * n));
+
+    chargeTransfer_.setData(chargeTransferDataFrame);
+    chargeDifference_.setData(chargeDiffDataFrame);
+    overlap_.setData(overlapDataFrame);
+}
+
+}  // namespace inviwo
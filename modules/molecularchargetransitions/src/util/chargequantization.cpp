@@ -0,0 +1,243 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/util/chargequantization.h>
+#include <inviwo/core/metadata/metadata.h>
+#include <inviwo/core/util/exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace inviwo {
+
+namespace {
+
+uint32_t bits(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    return u;
+}
+
+float fromBits(uint32_t u) {
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+// Half float conversions without branches or tables, after F. Giesen (public domain)
+uint16_t floatToHalf(float value) {
+    const uint32_t f32Infinity = 255u << 23;
+    const uint32_t f16Max = (127u + 16u) << 23;
+    const uint32_t denormMagic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    uint32_t f = bits(value);
+    const uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+
+    // Infinity or NaN, NaN becomes a quiet NaN
+    const uint32_t special = f > f32Infinity ? 0x7e00u : 0x7c00u;
+    // Subnormal or zero, aligns the mantissa using float addition (round to nearest even)
+    const uint32_t subnormal = bits(fromBits(f) + fromBits(denormMagic)) - denormMagic;
+    // Normal, rebias the exponent and round to nearest even
+    const uint32_t mantissaOdd = (f >> 13) & 1u;
+    const uint32_t rebias = static_cast<uint32_t>(15 - 127) << 23;
+    const uint32_t normal = (f + rebias + 0xfffu + mantissaOdd) >> 13;
+
+    const uint32_t half = f >= f16Max ? special : (f < (113u << 23) ? subnormal : normal);
+    return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float halfToFloat(uint16_t half) {
+    const uint32_t shiftedExponent = 0x7c00u << 13;
+    const float magic = fromBits(113u << 23);
+
+    uint32_t o = (half & 0x7fffu) << 13;
+    const uint32_t exponent = o & shiftedExponent;
+    o += (127u - 15u) << 23;
+
+    // Infinity or NaN needs an extra exponent adjustment, zero and subnormals a renormalization
+    const uint32_t special = o + ((128u - 16u) << 23);
+    const uint32_t subnormal = bits(fromBits(o + (1u << 23)) - magic);
+    o = exponent == shiftedExponent ? special : (exponent == 0 ? subnormal : o);
+    return fromBits(o | (static_cast<uint32_t>(half & 0x8000u) << 16));
+}
+
+template <typename Code>
+void encodeFixed(const float* src, Code* dst, size_t n, const ChargeQuantization::Encoding& e) {
+    // In double, in float the rounding of the code can be off by more than half a step
+    const auto invScale = 1.0 / e.scale;
+    const auto maxCode = static_cast<double>(std::numeric_limits<Code>::max());
+    for (size_t i = 0; i < n; i++) {
+        const auto code =
+            std::min(std::max((static_cast<double>(src[i]) - e.offset) * invScale + 0.5, 0.0),
+                     maxCode);
+        // NaN stays NaN through min and max, and converting it to an integer is undefined
+        dst[i] = static_cast<Code>(std::isnan(code) ? 0.0 : code);
+    }
+}
+
+template <typename Code>
+void decodeFixed(const Code* src, float* dst, size_t n, const ChargeQuantization::Encoding& e) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] = static_cast<float>(e.offset + e.scale * static_cast<double>(src[i]));
+    }
+}
+
+constexpr const char* formatKey = "quantizationFormat";
+constexpr const char* offsetKey = "quantizationOffset";
+constexpr const char* scaleKey = "quantizationScale";
+
+}  // namespace
+
+ChargeQuantization::Encoding ChargeQuantization::encoding(Format format, double min,
+                                                          double max) {
+    const auto range = max - min;
+    switch (format) {
+        case Format::Fixed16:
+            return {format, min, range > 0.0 ? range / 65535.0 : 1.0};
+        case Format::Fixed8:
+            return {format, min, range > 0.0 ? range / 255.0 : 1.0};
+        default:
+            return {format, 0.0, 1.0};
+    }
+}
+
+double ChargeQuantization::maxError(const Encoding& encoding, double min, double max) {
+    const auto magnitude = std::max(std::abs(min), std::abs(max));
+    switch (encoding.format) {
+        case Format::Float16:
+            if (magnitude > 65504.0) return std::numeric_limits<double>::infinity();
+            // Half the spacing of half floats at the largest magnitude, subnormals below 2^-14
+            return std::ldexp(1.0, std::max(std::ilogb(std::max(magnitude, 0x1p-14)), -14) - 11);
+        case Format::Fixed16:
+        case Format::Fixed8: {
+            // Half a step, plus half the spacing of floats at the largest magnitude for the
+            // decoded value
+            const auto rounding =
+                magnitude > 0.0 ? std::ldexp(1.0, std::ilogb(magnitude) - 24) : 0.0;
+            return max > min ? encoding.scale / 2.0 + rounding : 0.0;
+        }
+        default:
+            // Rounding to float is the reference
+            return 0.0;
+    }
+}
+
+ChargeQuantization::Encoding ChargeQuantization::choose(double min, double max,
+                                                        double errorBound) {
+    const auto fixed8 = encoding(Format::Fixed8, min, max);
+    if (maxError(fixed8, min, max) <= errorBound) return fixed8;
+
+    const auto fixed16 = encoding(Format::Fixed16, min, max);
+    const auto half = encoding(Format::Float16, min, max);
+    const auto fixed16Error = maxError(fixed16, min, max);
+    const auto halfError = maxError(half, min, max);
+    if (std::min(fixed16Error, halfError) <= errorBound) {
+        return halfError < fixed16Error ? half : fixed16;
+    }
+    return encoding(Format::Float32, min, max);
+}
+
+size_t ChargeQuantization::bytesPerValue(Format format) {
+    switch (format) {
+        case Format::Float16:
+        case Format::Fixed16:
+            return 2;
+        case Format::Fixed8:
+            return 1;
+        default:
+            return 4;
+    }
+}
+
+void ChargeQuantization::toHalf(const float* src, uint16_t* dst, size_t n) {
+    std::transform(src, src + n, dst, floatToHalf);
+}
+
+void ChargeQuantization::fromHalf(const uint16_t* src, float* dst, size_t n) {
+    std::transform(src, src + n, dst, halfToFloat);
+}
+
+void ChargeQuantization::toFixed(const float* src, uint16_t* dst, size_t n,
+                                 const Encoding& encoding) {
+    encodeFixed(src, dst, n, encoding);
+}
+
+void ChargeQuantization::toFixed(const float* src, uint8_t* dst, size_t n,
+                                 const Encoding& encoding) {
+    encodeFixed(src, dst, n, encoding);
+}
+
+void ChargeQuantization::fromFixed(const uint16_t* src, float* dst, size_t n,
+                                   const Encoding& encoding) {
+    decodeFixed(src, dst, n, encoding);
+}
+
+void ChargeQuantization::fromFixed(const uint8_t* src, float* dst, size_t n,
+                                   const Encoding& encoding) {
+    decodeFixed(src, dst, n, encoding);
+}
+
+void ChargeQuantization::setEncoding(BufferBase& buffer, const Encoding& encoding) {
+    buffer.setMetaData<IntMetaData>(formatKey, static_cast<int>(encoding.format));
+    buffer.setMetaData<DoubleMetaData>(offsetKey, encoding.offset);
+    buffer.setMetaData<DoubleMetaData>(scaleKey, encoding.scale);
+}
+
+std::optional<ChargeQuantization::Encoding> ChargeQuantization::encodingOf(
+    const BufferBase& buffer) {
+    const auto format = static_cast<Format>(
+        buffer.getMetaData<IntMetaData>(formatKey, static_cast<int>(Format::Float32)));
+    if (format == Format::Float32) return std::nullopt;
+    return Encoding{format, buffer.getMetaData<DoubleMetaData>(offsetKey, 0.0),
+                    buffer.getMetaData<DoubleMetaData>(scaleKey, 1.0)};
+}
+
+void ChargeQuantization::decode(const BufferBase& buffer, const Encoding& encoding, float* dst) {
+    buffer.getRepresentation<BufferRAM>()->dispatch<void, dispatching::filter::Scalars>(
+        [&](auto buf) {
+            using CodeType = util::PrecisionValueType<decltype(buf)>;
+            const auto& src = buf->getDataContainer();
+            if constexpr (std::is_same_v<CodeType, uint16_t>) {
+                if (encoding.format == Format::Float16) {
+                    fromHalf(src.data(), dst, src.size());
+                } else {
+                    fromFixed(src.data(), dst, src.size(), encoding);
+                }
+            } else if constexpr (std::is_same_v<CodeType, uint8_t>) {
+                fromFixed(src.data(), dst, src.size(), encoding);
+            } else {
+                throw Exception("Quantized column has to be stored as uint8 or uint16",
+                                IVW_CONTEXT_CUSTOM("ChargeQuantization"));
+            }
+        });
+}
+
+}  // namespace inviwo
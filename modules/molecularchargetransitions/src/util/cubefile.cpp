@@ -0,0 +1,399 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/util/cubefile.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/exception.h>
+#include <inviwo/core/util/filesystem.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+
+namespace inviwo {
+
+namespace {
+
+constexpr size_t minChunkBytes = 4096;
+constexpr size_t hashedBytes = 64 * 1024;
+constexpr char cacheMagic[8] = {'I', 'V', 'W', 'C', 'U', 'B', 'E', '\0'};
+constexpr uint32_t cacheVersion = 1;
+constexpr uint32_t cacheByteOrder = 0x01020304;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t fileSize;
+    int64_t fileModified;
+    uint64_t fileHash;
+    uint64_t dims[3];
+    double origin[3];
+    double basis[9];
+    uint64_t angstrom;
+    uint64_t nrAtoms;
+    uint64_t commentSize;
+    uint64_t valuesOffset;
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+[[noreturn]] void parseError(const std::string& message) {
+    throw Exception("Invalid cube file: " + message, IVW_CONTEXT_CUSTOM("CubeFile"));
+}
+
+/**
+ * Parses the next number in text and removes it, with the leading whitespace, from text.
+ */
+template <typename T>
+T next(std::string_view& text, const char* what) {
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    while (pos != end && isSpace(*pos)) ++pos;
+    if (pos != end && *pos == '+') ++pos;
+    T value{};
+    const auto [ptr, ec] = std::from_chars(pos, end, value);
+    if (ec != std::errc{}) parseError(std::string("could not read ") + what);
+    text.remove_prefix(static_cast<size_t>(ptr - text.data()));
+    return value;
+}
+
+/**
+ * Returns the next line (without line break) and removes it from text.
+ */
+std::string_view nextLine(std::string_view& text) {
+    const auto lineEnd = text.find('\n');
+    if (lineEnd == std::string_view::npos && text.empty()) parseError("unexpected end of file");
+    auto line = text.substr(0, lineEnd);
+    text.remove_prefix(lineEnd == std::string_view::npos ? text.size() : lineEnd + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+void parseChunk(const char* pos, const char* end, std::vector<float>& values) {
+    values.reserve(static_cast<size_t>(end - pos) / 12);
+    while (true) {
+        while (pos != end && isSpace(*pos)) ++pos;
+        if (pos == end) break;
+        if (*pos == '+') ++pos;
+        double value = 0.0;
+        const auto [ptr, ec] = std::from_chars(pos, end, value);
+        if (ec == std::errc::result_out_of_range) {
+            // Underflow if the exponent is negative, otherwise overflow
+            const auto exponent =
+                std::find_if(pos, ptr, [](char c) { return c == 'e' || c == 'E'; });
+            const bool negative = *pos == '-';
+            if (exponent + 1 < ptr && exponent[1] == '-') {
+                value = 0.0;
+            } else {
+                value = negative ? -std::numeric_limits<double>::infinity()
+                                 : std::numeric_limits<double>::infinity();
+            }
+        } else if (ec != std::errc{}) {
+            parseError("could not read value '" +
+                       std::string(pos, std::find_if(pos, end, isSpace)) + "'");
+        }
+        values.push_back(static_cast<float>(value));
+        pos = ptr;
+    }
+}
+
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash) {
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}  // namespace
+
+CubeFile::Cube CubeFile::parse(std::string_view text, size_t nrThreads) {
+    HotPathProfiler::ScopedTimer timer("CubeFile::parse");
+    const auto textSize = text.size();
+
+    Cube cube;
+    cube.comment = std::string(nextLine(text));
+    cube.comment += '\n';
+    cube.comment += nextLine(text);
+
+    auto line = nextLine(text);
+    const auto nrAtoms = next<int>(line, "number of atoms");
+    for (size_t i = 0; i < 3; i++) cube.origin[i] = next<double>(line, "origin");
+    if (line.find_first_not_of(" \t") != std::string_view::npos &&
+        next<int>(line, "number of values") != 1) {
+        parseError("only one value per voxel is supported");
+    }
+
+    for (size_t axis = 0; axis < 3; axis++) {
+        line = nextLine(text);
+        const auto n = next<int>(line, "number of voxels");
+        if (n == 0) parseError("zero voxels along an axis");
+        cube.angstrom = n < 0;
+        cube.dims[axis] = static_cast<size_t>(std::abs(n));
+        for (size_t i = 0; i < 3; i++) cube.basis[axis][i] = next<double>(line, "voxel step");
+    }
+
+    cube.atoms.resize(static_cast<size_t>(std::abs(nrAtoms)));
+    for (auto& atom : cube.atoms) {
+        line = nextLine(text);
+        atom.atomicNumber = next<int>(line, "atomic number");
+        atom.charge = next<double>(line, "atomic charge");
+        for (size_t i = 0; i < 3; i++) atom.position[i] = next<double>(line, "atom position");
+    }
+    if (nrAtoms < 0) {
+        line = nextLine(text);
+        if (next<int>(line, "number of data sets") != 1) {
+            parseError("only one data set is supported");
+        }
+    }
+
+    // Split the data section at whitespace and parse the chunks in parallel
+    const auto dataBegin = text.data();
+    const auto dataEnd = text.data() + text.size();
+    const auto nrChunks =
+        std::max<size_t>(1, std::min(nrThreads, text.size() / minChunkBytes));
+    std::vector<const char*> bounds(nrChunks + 1, dataEnd);
+    bounds[0] = dataBegin;
+    for (size_t chunk = 1; chunk < nrChunks; chunk++) {
+        auto pos = std::max(bounds[chunk - 1], dataBegin + chunk * text.size() / nrChunks);
+        while (pos != dataEnd && !isSpace(*pos)) ++pos;
+        bounds[chunk] = pos;
+    }
+    std::vector<std::vector<float>> chunks(nrChunks);
+    util::parallelForRanges(nrChunks, nrChunks, [&](size_t, size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            parseChunk(bounds[chunk], bounds[chunk + 1], chunks[chunk]);
+        }
+    });
+
+    std::vector<size_t> starts(nrChunks + 1, 0);
+    for (size_t chunk = 0; chunk < nrChunks; chunk++) {
+        starts[chunk + 1] = starts[chunk] + chunks[chunk].size();
+    }
+    const auto nrVoxels = glm::compMul(cube.dims);
+    if (starts.back() != nrVoxels) {
+        parseError("expected " + std::to_string(nrVoxels) + " values but found " +
+                   std::to_string(starts.back()));
+    }
+
+    // The file has the third axis fastest, reorder to have the first fastest
+    const size_t n1 = cube.dims.x;
+    const size_t n2 = cube.dims.y;
+    const size_t n3 = cube.dims.z;
+    cube.values = std::unique_ptr<float[]>(new float[nrVoxels]);
+    util::parallelForRanges(nrChunks, nrChunks, [&](size_t, size_t begin, size_t end) {
+        for (size_t chunk = begin; chunk < end; chunk++) {
+            size_t i3 = starts[chunk] % n3;
+            size_t i2 = (starts[chunk] / n3) % n2;
+            size_t i1 = starts[chunk] / (n2 * n3);
+            size_t index = i1 + n1 * (i2 + n2 * i3);
+            for (auto value : chunks[chunk]) {
+                cube.values[index] = value;
+                index += n1 * n2;
+                if (++i3 == n3) {
+                    i3 = 0;
+                    if (++i2 == n2) {
+                        i2 = 0;
+                        ++i1;
+                    }
+                    index = i1 + n1 * i2;
+                }
+            }
+        }
+    });
+
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("bytes read", static_cast<double>(textSize));
+    return cube;
+}
+
+CubeFile::Cube CubeFile::read(const std::string& path, size_t nrThreads) {
+    auto file = filesystem::ifstream(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw Exception("Could not open cube file " + path, IVW_CONTEXT_CUSTOM("CubeFile"));
+    }
+    file.seekg(0, std::ios::end);
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(text.data(), static_cast<std::streamsize>(text.size()));
+    return parse(text, nrThreads);
+}
+
+CubeFile::Cube CubeFile::load(const std::string& path, bool useCache, size_t nrThreads) {
+    if (!useCache) return read(path, nrThreads);
+
+    const auto fileKey = key(path);
+    const auto cache = cachePath(path);
+    if (auto cube = readCache(cache, fileKey)) {
+        return std::move(*cube);
+    }
+    auto cube = read(path, nrThreads);
+    writeCache(cube, fileKey, cache);
+    return cube;
+}
+
+CubeFile::Key CubeFile::key(const std::string& path) {
+    std::error_code error;
+    const std::filesystem::path file{path};
+    Key key;
+    key.size = std::filesystem::file_size(file, error);
+    if (error) {
+        throw Exception("Could not open cube file " + path, IVW_CONTEXT_CUSTOM("CubeFile"));
+    }
+    key.modified = static_cast<int64_t>(
+        std::filesystem::last_write_time(file, error).time_since_epoch().count());
+
+    // Hash of the first and last part of the file, the header and the end of the data
+    auto stream = filesystem::ifstream(path, std::ios::in | std::ios::binary);
+    std::vector<char> buffer(static_cast<size_t>(std::min<uint64_t>(key.size, hashedBytes)));
+    stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    key.hash = fnv1a(buffer.data(), buffer.size(), 14695981039346656037ull);
+    stream.seekg(static_cast<std::streamoff>(key.size - buffer.size()), std::ios::beg);
+    stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    key.hash = fnv1a(buffer.data(), buffer.size(), key.hash);
+    if (!stream) {
+        throw Exception("Could not read cube file " + path, IVW_CONTEXT_CUSTOM("CubeFile"));
+    }
+    return key;
+}
+
+std::string CubeFile::cachePath(const std::string& path) { return path + ".ivwcube"; }
+
+bool CubeFile::writeCache(const Cube& cube, const Key& key, const std::string& cachePath) {
+    HotPathProfiler::ScopedTimer timer("CubeFile::writeCache");
+
+    CacheHeader header{};
+    std::copy(std::begin(cacheMagic), std::end(cacheMagic), header.magic);
+    header.version = cacheVersion;
+    header.byteOrder = cacheByteOrder;
+    header.fileSize = key.size;
+    header.fileModified = key.modified;
+    header.fileHash = key.hash;
+    for (size_t i = 0; i < 3; i++) {
+        header.dims[i] = cube.dims[i];
+        header.origin[i] = cube.origin[i];
+        for (size_t j = 0; j < 3; j++) header.basis[3 * i + j] = cube.basis[i][j];
+    }
+    header.angstrom = cube.angstrom ? 1 : 0;
+    header.nrAtoms = cube.atoms.size();
+    header.commentSize = cube.comment.size();
+    const auto atomsSize = cube.atoms.size() * 5 * sizeof(double);
+    header.valuesOffset = (sizeof(CacheHeader) + atomsSize + cube.comment.size() + 63) / 64 * 64;
+
+    std::vector<double> atoms;
+    atoms.reserve(5 * cube.atoms.size());
+    for (const auto& atom : cube.atoms) {
+        atoms.insert(atoms.end(), {static_cast<double>(atom.atomicNumber), atom.charge,
+                                   atom.position.x, atom.position.y, atom.position.z});
+    }
+    const std::string padding(header.valuesOffset - sizeof(CacheHeader) - atomsSize -
+                                  cube.comment.size(),
+                              '\0');
+    const auto nrVoxels = glm::compMul(cube.dims);
+
+    // Write to a temporary file and rename, so that a partially written cache is never read
+    const auto tmpPath = cachePath + ".tmp";
+    {
+        auto file = filesystem::ofstream(tmpPath, std::ios::out | std::ios::binary);
+        if (!file) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+        file.write(reinterpret_cast<const char*>(atoms.data()),
+                   static_cast<std::streamsize>(atomsSize));
+        file.write(cube.comment.data(), static_cast<std::streamsize>(cube.comment.size()));
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char*>(cube.values.get()),
+                   static_cast<std::streamsize>(nrVoxels * sizeof(float)));
+        if (!file) return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(tmpPath, cachePath, error);
+    if (error) {
+        std::filesystem::remove(tmpPath, error);
+        return false;
+    }
+
+    timer.count("bytes copied", static_cast<double>(header.valuesOffset + nrVoxels * 4));
+    return true;
+}
+
+std::optional<CubeFile::Cube> CubeFile::readCache(const std::string& cachePath, const Key& key) {
+    HotPathProfiler::ScopedTimer timer("CubeFile::readCache");
+
+    auto file = filesystem::ifstream(cachePath, std::ios::in | std::ios::binary);
+    if (!file) return std::nullopt;
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+    if (!file || !std::equal(std::begin(cacheMagic), std::end(cacheMagic), header.magic) ||
+        header.version != cacheVersion || header.byteOrder != cacheByteOrder ||
+        header.fileSize != key.size || header.fileModified != key.modified ||
+        header.fileHash != key.hash) {
+        return std::nullopt;
+    }
+
+    Cube cube;
+    for (size_t i = 0; i < 3; i++) {
+        cube.dims[i] = static_cast<size_t>(header.dims[i]);
+        cube.origin[i] = header.origin[i];
+        for (size_t j = 0; j < 3; j++) cube.basis[i][j] = header.basis[3 * i + j];
+    }
+    cube.angstrom = header.angstrom != 0;
+    const auto nrVoxels = glm::compMul(cube.dims);
+    std::error_code error;
+    if (std::filesystem::file_size(cachePath, error) != header.valuesOffset + nrVoxels * 4 ||
+        error) {
+        return std::nullopt;
+    }
+
+    std::vector<double> atoms(5 * header.nrAtoms);
+    file.read(reinterpret_cast<char*>(atoms.data()),
+              static_cast<std::streamsize>(atoms.size() * sizeof(double)));
+    cube.atoms.resize(header.nrAtoms);
+    for (size_t i = 0; i < cube.atoms.size(); i++) {
+        const auto* atom = &atoms[5 * i];
+        cube.atoms[i] = Atom{static_cast<int>(atom[0]), atom[1], dvec3(atom[2], atom[3], atom[4])};
+    }
+    cube.comment.resize(header.commentSize);
+    file.read(cube.comment.data(), static_cast<std::streamsize>(header.commentSize));
+
+    cube.values = std::unique_ptr<float[]>(new float[nrVoxels]);
+    file.seekg(static_cast<std::streamoff>(header.valuesOffset), std::ios::beg);
+    file.read(reinterpret_cast<char*>(cube.values.get()),
+              static_cast<std::streamsize>(nrVoxels * sizeof(float)));
+    if (!file) return std::nullopt;
+
+    timer.count("voxels", static_cast<double>(nrVoxels));
+    timer.count("bytes copied", static_cast<double>(nrVoxels * sizeof(float)));
+    return cube;
+}
+
+}  // namespace inviwo
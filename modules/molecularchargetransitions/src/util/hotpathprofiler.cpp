@@ -0,0 +1,149 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+#include <algorithm>
+
+namespace inviwo {
+
+HotPathProfiler::ScopedTimer::ScopedTimer(const char* name)
+    : profiler_{nullptr}, name_{name}, start_{} {
+    auto& profiler = HotPathProfiler::getInstance();
+    if (profiler.isEnabled()) {
+        profiler_ = &profiler;
+        start_ = Clock::now();
+    }
+}
+
+HotPathProfiler::ScopedTimer::~ScopedTimer() {
+    if (!profiler_) return;
+    profiler_->record(name_, start_, Clock::now(), std::move(counters_));
+}
+
+HotPathProfiler::HotPathProfiler()
+    : enabled_{false}, epoch_{Clock::now()}, maxEvents_{defaultMaxEvents}, droppedEvents_{0} {}
+
+HotPathProfiler& HotPathProfiler::getInstance() {
+    static HotPathProfiler profiler;
+    return profiler;
+}
+
+void HotPathProfiler::setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void HotPathProfiler::clear() {
+    std::scoped_lock lock{mutex_};
+    events_.clear();
+    threads_.clear();
+    droppedEvents_ = 0;
+    epoch_ = Clock::now();
+}
+
+size_t HotPathProfiler::getMaxEvents() const {
+    std::scoped_lock lock{mutex_};
+    return maxEvents_;
+}
+
+void HotPathProfiler::setMaxEvents(size_t maxEvents) {
+    std::scoped_lock lock{mutex_};
+    maxEvents_ = maxEvents;
+}
+
+size_t HotPathProfiler::getDroppedEvents() const {
+    std::scoped_lock lock{mutex_};
+    return droppedEvents_;
+}
+
+void HotPathProfiler::record(const char* name, Clock::time_point start, Clock::time_point end,
+                             std::vector<std::pair<std::string, double>> counters) {
+    std::scoped_lock lock{mutex_};
+    if (events_.size() >= maxEvents_) {
+        ++droppedEvents_;
+        return;
+    }
+    const auto thread = threads_.try_emplace(std::this_thread::get_id(), threads_.size());
+    events_.push_back(
+        Event{name, thread.first->second, start - epoch_, end - start, std::move(counters)});
+}
+
+std::vector<HotPathProfiler::Event> HotPathProfiler::getEvents() const {
+    std::scoped_lock lock{mutex_};
+    return events_;
+}
+
+std::vector<HotPathProfiler::Summary> HotPathProfiler::summarize() const {
+    std::scoped_lock lock{mutex_};
+
+    std::vector<Summary> summaries;
+    std::unordered_map<std::string, size_t> summaryIndex;
+    for (const auto& event : events_) {
+        const auto [it, inserted] = summaryIndex.try_emplace(event.name, summaries.size());
+        if (inserted) summaries.push_back(Summary{event.name, 0, Clock::duration{0}, {}});
+
+        auto& summary = summaries[it->second];
+        summary.calls++;
+        summary.total += event.duration;
+        for (const auto& [counter, value] : event.counters) {
+            auto c = std::find_if(summary.counters.begin(), summary.counters.end(),
+                                  [&](const auto& item) { return item.first == counter; });
+            if (c == summary.counters.end()) {
+                summary.counters.emplace_back(counter, value);
+            } else {
+                c->second += value;
+            }
+        }
+    }
+    return summaries;
+}
+
+nlohmann::json HotPathProfiler::toChromeTrace() const {
+    using us = std::chrono::duration<double, std::micro>;
+    std::scoped_lock lock{mutex_};
+
+    auto traceEvents = nlohmann::json::array();
+    for (const auto& event : events_) {
+        auto args = nlohmann::json::object();
+        for (const auto& [counter, value] : event.counters) {
+            args[counter] = value;
+        }
+        traceEvents.push_back({{"name", event.name},
+                               {"cat", "MolecularChargeTransitions"},
+                               {"ph", "X"},
+                               {"ts", us(event.start).count()},
+                               {"dur", us(event.duration).count()},
+                               {"pid", 0},
+                               {"tid", event.thread},
+                               {"args", args}});
+    }
+    return {{"traceEvents", traceEvents}, {"displayTimeUnit", "ms"}};
+}
+
+}  // namespace inviwo
@@ -0,0 +1,179 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/util/kllsketch.h>
+#include <inviwo/core/util/exception.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace inviwo {
+
+KllSketch::KllSketch(size_t k, uint64_t seed)
+    : k_{std::max<size_t>(k, 8)}
+    , state_{seed * 0x9E3779B97F4A7C15ull + 0x2545F4914F6CDD1Dull}
+    , min_{std::numeric_limits<float>::infinity()}
+    , max_{-std::numeric_limits<float>::infinity()}
+    , levels_(1) {
+    updateMaxSize();
+}
+
+size_t KllSketch::capacity(size_t level) const {
+    // Capacities shrink by 2/3 for each level below the top one
+    const auto depth = levels_.size() - 1 - level;
+    const auto c = static_cast<double>(k_) * std::pow(2.0 / 3.0, static_cast<double>(depth));
+    return std::max<size_t>(2, static_cast<size_t>(std::ceil(c)));
+}
+
+void KllSketch::updateMaxSize() {
+    maxSize_ = 0;
+    for (size_t h = 0; h < levels_.size(); h++) maxSize_ += capacity(h);
+}
+
+bool KllSketch::coin() {
+    // xorshift64
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 7;
+    state_ ^= state_ << 17;
+    return (state_ >> 32) & 1;
+}
+
+void KllSketch::add(float value) {
+    if (std::isnan(value)) return;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    levels_.front().push_back(value);
+    ++count_;
+    if (++size_ > maxSize_) compress();
+}
+
+void KllSketch::merge(const KllSketch& other) {
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+        updateMaxSize();
+    }
+    for (size_t h = 0; h < other.levels_.size(); h++) {
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+    }
+    count_ += other.count_;
+    size_ += other.size_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    compress();
+}
+
+void KllSketch::compress() {
+    while (size_ > maxSize_) {
+        for (size_t h = 0; h < levels_.size(); h++) {
+            if (levels_[h].size() < capacity(h)) continue;
+            if (h + 1 == levels_.size()) {
+                levels_.emplace_back();
+                updateMaxSize();
+            }
+            auto& level = levels_[h];
+            auto& next = levels_[h + 1];
+
+            // An odd value out stays, the others are halved into the next level
+            std::sort(level.begin(), level.end());
+            const auto pairs = level.size() / 2;
+            const auto odd = level.size() % 2 == 1;
+            const auto oddValue = odd ? level.back() : 0.0f;
+            const size_t offset = coin() ? 1 : 0;
+            for (size_t i = 0; i < pairs; i++) {
+                next.push_back(level[2 * i + offset]);
+            }
+            level.clear();
+            if (odd) level.push_back(oddValue);
+            size_ -= pairs;
+            break;
+        }
+    }
+}
+
+float KllSketch::quantile(double q) const { return quantiles({q}).front(); }
+
+std::vector<float> KllSketch::quantiles(const std::vector<double>& qs) const {
+    std::vector<float> result(qs.size(), std::numeric_limits<float>::quiet_NaN());
+    if (count_ == 0) return result;
+
+    std::vector<std::pair<float, size_t>> weighted;
+    weighted.reserve(size_);
+    for (size_t h = 0; h < levels_.size(); h++) {
+        for (const auto value : levels_[h]) weighted.emplace_back(value, size_t{1} << h);
+    }
+    std::sort(weighted.begin(), weighted.end());
+    const auto total = std::accumulate(weighted.begin(), weighted.end(), size_t{0},
+                                       [](size_t sum, const auto& w) { return sum + w.second; });
+
+    for (size_t i = 0; i < qs.size(); i++) {
+        const auto q = std::clamp(qs[i], 0.0, 1.0);
+        if (q <= 0.0) {
+            result[i] = min_;
+        } else if (q >= 1.0) {
+            result[i] = max_;
+        } else {
+            // Smallest value with more than q of the weight at or below it
+            const auto rank = q * static_cast<double>(total);
+            size_t cumulative = 0;
+            result[i] = weighted.back().first;
+            for (const auto& [value, weight] : weighted) {
+                cumulative += weight;
+                if (static_cast<double>(cumulative) > rank) {
+                    result[i] = value;
+                    break;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<KllSketch> KllSketch::mergeUp(std::vector<KllSketch> leaves,
+                                          const std::vector<size_t>& first,
+                                          const std::vector<size_t>& second) {
+    if (first.size() != second.size()) {
+        throw Exception("Unexpected dimension missmatch", IVW_CONTEXT_CUSTOM("KllSketch"));
+    }
+    auto nodes = std::move(leaves);
+    const auto nrLeaves = nodes.size();
+    nodes.reserve(nrLeaves + first.size());
+    for (size_t i = 0; i < first.size(); i++) {
+        if (first[i] >= nrLeaves + i || second[i] >= nrLeaves + i) {
+            throw Exception("Merge " + std::to_string(i) + " joins a node that does not exist yet",
+                            IVW_CONTEXT_CUSTOM("KllSketch"));
+        }
+        auto node = nodes[first[i]];
+        node.merge(nodes[second[i]]);
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+}  // namespace inviwo
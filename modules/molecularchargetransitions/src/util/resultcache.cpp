@@ -0,0 +1,80 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
+#include <inviwo/molecularchargetransitions/util/chargequantization.h>
+#include <inviwo/core/util/formatdispatching.h>
+
+namespace inviwo {
+
+namespace {
+
+uint64_t mix(uint64_t hash, uint64_t word) {
+    word *= 0xbf58476d1ce4e5b9ull;
+    word ^= word >> 31;
+    hash = (hash ^ word) * 0x94d049bb133111ebull;
+    return (hash << 27) | (hash >> 37);
+}
+
+}  // namespace
+
+InputHash& InputHash::add(const void* data, size_t size) {
+    const auto bytes = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash_ = mix(hash_, word);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, bytes + i, size - i);
+    hash_ = mix(hash_, tail ^ (static_cast<uint64_t>(size) << 56));
+    return *this;
+}
+
+InputHash& InputHash::add(std::string_view string) { return add(string.data(), string.size()); }
+
+InputHash& InputHash::add(const Column* column) {
+    if (column == nullptr) return add(uint64_t{0});
+
+    add(column->getHeader());
+    const auto buffer = column->getBuffer();
+    add(static_cast<int>(buffer->getDataFormat()->getId()));
+    if (const auto encoding = ChargeQuantization::encodingOf(*buffer)) {
+        add(static_cast<int>(encoding->format)).add(encoding->offset).add(encoding->scale);
+    }
+    buffer->getRepresentation<BufferRAM>()->dispatch<void, dispatching::filter::All>(
+        [&](auto buf) {
+            using ValueType = util::PrecisionValueType<decltype(buf)>;
+            const auto& values = buf->getDataContainer();
+            add(values.data(), values.size() * sizeof(ValueType));
+        });
+    return *this;
+}
+
+}  // namespace inviwo
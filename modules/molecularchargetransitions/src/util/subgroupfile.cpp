@@ -0,0 +1,73 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <inviwo/molecularchargetransitions/util/subgroupfile.h>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+#include <inviwo/core/util/exception.h>
+#include <inviwo/core/util/filesystem.h>
+
+namespace inviwo {
+
+std::vector<SubgroupFile::Subgroup> SubgroupFile::read(const std::string& path) {
+    HotPathProfiler::ScopedTimer timer("SubgroupFile::read");
+
+    nlohmann::json json;
+    auto fileStream = filesystem::ifstream(path);
+    fileStream >> json;
+    auto subgroups = fromJson(json);
+
+    timer.count("subgroups", static_cast<double>(subgroups.size()));
+    return subgroups;
+}
+
+std::vector<SubgroupFile::Subgroup> SubgroupFile::fromJson(const nlohmann::json& json) {
+    std::vector<Subgroup> subgroups;
+    for (auto& subgroup : json) {
+        if (!subgroup.contains("indices")) {
+            throw Exception("Wrong format on json object (does not contain 'indices')",
+                            IVW_CONTEXT_CUSTOM("SubgroupFile"));
+        }
+        if (!subgroup.contains("name")) {
+            throw Exception("Wrong format on json object (does not contain 'name')",
+                            IVW_CONTEXT_CUSTOM("SubgroupFile"));
+        }
+        subgroups.push_back(Subgroup{subgroup["name"].get<std::string>(),
+                                     subgroup["indices"].get<std::vector<size_t>>()});
+    }
+    return subgroups;
+}
+
+size_t SubgroupFile::nrRegions(const std::vector<Subgroup>& subgroups) {
+    size_t nrRegions = 0;
+    for (auto& subgroup : subgroups) {
+        nrRegions += subgroup.indices.size();
+    }
+    return nrRegions;
+}
+
+}  // namespace inviwo
@@ -0,0 +1,759 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <benchmark/benchmark.h>
+#include <warn/pop>
+
+#include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/algorithm/clustergrouping.h>
+#include <inviwo/molecularchargetransitions/algorithm/clustermedoids.h>
+#include <inviwo/molecularchargetransitions/algorithm/dendrogramindex.h>
+#include <inviwo/molecularchargetransitions/algorithm/densitywatershed.h>
+#include <inviwo/molecularchargetransitions/algorithm/groupedcolumnstatistics.h>
+#include <inviwo/molecularchargetransitions/algorithm/localitydescriptors.h>
+#include <inviwo/molecularchargetransitions/algorithm/minibatchkmeans.h>
+#include <inviwo/molecularchargetransitions/algorithm/nearestatomsegmentation.h>
+#include <inviwo/molecularchargetransitions/algorithm/progressiveregionsum.h>
+#include <inviwo/molecularchargetransitions/algorithm/regionadjacency.h>
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+#include <inviwo/molecularchargetransitions/algorithm/statistics.h>
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+#include <inviwo/molecularchargetransitions/util/cubefile.h>
+#include <inviwo/molecularchargetransitions/util/kllsketch.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace inviwo {
+
+namespace {
+
+SyntheticEnsemble::Settings benchmarkSettings() {
+    SyntheticEnsemble::Settings settings;
+    settings.seed = 0;
+    settings.nrClusters = 8;
+    return settings;
+}
+
+}  // namespace
+
+/**
+ * Charge transfer matrix for M members with n subgroups each.
+ * Arguments: n, M
+ */
+void chargeTransferMatrix(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto members = static_cast<size_t>(state.range(1));
+
+    auto settings = benchmarkSettings();
+    settings.nrRegions = n;
+    settings.nrSubgroups = n;
+    const SyntheticEnsemble ensemble(settings);
+    std::vector<std::vector<float>> holeCharges(members);
+    std::vector<std::vector<float>> particleCharges(members);
+    for (size_t m = 0; m < members; m++) {
+        std::tie(holeCharges[m], particleCharges[m]) = ensemble.charges(m);
+    }
+
+    for (auto _ : state) {
+        for (size_t m = 0; m < members; m++) {
+            auto res = ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+                holeCharges[m], particleCharges[m]);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * (2 * n + n * n + n) * sizeof(float));
+}
+BENCHMARK(chargeTransferMatrix)
+    ->ArgsProduct({{2, 6, 16, 64}, {1 << 10, 1 << 14}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Locality descriptors (measure of locality, transferred charge, donors and acceptors and charge
+ * transfer distances) for M members with n subgroups each, directly from the charge columns.
+ * Compare to chargeTransferMatrix, which only gives the matrices.
+ * Arguments: n, M
+ */
+void localityDescriptors(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto members = static_cast<size_t>(state.range(1));
+
+    auto settings = benchmarkSettings();
+    settings.nrRegions = n;
+    settings.nrSubgroups = n;
+    settings.nrMembers = members;
+    const auto table = SyntheticEnsemble(settings).table();
+    std::vector<const float*> hole;
+    std::vector<const float*> particle;
+    std::vector<dvec3> positions;
+    for (size_t i = 0; i < n; i++) {
+        hole.push_back(table.holeCharges[i].data());
+        particle.push_back(table.particleCharges[i].data());
+        positions.emplace_back(static_cast<double>(i), static_cast<double>(i % 3), 0.0);
+    }
+
+    for (auto _ : state) {
+        auto res = LocalityDescriptors::compute(hole, particle, members, positions);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * 2 * n * sizeof(float));
+}
+BENCHMARK(localityDescriptors)
+    ->ArgsProduct({{2, 6, 16, 64}, {1 << 10, 1 << 14, 1 << 18}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Optimal transport charge transfer for M members with n subgroups each, solved in parallel and
+ * warm started from the previous member. The last argument is 1 for warm starts and 0 for solving
+ * each member from scratch (one thread).
+ * Arguments: n, M, warm start
+ */
+void optimalTransportChargeTransfer(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+    const auto members = static_cast<size_t>(state.range(1));
+    const auto warmStart = state.range(2) != 0;
+
+    auto settings = benchmarkSettings();
+    settings.nrRegions = n;
+    settings.nrSubgroups = n;
+    settings.nrMembers = members;
+    const auto table = SyntheticEnsemble(settings).table();
+    std::vector<const float*> hole;
+    std::vector<const float*> particle;
+    for (size_t i = 0; i < n; i++) {
+        hole.push_back(table.holeCharges[i].data());
+        particle.push_back(table.particleCharges[i].data());
+    }
+    std::vector<double> cost(n * n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) cost[i * n + j] = std::abs(double(i) - double(j));
+    }
+    const ChargeTransferMatrix::TransportSettings transport;
+
+    for (auto _ : state) {
+        if (warmStart) {
+            auto res = ChargeTransferMatrix::computeEnsembleOptimalTransport(
+                hole, particle, members, cost, transport);
+            benchmark::DoNotOptimize(res);
+        } else {
+            std::vector<float> h(n);
+            std::vector<float> p(n);
+            for (size_t m = 0; m < members; m++) {
+                for (size_t i = 0; i < n; i++) {
+                    h[i] = hole[i][m];
+                    p[i] = particle[i][m];
+                }
+                auto res =
+                    ChargeTransferMatrix::computeTransposedOptimalTransport(h, p, cost, transport);
+                benchmark::DoNotOptimize(res);
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * (2 * n + n * n) * sizeof(float));
+}
+BENCHMARK(optimalTransportChargeTransfer)
+    ->ArgsProduct({{6, 16, 64}, {1 << 10, 1 << 14}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Mean and variance of a vector with n elements.
+ * Arguments: n
+ */
+void vectorStatistics(benchmark::State& state) {
+    const auto n = static_cast<size_t>(state.range(0));
+
+    SyntheticEnsemble::Random rnd(0);
+    std::vector<float> values(n);
+    std::generate(values.begin(), values.end(),
+                  [&]() { return static_cast<float>(2.0 * rnd.uniform() - 1.0); });
+
+    for (auto _ : state) {
+        const auto mean = VectorStatistics::meanValue(values);
+        const auto variance = VectorStatistics::variance(values, mean);
+        benchmark::DoNotOptimize(mean);
+        benchmark::DoNotOptimize(variance);
+    }
+    // Two passes over the data, one for the mean and one for the variance
+    state.SetItemsProcessed(state.iterations() * n);
+    state.SetBytesProcessed(state.iterations() * 2 * n * sizeof(float));
+}
+BENCHMARK(vectorStatistics)->RangeMultiplier(16)->Range(1 << 8, 1 << 24);
+
+/**
+ * Sum of a dim^3 charge density volume into the regions of a segmentation with the given number
+ * of labels, same as done in SumChargeInSegmentedRegions.
+ * Arguments: dim, nrLabels
+ */
+void segmentedRegionSum(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto nrLabels = static_cast<size_t>(state.range(1));
+    const auto nrVoxels = dim * dim * dim;
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrRegions = nrLabels;
+    settings.nrSubgroups = 1;
+    const SyntheticEnsemble ensemble(settings);
+    const auto labels = ensemble.labels();
+    const auto values = ensemble.density(0, SyntheticEnsemble::Charge::Hole);
+
+    for (auto _ : state) {
+        auto sums = SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), nrVoxels, 0,
+                                                     nrLabels);
+        benchmark::DoNotOptimize(sums);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() * nrVoxels * (sizeof(float) + sizeof(uint16_t)));
+}
+BENCHMARK(segmentedRegionSum)
+    ->ArgsProduct({{64, 128, 256, 512}, {2, 16, 128, 500}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Sum and spatial moments of a dim^3 charge density volume per region in a single pass, same as
+ * done in SumChargeInSegmentedRegions with spatial moments. Compare with segmentedRegionSum.
+ * Arguments: dim, nrLabels
+ */
+void segmentedRegionMoments(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto nrLabels = static_cast<size_t>(state.range(1));
+    const auto nrVoxels = dim * dim * dim;
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrRegions = nrLabels;
+    settings.nrSubgroups = 1;
+    const SyntheticEnsemble ensemble(settings);
+    const auto labels = ensemble.labels();
+    const auto values = ensemble.density(0, SyntheticEnsemble::Charge::Hole);
+    const dmat3 indexToWorld{dvec3{0.2, 0.0, 0.0}, dvec3{0.0, 0.2, 0.0}, dvec3{0.0, 0.0, 0.2}};
+
+    for (auto _ : state) {
+        auto moments = SegmentedRegionSum::momentsPerRegion(
+            values.data(), labels.data(), settings.dimensions, 0, nrLabels, indexToWorld,
+            dvec3{0.0, 0.0, 0.0});
+        benchmark::DoNotOptimize(moments);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() * nrVoxels * (sizeof(float) + sizeof(uint16_t)));
+}
+BENCHMARK(segmentedRegionMoments)
+    ->ArgsProduct({{64, 128, 256, 512}, {2, 16, 128, 500}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * First (coarse) estimate of the region sums of a dim^3 volume, as shown by
+ * SumChargeInSegmentedRegions in progressive mode. The label pyramid is built once.
+ * Arguments: dim, level
+ */
+void progressiveRegionSum(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto level = static_cast<size_t>(state.range(1));
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrRegions = 128;
+    settings.nrSubgroups = 1;
+    const SyntheticEnsemble ensemble(settings);
+    const auto labels = ensemble.labels();
+    const auto values = ensemble.density(0, SyntheticEnsemble::Charge::Hole);
+    const auto pyramid = ProgressiveRegionSum::buildLabelPyramid(
+        labels.data(), settings.dimensions, 0, settings.nrRegions, level);
+
+    for (auto _ : state) {
+        auto estimate = ProgressiveRegionSum::estimate(values.data(), pyramid, level);
+        benchmark::DoNotOptimize(estimate);
+    }
+    const auto nrBlocks = pyramid.levels.back().regions.size();
+    state.SetItemsProcessed(state.iterations() * nrBlocks);
+    state.SetBytesProcessed(state.iterations() * nrBlocks * (sizeof(float) + sizeof(uint16_t)));
+}
+BENCHMARK(progressiveRegionSum)
+    ->ArgsProduct({{128, 256, 512}, {1, 2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Charge transfer matrix from a dim^3 hole and particle density with the given number of labels,
+ * same as done in VoxelOverlapChargeTransfer (one pass over the volumes and the shared faces).
+ * Arguments: dim, nrLabels
+ */
+void voxelOverlapChargeTransfer(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto nrLabels = static_cast<size_t>(state.range(1));
+    const auto nrVoxels = dim * dim * dim;
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrRegions = nrLabels;
+    settings.nrSubgroups = 1;
+    const SyntheticEnsemble ensemble(settings);
+    const auto labels = ensemble.labels();
+    const auto hole = ensemble.density(0, SyntheticEnsemble::Charge::Hole);
+    const auto particle = ensemble.density(0, SyntheticEnsemble::Charge::Particle);
+
+    for (auto _ : state) {
+        const auto regions = ChargeTransferMatrix::accumulateRegionOverlap(
+            hole.data(), particle.data(), labels.data(), settings.dimensions, 0, nrLabels, true);
+        auto res = ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            regions, ChargeTransferMatrix::Coupling::Adjacent);
+        benchmark::DoNotOptimize(res);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() * nrVoxels *
+                            (2 * sizeof(float) + sizeof(uint16_t)));
+}
+BENCHMARK(voxelOverlapChargeTransfer)
+    ->ArgsProduct({{64, 128, 256}, {16, 128}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Region adjacency graph (shared faces and centroids) of a dim^3 segmentation with the given
+ * number of labels, same as done in RegionAdjacencyGraph.
+ * Arguments: dim, nrLabels
+ */
+void regionAdjacency(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto nrLabels = static_cast<size_t>(state.range(1));
+    const auto nrVoxels = dim * dim * dim;
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrRegions = nrLabels;
+    settings.nrSubgroups = 1;
+    const auto labels = SyntheticEnsemble(settings).labels();
+    const dmat3 basis{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+
+    for (auto _ : state) {
+        auto graph = RegionAdjacency::compute(labels.data(), settings.dimensions, 0, nrLabels,
+                                              basis, dvec3{0.0});
+        benchmark::DoNotOptimize(graph);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() * nrVoxels * sizeof(uint16_t));
+}
+BENCHMARK(regionAdjacency)
+    ->ArgsProduct({{64, 128, 256}, {16, 128}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Nearest atom segmentation of a dim^3 volume with the given number of atoms, randomly placed in
+ * the volume, same as done in AtomVoronoiSegmentation.
+ * Arguments: dim, nrAtoms
+ */
+void nearestAtomSegmentation(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto nrAtoms = static_cast<size_t>(state.range(1));
+    const auto nrVoxels = dim * dim * dim;
+
+    SyntheticEnsemble::Random rnd(0);
+    std::vector<dvec3> atoms(nrAtoms);
+    for (auto& atom : atoms) {
+        atom = dvec3(rnd.uniform(), rnd.uniform(), rnd.uniform()) * static_cast<double>(dim);
+    }
+    const dmat3 indexToWorld{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+
+    for (auto _ : state) {
+        auto labels = NearestAtomSegmentation::segment(size3_t{dim, dim, dim}, indexToWorld,
+                                                       dvec3{0.0, 0.0, 0.0}, atoms);
+        benchmark::DoNotOptimize(labels);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() * nrVoxels * sizeof(uint16_t));
+}
+BENCHMARK(nearestAtomSegmentation)
+    ->ArgsProduct({{64, 128, 256}, {50, 300}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Watershed segmentation of a dim^3 synthetic density with the given number of regions (one
+ * gaussian per region), same as done in DensityWatershedSegmentation.
+ * Arguments: dim, nrRegions
+ */
+void densityWatershed(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const auto nrRegions = static_cast<size_t>(state.range(1));
+    const auto nrVoxels = dim * dim * dim;
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrRegions = nrRegions;
+    settings.nrSubgroups = 1;
+    const auto density = SyntheticEnsemble(settings).density(0, SyntheticEnsemble::Charge::Hole);
+    const dmat3 indexToWorld{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+
+    for (auto _ : state) {
+        const auto basins =
+            DensityWatershed::segment(density.data(), settings.dimensions, indexToWorld);
+        auto labels = DensityWatershed::labels(basins);
+        benchmark::DoNotOptimize(labels);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() * nrVoxels * (sizeof(float) + sizeof(uint16_t)));
+}
+BENCHMARK(densityWatershed)
+    ->ArgsProduct({{64, 128, 256}, {16, 128}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Loading a dim^3 cube file of a synthetic density written as by Gaussian (%13.5E, six values per
+ * line), by parsing the text or from the binary cache, same as done in FastCubeSource.
+ * Arguments: dim, useCache
+ */
+void cubeFileLoad(benchmark::State& state) {
+    const auto dim = static_cast<size_t>(state.range(0));
+    const bool useCache = state.range(1) != 0;
+    const auto nrVoxels = dim * dim * dim;
+
+    auto settings = benchmarkSettings();
+    settings.dimensions = size3_t{dim, dim, dim};
+    settings.nrSubgroups = 1;
+    const auto density = SyntheticEnsemble(settings).density(0, SyntheticEnsemble::Charge::Hole);
+
+    const auto path =
+        (std::filesystem::temp_directory_path() / "molecularchargetransitions-benchmark.cube")
+            .string();
+    {
+        std::ofstream file(path);
+        file << " Benchmark\n Synthetic density\n    1    0.000000    0.000000    0.000000\n";
+        for (size_t i = 0; i < 3; i++) {
+            file << dim << (i == 0 ? "    0.200000    0.000000    0.000000\n"
+                                   : (i == 1 ? "    0.000000    0.200000    0.000000\n"
+                                             : "    0.000000    0.000000    0.200000\n"));
+        }
+        file << "    6    6.000000    0.000000    0.000000    0.000000\n";
+        char value[16];
+        for (size_t x = 0; x < dim; x++) {
+            for (size_t y = 0; y < dim; y++) {
+                for (size_t z = 0; z < dim; z++) {
+                    std::snprintf(value, sizeof(value), "%13.5E",
+                                  density[(z * dim + y) * dim + x]);
+                    file << value << (z % 6 == 5 || z + 1 == dim ? "\n" : "");
+                }
+            }
+        }
+    }
+    const auto fileSize = std::filesystem::file_size(path);
+    std::filesystem::remove(CubeFile::cachePath(path));
+    if (useCache) CubeFile::load(path);
+
+    for (auto _ : state) {
+        auto cube = CubeFile::load(path, useCache);
+        benchmark::DoNotOptimize(cube);
+    }
+    state.SetItemsProcessed(state.iterations() * nrVoxels);
+    state.SetBytesProcessed(state.iterations() *
+                            (useCache ? nrVoxels * sizeof(float) : fileSize));
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(CubeFile::cachePath(path));
+}
+BENCHMARK(cubeFileLoad)
+    ->ArgsProduct({{64, 128, 256}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Grouping of M ensemble members into clusters and computing the mean and variance of one charge
+ * column per cluster, same as done in ClusterStatistics.
+ * Arguments: M, nrClusters
+ */
+void clusterStatistics(benchmark::State& state) {
+    const auto members = static_cast<size_t>(state.range(0));
+    const auto nrClusters = static_cast<size_t>(state.range(1));
+
+    auto settings = benchmarkSettings();
+    settings.nrMembers = members;
+    settings.nrClusters = nrClusters;
+    const auto table = SyntheticEnsemble(settings).table();
+    const auto& clusters = table.cluster;
+    const auto& charges = table.holeCharges[0];
+    std::vector<uint32_t> indices(members);
+    std::iota(indices.begin(), indices.end(), 0);
+
+    for (auto _ : state) {
+        const auto clusterNrToIndex = ClusterGrouping::groupByCluster(clusters, indices);
+        for (auto&& c : clusterNrToIndex) {
+            std::vector<float> chargesForCluster = {};
+            for (auto&& ind : c.second) {
+                chargesForCluster.push_back(charges[ind]);
+            }
+            const auto mean = VectorStatistics::meanValue(chargesForCluster);
+            const auto variance = VectorStatistics::variance(chargesForCluster, mean);
+            benchmark::DoNotOptimize(mean);
+            benchmark::DoNotOptimize(variance);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members *
+                            (sizeof(int) + sizeof(uint32_t) + sizeof(float)));
+}
+BENCHMARK(clusterStatistics)
+    ->ArgsProduct({{1000, 10000, 100000, 1000000}, {8, 64}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Representative (medoid) of each cluster of M ensemble members, with the hole and particle
+ * charges of the subgroups as features, as done in ClusterRepresentatives. Mode 0 searches all
+ * clusters by brute force, mode 1 uses the trimmed search for clusters larger than 256 members.
+ * Arguments: M, nrClusters, mode
+ */
+void clusterMedoids(benchmark::State& state) {
+    const auto members = static_cast<size_t>(state.range(0));
+    const auto nrClusters = static_cast<size_t>(state.range(1));
+
+    auto settings = benchmarkSettings();
+    settings.nrMembers = members;
+    settings.nrClusters = nrClusters;
+    const auto table = SyntheticEnsemble(settings).table();
+    std::vector<const float*> features;
+    for (size_t i = 0; i < table.holeCharges.size(); i++) {
+        features.push_back(table.holeCharges[i].data());
+        features.push_back(table.particleCharges[i].data());
+    }
+    std::vector<uint32_t> indices(members);
+    std::iota(indices.begin(), indices.end(), 0);
+    const auto ranges = ClusterGrouping::groupRanges(table.cluster.data(), indices.data(), members);
+
+    ClusterMedoids::Settings medoidSettings;
+    if (state.range(2) == 0) medoidSettings.bruteForceSize = members;
+    for (auto _ : state) {
+        auto medoids = ClusterMedoids::compute(features, ranges, medoidSettings);
+        benchmark::DoNotOptimize(medoids);
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * features.size() * sizeof(float));
+}
+BENCHMARK(clusterMedoids)
+    ->ArgsProduct({{1000, 10000, 100000}, {8, 64}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Mean, median and 5/95% quantiles per cluster of the charge columns of M ensemble members, as
+ * done for the charge transfer columns in ClusterChargeTransferStatistics. Mode 1 selects the
+ * quantiles with nth_element (GroupedColumnStatistics), mode 0 sorts the values of every cluster.
+ * Arguments: M, nrClusters, mode
+ */
+void groupedColumnStatistics(benchmark::State& state) {
+    const auto members = static_cast<size_t>(state.range(0));
+    const auto nrClusters = static_cast<size_t>(state.range(1));
+    const auto select = state.range(2) != 0;
+
+    auto settings = benchmarkSettings();
+    settings.nrMembers = members;
+    settings.nrClusters = nrClusters;
+    const auto table = SyntheticEnsemble(settings).table();
+    std::vector<const float*> columns;
+    for (size_t i = 0; i < table.holeCharges.size(); i++) {
+        columns.push_back(table.holeCharges[i].data());
+        columns.push_back(table.particleCharges[i].data());
+    }
+    std::vector<uint32_t> indices(members);
+    std::iota(indices.begin(), indices.end(), 0);
+    const auto ranges = ClusterGrouping::groupRanges(table.cluster.data(), indices.data(), members);
+    const std::vector<double> quantiles{0.5, 0.05, 0.95};
+
+    for (auto _ : state) {
+        if (select) {
+            auto stats = GroupedColumnStatistics::compute(columns, ranges, quantiles);
+            benchmark::DoNotOptimize(stats);
+        } else {
+            std::vector<float> result;
+            for (const auto column : columns) {
+                for (size_t g = 0; g < ranges.size(); g++) {
+                    std::vector<float> values;
+                    for (auto m = ranges.begin(g); m != ranges.end(g); ++m) {
+                        values.push_back(column[*m]);
+                    }
+                    std::sort(values.begin(), values.end());
+                    for (const auto q : quantiles) {
+                        result.push_back(values[static_cast<size_t>(q * (values.size() - 1))]);
+                    }
+                }
+            }
+            benchmark::DoNotOptimize(result);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * columns.size() * sizeof(float));
+}
+BENCHMARK(groupedColumnStatistics)
+    ->ArgsProduct({{100000, 1000000}, {8, 64}, {0, 1}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Mini-batch k-means of M ensemble members into K micro-clusters, with the hole and particle
+ * charges of the subgroups as features, as done in MiniBatchClustering (200 batches of 4096).
+ * Arguments: M, K
+ */
+void miniBatchKMeans(benchmark::State& state) {
+    const auto members = static_cast<size_t>(state.range(0));
+
+    auto settings = benchmarkSettings();
+    settings.nrMembers = members;
+    const auto table = SyntheticEnsemble(settings).table();
+    std::vector<const float*> features;
+    for (size_t i = 0; i < table.holeCharges.size(); i++) {
+        features.push_back(table.holeCharges[i].data());
+        features.push_back(table.particleCharges[i].data());
+    }
+
+    MiniBatchKMeans::Settings kMeansSettings;
+    kMeansSettings.nrClusters = static_cast<size_t>(state.range(1));
+    for (auto _ : state) {
+        auto result = MiniBatchKMeans::compute(features, members, kMeansSettings);
+        benchmark::DoNotOptimize(result);
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * features.size() * sizeof(float));
+}
+BENCHMARK(miniBatchKMeans)
+    ->ArgsProduct({{100000, 1000000}, {64, 256}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+/**
+ * Quantile sketches of one charge column of M ensemble members per cluster, merged up a balanced
+ * tree of the clusters, and the median of every node, as done in ClusterStatistics with quantile
+ * sketches and a linkage.
+ * Arguments: M, nrClusters, k
+ */
+void quantileSketches(benchmark::State& state) {
+    const auto members = static_cast<size_t>(state.range(0));
+    const auto nrClusters = static_cast<size_t>(state.range(1));
+    const auto k = static_cast<size_t>(state.range(2));
+
+    auto settings = benchmarkSettings();
+    settings.nrMembers = members;
+    settings.nrClusters = nrClusters;
+    const auto table = SyntheticEnsemble(settings).table();
+    const auto& charges = table.holeCharges[0];
+    std::vector<size_t> first;
+    std::vector<size_t> second;
+    for (size_t node = 0; first.size() + 1 < nrClusters; node += 2) {
+        first.push_back(node);
+        second.push_back(node + 1);
+    }
+
+    for (auto _ : state) {
+        std::vector<KllSketch> leaves(nrClusters, KllSketch(k));
+        for (size_t m = 0; m < members; m++) {
+            leaves[static_cast<size_t>(table.cluster[m]) % nrClusters].add(charges[m]);
+        }
+        const auto nodes = KllSketch::mergeUp(std::move(leaves), first, second);
+        std::vector<float> medians;
+        for (const auto& node : nodes) medians.push_back(node.quantile(0.5));
+        benchmark::DoNotOptimize(medians);
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * sizeof(float));
+}
+BENCHMARK(quantileSketches)
+    ->ArgsProduct({{100000, 1000000}, {8, 64}, {200}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Cluster of every member of M members at one cut of a merge tree, from the DendrogramIndex as
+ * done in DendrogramCut (the index is built once), or (mode 0) with a union find over the merges
+ * below the cut as done when clustering again.
+ * Arguments: M, nrClusters, mode
+ */
+void dendrogramCut(benchmark::State& state) {
+    const auto members = static_cast<size_t>(state.range(0));
+    const auto nrClusters = static_cast<size_t>(state.range(1));
+    const auto useIndex = state.range(2) != 0;
+
+    // Random merges of the remaining clusters
+    SyntheticEnsemble::Random rnd(0);
+    std::vector<size_t> active(members);
+    std::iota(active.begin(), active.end(), size_t{0});
+    std::vector<size_t> first;
+    std::vector<size_t> second;
+    std::vector<double> heights;
+    for (size_t i = 0; i + 1 < members; i++) {
+        const auto a = static_cast<size_t>(rnd.uniform() * active.size());
+        first.push_back(active[a]);
+        active[a] = active.back();
+        active.pop_back();
+        const auto b = static_cast<size_t>(rnd.uniform() * active.size());
+        second.push_back(active[b]);
+        active[b] = members + i;
+        heights.push_back(static_cast<double>(i));
+    }
+    const DendrogramIndex index(first, second, heights);
+    const auto level = index.levelOfClusters(nrClusters);
+
+    for (auto _ : state) {
+        if (useIndex) {
+            auto labels = index.labels(level);
+            benchmark::DoNotOptimize(labels);
+        } else {
+            std::vector<size_t> parent(2 * members - 1);
+            std::iota(parent.begin(), parent.end(), size_t{0});
+            const auto find = [&](size_t node) {
+                while (parent[node] != node) node = parent[node] = parent[parent[node]];
+                return node;
+            };
+            for (size_t i = 0; i < level; i++) {
+                parent[find(first[i])] = members + i;
+                parent[find(second[i])] = members + i;
+            }
+            std::vector<size_t> labels(members);
+            for (size_t m = 0; m < members; m++) labels[m] = find(m);
+            benchmark::DoNotOptimize(labels);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * members);
+    state.SetBytesProcessed(state.iterations() * members * sizeof(int));
+}
+BENCHMARK(dendrogramCut)
+    ->ArgsProduct({{1 << 14, 1 << 18}, {8, 1024}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace inviwo
+
+BENCHMARK_MAIN();
@@ -0,0 +1,74 @@
+# Inviwo Python script testing the Python access to the outputs of ComputeChargeTransfer.
+# Run it in Inviwo, e.g. "inviwo --pythonScript computechargetransfer-test.py --quit", it raises
+# an AssertionError on failure.
+import inviwopy
+import inviwopy.qt
+import ivwmolecularchargetransitions as mct
+import os
+import tempfile
+
+app = inviwopy.app
+network = app.network
+
+nrSubgroups = 3
+subgroupFile = os.path.join(tempfile.mkdtemp(), "subgroups.json")
+
+# SyntheticEnsembleSource -> SumChargeInSegmentedRegions (hole, particle) -> ComputeChargeTransfer
+network.lock()
+network.clear()
+
+source = app.processorFactory.create("org.inviwo.SyntheticEnsembleSource")
+network.addProcessor(source)
+source.dimensions.value = inviwopy.glm.size3_t(16, 16, 16)
+source.nrSubgroups.value = nrSubgroups
+source.nrMembers.value = 10
+source.subgroupFile.value = subgroupFile
+
+chargeTransfer = app.processorFactory.create("org.inviwo.ComputeChargeTransfer")
+network.addProcessor(chargeTransfer)
+
+for density, inport in [("holeDensity", "holeCharges"), ("particleDensity", "particleCharges")]:
+    sumCharge = app.processorFactory.create("org.inviwo.SumChargeInSegmentedRegions")
+    network.addProcessor(sumCharge)
+    sumCharge.fileLocation.value = subgroupFile
+    network.addConnection(source.getOutport("segmentation"),
+                          sumCharge.getInport("volumeSegmentation"))
+    network.addConnection(source.getOutport(density), sumCharge.getInport("chargeDensity"))
+    network.addConnection(sumCharge.getOutport("chargePerSubgroup"),
+                          chargeTransfer.getInport(inport))
+
+network.unlock()
+inviwopy.qt.update()
+while network.runningBackgroundJobs > 0:
+    inviwopy.qt.update()
+
+# The outports are LazyDataOutports, which compute their data on the first getData()
+for identifier in ["chargeDifference", "chargeTransfer", "holeAndParticleCharges"]:
+    port = chargeTransfer.getOutport(identifier)
+    assert isinstance(port, mct.LazyDataFrameOutport), type(port)
+    assert port.isPending(), identifier + " was computed before it was read"
+    assert port.getData() is not None, identifier + " has no data"
+    assert not port.isPending(), identifier + " was not computed by getData()"
+
+# NumPy access through ivwmolecularchargetransitions, compared to the values read one at a time
+chargeDifference = chargeTransfer.getOutport("chargeDifference").getData()
+differences = mct.column(chargeDifference, "Charge difference")
+assert len(differences) == nrSubgroups, len(differences)
+assert not differences.flags.writeable
+assert [float(v) for v in differences] == [chargeDifference[1].get(i) for i in range(nrSubgroups)]
+
+charges = mct.columns(chargeTransfer.getOutport("holeAndParticleCharges").getData(), ["charges"])
+assert len(charges["charges"]) == 2 * nrSubgroups, len(charges["charges"])
+
+chargeTransferData = chargeTransfer.getOutport("chargeTransfer").getData()
+matrix = mct.chargeTransferMatrix(chargeTransferData)
+assert matrix.shape == (nrSubgroups, nrSubgroups), matrix.shape
+for k in range(nrSubgroups):
+    for l in range(nrSubgroups):
+        assert float(matrix[k, l]) == chargeTransferData[l + 1].get(k), (k, l)
+
+# The matrix redistributes the hole charge, so it sums to the total hole charge
+totalHoleCharge = float(charges["charges"][:nrSubgroups].sum())
+assert abs(float(matrix.sum()) - totalHoleCharge) < 1e-3 * max(1.0, totalHoleCharge)
+
+print("computechargetransfer-test passed")
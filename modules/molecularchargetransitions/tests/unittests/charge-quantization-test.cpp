@@ -0,0 +1,183 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <inviwo/molecularchargetransitions/util/chargequantization.h>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/dataframe/datastructures/column.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, ChargeQuantization_Half_RoundTripsWithinRelativeError) {
+    std::vector<float> values;
+    for (int i = -1000; i <= 1000; i++) values.push_back(static_cast<float>(i) * 0.001013f);
+    std::vector<uint16_t> codes(values.size());
+    std::vector<float> decoded(values.size());
+
+    ChargeQuantization::toHalf(values.data(), codes.data(), values.size());
+    ChargeQuantization::fromHalf(codes.data(), decoded.data(), values.size());
+
+    const auto bound = ChargeQuantization::maxError(
+        ChargeQuantization::encoding(ChargeQuantization::Format::Float16, -1.0, 1.0), -1.0, 1.0);
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_LE(std::abs(values[i] - decoded[i]), bound) << values[i];
+    }
+}
+
+TEST(MolecularChargeTransitions, ChargeQuantization_Half_KeepsSpecialValues) {
+    const std::vector<float> values{0.0f, -0.0f, 1.0f, 65504.0f, 1e6f,
+                                    std::numeric_limits<float>::infinity(), 0x1p-24f};
+    std::vector<uint16_t> codes(values.size());
+    std::vector<float> decoded(values.size());
+
+    ChargeQuantization::toHalf(values.data(), codes.data(), values.size());
+    ChargeQuantization::fromHalf(codes.data(), decoded.data(), values.size());
+
+    EXPECT_EQ(0x0000, codes[0]);
+    EXPECT_EQ(0x8000, codes[1]);
+    EXPECT_EQ(0x3c00, codes[2]);
+    EXPECT_EQ(65504.0f, decoded[3]);
+    EXPECT_TRUE(std::isinf(decoded[4]));
+    EXPECT_TRUE(std::isinf(decoded[5]));
+    EXPECT_EQ(0x1p-24f, decoded[6]);
+
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    uint16_t nanCode;
+    ChargeQuantization::toHalf(&nan, &nanCode, 1);
+    float nanDecoded;
+    ChargeQuantization::fromHalf(&nanCode, &nanDecoded, 1);
+    EXPECT_TRUE(std::isnan(nanDecoded));
+}
+
+TEST(MolecularChargeTransitions, ChargeQuantization_Fixed_ErrorWithinHalfStep) {
+    std::vector<float> values;
+    for (int i = 0; i <= 997; i++) values.push_back(-1.0f + 2.0f * static_cast<float>(i) / 997);
+    const auto encoding =
+        ChargeQuantization::encoding(ChargeQuantization::Format::Fixed8, -1.0, 1.0);
+    std::vector<uint8_t> codes(values.size());
+    std::vector<float> decoded(values.size());
+
+    ChargeQuantization::toFixed(values.data(), codes.data(), values.size(), encoding);
+    ChargeQuantization::fromFixed(codes.data(), decoded.data(), values.size(), encoding);
+
+    EXPECT_EQ(0, codes.front());
+    EXPECT_EQ(255, codes.back());
+    const auto bound = ChargeQuantization::maxError(encoding, -1.0, 1.0);
+    EXPECT_NEAR(1.0 / 255.0, bound, 1e-7);
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_LE(std::abs(values[i] - decoded[i]), bound) << values[i];
+    }
+}
+
+TEST(MolecularChargeTransitions, ChargeQuantization_Fixed16WideRange_ErrorWithinBound) {
+    // Values at the ends of the range and next to the midpoints between codes, where computing the
+    // codes in float rounded to the wrong code
+    const std::vector<std::pair<float, float>> ranges{
+        {-1000.0f, 1000.0f}, {0.5f, 4000.7f}, {-3e-3f, 7e-2f}, {-70000.0f, 12345.678f}};
+    for (const auto& [min, max] : ranges) {
+        const auto encoding =
+            ChargeQuantization::encoding(ChargeQuantization::Format::Fixed16, min, max);
+        std::vector<float> values{min, max, std::nextafter(min, max), std::nextafter(max, min)};
+        for (size_t k = 0; k < 65535; k++) {
+            for (const auto f : {0.5 - 1e-9, 0.5, 0.5 + 1e-9}) {
+                const auto value = static_cast<float>(min + (k + f) * encoding.scale);
+                if (value >= min && value <= max) values.push_back(value);
+            }
+        }
+        std::vector<uint16_t> codes(values.size());
+        std::vector<float> decoded(values.size());
+
+        ChargeQuantization::toFixed(values.data(), codes.data(), values.size(), encoding);
+        ChargeQuantization::fromFixed(codes.data(), decoded.data(), values.size(), encoding);
+
+        EXPECT_EQ(0, codes[0]);
+        EXPECT_EQ(65535, codes[1]);
+        EXPECT_EQ(min, decoded[0]);
+        const auto bound = ChargeQuantization::maxError(encoding, min, max);
+        for (size_t i = 0; i < values.size(); i++) {
+            ASSERT_LE(std::abs(static_cast<double>(values[i]) - decoded[i]), bound)
+                << values[i] << " in [" << min << ", " << max << "]";
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, ChargeQuantization_Fixed_ClampsOutOfRangeAndNaN) {
+    const std::vector<float> values{-2.0f, 2.0f, std::numeric_limits<float>::quiet_NaN(),
+                                    -std::numeric_limits<float>::infinity(),
+                                    std::numeric_limits<float>::infinity()};
+    const auto encoding =
+        ChargeQuantization::encoding(ChargeQuantization::Format::Fixed16, -1.0, 1.0);
+    std::vector<uint16_t> codes(values.size());
+
+    ChargeQuantization::toFixed(values.data(), codes.data(), values.size(), encoding);
+
+    EXPECT_EQ(0, codes[0]);
+    EXPECT_EQ(65535, codes[1]);
+    EXPECT_EQ(0, codes[2]);
+    EXPECT_EQ(0, codes[3]);
+    EXPECT_EQ(65535, codes[4]);
+}
+
+TEST(MolecularChargeTransitions, ChargeQuantization_Choose_SmallestFormatWithinBound) {
+    using Format = ChargeQuantization::Format;
+    EXPECT_EQ(Format::Fixed8, ChargeQuantization::choose(0.0, 1.0, 0.01).format);
+    EXPECT_EQ(Format::Fixed16, ChargeQuantization::choose(0.0, 1.0, 1e-4).format);
+    EXPECT_EQ(Format::Fixed16, ChargeQuantization::choose(0.0, 1e-3, 1e-6).format);
+    EXPECT_EQ(Format::Float32, ChargeQuantization::choose(0.0, 1.0, 1e-6).format);
+}
+
+TEST(MolecularChargeTransitions, ColumnView_QuantizedColumn_DecodesValues) {
+    const std::vector<float> values{0.0f, 0.25f, 0.5f, 1.0f};
+    const auto encoding =
+        ChargeQuantization::encoding(ChargeQuantization::Format::Fixed16, 0.0, 1.0);
+    std::vector<uint16_t> codes(values.size());
+    ChargeQuantization::toFixed(values.data(), codes.data(), values.size(), encoding);
+    auto column = std::make_shared<TemplateColumn<uint16_t>>("a", codes);
+    ChargeQuantization::setEncoding(*column->getTypedBuffer(), encoding);
+
+    ColumnViewCache cache;
+    const auto view = cache.get<double>(column);
+    const auto raw = cache.get<int>(column);
+
+    EXPECT_TRUE(view.isConverted());
+    ASSERT_TRUE(view.encoding());
+    for (size_t i = 0; i < values.size(); i++) {
+        EXPECT_NEAR(values[i], view[i], encoding.scale / 2);
+    }
+    EXPECT_FALSE(raw.encoding());
+    EXPECT_EQ(65535, raw[3]);
+}
+
+}  // namespace inviwo
@@ -162,4 +162,370 @@ TEST(MolecularChargeTransitions,
                      /*particleCharges*/ std::vector<float>{1.0f, 1.0f}),
                  inviwo::Exception);
 }
+
+namespace {
+
+// Three regions along x (labels 1, 2, 3), each with constant values along z
+ChargeTransferMatrix::RegionOverlap threeRegionOverlap(const std::vector<float>& holeCharges,
+                                                       const std::vector<float>& particleCharges,
+                                                       bool faces, size_t nrThreads) {
+    const size3_t dims{3, 1, 4};
+    std::vector<uint16_t> labels;
+    std::vector<float> hole;
+    std::vector<float> particle;
+    for (size_t z = 0; z < dims.z; z++) {
+        for (size_t x = 0; x < dims.x; x++) {
+            labels.push_back(static_cast<uint16_t>(x + 1));
+            hole.push_back(holeCharges[x] / dims.z);
+            particle.push_back(particleCharges[x] / dims.z);
+        }
+    }
+    return ChargeTransferMatrix::accumulateRegionOverlap(hole.data(), particle.data(),
+                                                         labels.data(), dims, 1, 3, faces,
+                                                         dvec2{1.0}, nrThreads);
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions,
+     ComputeTransposedChargeTransferFromOverlap_UniformRegions_SameAsSubgroupHeuristic) {
+    const auto holeCharges = std::vector<float>{0.5f, 0.2f, 0.3f};
+    const auto particleCharges = std::vector<float>{0.1f, 0.4f, 0.5f};
+    for (size_t nrThreads : {1, 2, 4}) {
+        const auto regions = threeRegionOverlap(holeCharges, particleCharges, false, nrThreads);
+        const auto [chargeTransfer, chargeDifference] =
+            ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+                regions, ChargeTransferMatrix::Coupling::Proportional);
+        checkChargeTransferAndChargeDifference(
+            chargeTransfer, chargeDifference,
+            /*expectedChargeTransfer*/
+            std::vector<std::vector<float>>{
+                {0.1f, 0.2f, 0.2f}, {0.0f, 0.2f, 0.0f}, {0.0f, 0.0f, 0.3f}},
+            /*expectedChargeDifference*/ std::vector<float>{-0.4f, 0.2f, 0.2f});
+    }
+}
+
+TEST(MolecularChargeTransitions,
+     ComputeTransposedChargeTransferFromOverlap_SeparatedDensities_TransfersFreeHoleCharge) {
+    // Hole and particle in different voxels of both regions, so nothing overlaps even though the
+    // regions have the same hole and particle charge
+    const std::vector<uint16_t> labels{0, 0, 1, 1};
+    const std::vector<float> hole{1.0f, 0.0f, 0.5f, 0.0f};
+    const std::vector<float> particle{0.0f, 1.0f, 0.0f, 0.5f};
+    const auto regions = ChargeTransferMatrix::accumulateRegionOverlap(
+        hole.data(), particle.data(), labels.data(), size3_t{4, 1, 1}, 0, 2, false);
+    EXPECT_FLOAT_EQ(0.0f, regions.overlap[0]);
+    EXPECT_FLOAT_EQ(0.0f, regions.overlap[1]);
+
+    // The subgroup heuristic keeps all charge in place, the hole charge of each region is
+    // distributed over all free particle charge instead
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            regions, ChargeTransferMatrix::Coupling::Proportional);
+    checkChargeTransferAndChargeDifference(
+        chargeTransfer, chargeDifference,
+        /*expectedChargeTransfer*/
+        std::vector<std::vector<float>>{{2.0f / 3.0f, 1.0f / 3.0f}, {1.0f / 3.0f, 1.0f / 6.0f}},
+        /*expectedChargeDifference*/ std::vector<float>{0.0f, 0.0f});
+}
+
+TEST(MolecularChargeTransitions,
+     ComputeTransposedChargeTransferFromOverlap_Adjacent_TransfersToNeighboursOnly) {
+    const auto regions = threeRegionOverlap({0.5f, 0.2f, 0.3f}, {0.1f, 0.4f, 0.5f}, true, 2);
+    // Region 1 and 2, and 2 and 3, share one face per z-slice
+    EXPECT_FLOAT_EQ(4.0f, regions.faces[0 * 3 + 1]);
+    EXPECT_FLOAT_EQ(0.0f, regions.faces[0 * 3 + 2]);
+    EXPECT_FLOAT_EQ(4.0f, regions.faces[2 * 3 + 1]);
+
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            regions, ChargeTransferMatrix::Coupling::Adjacent);
+    checkChargeTransferAndChargeDifference(
+        chargeTransfer, chargeDifference,
+        /*expectedChargeTransfer*/
+        std::vector<std::vector<float>>{
+            {0.1f, 0.4f, 0.0f}, {0.0f, 0.2f, 0.0f}, {0.0f, 0.0f, 0.3f}},
+        /*expectedChargeDifference*/ std::vector<float>{-0.4f, 0.2f, 0.2f});
+}
+
+TEST(MolecularChargeTransitions, GroupRegions_TwoGroups_SumsOverlapAndRemovesInnerFaces) {
+    // Hole and particle in different voxels of the same region do not overlap
+    const std::vector<uint16_t> labels{0, 0, 1, 2};
+    const std::vector<float> hole{1.0f, 0.0f, 0.5f, 0.0f};
+    const std::vector<float> particle{0.0f, 1.0f, 0.0f, 0.5f};
+    const auto regions = ChargeTransferMatrix::accumulateRegionOverlap(
+        hole.data(), particle.data(), labels.data(), size3_t{4, 1, 1}, 0, 3, true);
+    EXPECT_FLOAT_EQ(0.0f, regions.overlap[0]);
+
+    const auto grouped = ChargeTransferMatrix::groupRegions(regions, {{0}, {1, 2}});
+    ASSERT_EQ(2, grouped.nrRegions);
+    EXPECT_FLOAT_EQ(0.5f, grouped.hole[1]);
+    EXPECT_FLOAT_EQ(0.5f, grouped.particle[1]);
+    EXPECT_FLOAT_EQ(1.0f, grouped.faces[0 * 2 + 1]);
+    EXPECT_FLOAT_EQ(0.0f, grouped.faces[1 * 2 + 1]);
+
+    // Nothing overlaps, so the hole charge of each group is distributed over the free particle
+    // charge of the group and its neighbour
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            grouped, ChargeTransferMatrix::Coupling::Adjacent);
+    checkChargeTransferAndChargeDifference(
+        chargeTransfer, chargeDifference,
+        /*expectedChargeTransfer*/
+        std::vector<std::vector<float>>{{2.0f / 3.0f, 1.0f / 3.0f}, {1.0f / 3.0f, 1.0f / 6.0f}},
+        /*expectedChargeDifference*/ std::vector<float>{0.0f, 0.0f});
+}
+
+TEST(MolecularChargeTransitions,
+     ComputeTransposedChargeTransferFromOverlap_Adjacent_DoesNotReachDistantRegions) {
+    // Region 0 and 2 are not adjacent, region 0 has free hole charge and region 2 free particle
+    // charge, region 1 is in between and has only overlapping charge
+    const std::vector<uint16_t> labels{0, 0, 1, 2};
+    const std::vector<float> hole{1.0f, 0.0f, 0.5f, 0.0f};
+    const std::vector<float> particle{0.0f, 0.5f, 0.5f, 0.5f};
+    const auto regions = ChargeTransferMatrix::accumulateRegionOverlap(
+        hole.data(), particle.data(), labels.data(), size3_t{4, 1, 1}, 0, 3, true);
+
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            regions, ChargeTransferMatrix::Coupling::Adjacent);
+    // Region 0 only reaches its own free particle charge
+    checkChargeTransferAndChargeDifference(
+        chargeTransfer, chargeDifference,
+        /*expectedChargeTransfer*/
+        std::vector<std::vector<float>>{
+            {1.0f, 0.0f, 0.0f}, {0.0f, 0.5f, 0.0f}, {0.0f, 0.0f, 0.0f}},
+        /*expectedChargeDifference*/ std::vector<float>{-0.5f, 0.0f, 0.5f});
+}
+
+TEST(MolecularChargeTransitions, AccumulateRegionOverlap_Scale_NormalizesBeforeOverlap) {
+    // Hole charge 4 and particle charge 2 in total, scaled to one each
+    const std::vector<uint16_t> labels{0, 0, 1, 1};
+    const std::vector<float> hole{2.0f, 2.0f, 0.0f, 0.0f};
+    const std::vector<float> particle{1.0f, 0.0f, 0.0f, 1.0f};
+    const auto regions = ChargeTransferMatrix::accumulateRegionOverlap(
+        hole.data(), particle.data(), labels.data(), size3_t{4, 1, 1}, 0, 2, false,
+        dvec2{0.25, 0.5});
+
+    EXPECT_EQ((std::vector<float>{1.0f, 0.0f}), regions.hole);
+    EXPECT_EQ((std::vector<float>{0.5f, 0.5f}), regions.particle);
+    EXPECT_EQ((std::vector<float>{0.5f, 0.0f}), regions.overlap);
+
+    // Columns sum up to the hole and rows to the particle charges
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            regions, ChargeTransferMatrix::Coupling::Proportional);
+    checkChargeTransferAndChargeDifference(
+        chargeTransfer, chargeDifference,
+        /*expectedChargeTransfer*/
+        std::vector<std::vector<float>>{{0.5f, 0.5f}, {0.0f, 0.0f}},
+        /*expectedChargeDifference*/ std::vector<float>{-0.5f, 0.5f});
+}
+
+TEST(MolecularChargeTransitions, AccumulateRegionOverlap_LabelOutOfRange_ThrowsException) {
+    const std::vector<uint16_t> labels{0, 1, 5, 1};
+    const std::vector<float> values{1.0f, 1.0f, 1.0f, 1.0f};
+    EXPECT_THROW(ChargeTransferMatrix::accumulateRegionOverlap(
+                     values.data(), values.data(), labels.data(), size3_t{2, 1, 2}, 0, 2, false,
+                     dvec2{1.0}, 2),
+                 inviwo::Exception);
+}
+
+// Subgroups on a line with squared distance cost, moving the charge of 0 to 2 and of 1 to 3 is
+// cheaper (4 + 4) than 0 to 3 and 1 to 2 (9 + 1)
+std::vector<double> squaredDistanceCost(size_t n) {
+    std::vector<double> cost(n * n);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < n; j++) {
+            cost[i * n + j] = (double(i) - double(j)) * (double(i) - double(j));
+        }
+    }
+    return cost;
+}
+
+TEST(MolecularChargeTransitions, ComputeTransposedOptimalTransport_Line_MovesToCheapest) {
+    const std::vector<float> holeCharges{0.5f, 0.5f, 0.0f, 0.0f};
+    const std::vector<float> particleCharges{0.0f, 0.0f, 0.5f, 0.5f};
+    const auto [chargeTransfer, chargeDifference] =
+        ChargeTransferMatrix::computeTransposedOptimalTransport(
+            holeCharges, particleCharges, squaredDistanceCost(4), {});
+
+    EXPECT_NEAR(0.5f, chargeTransfer[0][2], 1e-4f);
+    EXPECT_NEAR(0.0f, chargeTransfer[0][3], 1e-4f);
+    EXPECT_NEAR(0.0f, chargeTransfer[1][2], 1e-4f);
+    EXPECT_NEAR(0.5f, chargeTransfer[1][3], 1e-4f);
+    EXPECT_FLOAT_EQ(0.5f, chargeDifference[2]);
+
+    // The heuristic spreads the charge of each donor over all acceptors instead
+    const auto heuristic =
+        ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+            holeCharges, particleCharges)
+            .first;
+    EXPECT_FLOAT_EQ(0.25f, heuristic[0][2]);
+    EXPECT_FLOAT_EQ(0.25f, heuristic[0][3]);
+}
+
+TEST(MolecularChargeTransitions, ComputeTransposedOptimalTransport_Unbalanced_ColumnsSumToHole) {
+    const std::vector<float> holeCharges{0.4f, 0.1f, 0.3f, 0.2f};
+    const std::vector<float> particleCharges{0.1f, 0.5f, 0.1f, 0.4f};
+    const auto chargeTransfer = ChargeTransferMatrix::computeTransposedOptimalTransport(
+                                    holeCharges, particleCharges, squaredDistanceCost(4), {})
+                                    .first;
+    for (size_t d = 0; d < 4; d++) {
+        float sum = 0.0f;
+        for (auto value : chargeTransfer[d]) sum += value;
+        EXPECT_NEAR(holeCharges[d], sum, 1e-5f);
+    }
+    // The acceptors get the donated charge in proportion to their charge difference
+    float accepted1 = 0.0f;
+    float accepted3 = 0.0f;
+    for (size_t d = 0; d < 4; d++) {
+        accepted1 += chargeTransfer[d][1];
+        accepted3 += chargeTransfer[d][3];
+    }
+    EXPECT_NEAR(0.4f / 0.2f, (accepted1 - 0.1f) / (accepted3 - 0.2f), 1e-3f);
+}
+
+TEST(MolecularChargeTransitions, ComputeTransposedOptimalTransport_WarmStart_FewerIterations) {
+    const std::vector<float> holeCharges{0.4f, 0.3f, 0.2f, 0.1f, 0.0f};
+    const std::vector<float> particleCharges{0.0f, 0.1f, 0.2f, 0.3f, 0.4f};
+    const auto cost = squaredDistanceCost(5);
+    ChargeTransferMatrix::TransportSettings settings;
+    settings.epsilon = 0.05;
+
+    ChargeTransferMatrix::TransportState state;
+    const auto cold = ChargeTransferMatrix::computeTransposedOptimalTransport(
+                          holeCharges, particleCharges, cost, settings, &state)
+                          .first;
+    const auto coldIterations = state.iterations;
+    EXPECT_GT(coldIterations, 1u);
+
+    const auto warm = ChargeTransferMatrix::computeTransposedOptimalTransport(
+                          holeCharges, particleCharges, cost, settings, &state)
+                          .first;
+    EXPECT_LT(state.iterations, coldIterations);
+    for (size_t d = 0; d < 5; d++) {
+        for (size_t a = 0; a < 5; a++) EXPECT_NEAR(cold[d][a], warm[d][a], 1e-5f);
+    }
+}
+
+TEST(MolecularChargeTransitions, ComputeEnsembleOptimalTransport_ThreeThreads_SameAsMembers) {
+    const size_t nrMembers = 7;
+    std::vector<std::vector<float>> hole(3, std::vector<float>(nrMembers));
+    std::vector<std::vector<float>> particle(3, std::vector<float>(nrMembers));
+    for (size_t m = 0; m < nrMembers; m++) {
+        const auto t = static_cast<float>(m) / nrMembers;
+        hole[0][m] = 0.6f - 0.3f * t;
+        hole[1][m] = 0.3f;
+        hole[2][m] = 0.1f + 0.3f * t;
+        particle[0][m] = 0.1f;
+        particle[1][m] = 0.2f + 0.4f * t;
+        particle[2][m] = 0.7f - 0.4f * t;
+    }
+    const auto cost = squaredDistanceCost(3);
+    const ChargeTransferMatrix::TransportSettings settings;
+    const auto transfer = ChargeTransferMatrix::computeEnsembleOptimalTransport(
+        {hole[0].data(), hole[1].data(), hole[2].data()},
+        {particle[0].data(), particle[1].data(), particle[2].data()}, nrMembers, cost, settings,
+        3);
+    ASSERT_EQ(9u, transfer.size());
+
+    for (size_t m = 0; m < nrMembers; m++) {
+        const auto member =
+            ChargeTransferMatrix::computeTransposedOptimalTransport(
+                {hole[0][m], hole[1][m], hole[2][m]},
+                {particle[0][m], particle[1][m], particle[2][m]}, cost, settings)
+                .first;
+        for (size_t d = 0; d < 3; d++) {
+            for (size_t a = 0; a < 3; a++) {
+                EXPECT_NEAR(member[d][a], transfer[d * 3 + a][m], 1e-5f);
+            }
+        }
+    }
+}
+
+
+namespace {
+
+// Members moving charge from subgroup 1 to subgroups 2 and 3, changing gradually over the members
+std::vector<std::vector<float>> gradualMembers(size_t nrMembers, bool particle) {
+    std::vector<std::vector<float>> charges(3, std::vector<float>(nrMembers));
+    for (size_t m = 0; m < nrMembers; m++) {
+        const auto t = static_cast<float>(m) / nrMembers;
+        if (particle) {
+            charges[0][m] = 0.1f;
+            charges[1][m] = 0.2f + 0.4f * t;
+            charges[2][m] = 0.7f - 0.4f * t;
+        } else {
+            charges[0][m] = 0.6f - 0.3f * t;
+            charges[1][m] = 0.3f;
+            charges[2][m] = 0.1f + 0.3f * t;
+        }
+    }
+    return charges;
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, ComputeEnsembleOptimalTransport_AnyThreadCount_BitIdentical) {
+    const size_t nrMembers = 50;
+    const auto hole = gradualMembers(nrMembers, false);
+    const auto particle = gradualMembers(nrMembers, true);
+    const auto cost = squaredDistanceCost(3);
+    // A loose tolerance, so that the warm starts change the result
+    ChargeTransferMatrix::TransportSettings settings;
+    settings.tolerance = 1e-2;
+    settings.warmStartBlockSize = 8;
+
+    const auto solve = [&](size_t nrThreads) {
+        return ChargeTransferMatrix::computeEnsembleOptimalTransport(
+            {hole[0].data(), hole[1].data(), hole[2].data()},
+            {particle[0].data(), particle[1].data(), particle[2].data()}, nrMembers, cost,
+            settings, nrThreads);
+    };
+    const auto expected = solve(1);
+    for (const size_t nrThreads : {2, 3, 7}) {
+        EXPECT_EQ(expected, solve(nrThreads)) << nrThreads << " threads";
+    }
+}
+
+TEST(MolecularChargeTransitions, ComputeEnsembleChargeTransfer_ThreeThreads_SameAsMembers) {
+    const size_t nrMembers = 7;
+    const auto hole = gradualMembers(nrMembers, false);
+    const auto particle = gradualMembers(nrMembers, true);
+    const auto transfer = ChargeTransferMatrix::computeEnsembleChargeTransfer(
+        {hole[0].data(), hole[1].data(), hole[2].data()},
+        {particle[0].data(), particle[1].data(), particle[2].data()}, nrMembers, 3);
+    ASSERT_EQ(9u, transfer.size());
+
+    for (size_t m = 0; m < nrMembers; m++) {
+        const auto member =
+            ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(
+                {hole[0][m], hole[1][m], hole[2][m]},
+                {particle[0][m], particle[1][m], particle[2][m]})
+                .first;
+        for (size_t d = 0; d < 3; d++) {
+            for (size_t a = 0; a < 3; a++) EXPECT_EQ(member[d][a], transfer[d * 3 + a][m]);
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, ComputeEnsembleChargeTransfer_NoDonors_OnlyDiagonal) {
+    // Member 0 moves charge from subgroup 0 to 1, member 1 has equal hole and particle charges
+    const std::vector<float> hole0{0.7f, 0.5f};
+    const std::vector<float> hole1{0.3f, 0.5f};
+    const std::vector<float> particle0{0.4f, 0.5f};
+    const std::vector<float> particle1{0.6f, 0.5f};
+    const auto transfer = ChargeTransferMatrix::computeEnsembleChargeTransfer(
+        {hole0.data(), hole1.data()}, {particle0.data(), particle1.data()}, 2, 2);
+    ASSERT_EQ(4u, transfer.size());
+
+    EXPECT_FLOAT_EQ(0.4f, transfer[0][0]);
+    EXPECT_FLOAT_EQ(0.3f, transfer[1][0]);
+    EXPECT_FLOAT_EQ(0.5f, transfer[0][1]);
+    EXPECT_FLOAT_EQ(0.0f, transfer[1][1]);
+    EXPECT_FLOAT_EQ(0.0f, transfer[2][1]);
+    EXPECT_FLOAT_EQ(0.5f, transfer[3][1]);
+}
+
 }  // namespace inviwo
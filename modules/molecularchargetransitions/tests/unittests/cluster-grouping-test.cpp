@@ -0,0 +1,74 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/clustergrouping.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, GroupByCluster_ThreeClusters_GroupsInInputOrder) {
+    const auto clusters = std::vector<int>{2, 1, 2, 3, 1};
+    const auto indices = std::vector<uint32_t>{0, 1, 2, 3, 4};
+    const auto groups = ClusterGrouping::groupByCluster(clusters, indices);
+
+    ASSERT_EQ(3, groups.size());
+    EXPECT_EQ((std::vector<uint32_t>{1, 4}), groups.at(1));
+    EXPECT_EQ((std::vector<uint32_t>{0, 2}), groups.at(2));
+    EXPECT_EQ((std::vector<uint32_t>{3}), groups.at(3));
+}
+
+TEST(MolecularChargeTransitions, GroupByCluster_DifferentSizes_ThrowsException) {
+    EXPECT_THROW(ClusterGrouping::groupByCluster(/*clusters*/ std::vector<int>{1, 2},
+                                                 /*indices*/ std::vector<uint32_t>{0}),
+                 inviwo::Exception);
+}
+
+TEST(MolecularChargeTransitions, GroupRanges_ThreeClusters_SameAsGroupByCluster) {
+    const auto clusters = std::vector<int>{2, -1, 2, 3, -1, 2};
+    const auto indices = std::vector<uint32_t>{10, 11, 12, 13, 14, 15};
+    const auto ranges =
+        ClusterGrouping::groupRanges(clusters.data(), indices.data(), clusters.size());
+    const auto groups = ClusterGrouping::groupByCluster(clusters, indices);
+
+    ASSERT_EQ(groups.size(), ranges.size());
+    EXPECT_EQ((std::vector<size_t>{0, 2, 5, 6}), ranges.offsets);
+    size_t c = 0;
+    for (const auto& group : groups) {
+        EXPECT_EQ(group.first, ranges.clusters[c]);
+        EXPECT_EQ(group.second, std::vector<uint32_t>(ranges.begin(c), ranges.end(c)));
+        c++;
+    }
+}
+
+}  // namespace inviwo
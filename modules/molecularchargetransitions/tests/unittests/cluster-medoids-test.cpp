@@ -0,0 +1,103 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <random>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/clustermedoids.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, ClusterMedoids_PointsOnALine_ReturnsMiddleMember) {
+    const auto x = std::vector<float>{0.0f, 10.0f, 1.0f, 2.0f, 3.0f, 5.0f, 7.0f};
+    const auto clusters = std::vector<int>{1, 2, 1, 1, 1, 2, 2};
+    const auto indices = std::vector<uint32_t>{0, 1, 2, 3, 4, 5, 6};
+    const auto ranges =
+        ClusterGrouping::groupRanges(clusters.data(), indices.data(), clusters.size());
+    const auto medoids = ClusterMedoids::compute({x.data()}, ranges, ClusterMedoids::Settings{});
+
+    ASSERT_EQ(2, medoids.size());
+    // Cluster 1 is {0, 1, 2, 3}, with two medoids, the first member is chosen
+    EXPECT_EQ(2, medoids[0].member);
+    EXPECT_DOUBLE_EQ(4.0 / 4.0, medoids[0].meanDistance);
+    // Cluster 2 is {10, 5, 7}
+    EXPECT_EQ(6, medoids[1].member);
+    EXPECT_DOUBLE_EQ(5.0 / 3.0, medoids[1].meanDistance);
+}
+
+TEST(MolecularChargeTransitions, ClusterMedoids_TrimmedSearch_SameAsBruteForce) {
+    const size_t k = 2000;
+    const size_t nrFeatures = 4;
+    std::mt19937 rand(5);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> points(k * nrFeatures);
+    for (auto& p : points) p = dist(rand);
+
+    ClusterMedoids::Settings bruteForce;
+    bruteForce.bruteForceSize = k;
+    const auto expected = ClusterMedoids::medoid(points, nrFeatures, k, bruteForce);
+    const auto trimmed = ClusterMedoids::medoid(points, nrFeatures, k, {});
+
+    EXPECT_EQ(expected.member, trimmed.member);
+    EXPECT_NEAR(expected.meanDistance, trimmed.meanDistance, 1e-9);
+    EXPECT_EQ(k, expected.candidates);
+    EXPECT_LT(trimmed.candidates, k / 2);
+}
+
+TEST(MolecularChargeTransitions, ClusterMedoids_AnyThreadCount_SameMedoids) {
+    const size_t n = 20000;
+    std::mt19937 rand(9);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> hole(n), particle(n);
+    std::vector<int> clusters(n);
+    std::vector<uint32_t> indices(n);
+    for (size_t i = 0; i < n; i++) {
+        clusters[i] = static_cast<int>((i * i) % 23);
+        hole[i] = dist(rand) + static_cast<float>(clusters[i]);
+        particle[i] = dist(rand);
+        indices[i] = static_cast<uint32_t>(i);
+    }
+    const auto ranges = ClusterGrouping::groupRanges(clusters.data(), indices.data(), n);
+
+    const std::vector<const float*> features{hole.data(), particle.data()};
+    const auto expected = ClusterMedoids::compute(features, ranges, {}, 1);
+    for (const size_t nrThreads : {2, 5}) {
+        const auto medoids = ClusterMedoids::compute(features, ranges, {}, nrThreads);
+        ASSERT_EQ(expected.size(), medoids.size());
+        for (size_t c = 0; c < medoids.size(); c++) {
+            EXPECT_EQ(expected[c].member, medoids[c].member);
+            EXPECT_EQ(clusters[medoids[c].member], ranges.clusters[c]);
+        }
+    }
+}
+
+}  // namespace inviwo
@@ -0,0 +1,69 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <vector>
+#include <inviwo/molecularchargetransitions/util/columnaccess.h>
+#include <inviwo/dataframe/datastructures/column.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, ColumnView_SameType_RefersToColumnData) {
+    auto column = std::make_shared<TemplateColumn<float>>("a", std::vector<float>{1.f, 2.f, 3.f});
+    const ColumnView<float> view(column);
+
+    EXPECT_FALSE(view.isConverted());
+    ASSERT_EQ(3, view.size());
+    EXPECT_EQ(column->getTypedBuffer()->getRAMRepresentation()->getDataContainer().data(),
+              view.data());
+}
+
+TEST(MolecularChargeTransitions, ColumnView_OtherType_ConvertsValues) {
+    auto column = std::make_shared<TemplateColumn<double>>("a", std::vector<double>{1.5, -2.0});
+    const ColumnView<float> view(column);
+
+    EXPECT_TRUE(view.isConverted());
+    EXPECT_EQ((std::vector<float>{1.5f, -2.0f}), std::vector<float>(view.begin(), view.end()));
+}
+
+TEST(MolecularChargeTransitions, ColumnViewCache_SameBuffer_SharesConvertedData) {
+    auto column = std::make_shared<TemplateColumn<int>>("a", std::vector<int>{4, 5, 6});
+    ColumnViewCache cache;
+
+    const auto first = cache.get<float>(column);
+    const auto second = cache.get<float>(column);
+
+    EXPECT_TRUE(first.isConverted());
+    EXPECT_EQ(first.data(), second.data());
+    EXPECT_FLOAT_EQ(6.0f, second[2]);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,146 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <inviwo/molecularchargetransitions/util/cubefile.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+namespace {
+
+// Cube with value 100 * i1 + 10 * i2 + i3 at voxel (i1, i2, i3), six values per line
+std::string cubeText(size_t n1, size_t n2, size_t n3, const std::string& atomsLine = "-2") {
+    std::ostringstream text;
+    text << " Test cube\n Electron density\n";
+    text << atomsLine << "   -1.000000   -2.000000    0.500000\n";
+    text << n1 << "    0.200000    0.000000    0.000000\n";
+    text << n2 << "    0.000000    0.300000    0.000000\n";
+    text << n3 << "    0.000000    0.000000    0.400000\n";
+    text << "    8    8.000000    0.000000    0.000000    0.220000\n";
+    text << "    1    1.000000    0.000000    1.430000   -0.880000\n";
+    text << "    1 0\n";
+    for (size_t i1 = 0; i1 < n1; i1++) {
+        for (size_t i2 = 0; i2 < n2; i2++) {
+            for (size_t i3 = 0; i3 < n3; i3++) {
+                text << " " << std::scientific << static_cast<double>(100 * i1 + 10 * i2 + i3);
+                if (i3 % 6 == 5 || i3 + 1 == n3) text << "\n";
+            }
+        }
+    }
+    return text.str();
+}
+
+void expectValues(const CubeFile::Cube& cube) {
+    for (size_t z = 0; z < cube.dims.z; z++) {
+        for (size_t y = 0; y < cube.dims.y; y++) {
+            for (size_t x = 0; x < cube.dims.x; x++) {
+                ASSERT_FLOAT_EQ(static_cast<float>(100 * x + 10 * y + z),
+                                cube.values[(z * cube.dims.y + y) * cube.dims.x + x]);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, CubeFile_Parse_ReadsHeaderAndReordersValues) {
+    const auto cube = CubeFile::parse(cubeText(2, 3, 7), 1);
+
+    EXPECT_EQ(" Test cube\n Electron density", cube.comment);
+    EXPECT_EQ(size3_t(2, 3, 7), cube.dims);
+    EXPECT_EQ(dvec3(-1.0, -2.0, 0.5), cube.origin);
+    EXPECT_EQ(dvec3(0.2, 0.0, 0.0), cube.basis[0]);
+    EXPECT_EQ(dvec3(0.0, 0.0, 0.4), cube.basis[2]);
+    EXPECT_FALSE(cube.angstrom);
+    ASSERT_EQ(2, cube.atoms.size());
+    EXPECT_EQ(8, cube.atoms[0].atomicNumber);
+    EXPECT_EQ(1.0, cube.atoms[1].charge);
+    EXPECT_EQ(dvec3(0.0, 1.43, -0.88), cube.atoms[1].position);
+    expectValues(cube);
+}
+
+TEST(MolecularChargeTransitions, CubeFile_ParseInChunks_SameValues) {
+    const auto text = cubeText(11, 13, 23);
+    ASSERT_GT(text.size(), 8 * 4096);
+    for (size_t nrThreads : {1, 3, 8}) {
+        expectValues(CubeFile::parse(text, nrThreads));
+    }
+}
+
+TEST(MolecularChargeTransitions, CubeFile_InvalidData_ThrowsException) {
+    auto missing = cubeText(2, 2, 8);
+    missing.resize(missing.rfind("7.0"));
+    EXPECT_THROW(CubeFile::parse(missing), inviwo::Exception);
+
+    auto invalid = cubeText(2, 2, 8);
+    invalid.replace(invalid.rfind("7.0"), 1, "x");
+    EXPECT_THROW(CubeFile::parse(invalid), inviwo::Exception);
+
+    EXPECT_THROW(CubeFile::parse(cubeText(2, 2, 2, "2")), inviwo::Exception);
+    EXPECT_THROW(CubeFile::parse(" Test cube\n"), inviwo::Exception);
+}
+
+TEST(MolecularChargeTransitions, CubeFile_Load_WritesAndUsesCache) {
+    const auto path =
+        (std::filesystem::temp_directory_path() / "molecularchargetransitions-test.cube").string();
+    const auto cachePath = CubeFile::cachePath(path);
+    std::filesystem::remove(cachePath);
+    std::ofstream(path) << cubeText(4, 3, 5);
+
+    const auto parsed = CubeFile::load(path);
+    ASSERT_TRUE(std::filesystem::exists(cachePath));
+    const auto cached = CubeFile::readCache(cachePath, CubeFile::key(path));
+    ASSERT_TRUE(cached.has_value());
+    EXPECT_EQ(parsed.comment, cached->comment);
+    EXPECT_EQ(parsed.dims, cached->dims);
+    EXPECT_EQ(parsed.origin, cached->origin);
+    EXPECT_EQ(parsed.basis[1], cached->basis[1]);
+    ASSERT_EQ(parsed.atoms.size(), cached->atoms.size());
+    EXPECT_EQ(parsed.atoms[1].position, cached->atoms[1].position);
+    expectValues(*cached);
+
+    // Changing the file invalidates the cache
+    std::ofstream(path) << cubeText(4, 3, 6);
+    EXPECT_FALSE(CubeFile::readCache(cachePath, CubeFile::key(path)).has_value());
+    EXPECT_EQ(size3_t(4, 3, 6), CubeFile::load(path).dims);
+    EXPECT_EQ(size3_t(4, 3, 6), CubeFile::readCache(cachePath, CubeFile::key(path))->dims);
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(cachePath);
+}
+
+}  // namespace inviwo
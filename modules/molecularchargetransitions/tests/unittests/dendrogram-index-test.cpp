@@ -0,0 +1,116 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <numeric>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/dendrogramindex.h>
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, DendrogramIndex_FiveMembers_ClustersAtAllLevels) {
+    // ((0, 3), ((1, 4), 2)): merges 5 = (0, 3), 6 = (1, 4), 7 = (6, 2), 8 = (5, 7)
+    const DendrogramIndex index({0, 1, 6, 5}, {3, 4, 2, 7}, {0.5, 1.0, 2.0, 4.0});
+
+    EXPECT_EQ(8u, index.root());
+    EXPECT_EQ((std::vector<size_t>{0, 3, 1, 4, 2}), index.leafOrder());
+    EXPECT_EQ((std::pair<size_t, size_t>{2, 5}), index.leafRange(7));
+
+    EXPECT_EQ(0u, index.level(0.1));
+    EXPECT_EQ(2u, index.level(1.0));
+    EXPECT_EQ(4u, index.level(10.0));
+    EXPECT_EQ(2u, index.levelOfClusters(3));
+
+    EXPECT_EQ(4u, index.cluster(4, 0));
+    EXPECT_EQ(6u, index.cluster(4, 2));
+    EXPECT_EQ(7u, index.cluster(4, 3));
+    EXPECT_EQ(8u, index.cluster(4, 4));
+    EXPECT_EQ(2u, index.cluster(2, 2));
+    EXPECT_EQ(5u, index.cluster(3, 3));
+
+    EXPECT_EQ((std::vector<size_t>{5, 6, 2}), index.clusters(2));
+    EXPECT_EQ((std::vector<int>{1, 2, 3, 1, 2}), index.labels(2));
+    EXPECT_EQ((std::vector<int>{1, 1, 1, 1, 1}), index.labels(4));
+}
+
+TEST(MolecularChargeTransitions, DendrogramIndex_RandomLinkage_SameAsUnionFind) {
+    // Random merges of the remaining clusters, compared to the clusters of a union find at each
+    // level
+    const size_t n = 300;
+    SyntheticEnsemble::Random rnd(3);
+    std::vector<size_t> active(n);
+    std::iota(active.begin(), active.end(), size_t{0});
+    std::vector<size_t> first;
+    std::vector<size_t> second;
+    std::vector<double> heights;
+    for (size_t i = 0; i + 1 < n; i++) {
+        const auto a = static_cast<size_t>(rnd.uniform() * active.size());
+        const auto nodeA = active[a];
+        active.erase(active.begin() + a);
+        const auto b = static_cast<size_t>(rnd.uniform() * active.size());
+        first.push_back(nodeA);
+        second.push_back(active[b]);
+        active[b] = n + i;
+        heights.push_back(static_cast<double>(i));
+    }
+    const DendrogramIndex index(first, second, heights);
+
+    std::vector<size_t> clusterOf(n);
+    std::iota(clusterOf.begin(), clusterOf.end(), size_t{0});
+    for (size_t level = 0; level < n; level++) {
+        if (level > 0) {
+            // Members of both children now belong to node n + level - 1
+            for (auto& c : clusterOf) {
+                if (c == first[level - 1] || c == second[level - 1]) c = n + level - 1;
+            }
+        }
+        for (size_t m = 0; m < n; m++) {
+            ASSERT_EQ(clusterOf[m], index.cluster(m, level));
+        }
+        const auto clusters = index.clusters(level);
+        EXPECT_EQ(n - level, clusters.size());
+        for (auto c : clusters) {
+            const auto [begin, end] = index.leafRange(c);
+            for (auto i = begin; i < end; i++) {
+                EXPECT_EQ(c, clusterOf[index.leafOrder()[i]]);
+            }
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, DendrogramIndex_NodeMergedTwice_ThrowsException) {
+    EXPECT_THROW(DendrogramIndex({0, 0}, {1, 2}, {1.0, 2.0}), inviwo::Exception);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,135 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/densitywatershed.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+namespace {
+
+const dmat3 identity{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+
+// Sum of Gaussians centered at the given voxel positions
+std::vector<float> gaussians(size3_t dims, const std::vector<dvec3>& centers) {
+    std::vector<float> density(glm::compMul(dims), 0.0f);
+    for (size_t z = 0; z < dims.z; z++) {
+        for (size_t y = 0; y < dims.y; y++) {
+            for (size_t x = 0; x < dims.x; x++) {
+                const dvec3 p{static_cast<double>(x), static_cast<double>(y),
+                              static_cast<double>(z)};
+                for (const auto& c : centers) {
+                    const auto d = p - c;
+                    density[(z * dims.y + y) * dims.x + x] +=
+                        static_cast<float>(std::exp(-0.1 * glm::dot(d, d)));
+                }
+            }
+        }
+    }
+    return density;
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, DensityWatershed_TwoGaussians_SplitsBetweenMaxima) {
+    const size3_t dims{17, 9, 9};
+    const auto density = gaussians(dims, {dvec3{4.0, 4.0, 4.0}, dvec3{12.0, 4.0, 4.0}});
+    const auto basins = DensityWatershed::segment(density.data(), dims, identity, 3);
+
+    ASSERT_EQ(2, basins.maxima.size());
+    EXPECT_EQ((4 * 9 + 4) * 17 + 4, basins.maxima[0]);
+    EXPECT_EQ((4 * 9 + 4) * 17 + 12, basins.maxima[1]);
+    for (size_t i = 0; i < basins.labels.size(); i++) {
+        const auto x = i % dims.x;
+        // The ties in the middle plane ascend towards the larger index
+        EXPECT_EQ(x < 8 ? 0u : 1u, basins.labels[i]) << "x = " << x;
+    }
+}
+
+TEST(MolecularChargeTransitions, DensityWatershed_Threads_SameAsSequentialAscent) {
+    const size3_t dims{12, 10, 23};
+    std::vector<double> density(glm::compMul(dims));
+    for (size_t i = 0; i < density.size(); i++) {
+        const auto x = static_cast<double>(i % dims.x);
+        const auto y = static_cast<double>((i / dims.x) % dims.y);
+        const auto z = static_cast<double>(i / (dims.x * dims.y));
+        density[i] = std::sin(0.9 * x) * std::cos(0.7 * y) + std::sin(0.5 * z + 0.3 * x);
+    }
+    const dmat3 basis{dvec3{0.5, 0.0, 0.0}, dvec3{0.1, 0.4, 0.0}, dvec3{0.0, 0.0, 0.3}};
+
+    const auto parent = DensityWatershed::ascentPointers(density.data(), dims, basis, 1);
+    const auto sequential = DensityWatershed::segment(density.data(), dims, basis, 1);
+    for (size_t nrThreads : {2, 5, 23}) {
+        const auto basins = DensityWatershed::segment(density.data(), dims, basis, nrThreads);
+        EXPECT_EQ(sequential.maxima, basins.maxima);
+        EXPECT_EQ(sequential.labels, basins.labels);
+    }
+    for (size_t v = 0; v < parent.size(); v++) {
+        auto root = v;
+        while (parent[root] != root) root = parent[root];
+        ASSERT_EQ(root, sequential.maxima[sequential.labels[v]]);
+    }
+}
+
+TEST(MolecularChargeTransitions, DensityWatershed_Constant_SingleBasin) {
+    const size3_t dims{5, 4, 6};
+    const std::vector<float> density(glm::compMul(dims), 1.0f);
+    const auto basins = DensityWatershed::segment(density.data(), dims, identity, 4);
+
+    EXPECT_EQ(std::vector<size_t>{glm::compMul(dims) - 1}, basins.maxima);
+    EXPECT_EQ(std::vector<uint32_t>(glm::compMul(dims), 0u), basins.labels);
+}
+
+TEST(MolecularChargeTransitions, DensityWatershed_NearestAtoms_LabelsBasinsByAtom) {
+    const size3_t dims{17, 9, 9};
+    const auto density = gaussians(dims, {dvec3{4.0, 4.0, 4.0}, dvec3{12.0, 4.0, 4.0}});
+    const auto basins = DensityWatershed::segment(density.data(), dims, identity);
+
+    // Atoms in world space, the volume is offset by one unit in x
+    const std::vector<dvec3> atoms{dvec3{13.2, 4.0, 4.0}, dvec3{30.0, 0.0, 0.0},
+                                   dvec3{5.0, 4.1, 3.9}};
+    const auto basinAtoms =
+        DensityWatershed::nearestAtoms(basins, dims, identity, dvec3{1.0, 0.0, 0.0}, atoms);
+    EXPECT_EQ((std::vector<uint16_t>{2, 0}), basinAtoms);
+
+    const auto labels = DensityWatershed::labels(basins, basinAtoms);
+    for (size_t i = 0; i < labels.size(); i++) {
+        EXPECT_EQ(i % dims.x < 8 ? 2 : 0, labels[i]);
+    }
+    EXPECT_THROW(DensityWatershed::nearestAtoms(basins, dims, identity, dvec3{}, {}),
+                 inviwo::Exception);
+    EXPECT_THROW(DensityWatershed::labels(basins, {0}), inviwo::Exception);
+}
+
+}  // namespace inviwo
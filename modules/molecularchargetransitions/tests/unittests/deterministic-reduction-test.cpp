@@ -0,0 +1,184 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <inviwo/molecularchargetransitions/util/deterministicreduction.h>
+#include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+
+namespace inviwo {
+
+namespace {
+
+const std::vector<size_t> threadCounts{1, 2, 3, 7, 16};
+
+// Values spanning many orders of magnitude, so that the order of the additions matters
+std::vector<float> mixedMagnitudes(size_t n) {
+    std::mt19937 rand(17);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> values(n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = dist(rand) * std::pow(10.0f, static_cast<float>(i % 9) - 4.0f);
+    }
+    return values;
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, CompensatedSum_CancellingTerms_KeepsSmallTerm) {
+    util::CompensatedSum sum;
+    sum.add(1e16);
+    sum.add(1.0);
+    sum.add(-1e16);
+
+    EXPECT_EQ(1.0, sum.value());
+}
+
+TEST(MolecularChargeTransitions, DeterministicReduce_AnyThreadCount_BitIdentical) {
+    const auto values = mixedMagnitudes(100003);
+    const auto reduce = [&](size_t nrThreads) {
+        return util::deterministicReduce(
+            values.size(), 1000, 0.0,
+            [&](size_t, size_t begin, size_t end) {
+                double sum = 0.0;
+                for (size_t i = begin; i < end; i++) sum += values[i];
+                return sum;
+            },
+            [](double& a, double b) { a += b; }, nrThreads);
+    };
+
+    const auto expected = reduce(1);
+    for (const auto nrThreads : threadCounts) {
+        EXPECT_EQ(expected, reduce(nrThreads)) << nrThreads << " threads";
+    }
+    EXPECT_EQ(0.0, util::deterministicReduce(
+                       0, 1000, 0.0, [](size_t, size_t, size_t) { return 1.0; },
+                       [](double& a, double b) { a += b; }, 4));
+}
+
+TEST(MolecularChargeTransitions, DeterministicReduce_AnyThreadCount_SamePairwiseTree) {
+    // The merges as a string, e.g. ((0 1) 2), compared to merging all blocks level by level
+    const auto merge = [](std::string& a, const std::string& b) { a = "(" + a + " " + b + ")"; };
+    for (size_t nrBlocks = 1; nrBlocks <= 70; nrBlocks++) {
+        std::vector<std::string> levels;
+        for (size_t b = 0; b < nrBlocks; b++) levels.push_back(std::to_string(b));
+        for (size_t stride = 1; stride < nrBlocks; stride *= 2) {
+            for (size_t b = 0; b + stride < nrBlocks; b += 2 * stride) {
+                merge(levels[b], levels[b + stride]);
+            }
+        }
+
+        for (const auto nrThreads : threadCounts) {
+            const auto tree = util::deterministicReduce(
+                3 * nrBlocks - 1, 3, std::string{},
+                [](size_t, size_t begin, size_t) { return std::to_string(begin / 3); }, merge,
+                nrThreads);
+            EXPECT_EQ(levels.front(), tree) << nrBlocks << " blocks, " << nrThreads << " threads";
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, SumPerRegion_AnyThreadCount_BitIdentical) {
+    const size_t nrVoxels = 300007;
+    const auto values = mixedMagnitudes(nrVoxels);
+    std::vector<uint16_t> labels(nrVoxels);
+    for (size_t i = 0; i < nrVoxels; i++) labels[i] = static_cast<uint16_t>((i / 37) % 5);
+
+    const auto expected = SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), nrVoxels,
+                                                           /*firstLabel*/ 0, /*nrRegions*/ 5, 1);
+    for (const auto nrThreads : threadCounts) {
+        const auto sums = SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), nrVoxels,
+                                                           0, 5, nrThreads);
+        ASSERT_EQ(expected.size(), sums.size());
+        for (size_t r = 0; r < sums.size(); r++) {
+            EXPECT_EQ(expected[r], sums[r]) << nrThreads << " threads, region " << r;
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, MomentsPerRegion_AnyThreadCount_BitIdentical) {
+    const size3_t dims{50, 40, 90};
+    const auto nrVoxels = dims.x * dims.y * dims.z;
+    const auto values = mixedMagnitudes(nrVoxels);
+    std::vector<uint16_t> labels(nrVoxels);
+    for (size_t i = 0; i < nrVoxels; i++) labels[i] = static_cast<uint16_t>((i / 37) % 5);
+    const dmat3 basis{dvec3{0.5, 0.1, 0.0}, dvec3{0.0, 0.4, 0.2}, dvec3{-0.1, 0.0, 0.3}};
+    const dvec3 offset{1.0, -2.0, 0.5};
+
+    // The charges are the same as without the moments
+    const auto sums = SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), nrVoxels,
+                                                       /*firstLabel*/ 0, /*nrRegions*/ 5, 1);
+    const auto expected = SegmentedRegionSum::momentsPerRegion(
+        values.data(), labels.data(), dims, 0, 5, basis, offset, {}, 1);
+    for (size_t r = 0; r < sums.size(); r++) {
+        EXPECT_EQ(sums[r], static_cast<float>(expected[r].charge)) << "region " << r;
+    }
+    for (const auto nrThreads : threadCounts) {
+        const auto moments = SegmentedRegionSum::momentsPerRegion(
+            values.data(), labels.data(), dims, 0, 5, basis, offset, {}, nrThreads);
+        ASSERT_EQ(expected.size(), moments.size());
+        for (size_t r = 0; r < moments.size(); r++) {
+            EXPECT_EQ(expected[r].charge, moments[r].charge) << nrThreads << " threads";
+            EXPECT_EQ(expected[r].first, moments[r].first) << nrThreads << " threads";
+            EXPECT_EQ(expected[r].second, moments[r].second) << nrThreads << " threads";
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, AccumulateRegionOverlap_AnyThreadCount_BitIdentical) {
+    const size3_t dims{40, 40, 70};
+    const auto nrVoxels = dims.x * dims.y * dims.z;
+    const auto hole = mixedMagnitudes(nrVoxels);
+    auto particle = mixedMagnitudes(nrVoxels + 5);
+    particle.erase(particle.begin(), particle.begin() + 5);
+    std::vector<uint8_t> labels(nrVoxels);
+    for (size_t i = 0; i < nrVoxels; i++) {
+        labels[i] = static_cast<uint8_t>((i % dims.x) / 10 + 4 * ((i / dims.x / dims.y) / 35));
+    }
+
+    const auto expected = ChargeTransferMatrix::accumulateRegionOverlap(
+        hole.data(), particle.data(), labels.data(), dims, 0, 8, true, dvec2{1.0}, 1);
+    for (const auto nrThreads : threadCounts) {
+        const auto result = ChargeTransferMatrix::accumulateRegionOverlap(
+            hole.data(), particle.data(), labels.data(), dims, 0, 8, true, dvec2{1.0}, nrThreads);
+        EXPECT_EQ(expected.hole, result.hole) << nrThreads << " threads";
+        EXPECT_EQ(expected.particle, result.particle) << nrThreads << " threads";
+        EXPECT_EQ(expected.overlap, result.overlap) << nrThreads << " threads";
+        EXPECT_EQ(expected.faces, result.faces) << nrThreads << " threads";
+    }
+}
+
+}  // namespace inviwo
@@ -0,0 +1,128 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/groupedcolumnstatistics.h>
+
+namespace inviwo {
+
+namespace {
+
+// Quantile of sorted values with linear interpolation, as numpy.quantile
+double sortedQuantile(const std::vector<float>& sorted, double q) {
+    const auto h = q * static_cast<double>(sorted.size() - 1);
+    const auto lo = static_cast<size_t>(std::floor(h));
+    const auto hi = std::min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (h - static_cast<double>(lo)) * (sorted[hi] - sorted[lo]);
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, GroupedQuantiles_FiveValues_InterpolatesOrderStatistics) {
+    auto values = std::vector<float>{5.0f, 1.0f, 4.0f, 2.0f, 3.0f};
+    const auto q = GroupedColumnStatistics::quantiles(values, {0.5, 0.0, 1.0, 0.05, 0.95});
+
+    ASSERT_EQ(5, q.size());
+    EXPECT_FLOAT_EQ(3.0f, q[0]);
+    EXPECT_FLOAT_EQ(1.0f, q[1]);
+    EXPECT_FLOAT_EQ(5.0f, q[2]);
+    EXPECT_FLOAT_EQ(1.2f, q[3]);
+    EXPECT_FLOAT_EQ(4.8f, q[4]);
+}
+
+TEST(MolecularChargeTransitions, GroupedQuantiles_RandomValues_SameAsSorting) {
+    std::mt19937 rand(11);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    const std::vector<double> quantiles{0.95, 0.05, 0.5, 0.5, 0.25, 0.999};
+    for (const size_t k : {1, 2, 3, 10, 101, 1000}) {
+        std::vector<float> values(k);
+        for (auto& v : values) v = dist(rand);
+        auto sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+
+        const auto q = GroupedColumnStatistics::quantiles(values, quantiles);
+        for (size_t i = 0; i < quantiles.size(); i++) {
+            EXPECT_NEAR(sortedQuantile(sorted, quantiles[i]), q[i], 1e-6) << k << " values";
+        }
+    }
+    std::vector<float> empty;
+    EXPECT_TRUE(std::isnan(GroupedColumnStatistics::quantiles(empty, {0.5})[0]));
+}
+
+TEST(MolecularChargeTransitions, GroupedColumnStatistics_TwoClusters_StatisticsPerCluster) {
+    const auto clusters = std::vector<int>{7, 3, 7, 7, 3};
+    const auto indices = std::vector<uint32_t>{0, 1, 2, 3, 4};
+    const auto a = std::vector<float>{1.0f, 10.0f, 2.0f, 6.0f, 20.0f};
+    const auto b = std::vector<float>{0.0f, -1.0f, 0.0f, 3.0f, -3.0f};
+    const auto ranges =
+        ClusterGrouping::groupRanges(clusters.data(), indices.data(), clusters.size());
+    const auto stats = GroupedColumnStatistics::compute({a.data(), b.data()}, ranges, {0.5});
+
+    ASSERT_EQ(2, stats.nrGroups);
+    ASSERT_EQ(2, stats.nrColumns);
+    // Cluster 3 (members 1, 4), then cluster 7 (members 0, 2, 3)
+    EXPECT_EQ((std::vector<float>{15.0f, -2.0f, 3.0f, 1.0f}), stats.mean);
+    EXPECT_EQ((std::vector<float>{15.0f, -2.0f, 2.0f, 0.0f}), stats.quantiles[0]);
+}
+
+TEST(MolecularChargeTransitions, GroupedColumnStatistics_AnyThreadCount_SameResult) {
+    const size_t n = 10000;
+    std::mt19937 rand(2);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<std::vector<float>> values(9, std::vector<float>(n));
+    for (auto& column : values) {
+        for (auto& v : column) v = dist(rand);
+    }
+    std::vector<int> clusters(n);
+    std::vector<uint32_t> indices(n);
+    for (size_t i = 0; i < n; i++) {
+        clusters[i] = static_cast<int>((i * 7) % 13);
+        indices[i] = static_cast<uint32_t>(i);
+    }
+    const auto ranges = ClusterGrouping::groupRanges(clusters.data(), indices.data(), n);
+    std::vector<const float*> columns;
+    for (const auto& column : values) columns.push_back(column.data());
+
+    const std::vector<double> quantiles{0.05, 0.5, 0.95};
+    const auto expected = GroupedColumnStatistics::compute(columns, ranges, quantiles, 1);
+    for (const size_t nrThreads : {2, 4, 16}) {
+        const auto stats = GroupedColumnStatistics::compute(columns, ranges, quantiles, nrThreads);
+        EXPECT_EQ(expected.mean, stats.mean);
+        EXPECT_EQ(expected.quantiles, stats.quantiles);
+    }
+}
+
+}  // namespace inviwo
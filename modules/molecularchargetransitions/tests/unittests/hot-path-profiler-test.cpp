@@ -0,0 +1,112 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <inviwo/molecularchargetransitions/util/hotpathprofiler.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, HotPathProfiler_Disabled_RecordsNothing) {
+    auto& profiler = HotPathProfiler::getInstance();
+    profiler.setEnabled(false);
+    profiler.clear();
+    {
+        HotPathProfiler::ScopedTimer timer("disabled");
+        timer.count("voxels", 10.0);
+    }
+    EXPECT_TRUE(profiler.getEvents().empty());
+}
+
+TEST(MolecularChargeTransitions, HotPathProfiler_Enabled_SummarizesPerScope) {
+    auto& profiler = HotPathProfiler::getInstance();
+    profiler.setEnabled(true);
+    profiler.clear();
+    for (int i = 0; i < 3; i++) {
+        HotPathProfiler::ScopedTimer timer("scope");
+        timer.count("voxels", 10.0);
+    }
+    {
+        HotPathProfiler::ScopedTimer timer("other");
+    }
+    profiler.setEnabled(false);
+
+    const auto summaries = profiler.summarize();
+    ASSERT_EQ(2, summaries.size());
+    EXPECT_EQ("scope", summaries[0].name);
+    EXPECT_EQ(3, summaries[0].calls);
+    ASSERT_EQ(1, summaries[0].counters.size());
+    EXPECT_EQ("voxels", summaries[0].counters[0].first);
+    EXPECT_DOUBLE_EQ(30.0, summaries[0].counters[0].second);
+    EXPECT_EQ("other", summaries[1].name);
+    EXPECT_EQ(1, summaries[1].calls);
+}
+
+TEST(MolecularChargeTransitions, HotPathProfiler_ChromeTrace_ContainsCompleteEvents) {
+    auto& profiler = HotPathProfiler::getInstance();
+    profiler.setEnabled(true);
+    profiler.clear();
+    {
+        HotPathProfiler::ScopedTimer timer("scope");
+        timer.count("rows", 5.0);
+    }
+    profiler.setEnabled(false);
+
+    const auto trace = profiler.toChromeTrace();
+    ASSERT_EQ(1, trace["traceEvents"].size());
+    const auto& event = trace["traceEvents"][0];
+    EXPECT_EQ("scope", event["name"].get<std::string>());
+    EXPECT_EQ("X", event["ph"].get<std::string>());
+    EXPECT_DOUBLE_EQ(5.0, event["args"]["rows"].get<double>());
+    EXPECT_GE(event["dur"].get<double>(), 0.0);
+    profiler.clear();
+}
+
+TEST(MolecularChargeTransitions, HotPathProfiler_MaxEvents_DropsLaterEvents) {
+    auto& profiler = HotPathProfiler::getInstance();
+    profiler.setEnabled(true);
+    profiler.clear();
+    profiler.setMaxEvents(2);
+    for (int i = 0; i < 5; i++) {
+        HotPathProfiler::ScopedTimer timer("scope");
+    }
+    profiler.setEnabled(false);
+
+    EXPECT_EQ(2, profiler.getEvents().size());
+    EXPECT_EQ(3, profiler.getDroppedEvents());
+    EXPECT_EQ(2, profiler.summarize()[0].calls);
+
+    profiler.clear();
+    profiler.setMaxEvents(HotPathProfiler::defaultMaxEvents);
+    EXPECT_EQ(0, profiler.getDroppedEvents());
+}
+
+}  // namespace inviwo
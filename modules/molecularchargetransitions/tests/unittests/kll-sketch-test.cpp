@@ -0,0 +1,114 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <inviwo/molecularchargetransitions/util/kllsketch.h>
+
+namespace inviwo {
+
+namespace {
+
+// Fraction of values below value
+double rank(const std::vector<float>& sorted, float value) {
+    return static_cast<double>(std::lower_bound(sorted.begin(), sorted.end(), value) -
+                               sorted.begin()) /
+           static_cast<double>(sorted.size());
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, KllSketch_FewValues_ExactQuantiles) {
+    KllSketch sketch;
+    for (const auto v : {4.0f, 1.0f, 3.0f, 2.0f, 5.0f}) sketch.add(v);
+
+    EXPECT_EQ(5, sketch.count());
+    EXPECT_EQ(5, sketch.size());
+    EXPECT_FLOAT_EQ(1.0f, sketch.quantile(0.0));
+    EXPECT_FLOAT_EQ(3.0f, sketch.quantile(0.5));
+    EXPECT_FLOAT_EQ(5.0f, sketch.quantile(1.0));
+    EXPECT_TRUE(std::isnan(KllSketch{}.quantile(0.5)));
+}
+
+TEST(MolecularChargeTransitions, KllSketch_ManyValues_BoundedSizeAndRankError) {
+    std::mt19937 rand(1);
+    std::normal_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> values(200000);
+    for (auto& v : values) v = dist(rand);
+    KllSketch sketch(200);
+    for (const auto v : values) sketch.add(v);
+    std::sort(values.begin(), values.end());
+
+    EXPECT_EQ(values.size(), sketch.count());
+    EXPECT_LT(sketch.size(), 3 * 200);
+    for (const auto q : {0.01, 0.05, 0.25, 0.5, 0.75, 0.95, 0.99}) {
+        EXPECT_NEAR(q, rank(values, sketch.quantile(q)), 0.02) << "quantile " << q;
+    }
+}
+
+TEST(MolecularChargeTransitions, KllSketch_MergedSketches_SameAccuracyAsOneStream) {
+    std::mt19937 rand(4);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::vector<float> all;
+    std::vector<KllSketch> leaves;
+    for (size_t leaf = 0; leaf < 8; leaf++) {
+        KllSketch sketch(200, leaf);
+        // Leaves with different ranges, so that the merged distribution differs from each
+        for (size_t i = 0; i < 20000; i++) {
+            const auto v = dist(rand) + static_cast<float>(leaf);
+            sketch.add(v);
+            all.push_back(v);
+        }
+        leaves.push_back(sketch);
+    }
+    // ((0 1) (2 3)) and ((4 5) (6 7)), the root is node 14
+    const std::vector<size_t> first{0, 2, 8, 4, 6, 11, 10};
+    const std::vector<size_t> second{1, 3, 9, 5, 7, 12, 13};
+    const auto nodes = KllSketch::mergeUp(leaves, first, second);
+    std::sort(all.begin(), all.end());
+
+    ASSERT_EQ(15, nodes.size());
+    EXPECT_EQ(all.size(), nodes[14].count());
+    EXPECT_EQ(4 * 20000, nodes[10].count());
+    EXPECT_LT(nodes[14].size(), 3 * 200);
+    EXPECT_FLOAT_EQ(all.front(), nodes[14].min());
+    EXPECT_FLOAT_EQ(all.back(), nodes[14].max());
+    for (const auto q : {0.05, 0.5, 0.95}) {
+        EXPECT_NEAR(q, rank(all, nodes[14].quantile(q)), 0.02) << "quantile " << q;
+        EXPECT_NEAR(4.0 * q, nodes[10].quantile(q), 0.08) << "quantile " << q;
+    }
+}
+
+}  // namespace inviwo
@@ -0,0 +1,93 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <vector>
+#include <inviwo/molecularchargetransitions/ports/lazydataoutport.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, LazyDataOutport_Generator_CalledOnceOnRead) {
+    LazyDataOutport<std::vector<int>> outport("outport");
+    size_t calls = 0;
+    outport.setGenerator([&calls]() {
+        ++calls;
+        return std::make_shared<const std::vector<int>>(3, 7);
+    });
+
+    EXPECT_TRUE(outport.hasData());
+    EXPECT_TRUE(outport.isReady());
+    EXPECT_TRUE(outport.isPending());
+    EXPECT_EQ(0, calls);
+
+    const auto first = outport.getData();
+    const auto second = outport.getData();
+    EXPECT_EQ(1, calls);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ((std::vector<int>{7, 7, 7}), *first);
+    EXPECT_FALSE(outport.isPending());
+}
+
+TEST(MolecularChargeTransitions, LazyDataOutport_SetDataOrClear_DropsGenerator) {
+    LazyDataOutport<std::vector<int>> outport("outport");
+    size_t calls = 0;
+    const auto generator = [&calls]() {
+        ++calls;
+        return std::make_shared<const std::vector<int>>(1, 1);
+    };
+
+    outport.setGenerator(generator);
+    outport.setData(std::make_shared<const std::vector<int>>(1, 2));
+    EXPECT_EQ(2, outport.getData()->front());
+
+    outport.setGenerator(generator);
+    outport.clear();
+    EXPECT_FALSE(outport.hasData());
+    EXPECT_EQ(nullptr, outport.getData());
+    EXPECT_EQ(0, calls);
+}
+
+TEST(MolecularChargeTransitions, LazyDataOutport_Memoize_SharesDataBetweenOutports) {
+    LazyDataOutport<std::vector<int>> first("first");
+    LazyDataOutport<std::vector<int>> second("second");
+    size_t calls = 0;
+    const auto generator = LazyDataOutport<std::vector<int>>::memoize([&calls]() {
+        ++calls;
+        return std::make_shared<const std::vector<int>>(2, 5);
+    });
+
+    first.setGenerator(generator);
+    second.setGenerator(generator);
+    EXPECT_EQ(first.getData(), second.getData());
+    EXPECT_EQ(1, calls);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,111 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/algorithm/localitydescriptors.h>
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, LocalityDescriptors_SyntheticEnsemble_SameAsChargeTransferMatrix) {
+    SyntheticEnsemble::Settings settings;
+    settings.nrMembers = 600;
+    settings.nrSubgroups = 5;
+    settings.nrRegions = 5;
+    const auto table = SyntheticEnsemble(settings).table();
+    const std::vector<dvec3> positions{dvec3{0.0, 0.0, 0.0}, dvec3{3.0, 0.0, 0.0},
+                                       dvec3{0.0, 4.0, 1.0}, dvec3{10.0, 10.0, 10.0},
+                                       dvec3{-2.0, 5.0, 0.5}};
+
+    std::vector<const float*> hole;
+    std::vector<const float*> particle;
+    for (size_t i = 0; i < settings.nrSubgroups; i++) {
+        hole.push_back(table.holeCharges[i].data());
+        particle.push_back(table.particleCharges[i].data());
+    }
+    const auto descriptors =
+        LocalityDescriptors::compute(hole, particle, settings.nrMembers, positions, 3);
+
+    ASSERT_EQ(settings.nrMembers, descriptors.measureOfLocality.size());
+    for (size_t m = 0; m < settings.nrMembers; m++) {
+        std::vector<float> h, p;
+        for (size_t i = 0; i < settings.nrSubgroups; i++) {
+            h.push_back(table.holeCharges[i][m]);
+            p.push_back(table.particleCharges[i][m]);
+        }
+        // Columns are donors, rows acceptors
+        const auto matrix =
+            ChargeTransferMatrix::computeTransposedChargeTransferAndChargeDifference(h, p).first;
+        double trace = 0.0, offDiagonal = 0.0, distance2 = 0.0;
+        int donors = 0;
+        for (size_t d = 0; d < h.size(); d++) {
+            donors += h[d] > p[d];
+            for (size_t a = 0; a < h.size(); a++) {
+                if (a == d) {
+                    trace += matrix[d][a];
+                    continue;
+                }
+                const auto v = positions[d] - positions[a];
+                offDiagonal += matrix[d][a];
+                distance2 += matrix[d][a] * glm::dot(v, v);
+            }
+        }
+
+        EXPECT_NEAR(trace, descriptors.measureOfLocality[m], 1e-5);
+        EXPECT_NEAR(offDiagonal, descriptors.transferredCharge[m], 1e-5);
+        EXPECT_EQ(donors, descriptors.donors[m]);
+        EXPECT_EQ(static_cast<int>(h.size()) - donors, descriptors.acceptors[m]);
+        EXPECT_NEAR(std::sqrt(distance2 / offDiagonal), descriptors.ctRmsDistance[m], 1e-3);
+        EXPECT_LE(descriptors.ctDistance[m], descriptors.ctRmsDistance[m] + 1e-4);
+    }
+}
+
+TEST(MolecularChargeTransitions, LocalityDescriptors_OneDonorOneAcceptor_DistanceBetweenThem) {
+    const std::vector<float> hole{0.8f, 0.2f};
+    const std::vector<float> particle{0.3f, 0.7f};
+    const auto descriptors = LocalityDescriptors::compute<float>(
+        {&hole[0], &hole[1]}, {&particle[0], &particle[1]}, 1,
+        {dvec3{1.0, 2.0, 3.0}, dvec3{4.0, 6.0, 3.0}});
+
+    EXPECT_FLOAT_EQ(0.5f, descriptors.measureOfLocality[0]);
+    EXPECT_FLOAT_EQ(0.5f, descriptors.transferredCharge[0]);
+    EXPECT_EQ(1, descriptors.donors[0]);
+    EXPECT_EQ(1, descriptors.acceptors[0]);
+    EXPECT_NEAR(5.0f, descriptors.ctDistance[0], 1e-5);
+    EXPECT_NEAR(5.0f, descriptors.ctRmsDistance[0], 1e-5);
+
+    EXPECT_THROW(LocalityDescriptors::compute<float>({&hole[0]}, {}, 1), Exception);
+}
+
+}  // namespace inviwo
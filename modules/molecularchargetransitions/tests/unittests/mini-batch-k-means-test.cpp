@@ -0,0 +1,121 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/minibatchkmeans.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+namespace {
+
+// Members around nrBlobs well separated centers in 2D, member m belongs to blob m % nrBlobs
+std::vector<std::vector<float>> blobs(size_t nrMembers, size_t nrBlobs) {
+    std::mt19937 rand(3);
+    std::normal_distribution<float> noise(0.0f, 0.1f);
+    std::vector<std::vector<float>> features(2, std::vector<float>(nrMembers));
+    for (size_t m = 0; m < nrMembers; m++) {
+        const auto blob = static_cast<float>(m % nrBlobs);
+        features[0][m] = 10.0f * blob + noise(rand);
+        features[1][m] = -5.0f * blob + noise(rand);
+    }
+    return features;
+}
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, MiniBatchKMeans_SeparatedBlobs_FindsBlobs) {
+    const size_t nrMembers = 20000;
+    const auto features = blobs(nrMembers, 4);
+    MiniBatchKMeans::Settings settings;
+    settings.nrClusters = 4;
+    settings.batchSize = 256;
+    settings.nrBatches = 50;
+    const auto result =
+        MiniBatchKMeans::compute({features[0].data(), features[1].data()}, nrMembers, settings);
+
+    ASSERT_EQ(4, result.nrClusters());
+    ASSERT_EQ(nrMembers, result.labels.size());
+    for (size_t m = 0; m < nrMembers; m++) {
+        EXPECT_EQ(result.labels[m % 4], result.labels[m]);
+    }
+    for (size_t c = 0; c < 4; c++) {
+        EXPECT_EQ(nrMembers / 4, result.sizes[c]);
+        const auto blob = std::round(result.centers[2 * c] / 10.0f);
+        EXPECT_NEAR(10.0f * blob, result.centers[2 * c], 0.01f);
+        EXPECT_NEAR(-5.0f * blob, result.centers[2 * c + 1], 0.01f);
+    }
+    EXPECT_NEAR(nrMembers * 2 * 0.01, result.inertia, nrMembers * 2 * 0.001);
+}
+
+TEST(MolecularChargeTransitions, MiniBatchKMeans_MoreClustersThanPoints_RemovesEmptyClusters) {
+    const auto x = std::vector<float>{1.0f, 1.0f, 2.0f, 2.0f, 2.0f};
+    MiniBatchKMeans::Settings settings;
+    settings.nrClusters = 4;
+    const auto result = MiniBatchKMeans::compute({x.data()}, x.size(), settings);
+
+    ASSERT_EQ(2, result.nrClusters());
+    EXPECT_EQ(x.size(), std::accumulate(result.sizes.begin(), result.sizes.end(), size_t{0}));
+    for (size_t m = 0; m < x.size(); m++) {
+        EXPECT_FLOAT_EQ(x[m], result.centers[result.labels[m]]);
+    }
+}
+
+TEST(MolecularChargeTransitions, MiniBatchKMeans_AnyThreadCount_BitIdentical) {
+    const size_t nrMembers = 200000;
+    const auto features = blobs(nrMembers, 7);
+    MiniBatchKMeans::Settings settings;
+    settings.nrClusters = 32;
+    settings.batchSize = 512;
+    settings.nrBatches = 20;
+    const std::vector<const float*> columns{features[0].data(), features[1].data()};
+
+    const auto expected = MiniBatchKMeans::compute(columns, nrMembers, settings, 1);
+    for (const size_t nrThreads : {2, 3, 8}) {
+        const auto result = MiniBatchKMeans::compute(columns, nrMembers, settings, nrThreads);
+        EXPECT_EQ(expected.labels, result.labels);
+        EXPECT_EQ(expected.centers, result.centers);
+        EXPECT_EQ(expected.sizes, result.sizes);
+        EXPECT_EQ(expected.inertia, result.inertia);
+    }
+}
+
+TEST(MolecularChargeTransitions, MiniBatchKMeans_NoFeatures_ThrowsException) {
+    EXPECT_THROW(MiniBatchKMeans::compute({}, 10, MiniBatchKMeans::Settings{}),
+                 inviwo::Exception);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,108 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/nearestatomsegmentation.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+namespace {
+
+const dmat3 identity{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+
+}  // namespace
+
+TEST(MolecularChargeTransitions, NearestAtomSegmentation_TwoAtoms_SplitsInTheMiddle) {
+    const std::vector<dvec3> atoms{dvec3{1.0, 1.0, 1.0}, dvec3{6.0, 1.0, 1.0}};
+    const auto labels = NearestAtomSegmentation::segment(size3_t{8, 2, 2}, identity,
+                                                         dvec3{0.0, 0.0, 0.0}, atoms, {}, 2);
+
+    ASSERT_EQ(32, labels.size());
+    for (size_t i = 0; i < labels.size(); i++) {
+        const auto x = i % 8;
+        EXPECT_EQ(x <= 3 ? 0 : 1, labels[i]) << "x = " << x;
+    }
+}
+
+TEST(MolecularChargeTransitions, NearestAtomSegmentation_Radii_MovesBoundaryToSmallerAtom) {
+    const std::vector<dvec3> atoms{dvec3{0.0, 0.0, 0.0}, dvec3{8.0, 0.0, 0.0}};
+    // |x|^2 - 16 < |x - 8|^2 for x < 5, the tie at x = 5 goes to the first atom
+    const auto labels = NearestAtomSegmentation::segment(
+        size3_t{9, 1, 1}, identity, dvec3{0.0, 0.0, 0.0}, atoms, {4.0, 0.0});
+    EXPECT_EQ((std::vector<uint16_t>{0, 0, 0, 0, 0, 0, 1, 1, 1}), labels);
+}
+
+TEST(MolecularChargeTransitions, NearestAtomSegmentation_ManyAtoms_SameAsBruteForce) {
+    std::vector<dvec3> atoms;
+    for (size_t i = 0; i < 50; i++) {
+        // Deterministic scattered positions, some outside of the volume
+        atoms.emplace_back(static_cast<double>((i * 37) % 23) - 2.0,
+                           static_cast<double>((i * 11) % 17), static_cast<double>((i * 7) % 5));
+    }
+    const size3_t dims{20, 16, 6};
+    const dvec3 offset{0.25, 0.5, 0.0};
+    const auto labels = NearestAtomSegmentation::segment(dims, identity, offset, atoms, {}, 3);
+
+    for (size_t z = 0; z < dims.z; z++) {
+        for (size_t y = 0; y < dims.y; y++) {
+            for (size_t x = 0; x < dims.x; x++) {
+                const dvec3 p = dvec3(static_cast<double>(x), static_cast<double>(y),
+                                      static_cast<double>(z)) +
+                                offset;
+                size_t nearest = 0;
+                for (size_t a = 1; a < atoms.size(); a++) {
+                    const auto da = atoms[a] - p;
+                    const auto dn = atoms[nearest] - p;
+                    if (glm::dot(da, da) < glm::dot(dn, dn)) nearest = a;
+                }
+                ASSERT_EQ(nearest, labels[(z * dims.y + y) * dims.x + x]);
+            }
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, NearestAtomSegmentation_CovalentRadius_ReturnsTableValues) {
+    EXPECT_DOUBLE_EQ(0.31, NearestAtomSegmentation::covalentRadius(1));
+    EXPECT_DOUBLE_EQ(0.76, NearestAtomSegmentation::covalentRadius(6));
+    EXPECT_DOUBLE_EQ(1.45, NearestAtomSegmentation::covalentRadius(47));
+    EXPECT_DOUBLE_EQ(1.36, NearestAtomSegmentation::covalentRadius(79));
+    EXPECT_THROW(NearestAtomSegmentation::covalentRadius(0), inviwo::Exception);
+}
+
+TEST(MolecularChargeTransitions, NearestAtomSegmentation_NoAtoms_ThrowsException) {
+    EXPECT_THROW(NearestAtomSegmentation::segment(size3_t{2, 2, 2}, identity,
+                                                  dvec3{0.0, 0.0, 0.0}, {}),
+                 inviwo::Exception);
+}
+
+}  // namespace inviwo
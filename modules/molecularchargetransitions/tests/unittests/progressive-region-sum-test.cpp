@@ -0,0 +1,109 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/progressiveregionsum.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, ProgressiveRegionSum_PureBlocks_ExactWithoutChange) {
+    // Two regions split along x, constant density
+    const size3_t dims{4, 4, 4};
+    std::vector<uint16_t> labels;
+    for (size_t i = 0; i < 64; i++) {
+        labels.push_back(static_cast<uint16_t>(i % 4 < 2 ? 1 : 2));
+    }
+    const std::vector<float> values(64, 0.5f);
+
+    const auto pyramid = ProgressiveRegionSum::buildLabelPyramid(labels.data(), dims,
+                                                                 /*firstLabel*/ 1,
+                                                                 /*nrRegions*/ 2, /*nrLevels*/ 2);
+    ASSERT_EQ(2, pyramid.levels.size());
+    EXPECT_EQ(size3_t(1), pyramid.levels[1].dims);
+
+    const auto level1 = ProgressiveRegionSum::estimate(values.data(), pyramid, 1);
+    EXPECT_FLOAT_EQ(16.0f, level1.charges[0]);
+    EXPECT_FLOAT_EQ(16.0f, level1.charges[1]);
+    EXPECT_FLOAT_EQ(0.0f, level1.changeEstimate[0]);
+    EXPECT_FLOAT_EQ(0.0f, level1.changeEstimate[1]);
+
+    // The single block at level 2 is mixed, ties go to the smallest region
+    const auto level2 = ProgressiveRegionSum::estimate(values.data(), pyramid, 2);
+    EXPECT_FLOAT_EQ(32.0f, level2.charges[0]);
+    EXPECT_FLOAT_EQ(0.0f, level2.charges[1]);
+    EXPECT_FLOAT_EQ(32.0f, level2.changeEstimate[0]);
+
+    const auto refined = ProgressiveRegionSum::estimate(values.data(), pyramid, 1, &level2);
+    EXPECT_FLOAT_EQ(16.0f, refined.changeEstimate[0]);
+    EXPECT_FLOAT_EQ(16.0f, refined.changeEstimate[1]);
+}
+
+TEST(MolecularChargeTransitions, ProgressiveRegionSum_OddDimensions_CountsAllVoxels) {
+    const size3_t dims{3, 3, 1};
+    const std::vector<uint8_t> labels(9, 0);
+    const std::vector<double> values(9, 1.0);
+
+    const auto pyramid = ProgressiveRegionSum::buildLabelPyramid(labels.data(), dims, 0, 1, 1);
+    const auto estimate = ProgressiveRegionSum::estimate(values.data(), pyramid, 1);
+    EXPECT_FLOAT_EQ(9.0f, estimate.charges[0]);
+}
+
+TEST(MolecularChargeTransitions, ProgressiveRegionSum_LabelPyramid_SameForAnyThreadCount) {
+    const size3_t dims{9, 7, 13};
+    std::vector<uint8_t> labels(glm::compMul(dims));
+    for (size_t i = 0; i < labels.size(); i++) {
+        labels[i] = static_cast<uint8_t>(2 + (i * 7919 / 13) % 5);
+    }
+
+    const auto serial = ProgressiveRegionSum::buildLabelPyramid(labels.data(), dims, 2, 5, 3, 1);
+    const auto parallel = ProgressiveRegionSum::buildLabelPyramid(labels.data(), dims, 2, 5, 3, 4);
+    ASSERT_EQ(serial.levels.size(), parallel.levels.size());
+    for (size_t l = 0; l < serial.levels.size(); l++) {
+        EXPECT_EQ(serial.levels[l].regions, parallel.levels[l].regions);
+        EXPECT_EQ(serial.levels[l].mixed, parallel.levels[l].mixed);
+    }
+
+    labels[50] = 7;
+    EXPECT_THROW(ProgressiveRegionSum::buildLabelPyramid(labels.data(), dims, 2, 5, 3, 4),
+                 inviwo::Exception);
+}
+
+TEST(MolecularChargeTransitions, ProgressiveRegionSum_LevelOutsidePyramid_ThrowsException) {
+    const std::vector<uint16_t> labels(8, 0);
+    const std::vector<float> values(8, 1.0f);
+    const auto pyramid =
+        ProgressiveRegionSum::buildLabelPyramid(labels.data(), size3_t{2, 2, 2}, 0, 1, 1);
+    EXPECT_THROW(ProgressiveRegionSum::estimate(values.data(), pyramid, 2), inviwo::Exception);
+}
+
+}  // namespace inviwo
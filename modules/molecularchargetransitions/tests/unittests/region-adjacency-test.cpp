@@ -0,0 +1,116 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/chargetransfermatrix.h>
+#include <inviwo/molecularchargetransitions/algorithm/regionadjacency.h>
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+namespace {
+const dmat3 identity{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+}
+
+TEST(MolecularChargeTransitions, RegionAdjacency_ThreeRegions_FacesAndCentroids) {
+    // 3 x 2 x 2 volume, labels 1 and 2 split along x in both slices, label 3 only in slice 1
+    // z = 0:  1 1 2    z = 1:  1 3 2
+    //         1 1 2            1 3 2
+    const std::vector<uint8_t> labels{1, 1, 2, 1, 1, 2, 1, 3, 2, 1, 3, 2};
+    const auto graph = RegionAdjacency::compute(labels.data(), size3_t{3, 2, 2}, 1, 3, identity,
+                                                dvec3{1.0, 0.0, 0.0}, 1);
+
+    ASSERT_EQ(3u, graph.edges.size());
+    EXPECT_EQ(0u, graph.edges[0].first);
+    EXPECT_EQ(1u, graph.edges[0].second);
+    EXPECT_EQ(2u, graph.edges[0].faces);  // Along x in slice 0
+    EXPECT_EQ(0u, graph.edges[1].first);
+    EXPECT_EQ(2u, graph.edges[1].second);
+    EXPECT_EQ(4u, graph.edges[1].faces);  // Along x in slice 1 and along z
+    EXPECT_EQ(1u, graph.edges[2].first);
+    EXPECT_EQ(2u, graph.edges[2].second);
+    EXPECT_EQ(2u, graph.edges[2].faces);
+
+    EXPECT_EQ(6u, graph.voxels[0]);
+    EXPECT_EQ(4u, graph.voxels[1]);
+    EXPECT_EQ(2u, graph.voxels[2]);
+    // Offset by one along x
+    EXPECT_DOUBLE_EQ(1.0 + 2.0 / 6.0, graph.centroids[0].x);
+    EXPECT_DOUBLE_EQ(0.5, graph.centroids[0].y);
+    EXPECT_DOUBLE_EQ(1.0 / 3.0, graph.centroids[0].z);
+    EXPECT_DOUBLE_EQ(3.0, graph.centroids[1].x);
+    EXPECT_DOUBLE_EQ(2.0, graph.centroids[2].x);
+    EXPECT_DOUBLE_EQ(1.0, graph.centroids[2].z);
+
+    const auto distances = RegionAdjacency::centroidDistances(graph);
+    EXPECT_DOUBLE_EQ(std::sqrt(1.0 + 0.25), distances[1 * 3 + 2]);
+    EXPECT_DOUBLE_EQ(distances[0 * 3 + 1], distances[1 * 3 + 0]);
+    EXPECT_DOUBLE_EQ(0.0, distances[1 * 3 + 1]);
+}
+
+TEST(MolecularChargeTransitions, RegionAdjacency_Threads_SameAsRegionOverlapFaces) {
+    SyntheticEnsemble::Settings settings;
+    settings.dimensions = size3_t{24, 20, 17};
+    settings.nrRegions = 12;
+    const SyntheticEnsemble ensemble(settings);
+    const auto labels = ensemble.labels();
+    const auto density = ensemble.density(0, SyntheticEnsemble::Charge::Hole);
+
+    const auto single = RegionAdjacency::compute(labels.data(), settings.dimensions, 0, 12,
+                                                 identity, dvec3{0.0}, 1);
+    const auto parallel = RegionAdjacency::compute(labels.data(), settings.dimensions, 0, 12,
+                                                   identity, dvec3{0.0}, 4);
+    const auto overlap = ChargeTransferMatrix::accumulateRegionOverlap(
+        density.data(), density.data(), labels.data(), settings.dimensions, 0, 12, true,
+        dvec2{1.0}, 1);
+
+    EXPECT_EQ(RegionAdjacency::faceMatrix(single), overlap.faces);
+    EXPECT_EQ(RegionAdjacency::faceMatrix(parallel), overlap.faces);
+    EXPECT_EQ(single.voxels, parallel.voxels);
+    for (size_t r = 0; r < 12; r++) {
+        EXPECT_NEAR(single.centroids[r].x, parallel.centroids[r].x, 1e-9);
+        EXPECT_NEAR(single.centroids[r].y, parallel.centroids[r].y, 1e-9);
+        EXPECT_NEAR(single.centroids[r].z, parallel.centroids[r].z, 1e-9);
+    }
+}
+
+TEST(MolecularChargeTransitions, RegionAdjacency_LabelOutsideRange_ThrowsException) {
+    const std::vector<uint16_t> labels{0, 1, 2, 1};
+    EXPECT_THROW(RegionAdjacency::compute(labels.data(), size3_t{2, 2, 1}, 0, 2, identity,
+                                          dvec3{0.0}, 1),
+                 inviwo::Exception);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,73 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <string>
+#include <vector>
+#include <inviwo/molecularchargetransitions/util/resultcache.h>
+#include <inviwo/dataframe/datastructures/column.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, InputHash_EqualValuesInNewBuffer_SameHash) {
+    const TemplateColumn<float> a("Hole sg1", std::vector<float>{0.1f, 0.2f, 0.7f});
+    const TemplateColumn<float> b("Hole sg1", std::vector<float>{0.1f, 0.2f, 0.7f});
+    const TemplateColumn<float> changed("Hole sg1", std::vector<float>{0.1f, 0.2f, 0.8f});
+    const TemplateColumn<float> renamed("Hole sg2", std::vector<float>{0.1f, 0.2f, 0.7f});
+    const TemplateColumn<int> otherType("Hole sg1", std::vector<int>{1, 2, 3});
+
+    const auto hash = [](const Column* column) { return InputHash{}.add(column).value(); };
+    EXPECT_EQ(hash(&a), hash(&b));
+    EXPECT_NE(hash(&a), hash(&changed));
+    EXPECT_NE(hash(&a), hash(&renamed));
+    EXPECT_NE(hash(&a), hash(&otherType));
+    EXPECT_NE(hash(&a), hash(nullptr));
+    EXPECT_NE(InputHash{}.add(&a).add(2).value(), InputHash{}.add(&a).add(3).value());
+}
+
+TEST(MolecularChargeTransitions, ResultCache_OverCapacity_DropsLeastRecentlyUsed) {
+    ResultCache<std::string> cache(2);
+    cache.insert(1, "one");
+    cache.insert(2, "two");
+    ASSERT_NE(nullptr, cache.find(1));  // 2 is now the least recently used
+    cache.insert(3, "three");
+
+    EXPECT_EQ(2, cache.size());
+    EXPECT_EQ(nullptr, cache.find(2));
+    EXPECT_EQ("one", *cache.find(1));
+    EXPECT_EQ("three", *cache.find(3));
+
+    cache.insert(3, "drei");
+    EXPECT_EQ(2, cache.size());
+    EXPECT_EQ("drei", *cache.find(3));
+}
+
+}  // namespace inviwo
@@ -0,0 +1,193 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <cmath>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, SumPerRegion_ThreeRegions_CalculatesCorrectly) {
+    const auto values = std::vector<float>{0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f};
+    const auto labels = std::vector<uint16_t>{0, 1, 2, 2, 1, 0};
+    const auto sums = SegmentedRegionSum::sumPerRegion(values.data(), labels.data(),
+                                                       values.size(), /*firstLabel*/ 0,
+                                                       /*nrRegions*/ 3);
+
+    ASSERT_EQ(3, sums.size());
+    EXPECT_FLOAT_EQ(0.7f, sums[0]);
+    EXPECT_FLOAT_EQ(0.7f, sums[1]);
+    EXPECT_FLOAT_EQ(0.7f, sums[2]);
+}
+
+TEST(MolecularChargeTransitions, SumPerRegion_FirstLabelNotZero_CalculatesCorrectly) {
+    const auto values = std::vector<double>{1.0, 2.0, 3.0, 4.0};
+    const auto labels = std::vector<uint8_t>{3, 4, 4, 3};
+    const auto sums = SegmentedRegionSum::sumPerRegion(values.data(), labels.data(),
+                                                       values.size(), /*firstLabel*/ 3,
+                                                       /*nrRegions*/ 2);
+
+    ASSERT_EQ(2, sums.size());
+    EXPECT_FLOAT_EQ(5.0f, sums[0]);
+    EXPECT_FLOAT_EQ(5.0f, sums[1]);
+}
+
+TEST(MolecularChargeTransitions, SumPerRegion_LabelOutsideRange_ThrowsException) {
+    const auto values = std::vector<float>{1.0f, 2.0f};
+    const auto labels = std::vector<uint16_t>{0, 2};
+    EXPECT_THROW(SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), values.size(),
+                                                  /*firstLabel*/ 0, /*nrRegions*/ 2),
+                 inviwo::Exception);
+}
+
+TEST(MolecularChargeTransitions, SumPerRegion_NoRegions_ThrowsException) {
+    const auto values = std::vector<float>{1.0f};
+    const auto labels = std::vector<uint16_t>{0};
+    EXPECT_THROW(SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), values.size(),
+                                                  /*firstLabel*/ 0, /*nrRegions*/ 0),
+                 inviwo::Exception);
+}
+
+TEST(MolecularChargeTransitions, MomentsPerRegion_SkewedBasis_SameAsWorldSpaceSums) {
+    const size3_t dims{4, 3, 5};
+    const dmat3 basis{dvec3{0.5, 0.1, 0.0}, dvec3{0.0, 0.4, 0.2}, dvec3{-0.1, 0.0, 0.3}};
+    const dvec3 offset{1.0, -2.0, 0.5};
+    std::vector<float> values(glm::compMul(dims));
+    std::vector<uint16_t> labels(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = 0.1f * static_cast<float>((i * 7) % 11);
+        labels[i] = static_cast<uint16_t>(2 + (i * 5) % 3);
+    }
+
+    const auto moments = SegmentedRegionSum::momentsPerRegion(values.data(), labels.data(), dims,
+                                                              2, 3, basis, offset);
+    const auto sums =
+        SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), values.size(), 2, 3);
+
+    std::vector<SegmentedRegionSum::Moments> expected(3);
+    for (size_t i = 0; i < values.size(); i++) {
+        const dvec3 index{static_cast<double>(i % dims.x),
+                          static_cast<double>((i / dims.x) % dims.y),
+                          static_cast<double>(i / (dims.x * dims.y))};
+        const auto p = basis * index + offset;
+        const auto q = static_cast<double>(values[i]);
+        auto& m = expected[labels[i] - 2];
+        m.charge += q;
+        m.first += p * q;
+        const double second[6] = {p.x * p.x, p.y * p.y, p.z * p.z,
+                                  p.x * p.y, p.x * p.z, p.y * p.z};
+        for (size_t j = 0; j < 6; j++) m.second[j] += q * second[j];
+    }
+
+    ASSERT_EQ(3, moments.size());
+    for (size_t r = 0; r < 3; r++) {
+        EXPECT_EQ(sums[r], static_cast<float>(moments[r].charge));
+        for (size_t j = 0; j < 3; j++) EXPECT_NEAR(expected[r].first[j], moments[r].first[j], 1e-9);
+        for (size_t j = 0; j < 6; j++) {
+            EXPECT_NEAR(expected[r].second[j], moments[r].second[j], 1e-9);
+        }
+    }
+}
+
+TEST(MolecularChargeTransitions, SumPerRegion_Progress_CallsBackAndStops) {
+    const size3_t dims{64, 64, 200};
+    std::vector<float> values(glm::compMul(dims));
+    std::vector<uint16_t> labels(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = 0.25f * static_cast<float>(i % 3);
+        labels[i] = static_cast<uint16_t>(i / 500000);
+    }
+
+    // Progress every 4 blocks and when all are done, a single thread does the blocks in order
+    std::vector<size_t> done;
+    const auto sums = SegmentedRegionSum::sumPerRegion(
+        values.data(), labels.data(), dims, 0, 2,
+        [&](size_t voxels) {
+            done.push_back(voxels);
+            return true;
+        },
+        1);
+    const auto expected =
+        SegmentedRegionSum::sumPerRegion(values.data(), labels.data(), values.size(), 0, 2);
+    const auto interval = 4 * SegmentedRegionSum::reductionBlockSize;
+    EXPECT_EQ((std::vector<size_t>{interval, 2 * interval, 3 * interval, values.size()}), done);
+    EXPECT_EQ(expected, sums);
+
+    done.clear();
+    const auto threaded = SegmentedRegionSum::sumPerRegion(
+        values.data(), labels.data(), dims, 0, 2, [&](size_t voxels) {
+            done.push_back(voxels);
+            return true;
+        });
+    EXPECT_EQ(expected, threaded);
+    ASSERT_FALSE(done.empty());
+    EXPECT_EQ(values.size(), done.back());
+
+    // The moments report progress every 4 blocks, a single thread does the blocks in order
+    done.clear();
+    const dmat3 basis{dvec3{1.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+    const auto stopped = SegmentedRegionSum::momentsPerRegion(
+        values.data(), labels.data(), dims, 0, 2, basis, dvec3{0.0},
+        [&](size_t voxels) {
+            done.push_back(voxels);
+            return false;
+        },
+        1);
+    EXPECT_EQ((std::vector<size_t>{4 * SegmentedRegionSum::reductionBlockSize}), done);
+    EXPECT_EQ(0.0, stopped[1].charge);
+}
+
+TEST(MolecularChargeTransitions, MomentsFeatures_TwoPoints_CentroidAndSpread) {
+    // Charge 1 at x = 1 and charge 3 at x = 5
+    const std::vector<float> values{1.0f, 0.0f, 3.0f};
+    const std::vector<uint16_t> labels{0, 0, 0};
+    const dmat3 basis{dvec3{2.0, 0.0, 0.0}, dvec3{0.0, 1.0, 0.0}, dvec3{0.0, 0.0, 1.0}};
+    const auto moments = SegmentedRegionSum::momentsPerRegion(
+        values.data(), labels.data(), size3_t{3, 1, 1}, 0, 1, basis, dvec3{1.0, 0.0, 0.0});
+
+    const auto features = SegmentedRegionSum::features(moments[0]);
+    EXPECT_DOUBLE_EQ(4.0, features.centroid.x);
+    EXPECT_DOUBLE_EQ(0.0, features.centroid.y);
+    EXPECT_DOUBLE_EQ(std::sqrt(3.0), features.spread.x);  // (1 * 9 + 3 * 1) / 4 = 3
+    EXPECT_DOUBLE_EQ(0.0, features.spread.y);
+    EXPECT_DOUBLE_EQ(std::sqrt(3.0), features.radius);
+    EXPECT_DOUBLE_EQ(16.0, features.dipole.x);
+
+    const auto total = SegmentedRegionSum::sum({moments[0], moments[0]}, {0, 1});
+    EXPECT_DOUBLE_EQ(8.0, total.charge);
+    EXPECT_DOUBLE_EQ(4.0, SegmentedRegionSum::features(total).centroid.x);
+    EXPECT_DOUBLE_EQ(0.0, SegmentedRegionSum::features({}).radius);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,55 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <inviwo/molecularchargetransitions/util/subgroupfile.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+TEST(MolecularChargeTransitions, SubgroupFileFromJson_TwoSubgroups_ReturnsNamesAndIndices) {
+    const auto json = nlohmann::json::parse(
+        R"([{"name": "sg1", "indices": [0, 2]}, {"name": "sg2", "indices": [1]}])");
+    const auto subgroups = SubgroupFile::fromJson(json);
+
+    ASSERT_EQ(2, subgroups.size());
+    EXPECT_EQ("sg1", subgroups[0].name);
+    EXPECT_EQ((std::vector<size_t>{0, 2}), subgroups[0].indices);
+    EXPECT_EQ("sg2", subgroups[1].name);
+    EXPECT_EQ(3, SubgroupFile::nrRegions(subgroups));
+}
+
+TEST(MolecularChargeTransitions, SubgroupFileFromJson_MissingIndices_ThrowsException) {
+    const auto json = nlohmann::json::parse(R"([{"name": "sg1"}])");
+    EXPECT_THROW(SubgroupFile::fromJson(json), inviwo::Exception);
+}
+
+}  // namespace inviwo
@@ -0,0 +1,178 @@
+/*********************************************************************************
+ *
+ * Inviwo - Interactive Visualization Workshop
+ *
+ * Copyright (c) 2021 Inviwo Foundation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *********************************************************************************/
+
+#include <warn/push>
+#include <warn/ignore/all>
+#include <gtest/gtest.h>
+#include <warn/pop>
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <set>
+#include <utility>
+#include <vector>
+#include <inviwo/molecularchargetransitions/algorithm/syntheticensemble.h>
+#include <inviwo/molecularchargetransitions/algorithm/segmentedregionsum.h>
+#include <inviwo/core/util/exception.h>
+
+namespace inviwo {
+
+namespace {
+SyntheticEnsemble::Settings testSettings() {
+    SyntheticEnsemble::Settings settings;
+    settings.seed = 42;
+    settings.dimensions = size3_t{24, 20, 16};
+    settings.nrRegions = 6;
+    settings.nrSubgroups = 3;
+    settings.nrMembers = 200;
+    settings.nrClusters = 4;
+    return settings;
+}
+}  // namespace
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_SameSeed_GeneratesSameData) {
+    const SyntheticEnsemble a(testSettings());
+    const SyntheticEnsemble b(testSettings());
+
+    EXPECT_EQ(a.labels(), b.labels());
+    EXPECT_EQ(a.density(7, SyntheticEnsemble::Charge::Hole),
+              b.density(7, SyntheticEnsemble::Charge::Hole));
+    EXPECT_EQ(a.table().holeCharges, b.table().holeCharges);
+    EXPECT_EQ(a.table().cluster, b.table().cluster);
+}
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_DifferentSeed_GeneratesDifferentData) {
+    auto settings = testSettings();
+    const SyntheticEnsemble a(settings);
+    settings.seed = 43;
+    const SyntheticEnsemble b(settings);
+
+    EXPECT_NE(a.table().holeCharges, b.table().holeCharges);
+}
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_Table_ChargesSumToOne) {
+    const SyntheticEnsemble ensemble(testSettings());
+    const auto table = ensemble.table();
+
+    ASSERT_EQ(3, table.holeCharges.size());
+    ASSERT_EQ(200, table.cluster.size());
+    std::set<int> clusters(table.cluster.begin(), table.cluster.end());
+    EXPECT_EQ(4, clusters.size());
+    for (size_t m = 0; m < table.cluster.size(); m++) {
+        float hole = 0.0f;
+        float particle = 0.0f;
+        for (size_t sg = 0; sg < 3; sg++) {
+            hole += table.holeCharges[sg][m];
+            particle += table.particleCharges[sg][m];
+        }
+        EXPECT_NEAR(1.0f, hole, 1e-5f);
+        EXPECT_NEAR(1.0f, particle, 1e-5f);
+    }
+}
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_Member_MatchesTable) {
+    const SyntheticEnsemble ensemble(testSettings());
+    const auto table = ensemble.table();
+    const auto [hole, particle] = ensemble.charges(123);
+
+    EXPECT_EQ(table.cluster[123], ensemble.cluster(123));
+    for (size_t sg = 0; sg < 3; sg++) {
+        EXPECT_EQ(table.holeCharges[sg][123], hole[sg]);
+        EXPECT_EQ(table.particleCharges[sg][123], particle[sg]);
+    }
+}
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_Volumes_IntegrateToMemberCharges) {
+    const SyntheticEnsemble ensemble(testSettings());
+    const auto labels = ensemble.labels();
+    const auto density = ensemble.density(3, SyntheticEnsemble::Charge::Particle);
+    ASSERT_EQ(24 * 20 * 16, labels.size());
+    ASSERT_EQ(labels.size(), density.size());
+
+    const auto regionSums =
+        SegmentedRegionSum::sumPerRegion(density.data(), labels.data(), labels.size(), 0, 6);
+    EXPECT_NEAR(1.0f, std::accumulate(regionSums.begin(), regionSums.end(), 0.0f), 1e-4f);
+
+    // Most of the charge of a region stays within the region
+    const auto subgroups = ensemble.subgroups();
+    ASSERT_EQ(3, subgroups.size());
+    const auto particle = ensemble.charges(3).second;
+    for (size_t sg = 0; sg < 3; sg++) {
+        float sum = 0.0f;
+        for (auto& index : subgroups[sg]["indices"]) {
+            sum += regionSums[index.get<size_t>()];
+        }
+        EXPECT_NEAR(particle[sg], sum, 0.1f);
+    }
+}
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_PrimeNrRegions_BoxShapedRegions) {
+    auto settings = testSettings();
+    for (const auto& [nrRegions, dims] : {std::pair{size_t{7}, size3_t{24, 20, 16}},
+                                          std::pair{size_t{13}, size3_t{24, 20, 16}},
+                                          std::pair{size_t{61}, size3_t{8, 8, 8}}}) {
+        settings.nrRegions = nrRegions;
+        settings.dimensions = dims;
+        const SyntheticEnsemble ensemble(settings);
+        const auto labels = ensemble.labels();
+
+        // Every region has voxels and fills its bounding box
+        std::vector<size_t> count(nrRegions, 0);
+        std::vector<std::array<size_t, 3>> lower(nrRegions, {dims.x, dims.y, dims.z});
+        std::vector<std::array<size_t, 3>> upper(nrRegions, {0, 0, 0});
+        for (size_t i = 0; i < labels.size(); i++) {
+            ASSERT_LT(labels[i], nrRegions);
+            const std::array<size_t, 3> p{i % dims.x, (i / dims.x) % dims.y, i / (dims.x * dims.y)};
+            count[labels[i]]++;
+            for (size_t axis = 0; axis < 3; axis++) {
+                lower[labels[i]][axis] = std::min(lower[labels[i]][axis], p[axis]);
+                upper[labels[i]][axis] = std::max(upper[labels[i]][axis], p[axis] + 1);
+            }
+        }
+        for (size_t r = 0; r < nrRegions; r++) {
+            const auto box = (upper[r][0] - lower[r][0]) * (upper[r][1] - lower[r][1]) *
+                             (upper[r][2] - lower[r][2]);
+            EXPECT_GT(count[r], 0u) << nrRegions << " regions, region " << r;
+            EXPECT_EQ(box, count[r]) << nrRegions << " regions, region " << r;
+        }
+
+        const auto density = ensemble.density(0, SyntheticEnsemble::Charge::Hole);
+        const auto sums = SegmentedRegionSum::sumPerRegion(density.data(), labels.data(),
+                                                           labels.size(), 0, nrRegions);
+        EXPECT_NEAR(1.0f, std::accumulate(sums.begin(), sums.end(), 0.0f), 1e-4f);
+    }
+}
+
+TEST(MolecularChargeTransitions, SyntheticEnsemble_MoreSubgroupsThanRegions_ThrowsException) {
+    auto settings = testSettings();
+    settings.nrSubgroups = 7;
+    EXPECT_THROW(SyntheticEnsemble{settings}, inviwo::Exception);
+}
+
+}  // namespace inviwo
@@ -2,14 +2,26 @@
 import inviwopy
 import inviwopy.qt
 import ivw.utils as inviwo_utils
+import ivwmolecularchargetransitions as mct
 import time
 import csv
+import os
+import json
+import array
+import hashlib
 
 t0 = time.time()
 
 app = inviwopy.app
 network = app.network
-data_folder = "C:/Users/sigsi52/Development/Inviwo/ElectronDensity/data/silver-complexes/"
+# With a trailing separator, the file names below are appended to it
+data_folder = os.path.join(os.environ.get("IVW_DATA_FOLDER", "C:/Users/sigsi52/Development/Inviwo/ElectronDensity/data/silver-complexes/"), "")
+
+# Set by generate_data_sharded.py when run as one of several worker processes. The worker only
+# processes its contiguous range of the metadata rows and writes them as a binary partial table.
+shardIndex = int(os.environ.get("IVW_SHARD_INDEX", "0"))
+shardCount = int(os.environ.get("IVW_SHARD_COUNT", "1"))
+shardOutput = os.environ.get("IVW_SHARD_OUTPUT", "")
 
 # Read metadata file
 f = open(data_folder + "metadata.csv", mode='r')
@@ -20,6 +32,17 @@ for i in range(1, len(lines)):
     # State,Hole cube file,Particle cube file,Subgroups file,Type
     fileNames.append((splitted[0], splitted[1], splitted[2], splitted[3], splitted[4]))
 
+shardBegin = len(fileNames) * shardIndex // shardCount
+shardEnd = len(fileNames) * (shardIndex + 1) // shardCount
+fileNames = fileNames[shardBegin:shardEnd]
+# Identifies the metadata rows of the shard, so that stale shard files are not merged
+shardMetadata = hashlib.sha256("\n".join(line.strip() for line in lines[1 + shardBegin:1 + shardEnd])
+                               .encode("utf-8")).hexdigest()
+
+# Several workers share the machine, each uses its share of the threads (see the module algorithms)
+if "IVW_THREAD_COUNT" in os.environ:
+    app.systemSettings.poolSize.value = int(os.environ["IVW_THREAD_COUNT"])
+
 dataResult = []
 nrSubgroups = 0
 for file in fileNames:
@@ -66,7 +89,12 @@ for file in fileNames:
         print("Error, no data in outport(s) (None), " + file[4] + ", " + file[0])
         exit()
     
-    nrSubgroups = chargeDifference[1].size 
+    # One call per table, the arrays refer directly to the output DataFrames
+    charges = mct.column(holeAndParticleCharges, "charges")
+    chargeDifferences = mct.column(chargeDifference, "Charge difference")
+    chargeTransferMatrix = mct.chargeTransferMatrix(chargeTransfer)
+
+    nrSubgroups = len(chargeDifferences)
 
     row = []
     # Type
@@ -75,17 +103,13 @@ for file in fileNames:
     row.append(file[0])
 
     # Hole and particle charges
-    for i in range(0, 2*nrSubgroups):
-        row.append(holeAndParticleCharges[1].get(i)) 
+    row.extend(charges.tolist())
     
     # Charge difference
-    for j in range(0, nrSubgroups):
-        row.append(chargeDifference[1].get(j))        
+    row.extend(chargeDifferences.tolist())
     
     # Charge transfer matrix (row-wise)
-    for k in range(0, nrSubgroups):
-        for l in range(1, nrSubgroups+1):
-            row.append(chargeTransfer[l].get(k))
+    row.extend(chargeTransferMatrix.ravel().tolist())
     
     dataResult.append(row)
 
@@ -108,10 +132,21 @@ header.extend(particleNames)
 header.extend(diffNames)
 header.extend(chargeTransferNames)
 
-with open(data_folder + 'results3.csv', 'w', newline='') as resultsFile:
-    writer = csv.writer(resultsFile)
-    writer.writerow(header)
-    writer.writerows(dataResult)
+if shardOutput:
+    # Written to a temporary file and renamed, so a shard file only exists if the shard is complete
+    with open(shardOutput + ".tmp", 'wb') as shardFile:
+        # One json line with the header, the names and the metadata rows, followed by the values
+        # as float64
+        shardFile.write((json.dumps({"header": header, "names": [row[0:2] for row in dataResult],
+                                     "rows": [shardBegin, shardEnd],
+                                     "metadata": shardMetadata}) + "\n").encode("utf-8"))
+        array.array('d', [value for row in dataResult for value in row[2:]]).tofile(shardFile)
+    os.replace(shardOutput + ".tmp", shardOutput)
+else:
+    with open(data_folder + 'results3.csv', 'w', newline='') as resultsFile:
+        writer = csv.writer(resultsFile)
+        writer.writerow(header)
+        writer.writerows(dataResult)
 
 t1 = time.time()
 
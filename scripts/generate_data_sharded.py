@@ -0,0 +1,151 @@
+# Runs generate_data.py in several Inviwo processes on the same machine, each on its own shard of
+# the metadata rows, and merges the partial tables into the final table in metadata order.
+#
+# Each worker writes its rows to shards_<K>/shard_<k>.bin in the data folder (K is the number of
+# shards), and a shard file only exists once the worker is done. Shards that already have a file
+# are not run again, so after a failure (see shards_<K>/shard_<k>.log) running the same command
+# again only runs the failed shards. A shard file records its row range and a hash of its metadata
+# rows, files that do not match the current metadata.csv are removed and run again.
+#
+# Every worker gets cpu_count / jobs threads (IVW_THREAD_COUNT, used by the module algorithms and
+# for the Inviwo thread pool), so that the workers together do not oversubscribe the machine.
+#
+# Example:
+#   python generate_data_sharded.py --data-folder path/to/silver-complexes/ \
+#       --inviwo path/to/inviwo --workspace path/to/generate_data.inv --shards 8
+import argparse
+import array
+import csv
+import hashlib
+import json
+import os
+import subprocess
+import sys
+import time
+
+
+def shardPath(shardFolder, shard):
+    return os.path.join(shardFolder, "shard_%03d.bin" % shard)
+
+
+def shardMetadata(dataFolder, shards):
+    # Row range and hash of the metadata rows of each shard, computed as in generate_data.py
+    with open(os.path.join(dataFolder, "metadata.csv"), mode='r') as metadataFile:
+        rows = [line.strip() for line in metadataFile.readlines()[1:]]
+    metadata = []
+    for shard in range(shards):
+        begin = len(rows) * shard // shards
+        end = len(rows) * (shard + 1) // shards
+        digest = hashlib.sha256("\n".join(rows[begin:end]).encode("utf-8")).hexdigest()
+        metadata.append(([begin, end], digest))
+    return metadata
+
+
+def isCurrentShard(shardFolder, shard, metadata):
+    path = shardPath(shardFolder, shard)
+    if not os.path.exists(path):
+        return False
+    with open(path, 'rb') as shardFile:
+        try:
+            table = json.loads(shardFile.readline().decode("utf-8"))
+        except ValueError:
+            return False
+    return (table.get("rows"), table.get("metadata")) == tuple(metadata[shard])
+
+
+def runShards(args, shardFolder, shards):
+    # Keeps at most args.jobs workers running, returns the shards that did not write their file
+    script = os.path.join(os.path.dirname(os.path.abspath(__file__)), "generate_data.py")
+    pending = list(shards)
+    running = []
+    while pending or running:
+        while pending and len(running) < args.jobs:
+            shard = pending.pop(0)
+            env = dict(os.environ,
+                       IVW_DATA_FOLDER=os.path.join(args.data_folder, ""),
+                       IVW_SHARD_INDEX=str(shard),
+                       IVW_SHARD_COUNT=str(args.shards),
+                       IVW_THREAD_COUNT=str(max(1, (os.cpu_count() or 1) // args.jobs)),
+                       IVW_SHARD_OUTPUT=shardPath(shardFolder, shard))
+            log = open(os.path.join(shardFolder, "shard_%03d.log" % shard), "w")
+            command = [args.inviwo, "-w", args.workspace, "-p", script, "-q"]
+            running.append((shard, subprocess.Popen(command, env=env, stdout=log,
+                                                    stderr=subprocess.STDOUT), log))
+        time.sleep(0.5)
+        for shard, process, log in list(running):
+            if process.poll() is not None:
+                log.close()
+                running.remove((shard, process, log))
+
+    return [shard for shard in shards if not os.path.exists(shardPath(shardFolder, shard))]
+
+
+def mergeShards(shardFolder, shards, output):
+    header = None
+    rows = []
+    for shard in range(shards):
+        with open(shardPath(shardFolder, shard), 'rb') as shardFile:
+            table = json.loads(shardFile.readline().decode("utf-8"))
+            values = array.array('d')
+            values.frombytes(shardFile.read())
+        # Shards without rows do not know the number of subgroups
+        if len(table["names"]) == 0:
+            continue
+        if header is None:
+            header = table["header"]
+        elif table["header"] != header:
+            raise RuntimeError("Shard %d has other columns than the earlier shards" % shard)
+        nrValues = len(header) - 2
+        for i, names in enumerate(table["names"]):
+            rows.append(names + values[i * nrValues:(i + 1) * nrValues].tolist())
+
+    with open(output, 'w', newline='') as resultsFile:
+        writer = csv.writer(resultsFile)
+        writer.writerow(header if header is not None else ["Name", "State"])
+        writer.writerows(rows)
+    return len(rows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Sharded generate_data.py")
+    parser.add_argument("--data-folder", required=True, help="Folder with metadata.csv")
+    parser.add_argument("--inviwo", required=True, help="Inviwo executable")
+    parser.add_argument("--workspace", required=True, help="Workspace used by generate_data.py")
+    parser.add_argument("--shards", type=int, default=os.cpu_count())
+    parser.add_argument("--jobs", type=int, default=os.cpu_count(),
+                        help="Number of workers running at the same time")
+    parser.add_argument("--retries", type=int, default=1,
+                        help="Number of times failed shards are run again")
+    parser.add_argument("--output", default="results3.csv", help="Result file in the data folder")
+    args = parser.parse_args()
+
+    t0 = time.time()
+    shardFolder = os.path.join(args.data_folder, "shards_%d" % args.shards)
+    os.makedirs(shardFolder, exist_ok=True)
+
+    metadata = shardMetadata(args.data_folder, args.shards)
+    failed = [shard for shard in range(args.shards)
+              if not isCurrentShard(shardFolder, shard, metadata)]
+    for shard in failed:
+        if os.path.exists(shardPath(shardFolder, shard)):
+            print("Shard %d does not match metadata.csv, running it again" % shard)
+            os.remove(shardPath(shardFolder, shard))
+    if len(failed) < args.shards:
+        print("Resuming, %d of %d shards already done" % (args.shards - len(failed), args.shards))
+    for attempt in range(args.retries + 1):
+        if not failed:
+            break
+        failed = runShards(args, shardFolder, failed)
+
+    if failed:
+        print("Shards failed (see the logs in " + shardFolder + "): " + str(failed))
+        sys.exit(1)
+
+    nrRows = mergeShards(shardFolder, args.shards, os.path.join(args.data_folder, args.output))
+    print("Merged %d rows from %d shards" % (nrRows, args.shards))
+    print("Time:")
+    print(time.time() - t0)
+
+
+if __name__ == "__main__":
+    main()